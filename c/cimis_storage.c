@@ -2,6 +2,232 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* Allocator hooks and memory accounting */
+
+static void *libc_malloc(size_t size, void *ctx) {
+    (void)ctx;
+    return malloc(size);
+}
+
+static void libc_free(void *ptr, void *ctx) {
+    (void)ctx;
+    free(ptr);
+}
+
+static void *libc_realloc(void *ptr, size_t size, void *ctx) {
+    (void)ctx;
+    return realloc(ptr, size);
+}
+
+static struct {
+    cimis_malloc_fn malloc_fn;
+    cimis_free_fn free_fn;
+    cimis_realloc_fn realloc_fn;
+    void *ctx;
+} mem_allocator = {libc_malloc, libc_free, libc_realloc, NULL};
+
+static cimis_mem_stats_t mem_stats;
+static uint64_t mem_limit;
+static uint64_t mem_live_blocks;
+
+/* Size and owner in front of every allocation; 16 bytes keeps the
+ * allocator's alignment for the caller */
+typedef struct {
+    uint64_t size;
+    uint32_t subsystem;
+    uint32_t reserved;
+} mem_header_t;
+
+#define MEM_HEADER_SIZE sizeof(mem_header_t)
+
+#define MEM_COUNT(sub, field) do { \
+    __atomic_add_fetch(&mem_stats.total.field, 1, __ATOMIC_RELAXED); \
+    __atomic_add_fetch(&mem_stats.subsystem[sub].field, 1, __ATOMIC_RELAXED); \
+} while (0)
+
+static void mem_raise_peak(uint64_t *peak, uint64_t live) {
+    uint64_t old = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (live > old &&
+           !__atomic_compare_exchange_n(peak, &old, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/* Add size live bytes unless that would pass the limit */
+static bool mem_charge(uint32_t sub, uint64_t size) {
+    uint64_t live = __atomic_add_fetch(&mem_stats.total.live_bytes, size, __ATOMIC_RELAXED);
+    uint64_t limit = __atomic_load_n(&mem_limit, __ATOMIC_RELAXED);
+    if (limit > 0 && live > limit) {
+        __atomic_sub_fetch(&mem_stats.total.live_bytes, size, __ATOMIC_RELAXED);
+        MEM_COUNT(sub, failures);
+        return false;
+    }
+    mem_raise_peak(&mem_stats.total.peak_bytes, live);
+    cimis_mem_counters_t *c = &mem_stats.subsystem[sub];
+    mem_raise_peak(&c->peak_bytes, __atomic_add_fetch(&c->live_bytes, size, __ATOMIC_RELAXED));
+    return true;
+}
+
+static void mem_uncharge(uint32_t sub, uint64_t size) {
+    __atomic_sub_fetch(&mem_stats.total.live_bytes, size, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&mem_stats.subsystem[sub].live_bytes, size, __ATOMIC_RELAXED);
+}
+
+static void *mem_alloc(cimis_mem_subsystem_t sub, size_t size) {
+    if (size > SIZE_MAX - MEM_HEADER_SIZE) {
+        MEM_COUNT(sub, failures);
+        return NULL;
+    }
+    if (!mem_charge(sub, size)) {
+        return NULL;
+    }
+    mem_header_t *h = mem_allocator.malloc_fn(size + MEM_HEADER_SIZE, mem_allocator.ctx);
+    if (h == NULL) {
+        mem_uncharge(sub, size);
+        MEM_COUNT(sub, failures);
+        return NULL;
+    }
+    h->size = size;
+    h->subsystem = sub;
+    MEM_COUNT(sub, allocations);
+    __atomic_add_fetch(&mem_live_blocks, 1, __ATOMIC_RELAXED);
+    return (uint8_t *)h + MEM_HEADER_SIZE;
+}
+
+static void *mem_calloc(cimis_mem_subsystem_t sub, size_t n, size_t size) {
+    if (size > 0 && n > SIZE_MAX / size) {
+        MEM_COUNT(sub, failures);
+        return NULL;
+    }
+    void *p = mem_alloc(sub, n * size);
+    if (p != NULL) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+/* Resize keeping the original owner (sub is used for a NULL ptr); on
+ * failure ptr stays valid */
+static void *mem_realloc(cimis_mem_subsystem_t sub, void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return mem_alloc(sub, size);
+    }
+    mem_header_t *h = (mem_header_t *)((uint8_t *)ptr - MEM_HEADER_SIZE);
+    sub = h->subsystem;
+    uint64_t old = h->size;
+    if (size > SIZE_MAX - MEM_HEADER_SIZE) {
+        MEM_COUNT(sub, failures);
+        return NULL;
+    }
+    if (size > old && !mem_charge(sub, size - old)) {
+        return NULL;
+    }
+
+    mem_header_t *moved;
+    if (mem_allocator.realloc_fn != NULL) {
+        moved = mem_allocator.realloc_fn(h, size + MEM_HEADER_SIZE, mem_allocator.ctx);
+    } else {
+        moved = mem_allocator.malloc_fn(size + MEM_HEADER_SIZE, mem_allocator.ctx);
+        if (moved != NULL) {
+            memcpy(moved, h, MEM_HEADER_SIZE + (size < old ? size : old));
+            mem_allocator.free_fn(h, mem_allocator.ctx);
+        }
+    }
+    if (moved == NULL) {
+        if (size > old) {
+            mem_uncharge(sub, size - old);
+        }
+        MEM_COUNT(sub, failures);
+        return NULL;
+    }
+    if (size < old) {
+        mem_uncharge(sub, old - size);
+    }
+    moved->size = size;
+    MEM_COUNT(sub, allocations);
+    return (uint8_t *)moved + MEM_HEADER_SIZE;
+}
+
+static void mem_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    mem_header_t *h = (mem_header_t *)((uint8_t *)ptr - MEM_HEADER_SIZE);
+    mem_uncharge(h->subsystem, h->size);
+    MEM_COUNT(h->subsystem, frees);
+    __atomic_sub_fetch(&mem_live_blocks, 1, __ATOMIC_RELAXED);
+    mem_allocator.free_fn(h, mem_allocator.ctx);
+}
+
+cimis_result_t cimis_set_allocator(cimis_malloc_fn malloc_fn, cimis_free_fn free_fn,
+                                   cimis_realloc_fn realloc_fn, void *ctx) {
+    if (malloc_fn == NULL && free_fn == NULL && realloc_fn == NULL) {
+        malloc_fn = libc_malloc;
+        free_fn = libc_free;
+        realloc_fn = libc_realloc;
+        ctx = NULL;
+    } else if (malloc_fn == NULL || free_fn == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    /* Blocks must go back to the allocator that made them */
+    if (__atomic_load_n(&mem_live_blocks, __ATOMIC_RELAXED) > 0) {
+        return CIMIS_ERR_BUSY;
+    }
+    mem_allocator.malloc_fn = malloc_fn;
+    mem_allocator.free_fn = free_fn;
+    mem_allocator.realloc_fn = realloc_fn;
+    mem_allocator.ctx = ctx;
+    return CIMIS_OK;
+}
+
+void cimis_set_memory_limit(uint64_t limit) {
+    __atomic_store_n(&mem_limit, limit, __ATOMIC_RELAXED);
+}
+
+static void mem_load(cimis_mem_counters_t *dst, cimis_mem_counters_t *src) {
+    dst->live_bytes = __atomic_load_n(&src->live_bytes, __ATOMIC_RELAXED);
+    dst->peak_bytes = __atomic_load_n(&src->peak_bytes, __ATOMIC_RELAXED);
+    dst->allocations = __atomic_load_n(&src->allocations, __ATOMIC_RELAXED);
+    dst->frees = __atomic_load_n(&src->frees, __ATOMIC_RELAXED);
+    dst->failures = __atomic_load_n(&src->failures, __ATOMIC_RELAXED);
+}
+
+void cimis_mem_stats(cimis_mem_stats_t *stats) {
+    if (stats == NULL) {
+        return;
+    }
+    mem_load(&stats->total, &mem_stats.total);
+    for (uint32_t i = 0; i < CIMIS_MEM_SUBSYSTEM_COUNT; i++) {
+        mem_load(&stats->subsystem[i], &mem_stats.subsystem[i]);
+    }
+}
+
+void cimis_mem_reset_peak(void) {
+    __atomic_store_n(&mem_stats.total.peak_bytes,
+                     __atomic_load_n(&mem_stats.total.live_bytes, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    for (uint32_t i = 0; i < CIMIS_MEM_SUBSYSTEM_COUNT; i++) {
+        cimis_mem_counters_t *c = &mem_stats.subsystem[i];
+        __atomic_store_n(&c->peak_bytes, __atomic_load_n(&c->live_bytes, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    }
+}
+
+const char *cimis_mem_subsystem_name(cimis_mem_subsystem_t subsystem) {
+    static const char *const names[CIMIS_MEM_SUBSYSTEM_COUNT] = {
+        "iterator", "correlation", "climatology", "spatial", "tail_index", "aggregate", "range_index",
+    };
+    if ((uint32_t)subsystem >= CIMIS_MEM_SUBSYSTEM_COUNT) {
+        return "unknown";
+    }
+    return names[subsystem];
+}
 
 /* Days in each month (non-leap year) */
 static const int days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
@@ -19,24 +245,51 @@ static int get_days_in_month(int year, int month) {
     return days_in_month[month - 1];
 }
 
+/* Days before the first of each month, indexed [leap][month - 1] */
+static const uint16_t cumulative_days[2][12] = {
+    {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334},
+    {0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335},
+};
+
+/* Days from the epoch to January 1 of each year 1985-2101 */
+#define YEAR_TABLE_LAST 2101
+static const uint32_t year_start_days[YEAR_TABLE_LAST - CIMIS_EPOCH_YEAR + 1] = {
+    0, 365, 730, 1095, 1461, 1826, 2191, 2556,
+    2922, 3287, 3652, 4017, 4383, 4748, 5113, 5478,
+    5844, 6209, 6574, 6939, 7305, 7670, 8035, 8400,
+    8766, 9131, 9496, 9861, 10227, 10592, 10957, 11322,
+    11688, 12053, 12418, 12783, 13149, 13514, 13879, 14244,
+    14610, 14975, 15340, 15705, 16071, 16436, 16801, 17166,
+    17532, 17897, 18262, 18627, 18993, 19358, 19723, 20088,
+    20454, 20819, 21184, 21549, 21915, 22280, 22645, 23010,
+    23376, 23741, 24106, 24471, 24837, 25202, 25567, 25932,
+    26298, 26663, 27028, 27393, 27759, 28124, 28489, 28854,
+    29220, 29585, 29950, 30315, 30681, 31046, 31411, 31776,
+    32142, 32507, 32872, 33237, 33603, 33968, 34333, 34698,
+    35064, 35429, 35794, 36159, 36525, 36890, 37255, 37620,
+    37986, 38351, 38716, 39081, 39447, 39812, 40177, 40542,
+    40908, 41273, 41638, 42003, 42368,
+};
+
+/* Days from the epoch to January 1 of year (year >= CIMIS_EPOCH_YEAR) */
+static uint32_t days_before_year(int year) {
+    if (year <= YEAR_TABLE_LAST) {
+        return year_start_days[year - CIMIS_EPOCH_YEAR];
+    }
+    int y = year - 1, e = CIMIS_EPOCH_YEAR - 1;
+    int leaps = (y / 4 - y / 100 + y / 400) - (e / 4 - e / 100 + e / 400);
+    return (uint32_t)(365 * (year - CIMIS_EPOCH_YEAR) + leaps);
+}
+
 /* Calculate days since epoch (January 1, 1985) */
 uint32_t cimis_date_to_days_since_epoch(int year, int month, int day) {
-    uint32_t days = 0;
-    int y;
-    
-    /* Add days for complete years */
-    for (y = CIMIS_EPOCH_YEAR; y < year; y++) {
-        days += is_leap_year(y) ? 366 : 365;
-    }
-    
-    /* Add days for complete months in current year */
-    for (int m = 1; m < month; m++) {
-        days += get_days_in_month(year, m);
+    uint32_t days = year > CIMIS_EPOCH_YEAR ? days_before_year(year) : 0;
+
+    if (month >= 1 && month <= 12) {
+        days += cumulative_days[is_leap_year(year)][month - 1];
     }
-    
-    /* Add days in current month */
     days += day - 1;
-    
+
     return days;
 }
 
@@ -432,6 +685,7 @@ cimis_result_t cimis_iterator_init(cimis_record_iterator_t *iter, const uint8_t
     iter->buffer_size = buffer_size;
     iter->current_offset = 0;
     iter->is_hourly = is_hourly;
+    iter->stride = 1;
     
     size_t record_size = is_hourly ? CIMIS_HOURLY_RECORD_SIZE : CIMIS_DAILY_RECORD_SIZE;
     iter->record_count = buffer_size / record_size;
@@ -449,6 +703,42 @@ bool cimis_iterator_has_next(const cimis_record_iterator_t *iter) {
     return iter->current_offset + record_size <= iter->buffer_size;
 }
 
+static size_t iterator_record_size(const cimis_record_iterator_t *iter) {
+    return iter->is_hourly ? CIMIS_HOURLY_RECORD_SIZE : CIMIS_DAILY_RECORD_SIZE;
+}
+
+/* Signed byte distance between consecutive records in traversal order */
+static ptrdiff_t iterator_step(const cimis_record_iterator_t *iter) {
+    ptrdiff_t stride = iter->stride == 0 ? 1 : iter->stride;
+    return stride * (ptrdiff_t)iterator_record_size(iter);
+}
+
+/* Records the iterator will still yield */
+static uint32_t iterator_remaining(const cimis_record_iterator_t *iter) {
+    size_t record_size = iterator_record_size(iter);
+    if (iter->current_offset + record_size > iter->buffer_size) {
+        return 0;
+    }
+
+    ptrdiff_t step = iterator_step(iter);
+    size_t remaining;
+    if (step > 0) {
+        remaining = (iter->buffer_size - iter->current_offset - record_size) / (size_t)step + 1;
+    } else {
+        remaining = iter->current_offset / (size_t)(-step) + 1;
+    }
+    return remaining > UINT32_MAX ? UINT32_MAX : (uint32_t)remaining;
+}
+
+/* Skip n records; running off either end parks the offset at buffer_size */
+static void iterator_skip(cimis_record_iterator_t *iter, uint32_t n, uint32_t remaining) {
+    if (n >= remaining) {
+        iter->current_offset = iter->buffer_size;
+        return;
+    }
+    iter->current_offset = (size_t)((ptrdiff_t)iter->current_offset + (ptrdiff_t)n * iterator_step(iter));
+}
+
 /* Get next daily record from iterator */
 cimis_result_t cimis_iterator_next_daily(cimis_record_iterator_t *iter, cimis_daily_record_t *record) {
     if (iter == NULL || record == NULL) {
@@ -470,7 +760,7 @@ cimis_result_t cimis_iterator_next_daily(cimis_record_iterator_t *iter, cimis_da
     );
     
     if (result == CIMIS_OK) {
-        iter->current_offset += CIMIS_DAILY_RECORD_SIZE;
+        iterator_skip(iter, 1, iterator_remaining(iter));
     }
     
     return result;
@@ -497,12 +787,181 @@ cimis_result_t cimis_iterator_next_hourly(cimis_record_iterator_t *iter, cimis_h
     );
     
     if (result == CIMIS_OK) {
-        iter->current_offset += CIMIS_HOURLY_RECORD_SIZE;
+        iterator_skip(iter, 1, iterator_remaining(iter));
     }
-    
+
     return result;
 }
 
+_Static_assert(sizeof(cimis_daily_record_t) == CIMIS_DAILY_RECORD_SIZE, "daily record must match wire size");
+_Static_assert(sizeof(cimis_hourly_record_t) == CIMIS_HOURLY_RECORD_SIZE, "hourly record must match wire size");
+
+/* Claim up to max_count records: *first is the next record, step the byte
+ * distance to each following one */
+static uint32_t iterator_take(cimis_record_iterator_t *iter, uint32_t max_count,
+                              const uint8_t **first, ptrdiff_t *step) {
+    uint32_t remaining = iterator_remaining(iter);
+    uint32_t n = remaining < max_count ? remaining : max_count;
+
+    *first = n > 0 ? iter->buffer + iter->current_offset : NULL;
+    *step = iterator_step(iter);
+    iterator_skip(iter, n, remaining);
+    return n;
+}
+
+/* Decode n records spaced step bytes apart into a record array */
+static void iterator_copy(const uint8_t *src, ptrdiff_t step, uint32_t n, bool is_hourly, void *records) {
+    size_t record_size = is_hourly ? CIMIS_HOURLY_RECORD_SIZE : CIMIS_DAILY_RECORD_SIZE;
+    uint8_t *dst = records;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    /* The packed structs are the wire layout, so little-endian hosts copy */
+    if (step == (ptrdiff_t)record_size) {
+        memcpy(dst, src, (size_t)n * record_size);
+        return;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        memcpy(dst + i * record_size, src + (ptrdiff_t)i * step, record_size);
+    }
+#else
+    for (uint32_t i = 0; i < n; i++) {
+        if (is_hourly) {
+            cimis_decode_hourly_record(src + (ptrdiff_t)i * step, record_size,
+                                       (cimis_hourly_record_t *)(dst + i * record_size));
+        } else {
+            cimis_decode_daily_record(src + (ptrdiff_t)i * step, record_size,
+                                      (cimis_daily_record_t *)(dst + i * record_size));
+        }
+    }
+#endif
+}
+
+cimis_result_t cimis_iterator_set_stride(cimis_record_iterator_t *iter, int32_t stride) {
+    if (iter == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+
+    iter->stride = stride == 0 ? 1 : stride;
+    if (stride < 0) {
+        iter->current_offset = iter->record_count == 0
+            ? iter->buffer_size
+            : (size_t)(iter->record_count - 1) * iterator_record_size(iter);
+    }
+    return CIMIS_OK;
+}
+
+cimis_result_t cimis_iterator_set_sample(cimis_record_iterator_t *iter, uint32_t target) {
+    if (iter == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    if (target == 0) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+
+    uint32_t n = iter->record_count;
+    uint32_t stride = n <= target ? 1 : (n + target - 1) / target;
+    iter->stride = stride > INT32_MAX ? INT32_MAX : (int32_t)stride;
+    iter->current_offset = n == 0
+        ? iter->buffer_size
+        : (size_t)((n - 1) % stride) * iterator_record_size(iter);
+    return CIMIS_OK;
+}
+
+uint32_t cimis_iterator_remaining(const cimis_record_iterator_t *iter) {
+    return iter == NULL ? 0 : iterator_remaining(iter);
+}
+
+uint32_t cimis_iterator_next_batch(cimis_record_iterator_t *iter, void *records, uint32_t max_count) {
+    if (iter == NULL || records == NULL || max_count == 0) {
+        return 0;
+    }
+
+    const uint8_t *src;
+    ptrdiff_t step;
+    uint32_t n = iterator_take(iter, max_count, &src, &step);
+    if (n > 0) {
+        iterator_copy(src, step, n, iter->is_hourly, records);
+    }
+    return n;
+}
+
+uint32_t cimis_iterator_next_span(cimis_record_iterator_t *iter, uint32_t max_count, const uint8_t **span) {
+    if (iter == NULL || span == NULL) {
+        return 0;
+    }
+
+    *span = NULL;
+    if (iterator_step(iter) != (ptrdiff_t)iterator_record_size(iter)) {
+        return 0;
+    }
+
+    ptrdiff_t step;
+    return iterator_take(iter, max_count, span, &step);
+}
+
+/* xorshift64* uniform in (0, 1] */
+static double sample_uniform(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (double)(((*state * 0x2545F4914F6CDD1DULL) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+uint32_t cimis_iterator_sample(cimis_record_iterator_t *iter, uint32_t k, uint64_t seed, void *records) {
+    if (iter == NULL || records == NULL || k == 0) {
+        return 0;
+    }
+
+    uint32_t remaining = iterator_remaining(iter);
+    uint32_t n = remaining < k ? remaining : k;
+    if (n == 0) {
+        return 0;
+    }
+
+    uint32_t *picks = mem_alloc(CIMIS_MEM_ITERATOR, n * sizeof(uint32_t));
+    if (picks == NULL) {
+        return 0;
+    }
+
+    /* Reservoir Algorithm L over record positions: jumps straight to the next
+     * replacement, so only the n kept records are ever decoded */
+    for (uint32_t i = 0; i < n; i++) {
+        picks[i] = i;
+    }
+    if (remaining > n) {
+        uint64_t state = seed != 0 ? seed : 0x9E3779B97F4A7C15ULL;
+        double w = exp(log(sample_uniform(&state)) / n);
+        uint64_t i = n - 1;
+        for (;;) {
+            i += (uint64_t)floor(log(sample_uniform(&state)) / log1p(-w)) + 1;
+            if (i >= remaining) {
+                break;
+            }
+            picks[(uint64_t)(sample_uniform(&state) * n) % n] = (uint32_t)i;
+            w *= exp(log(sample_uniform(&state)) / n);
+        }
+        qsort(picks, n, sizeof(uint32_t), compare_u32);
+    }
+
+    const uint8_t *first = iter->buffer + iter->current_offset;
+    ptrdiff_t step = iterator_step(iter);
+    size_t record_size = iterator_record_size(iter);
+    for (uint32_t i = 0; i < n; i++) {
+        iterator_copy(first + (ptrdiff_t)picks[i] * step, step, 1, iter->is_hourly,
+                      (uint8_t *)records + i * record_size);
+    }
+    mem_free(picks);
+
+    iterator_skip(iter, remaining, remaining);
+    return n;
+}
+
 /* Calculate statistics for daily records */
 void cimis_calculate_daily_stats(const cimis_daily_record_t *records, uint32_t count, cimis_daily_stats_t *stats) {
     if (records == NULL || stats == NULL || count == 0) {
@@ -530,3 +989,2658 @@ void cimis_calculate_daily_stats(const cimis_daily_record_t *records, uint32_t c
     stats->total_et = total_et;
     stats->record_count = count;
 }
+
+/* Extract a measurement from a daily record in physical units */
+float cimis_daily_field_value(const cimis_daily_record_t *record, cimis_field_t field) {
+    switch (field) {
+    case CIMIS_FIELD_TEMPERATURE:
+        return cimis_fixed_to_float_temp(record->temperature);
+    case CIMIS_FIELD_ET:
+        return cimis_fixed_to_float_et_daily(record->et);
+    case CIMIS_FIELD_WIND_SPEED:
+        return cimis_fixed_to_float_wind(record->wind_speed);
+    case CIMIS_FIELD_HUMIDITY:
+        return (float)record->humidity;
+    case CIMIS_FIELD_SOLAR_RADIATION:
+        return cimis_fixed_to_float_solar(record->solar_radiation);
+    default:
+        return NAN;
+    }
+}
+
+/* Extract a measurement from an hourly record in physical units */
+float cimis_hourly_field_value(const cimis_hourly_record_t *record, cimis_field_t field) {
+    switch (field) {
+    case CIMIS_FIELD_TEMPERATURE:
+        return cimis_fixed_to_float_temp(record->temperature);
+    case CIMIS_FIELD_ET:
+        return cimis_fixed_to_float_et_hourly(record->et);
+    case CIMIS_FIELD_WIND_SPEED:
+        return cimis_fixed_to_float_wind(record->wind_speed);
+    case CIMIS_FIELD_HUMIDITY:
+        return (float)record->humidity;
+    case CIMIS_FIELD_SOLAR_RADIATION:
+        return (float)record->solar_radiation;
+    case CIMIS_FIELD_WIND_DIRECTION:
+        return cimis_fixed_to_float_wind_dir(record->wind_direction);
+    case CIMIS_FIELD_PRECIPITATION:
+        return cimis_fixed_to_float_precip(record->precipitation);
+    case CIMIS_FIELD_VAPOR_PRESSURE:
+        return cimis_fixed_to_float_vapor(record->vapor_pressure);
+    default:
+        return NAN;
+    }
+}
+
+/* Split daily records into timestamp/value columns for series kernels */
+cimis_result_t cimis_series_from_daily(const cimis_daily_record_t *records, uint32_t count,
+                                       cimis_field_t field, uint32_t *timestamps, float *values) {
+    if ((records == NULL || timestamps == NULL || values == NULL) && count > 0) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        timestamps[i] = records[i].timestamp;
+        values[i] = cimis_daily_field_value(&records[i], field);
+    }
+
+    return CIMIS_OK;
+}
+
+/*
+ * Pairwise correlation
+ *
+ * Series are scattered onto the union of their timestamps as two dense
+ * matrices: X holds values standardized once per series (0 where missing)
+ * and M holds the presence mask. For every pair the kernel accumulates
+ *   n = Σ Mi·Mj,  sx = Σ Xi·Mj,  sy = Σ Mi·Xj,
+ *   sxx = Σ Xi²·Mj,  syy = Σ Mi·Xj²,  sxy = Σ Xi·Xj
+ * which gives the exact Pearson r over the overlapping samples only.
+ * Work is tiled over (series block × series block × timeline tile) so both
+ * row blocks of a tile stay cache resident while every pair in the block
+ * reuses them, and block pairs are interleaved across threads.
+ */
+
+#define CORR_LANES 8
+#define CORR_TILE_T 512   /* Timeline samples per tile (2 KB per row) */
+#define CORR_BLOCK_S 16   /* Series per block; two blocks of X and M ≈ 128 KB */
+
+typedef float cimis_v8f __attribute__((vector_size(CORR_LANES * sizeof(float))));
+
+typedef struct {
+    uint32_t num_series;
+    size_t stride;          /* Padded timeline length, multiple of CORR_LANES */
+    const float *x;
+    const float *m;
+    double *acc;            /* 6 sums per (i, j), upper triangle only */
+    uint32_t num_blocks;
+    uint32_t num_units;     /* Block pairs (bi <= bj) */
+    uint32_t thread_index;
+    uint32_t num_threads;
+} corr_job_t;
+
+/* Vectors stay local to corr_dot6 so no vector values cross call boundaries */
+#define CORR_LOAD(v, p) memcpy(&(v), (p), sizeof(v))
+
+static double corr_hsum(const cimis_v8f *v) {
+    float lanes[CORR_LANES];
+    double s = 0.0;
+    memcpy(lanes, v, sizeof(lanes));
+    for (int l = 0; l < CORR_LANES; l++) {
+        s += lanes[l];
+    }
+    return s;
+}
+
+/* Six masked dot products over one tile; n is a multiple of CORR_LANES */
+static void corr_dot6(const float *xi, const float *mi, const float *xj, const float *mj,
+                      size_t n, double *out) {
+    cimis_v8f cnt = {0}, sx = {0}, sy = {0}, sxx = {0}, syy = {0}, sxy = {0};
+
+    for (size_t t = 0; t < n; t += CORR_LANES) {
+        cimis_v8f a, b, ma, mb;
+        CORR_LOAD(a, xi + t);
+        CORR_LOAD(b, xj + t);
+        CORR_LOAD(ma, mi + t);
+        CORR_LOAD(mb, mj + t);
+
+        cnt += ma * mb;
+        sx += a * mb;
+        sy += ma * b;
+        sxx += a * a * mb;
+        syy += ma * b * b;
+        sxy += a * b;
+    }
+
+    /* Fold per tile into doubles so long timelines don't lose precision */
+    out[0] += corr_hsum(&cnt);
+    out[1] += corr_hsum(&sx);
+    out[2] += corr_hsum(&sy);
+    out[3] += corr_hsum(&sxx);
+    out[4] += corr_hsum(&syy);
+    out[5] += corr_hsum(&sxy);
+}
+
+static void corr_run_unit(const corr_job_t *job, uint32_t bi, uint32_t bj) {
+    uint32_t S = job->num_series;
+    uint32_t i0 = bi * CORR_BLOCK_S, i1 = i0 + CORR_BLOCK_S;
+    uint32_t j0 = bj * CORR_BLOCK_S, j1 = j0 + CORR_BLOCK_S;
+    if (i1 > S) i1 = S;
+    if (j1 > S) j1 = S;
+
+    for (size_t t0 = 0; t0 < job->stride; t0 += CORR_TILE_T) {
+        size_t len = job->stride - t0;
+        if (len > CORR_TILE_T) len = CORR_TILE_T;
+
+        for (uint32_t i = i0; i < i1; i++) {
+            const float *xi = job->x + (size_t)i * job->stride + t0;
+            const float *mi = job->m + (size_t)i * job->stride + t0;
+            for (uint32_t j = (bi == bj ? i : j0); j < j1; j++) {
+                const float *xj = job->x + (size_t)j * job->stride + t0;
+                const float *mj = job->m + (size_t)j * job->stride + t0;
+                corr_dot6(xi, mi, xj, mj, len, job->acc + ((size_t)i * S + j) * 6);
+            }
+        }
+    }
+}
+
+static void *corr_worker(void *arg) {
+    const corr_job_t *job = (const corr_job_t *)arg;
+    uint32_t unit = 0;
+
+    for (uint32_t bi = 0; bi < job->num_blocks; bi++) {
+        for (uint32_t bj = bi; bj < job->num_blocks; bj++, unit++) {
+            if (unit % job->num_threads == job->thread_index) {
+                corr_run_unit(job, bi, bj);
+            }
+        }
+    }
+    return NULL;
+}
+
+static int corr_default_threads(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0) {
+        return (int)n;
+    }
+#endif
+    return 1;
+}
+
+/* Compute the Pearson correlation matrix of num_series aligned series */
+cimis_result_t cimis_correlation_matrix(const cimis_series_t *series, uint32_t num_series,
+                                        uint32_t min_overlap, int num_threads,
+                                        float *corr, uint32_t *overlap) {
+    if (series == NULL || corr == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    if (num_series == 0) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+
+    /* Build the union timeline */
+    size_t total = 0;
+    for (uint32_t s = 0; s < num_series; s++) {
+        if (series[s].count > 0 && (series[s].timestamps == NULL || series[s].values == NULL)) {
+            return CIMIS_ERR_NULL_PTR;
+        }
+        for (uint32_t k = 1; k < series[s].count; k++) {
+            if (series[s].timestamps[k] < series[s].timestamps[k - 1]) {
+                return CIMIS_ERR_INVALID_TIMESTAMP;
+            }
+        }
+        total += series[s].count;
+    }
+
+    uint32_t *timeline = mem_alloc(CIMIS_MEM_CORRELATION, (total > 0 ? total : 1) * sizeof(uint32_t));
+    if (timeline == NULL) {
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+    size_t pos = 0;
+    for (uint32_t s = 0; s < num_series; s++) {
+        if (series[s].count > 0) {
+            memcpy(timeline + pos, series[s].timestamps, series[s].count * sizeof(uint32_t));
+            pos += series[s].count;
+        }
+    }
+    qsort(timeline, total, sizeof(uint32_t), compare_u32);
+    size_t T = 0;
+    for (size_t k = 0; k < total; k++) {
+        if (T == 0 || timeline[k] != timeline[T - 1]) {
+            timeline[T++] = timeline[k];
+        }
+    }
+
+    size_t stride = (T + CORR_LANES - 1) / CORR_LANES * CORR_LANES;
+    if (stride == 0) {
+        stride = CORR_LANES;
+    }
+    size_t S = num_series;
+    float *x = mem_calloc(CIMIS_MEM_CORRELATION, S * stride, sizeof(float));
+    float *m = mem_calloc(CIMIS_MEM_CORRELATION, S * stride, sizeof(float));
+    double *acc = mem_calloc(CIMIS_MEM_CORRELATION, S * S * 6, sizeof(double));
+    if (x == NULL || m == NULL || acc == NULL) {
+        mem_free(timeline);
+        mem_free(x);
+        mem_free(m);
+        mem_free(acc);
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+
+    /* Scatter each series onto the timeline and standardize it once */
+    for (uint32_t s = 0; s < num_series; s++) {
+        float *xs = x + (size_t)s * stride;
+        float *ms = m + (size_t)s * stride;
+        double sum = 0.0, sum_sq = 0.0;
+        uint32_t n = 0;
+        size_t t = 0;
+
+        for (uint32_t k = 0; k < series[s].count; k++) {
+            float v = series[s].values[k];
+            uint32_t ts = series[s].timestamps[k];
+            while (timeline[t] < ts) {
+                t++;
+            }
+            if (isnan(v) || ms[t] != 0.0f) {
+                continue;
+            }
+            xs[t] = v;
+            ms[t] = 1.0f;
+            sum += v;
+            sum_sq += (double)v * v;
+            n++;
+        }
+
+        double mean = n > 0 ? sum / n : 0.0;
+        double var = n > 0 ? sum_sq / n - mean * mean : 0.0;
+        double inv_std = var > 0.0 ? 1.0 / sqrt(var) : 0.0;
+        for (size_t k = 0; k < T; k++) {
+            if (ms[k] != 0.0f) {
+                xs[k] = (float)((xs[k] - mean) * inv_std);
+            }
+        }
+    }
+    mem_free(timeline);
+
+    /* Tile the pair space across threads */
+    uint32_t num_blocks = (num_series + CORR_BLOCK_S - 1) / CORR_BLOCK_S;
+    uint32_t num_units = num_blocks * (num_blocks + 1) / 2;
+    if (num_threads <= 0) {
+        num_threads = corr_default_threads();
+    }
+    if ((uint32_t)num_threads > num_units) {
+        num_threads = (int)num_units;
+    }
+
+    corr_job_t *jobs = mem_alloc(CIMIS_MEM_CORRELATION, (size_t)num_threads * sizeof(corr_job_t));
+    pthread_t *threads = mem_alloc(CIMIS_MEM_CORRELATION, (size_t)num_threads * sizeof(pthread_t));
+    if (jobs == NULL || threads == NULL) {
+        mem_free(jobs);
+        mem_free(threads);
+        mem_free(x);
+        mem_free(m);
+        mem_free(acc);
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+
+    for (int w = 0; w < num_threads; w++) {
+        jobs[w] = (corr_job_t){
+            .num_series = num_series,
+            .stride = stride,
+            .x = x,
+            .m = m,
+            .acc = acc,
+            .num_blocks = num_blocks,
+            .num_units = num_units,
+            .thread_index = (uint32_t)w,
+            .num_threads = (uint32_t)num_threads,
+        };
+    }
+
+    /* Worker 0 runs on the calling thread; failed spawns also run inline */
+    int started = 0;
+    for (int w = 1; w < num_threads; w++) {
+        if (pthread_create(&threads[started], NULL, corr_worker, &jobs[w]) != 0) {
+            corr_worker(&jobs[w]);
+            continue;
+        }
+        started++;
+    }
+    corr_worker(&jobs[0]);
+    for (int w = 0; w < started; w++) {
+        pthread_join(threads[w], NULL);
+    }
+    mem_free(jobs);
+    mem_free(threads);
+    mem_free(x);
+    mem_free(m);
+
+    /* Reduce the sums to coefficients */
+    for (size_t i = 0; i < S; i++) {
+        for (size_t j = i; j < S; j++) {
+            const double *a = acc + (i * S + j) * 6;
+            double n = a[0];
+            double cov = n * a[5] - a[1] * a[2];
+            double var_x = n * a[3] - a[1] * a[1];
+            double var_y = n * a[4] - a[2] * a[2];
+            uint32_t count = (uint32_t)(n + 0.5);
+            float r = NAN;
+
+            if (count >= min_overlap && count >= 2 && var_x > 0.0 && var_y > 0.0) {
+                double v = cov / sqrt(var_x * var_y);
+                if (v > 1.0) v = 1.0;
+                if (v < -1.0) v = -1.0;
+                r = i == j ? 1.0f : (float)v;
+            }
+
+            corr[i * S + j] = r;
+            corr[j * S + i] = r;
+            if (overlap != NULL) {
+                overlap[i * S + j] = count;
+                overlap[j * S + i] = count;
+            }
+        }
+    }
+    mem_free(acc);
+
+    return CIMIS_OK;
+}
+
+/* Leap-aware day-of-year slot (civil-from-days on a March-based year) */
+uint16_t cimis_day_slot(uint32_t days_since_epoch) {
+    /* 5479 days from 1970-01-01 to the 1985 epoch, 719468 from 0000-03-01 */
+    uint64_t z = (uint64_t)days_since_epoch + 5479 + 719468;
+    uint64_t doe = z % 146097;
+    uint64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);  /* 0 = Mar 1, 365 = Feb 29 */
+
+    return (uint16_t)(doy >= 306 ? doy - 306 : doy + 60);
+}
+
+uint16_t cimis_hour_slot(uint32_t hours_since_epoch) {
+    return (uint16_t)(cimis_day_slot(hours_since_epoch / 24) * 24 + hours_since_epoch % 24);
+}
+
+#define ANOMALY_TILE 256
+
+typedef enum { FIELD_I16, FIELD_U16, FIELD_U8 } field_kind_t;
+
+typedef struct {
+    uint8_t offset;
+    uint8_t kind;
+    float scale;
+} field_layout_t;
+
+/* Encoded offsets of each cimis_field_t, matching the record layouts above */
+static const field_layout_t daily_field_layout[CIMIS_DAILY_FIELD_COUNT] = {
+    {6, FIELD_I16, 1.0f / TEMP_SCALE},
+    {8, FIELD_I16, 1.0f / ET_DAILY_SCALE},
+    {10, FIELD_U16, 1.0f / WIND_SCALE},
+    {12, FIELD_U8, 1.0f},
+    {13, FIELD_U8, 1.0f / SOLAR_SCALE},
+};
+
+static const field_layout_t hourly_field_layout[CIMIS_HOURLY_FIELD_COUNT] = {
+    {6, FIELD_I16, 1.0f / TEMP_SCALE},
+    {8, FIELD_I16, 1.0f / ET_HOURLY_SCALE},
+    {10, FIELD_U16, 1.0f / WIND_SCALE},
+    {13, FIELD_U8, 1.0f},
+    {14, FIELD_U16, 1.0f},
+    {12, FIELD_U8, 1.0f / WIND_DIR_SCALE},
+    {16, FIELD_U16, 1.0f / PRECIP_SCALE},
+    {18, FIELD_U16, 1.0f / VAPOR_SCALE},
+};
+
+static inline uint16_t read_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Decode one field column of n encoded records into floats */
+static void decode_field_column(const uint8_t *p, uint32_t n, ptrdiff_t record_size,
+                                const field_layout_t *layout, float *out) {
+    const uint8_t *base = p + layout->offset;
+
+    switch (layout->kind) {
+    case FIELD_I16:
+        for (uint32_t i = 0; i < n; i++) {
+            out[i] = (float)(int16_t)read_le16(base + (ptrdiff_t)i * record_size) * layout->scale;
+        }
+        break;
+    case FIELD_U16:
+        for (uint32_t i = 0; i < n; i++) {
+            out[i] = (float)read_le16(base + (ptrdiff_t)i * record_size) * layout->scale;
+        }
+        break;
+    default:
+        for (uint32_t i = 0; i < n; i++) {
+            out[i] = (float)base[(ptrdiff_t)i * record_size] * layout->scale;
+        }
+        break;
+    }
+}
+
+cimis_result_t cimis_iterator_next_columns(cimis_record_iterator_t *iter, cimis_column_batch_t *batch) {
+    if (iter == NULL || batch == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+
+    const uint8_t *p;
+    ptrdiff_t step;
+    uint32_t n = iterator_take(iter, batch->capacity, &p, &step);
+    batch->count = n;
+    if (n == 0) {
+        return CIMIS_OK;
+    }
+
+    if (batch->timestamps != NULL) {
+        for (uint32_t i = 0; i < n; i++) {
+            batch->timestamps[i] = read_le32(p + (ptrdiff_t)i * step);
+        }
+    }
+    if (batch->station_ids != NULL) {
+        for (uint32_t i = 0; i < n; i++) {
+            batch->station_ids[i] = read_le16(p + (ptrdiff_t)i * step + 4);
+        }
+    }
+    if (batch->qc_flags != NULL) {
+        ptrdiff_t qc_offset = iter->is_hourly ? 20 : 14;
+        for (uint32_t i = 0; i < n; i++) {
+            batch->qc_flags[i] = p[(ptrdiff_t)i * step + qc_offset];
+        }
+    }
+
+    const field_layout_t *layouts = iter->is_hourly ? hourly_field_layout : daily_field_layout;
+    uint32_t num_fields = iter->is_hourly ? CIMIS_HOURLY_FIELD_COUNT : CIMIS_DAILY_FIELD_COUNT;
+    for (uint32_t f = 0; f < CIMIS_HOURLY_FIELD_COUNT; f++) {
+        float *out = batch->values[f];
+        if (out == NULL) {
+            continue;
+        }
+        if (f >= num_fields) {
+            for (uint32_t i = 0; i < n; i++) {
+                out[i] = NAN;
+            }
+            continue;
+        }
+        decode_field_column(p, n, step, &layouts[f], out);
+    }
+
+    return CIMIS_OK;
+}
+
+static uint32_t anomaly_field_count(const cimis_anomaly_scan_t *scan) {
+    uint32_t n = 0;
+    for (uint32_t f = 0; f < scan->clim->num_fields; f++) {
+        if (scan->field_mask & (1u << f)) {
+            n++;
+        }
+    }
+    return n;
+}
+
+/* Scan n whole records; out must have room for n * selected fields */
+static uint32_t anomaly_scan_tile(cimis_anomaly_scan_t *scan, const uint8_t *p, uint32_t n,
+                                  cimis_anomaly_t *out) {
+    const cimis_climatology_t *clim = scan->clim;
+    size_t record_size = clim->is_hourly ? CIMIS_HOURLY_RECORD_SIZE : CIMIS_DAILY_RECORD_SIZE;
+    const field_layout_t *layouts = clim->is_hourly ? hourly_field_layout : daily_field_layout;
+
+    uint32_t ts[ANOMALY_TILE];
+    uint16_t slot[ANOMALY_TILE];
+    uint8_t keep[ANOMALY_TILE];
+    float value[ANOMALY_TILE];
+    float mean[ANOMALY_TILE];
+    float z[ANOMALY_TILE];
+    uint32_t emitted = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        const uint8_t *rec = p + i * record_size;
+        ts[i] = read_le32(rec);
+        keep[i] = read_le16(rec + 4) == clim->station_id;
+        slot[i] = clim->is_hourly ? cimis_hour_slot(ts[i]) : cimis_day_slot(ts[i]);
+        if (!keep[i]) {
+            scan->records_skipped++;
+        }
+    }
+    scan->records_scanned += n;
+
+    for (uint32_t f = 0; f < clim->num_fields; f++) {
+        if (!(scan->field_mask & (1u << f))) {
+            continue;
+        }
+        const float *clim_mean = clim->mean + (size_t)f * clim->num_slots;
+        const float *clim_std = clim->std + (size_t)f * clim->num_slots;
+        const uint32_t *clim_count = clim->count != NULL ? clim->count + (size_t)f * clim->num_slots : NULL;
+        float inv_std[ANOMALY_TILE];
+
+        decode_field_column(p, n, (ptrdiff_t)record_size, &layouts[f], value);
+
+        /* Gather the slot baselines, then score the tile in one branch-free pass */
+        for (uint32_t i = 0; i < n; i++) {
+            float sd = clim_std[slot[i]];
+            bool usable = sd > 0.0f && (clim_count == NULL || clim_count[slot[i]] >= scan->min_samples);
+            mean[i] = clim_mean[slot[i]];
+            inv_std[i] = usable ? 1.0f / sd : 0.0f;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            z[i] = (value[i] - mean[i]) * inv_std[i];
+        }
+
+        for (uint32_t i = 0; i < n; i++) {
+            if (!keep[i] || !(fabsf(z[i]) >= scan->threshold) || inv_std[i] == 0.0f) {
+                continue;
+            }
+            out[emitted++] = (cimis_anomaly_t){
+                .timestamp = ts[i],
+                .station_id = clim->station_id,
+                .field = (uint8_t)f,
+                .value = value[i],
+                .expected = mean[i],
+                .z_score = z[i],
+            };
+        }
+    }
+
+    scan->anomalies_found += emitted;
+    return emitted;
+}
+
+/* Initialize a streaming anomaly scan */
+cimis_result_t cimis_anomaly_scan_init(cimis_anomaly_scan_t *scan, const cimis_climatology_t *clim,
+                                       float threshold, uint32_t field_mask, uint32_t min_samples) {
+    if (scan == NULL || clim == NULL || clim->mean == NULL || clim->std == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+
+    uint32_t expected_slots = clim->is_hourly ? CIMIS_CLIM_HOUR_SLOTS : CIMIS_CLIM_DAY_SLOTS;
+    uint32_t max_fields = clim->is_hourly ? CIMIS_HOURLY_FIELD_COUNT : CIMIS_DAILY_FIELD_COUNT;
+    if (clim->num_slots != expected_slots || clim->num_fields == 0 || clim->num_fields > max_fields) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+
+    memset(scan, 0, sizeof(*scan));
+    scan->clim = clim;
+    scan->threshold = threshold;
+    scan->field_mask = field_mask & ((1u << clim->num_fields) - 1);
+    scan->min_samples = min_samples;
+
+    return CIMIS_OK;
+}
+
+/* Feed the next piece of an encoded record stream through the scan */
+cimis_result_t cimis_anomaly_scan_feed(cimis_anomaly_scan_t *scan, const uint8_t *buffer, size_t buffer_size,
+                                       cimis_anomaly_t *out, uint32_t max_out,
+                                       uint32_t *out_count, size_t *consumed) {
+    if (scan == NULL || scan->clim == NULL || out_count == NULL || consumed == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    if ((buffer == NULL && buffer_size > 0) || (out == NULL && max_out > 0)) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+
+    size_t record_size = scan->clim->is_hourly ? CIMIS_HOURLY_RECORD_SIZE : CIMIS_DAILY_RECORD_SIZE;
+    uint32_t fields = anomaly_field_count(scan);
+    uint32_t n_out = 0;
+    size_t pos = 0;
+
+    *out_count = 0;
+    *consumed = 0;
+
+    /* Finish a record split across the previous buffer */
+    if (scan->carry_len > 0) {
+        if (max_out < fields) {
+            return CIMIS_OK;
+        }
+        size_t take = record_size - scan->carry_len;
+        if (take > buffer_size) {
+            take = buffer_size;
+        }
+        memcpy(scan->carry + scan->carry_len, buffer, take);
+        scan->carry_len += (uint32_t)take;
+        pos += take;
+        if (scan->carry_len < record_size) {
+            *consumed = pos;
+            return CIMIS_OK;
+        }
+        n_out += anomaly_scan_tile(scan, scan->carry, 1, out);
+        scan->carry_len = 0;
+    }
+
+    /* Whole records, one tile at a time, never more than out can absorb */
+    while (buffer_size - pos >= record_size) {
+        uint32_t n = (uint32_t)((buffer_size - pos) / record_size);
+        if (n > ANOMALY_TILE) {
+            n = ANOMALY_TILE;
+        }
+        if (fields > 0 && n > (max_out - n_out) / fields) {
+            n = (max_out - n_out) / fields;
+        }
+        if (n == 0) {
+            *out_count = n_out;
+            *consumed = pos;
+            return CIMIS_OK;
+        }
+        n_out += anomaly_scan_tile(scan, buffer + pos, n, out + n_out);
+        pos += n * record_size;
+    }
+
+    /* Keep the partial tail for the next call */
+    if (pos < buffer_size) {
+        scan->carry_len = (uint32_t)(buffer_size - pos);
+        memcpy(scan->carry, buffer + pos, scan->carry_len);
+        pos = buffer_size;
+    }
+
+    *out_count = n_out;
+    *consumed = pos;
+    return CIMIS_OK;
+}
+
+/* Reset n accumulators */
+void cimis_clim_accum_init(cimis_clim_accum_t *acc, size_t n) {
+    if (acc == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        acc[i] = (cimis_clim_accum_t){.min = INFINITY, .max = -INFINITY};
+    }
+}
+
+/* Welford update */
+void cimis_clim_accum_add(cimis_clim_accum_t *acc, float value) {
+    if (isnan(value)) {
+        return;
+    }
+    acc->count++;
+    double delta = value - acc->mean;
+    acc->mean += delta / acc->count;
+    acc->m2 += delta * (value - acc->mean);
+    if (value < acc->min) acc->min = value;
+    if (value > acc->max) acc->max = value;
+}
+
+/* Chan et al. pairwise merge */
+void cimis_clim_accum_merge(cimis_clim_accum_t *dst, const cimis_clim_accum_t *src) {
+    if (src->count == 0) {
+        return;
+    }
+    if (dst->count == 0) {
+        *dst = *src;
+        return;
+    }
+    double n_a = dst->count, n_b = src->count, n = n_a + n_b;
+    double delta = src->mean - dst->mean;
+    dst->mean += delta * n_b / n;
+    dst->m2 += src->m2 + delta * delta * n_a * n_b / n;
+    dst->count += src->count;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+/* Accumulate one station's records */
+cimis_result_t cimis_climatology_accumulate(const cimis_record_batch_t *batch, bool is_hourly,
+                                            cimis_clim_accum_t *acc) {
+    if (batch == NULL || acc == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    if (batch->count > 0 && batch->records.daily == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+
+    if (is_hourly) {
+        for (uint32_t i = 0; i < batch->count; i++) {
+            const cimis_hourly_record_t *r = &batch->records.hourly[i];
+            if (r->station_id != batch->station_id) {
+                continue;
+            }
+            uint32_t slot = cimis_hour_slot(r->timestamp);
+            for (uint32_t f = 0; f < CIMIS_HOURLY_FIELD_COUNT; f++) {
+                cimis_clim_accum_add(&acc[f * CIMIS_CLIM_HOUR_SLOTS + slot],
+                                     cimis_hourly_field_value(r, (cimis_field_t)f));
+            }
+        }
+    } else {
+        for (uint32_t i = 0; i < batch->count; i++) {
+            const cimis_daily_record_t *r = &batch->records.daily[i];
+            if (r->station_id != batch->station_id) {
+                continue;
+            }
+            uint32_t slot = cimis_day_slot(r->timestamp);
+            for (uint32_t f = 0; f < CIMIS_DAILY_FIELD_COUNT; f++) {
+                cimis_clim_accum_add(&acc[f * CIMIS_CLIM_DAY_SLOTS + slot],
+                                     cimis_daily_field_value(r, (cimis_field_t)f));
+            }
+        }
+    }
+
+    return CIMIS_OK;
+}
+
+typedef struct {
+    const cimis_record_batch_t *batches;
+    uint32_t num_batches;
+    bool is_hourly;
+    size_t block;              /* Accumulators per station */
+    cimis_clim_accum_t *acc;
+    uint32_t *next;            /* Shared work cursor */
+} clim_job_t;
+
+static void *clim_worker(void *arg) {
+    const clim_job_t *job = (const clim_job_t *)arg;
+
+    for (;;) {
+        uint32_t b = __atomic_fetch_add(job->next, 1, __ATOMIC_RELAXED);
+        if (b >= job->num_batches) {
+            break;
+        }
+        cimis_climatology_accumulate(&job->batches[b], job->is_hourly, job->acc + b * job->block);
+    }
+    return NULL;
+}
+
+/* Accumulate many stations in parallel; stations are handed out dynamically
+ * because record counts vary widely with station age. */
+cimis_result_t cimis_climatology_build(const cimis_record_batch_t *batches, uint32_t num_batches,
+                                       bool is_hourly, int num_threads, cimis_clim_accum_t *acc) {
+    if ((batches == NULL || acc == NULL) && num_batches > 0) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    if (num_batches == 0) {
+        return CIMIS_OK;
+    }
+
+    size_t block = is_hourly ? (size_t)CIMIS_HOURLY_FIELD_COUNT * CIMIS_CLIM_HOUR_SLOTS
+                             : (size_t)CIMIS_DAILY_FIELD_COUNT * CIMIS_CLIM_DAY_SLOTS;
+    cimis_clim_accum_init(acc, block * num_batches);
+
+    if (num_threads <= 0) {
+        num_threads = corr_default_threads();
+    }
+    if ((uint32_t)num_threads > num_batches) {
+        num_threads = (int)num_batches;
+    }
+
+    uint32_t next = 0;
+    clim_job_t job = {
+        .batches = batches,
+        .num_batches = num_batches,
+        .is_hourly = is_hourly,
+        .block = block,
+        .acc = acc,
+        .next = &next,
+    };
+
+    pthread_t *threads = mem_alloc(CIMIS_MEM_CLIMATOLOGY, (size_t)num_threads * sizeof(pthread_t));
+    if (threads == NULL) {
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+    int started = 0;
+    for (int w = 1; w < num_threads; w++) {
+        if (pthread_create(&threads[started], NULL, clim_worker, &job) == 0) {
+            started++;
+        }
+    }
+    clim_worker(&job);
+    for (int w = 0; w < started; w++) {
+        pthread_join(threads[w], NULL);
+    }
+    mem_free(threads);
+
+    return CIMIS_OK;
+}
+
+static void write_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void write_le32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void write_le64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint64_t read_le64(const uint8_t *p) {
+    return (uint64_t)read_le32(p) | ((uint64_t)read_le32(p + 4) << 32);
+}
+
+static size_t clim_block_bytes(uint32_t num_fields, uint32_t num_slots) {
+    return (size_t)5 * num_fields * num_slots * sizeof(float);
+}
+
+/* Write a climatology table; the file is replaced atomically */
+cimis_result_t cimis_climatology_table_write(const char *path, bool is_hourly, uint32_t num_stations,
+                                             const uint16_t *station_ids, const uint64_t *years_masks,
+                                             const cimis_clim_accum_t *acc) {
+    if (path == NULL || ((station_ids == NULL || acc == NULL) && num_stations > 0)) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+
+    uint32_t num_fields = is_hourly ? CIMIS_HOURLY_FIELD_COUNT : CIMIS_DAILY_FIELD_COUNT;
+    uint32_t num_slots = is_hourly ? CIMIS_CLIM_HOUR_SLOTS : CIMIS_CLIM_DAY_SLOTS;
+    size_t cells = (size_t)num_fields * num_slots;
+    size_t block_bytes = clim_block_bytes(num_fields, num_slots);
+
+    /* Entries are sorted by station so readers can binary search */
+    uint32_t *order = mem_alloc(CIMIS_MEM_CLIMATOLOGY, (num_stations > 0 ? num_stations : 1) * sizeof(uint32_t));
+    uint8_t *block = mem_alloc(CIMIS_MEM_CLIMATOLOGY, block_bytes);
+    if (order == NULL || block == NULL) {
+        mem_free(order);
+        mem_free(block);
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+    for (uint32_t i = 0; i < num_stations; i++) {
+        uint32_t j = i;
+        while (j > 0 && station_ids[order[j - 1]] > station_ids[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    char tmp_path[4096];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
+        mem_free(order);
+        mem_free(block);
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        mem_free(order);
+        mem_free(block);
+        return CIMIS_ERR_IO;
+    }
+
+    uint8_t header[CIMIS_CLIM_HEADER_SIZE] = {0};
+    memcpy(header, CIMIS_CLIM_MAGIC, 4);
+    write_le16(header + 4, CIMIS_CLIM_VERSION);
+    write_le16(header + 6, is_hourly ? 1 : 0);
+    write_le32(header + 8, num_fields);
+    write_le32(header + 12, num_slots);
+    write_le32(header + 16, num_stations);
+    bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+
+    for (uint32_t i = 0; ok && i < num_stations; i++) {
+        uint8_t entry[CIMIS_CLIM_ENTRY_SIZE] = {0};
+        write_le16(entry, station_ids[order[i]]);
+        write_le32(entry + 4, i);
+        write_le64(entry + 8, years_masks != NULL ? years_masks[order[i]] : 0);
+        ok = fwrite(entry, sizeof(entry), 1, fp) == 1;
+    }
+
+    for (uint32_t i = 0; ok && i < num_stations; i++) {
+        const cimis_clim_accum_t *a = acc + (size_t)order[i] * cells;
+        for (size_t c = 0; c < cells; c++) {
+            float mean = 0.0f, std = 0.0f, min = 0.0f, max = 0.0f;
+            if (a[c].count > 0) {
+                mean = (float)a[c].mean;
+                std = (float)sqrt(a[c].m2 / a[c].count);
+                min = a[c].min;
+                max = a[c].max;
+            }
+            memcpy(block + (0 * cells + c) * 4, &mean, 4);
+            memcpy(block + (1 * cells + c) * 4, &std, 4);
+            memcpy(block + (2 * cells + c) * 4, &min, 4);
+            memcpy(block + (3 * cells + c) * 4, &max, 4);
+            write_le32(block + (4 * cells + c) * 4, a[c].count);
+        }
+        ok = fwrite(block, block_bytes, 1, fp) == 1;
+    }
+
+    mem_free(order);
+    mem_free(block);
+    if (fclose(fp) != 0) {
+        ok = false;
+    }
+    if (!ok || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        return CIMIS_ERR_IO;
+    }
+
+    return CIMIS_OK;
+}
+
+/* Map a climatology table read-only (read into memory where mmap is unavailable) */
+cimis_result_t cimis_climatology_table_open(const char *path, cimis_climatology_table_t *table) {
+    if (path == NULL || table == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    memset(table, 0, sizeof(*table));
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return CIMIS_ERR_IO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return CIMIS_ERR_IO;
+    }
+    if (st.st_size < CIMIS_CLIM_HEADER_SIZE) {
+        close(fd);
+        return CIMIS_ERR_BAD_FORMAT;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return CIMIS_ERR_IO;
+    }
+    table->data = data;
+    table->size = (size_t)st.st_size;
+    table->mapped = true;
+#else
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return CIMIS_ERR_IO;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size < CIMIS_CLIM_HEADER_SIZE) {
+        fclose(fp);
+        return CIMIS_ERR_BAD_FORMAT;
+    }
+    table->data = mem_alloc(CIMIS_MEM_CLIMATOLOGY, (size_t)size);
+    if (table->data == NULL) {
+        fclose(fp);
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+    if (fread(table->data, (size_t)size, 1, fp) != 1) {
+        fclose(fp);
+        mem_free(table->data);
+        table->data = NULL;
+        return CIMIS_ERR_IO;
+    }
+    fclose(fp);
+    table->size = (size_t)size;
+#endif
+
+    const uint8_t *h = table->data;
+    table->is_hourly = (read_le16(h + 6) & 1) != 0;
+    table->num_fields = read_le32(h + 8);
+    table->num_slots = read_le32(h + 12);
+    table->num_stations = read_le32(h + 16);
+
+    uint32_t want_fields = table->is_hourly ? CIMIS_HOURLY_FIELD_COUNT : CIMIS_DAILY_FIELD_COUNT;
+    uint32_t want_slots = table->is_hourly ? CIMIS_CLIM_HOUR_SLOTS : CIMIS_CLIM_DAY_SLOTS;
+    size_t want_size = CIMIS_CLIM_HEADER_SIZE + (size_t)table->num_stations *
+                       (CIMIS_CLIM_ENTRY_SIZE + clim_block_bytes(want_fields, want_slots));
+    if (memcmp(h, CIMIS_CLIM_MAGIC, 4) != 0 || read_le16(h + 4) != CIMIS_CLIM_VERSION ||
+        table->num_fields != want_fields || table->num_slots != want_slots || table->size != want_size) {
+        cimis_climatology_table_close(table);
+        return CIMIS_ERR_BAD_FORMAT;
+    }
+
+    return CIMIS_OK;
+}
+
+void cimis_climatology_table_close(cimis_climatology_table_t *table) {
+    if (table == NULL || table->data == NULL) {
+        return;
+    }
+#ifndef _WIN32
+    if (table->mapped) {
+        munmap(table->data, table->size);
+    } else {
+        mem_free(table->data);
+    }
+#else
+    mem_free(table->data);
+#endif
+    memset(table, 0, sizeof(*table));
+}
+
+/* Binary search the station directory; returns the block pointer or NULL */
+static const uint8_t *clim_find_station(const cimis_climatology_table_t *table, uint16_t station_id,
+                                        uint64_t *years_mask) {
+    const uint8_t *entries = (const uint8_t *)table->data + CIMIS_CLIM_HEADER_SIZE;
+    uint32_t lo = 0, hi = table->num_stations;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const uint8_t *e = entries + (size_t)mid * CIMIS_CLIM_ENTRY_SIZE;
+        uint16_t id = read_le16(e);
+        if (id == station_id) {
+            uint32_t block = read_le32(e + 4);
+            if (block >= table->num_stations) {
+                return NULL;
+            }
+            if (years_mask != NULL) {
+                *years_mask = read_le64(e + 8);
+            }
+            return entries + (size_t)table->num_stations * CIMIS_CLIM_ENTRY_SIZE +
+                   (size_t)block * clim_block_bytes(table->num_fields, table->num_slots);
+        }
+        if (id < station_id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+/* Zero-copy view into the table (assumes a little-endian host, like the mapping itself) */
+cimis_result_t cimis_climatology_table_station(const cimis_climatology_table_t *table, uint16_t station_id,
+                                               cimis_climatology_t *view, uint64_t *years_mask) {
+    if (table == NULL || table->data == NULL || view == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    const uint8_t *block = clim_find_station(table, station_id, years_mask);
+    if (block == NULL) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+
+    size_t cells = (size_t)table->num_fields * table->num_slots;
+    const float *arrays = (const float *)(const void *)block;
+    *view = (cimis_climatology_t){
+        .station_id = station_id,
+        .is_hourly = table->is_hourly,
+        .num_slots = table->num_slots,
+        .num_fields = table->num_fields,
+        .mean = arrays,
+        .std = arrays + cells,
+        .min = arrays + 2 * cells,
+        .max = arrays + 3 * cells,
+        .count = (const uint32_t *)(const void *)(arrays + 4 * cells),
+    };
+
+    return CIMIS_OK;
+}
+
+/* Turn stored mean/std/count back into accumulators (m2 = std² · count) */
+cimis_result_t cimis_climatology_table_load_accum(const cimis_climatology_table_t *table, uint16_t station_id,
+                                                  cimis_clim_accum_t *acc, uint64_t *years_mask) {
+    if (acc == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    cimis_climatology_t view;
+    cimis_result_t result = cimis_climatology_table_station(table, station_id, &view, years_mask);
+    if (result != CIMIS_OK) {
+        return result;
+    }
+
+    size_t cells = (size_t)view.num_fields * view.num_slots;
+    cimis_clim_accum_init(acc, cells);
+    for (size_t c = 0; c < cells; c++) {
+        if (view.count[c] == 0) {
+            continue;
+        }
+        acc[c].count = view.count[c];
+        acc[c].mean = view.mean[c];
+        acc[c].m2 = (double)view.std[c] * view.std[c] * view.count[c];
+        acc[c].min = view.min[c];
+        acc[c].max = view.max[c];
+    }
+
+    return CIMIS_OK;
+}
+
+#define EARTH_RADIUS_KM 6371.0088
+#define DEG_TO_RAD 0.017453292519943295
+
+static void station_to_xyz(float lat, float lon, float xyz[3]) {
+    double phi = lat * DEG_TO_RAD, lambda = lon * DEG_TO_RAD;
+    xyz[0] = (float)(cos(phi) * cos(lambda));
+    xyz[1] = (float)(cos(phi) * sin(lambda));
+    xyz[2] = (float)sin(phi);
+}
+
+static float chord_sq(const float a[3], const float b[3]) {
+    float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+static int kd_cmp_x(const void *a, const void *b) {
+    float x = ((const cimis_kdnode_t *)a)->xyz[0], y = ((const cimis_kdnode_t *)b)->xyz[0];
+    return (x > y) - (x < y);
+}
+
+static int kd_cmp_y(const void *a, const void *b) {
+    float x = ((const cimis_kdnode_t *)a)->xyz[1], y = ((const cimis_kdnode_t *)b)->xyz[1];
+    return (x > y) - (x < y);
+}
+
+static int kd_cmp_z(const void *a, const void *b) {
+    float x = ((const cimis_kdnode_t *)a)->xyz[2], y = ((const cimis_kdnode_t *)b)->xyz[2];
+    return (x > y) - (x < y);
+}
+
+static void kd_build(cimis_kdnode_t *nodes, uint32_t lo, uint32_t hi, int depth) {
+    if (hi - lo <= 1) {
+        return;
+    }
+    uint32_t mid = lo + (hi - lo) / 2;
+    static int (*const cmp[3])(const void *, const void *) = {kd_cmp_x, kd_cmp_y, kd_cmp_z};
+
+    /* Station networks are small, so a sort per level is cheap and keeps the build simple */
+    qsort(nodes + lo, hi - lo, sizeof(cimis_kdnode_t), cmp[depth % 3]);
+    kd_build(nodes, lo, mid, depth + 1);
+    kd_build(nodes, mid + 1, hi, depth + 1);
+}
+
+/* Build an implicit k-d tree over station coordinates */
+cimis_result_t cimis_kdtree_build(cimis_kdtree_t *tree, const cimis_station_coord_t *stations, uint32_t count) {
+    if (tree == NULL || (stations == NULL && count > 0)) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    tree->nodes = NULL;
+    tree->count = 0;
+    if (count == 0) {
+        return CIMIS_OK;
+    }
+
+    tree->nodes = mem_alloc(CIMIS_MEM_SPATIAL, (size_t)count * sizeof(cimis_kdnode_t));
+    if (tree->nodes == NULL) {
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        station_to_xyz(stations[i].lat, stations[i].lon, tree->nodes[i].xyz);
+        tree->nodes[i].station_id = stations[i].station_id;
+        tree->nodes[i].index = i;
+    }
+    kd_build(tree->nodes, 0, count, 0);
+    tree->count = count;
+
+    return CIMIS_OK;
+}
+
+void cimis_kdtree_free(cimis_kdtree_t *tree) {
+    if (tree == NULL) {
+        return;
+    }
+    mem_free(tree->nodes);
+    tree->nodes = NULL;
+    tree->count = 0;
+}
+
+typedef struct {
+    const cimis_kdnode_t *node;
+    float dist_sq;
+} kd_candidate_t;
+
+typedef struct {
+    const float *query;
+    kd_candidate_t *best;      /* Sorted ascending by dist_sq */
+    uint32_t k;
+    uint32_t found;
+} kd_search_t;
+
+static void kd_offer(kd_search_t *s, const cimis_kdnode_t *node, float dist_sq) {
+    if (s->found == s->k && dist_sq >= s->best[s->k - 1].dist_sq) {
+        return;
+    }
+    uint32_t i = s->found < s->k ? s->found++ : s->k - 1;
+    while (i > 0 && s->best[i - 1].dist_sq > dist_sq) {
+        s->best[i] = s->best[i - 1];
+        i--;
+    }
+    s->best[i] = (kd_candidate_t){node, dist_sq};
+}
+
+static void kd_search(kd_search_t *s, const cimis_kdnode_t *nodes, uint32_t lo, uint32_t hi, int depth) {
+    if (lo >= hi) {
+        return;
+    }
+    uint32_t mid = lo + (hi - lo) / 2;
+    const cimis_kdnode_t *node = &nodes[mid];
+    int axis = depth % 3;
+    float diff = s->query[axis] - node->xyz[axis];
+
+    kd_offer(s, node, chord_sq(s->query, node->xyz));
+
+    /* Near side first; the far side only if the splitting plane is closer than the k-th best */
+    if (diff < 0) {
+        kd_search(s, nodes, lo, mid, depth + 1);
+        if (s->found < s->k || diff * diff < s->best[s->k - 1].dist_sq) {
+            kd_search(s, nodes, mid + 1, hi, depth + 1);
+        }
+    } else {
+        kd_search(s, nodes, mid + 1, hi, depth + 1);
+        if (s->found < s->k || diff * diff < s->best[s->k - 1].dist_sq) {
+            kd_search(s, nodes, lo, mid, depth + 1);
+        }
+    }
+}
+
+/* k nearest stations by great-circle distance */
+uint32_t cimis_knn(const cimis_kdtree_t *tree, float lat, float lon, uint32_t k, cimis_neighbor_t *out) {
+    if (tree == NULL || out == NULL || tree->count == 0 || k == 0) {
+        return 0;
+    }
+    if (k > tree->count) {
+        k = tree->count;
+    }
+
+    kd_candidate_t *best = mem_alloc(CIMIS_MEM_SPATIAL, (size_t)k * sizeof(kd_candidate_t));
+    if (best == NULL) {
+        return 0;
+    }
+    float query[3];
+    station_to_xyz(lat, lon, query);
+    kd_search_t s = {.query = query, .best = best, .k = k, .found = 0};
+    kd_search(&s, tree->nodes, 0, tree->count, 0);
+
+    for (uint32_t i = 0; i < s.found; i++) {
+        double chord = sqrt(best[i].dist_sq);
+        if (chord > 2.0) chord = 2.0;
+        out[i] = (cimis_neighbor_t){
+            .station_id = best[i].node->station_id,
+            .index = best[i].node->index,
+            .distance_km = (float)(2.0 * EARTH_RADIUS_KM * asin(chord / 2.0)),
+        };
+    }
+    mem_free(best);
+
+    return s.found;
+}
+
+typedef int32_t cimis_v8i __attribute__((vector_size(CORR_LANES * sizeof(int32_t))));
+
+/* Weighted sums for one station, 8 samples at a time; NAN samples add nothing */
+static void idw_accumulate(const float *v, float w, uint32_t length, float *num, float *den) {
+    uint32_t t = 0;
+    cimis_v8f wv = {w, w, w, w, w, w, w, w};
+
+    for (; t + CORR_LANES <= length; t += CORR_LANES) {
+        cimis_v8f x, n, d, wx;
+        cimis_v8i present, xi, wi;
+        CORR_LOAD(x, v + t);
+        CORR_LOAD(n, num + t);
+        CORR_LOAD(d, den + t);
+        present = (cimis_v8i)(x == x);
+        wx = wv * x;
+        memcpy(&xi, &wx, sizeof(xi));
+        memcpy(&wi, &wv, sizeof(wi));
+        xi &= present;
+        wi &= present;
+        memcpy(&wx, &xi, sizeof(wx));
+        n += wx;
+        memcpy(&wx, &wi, sizeof(wx));
+        d += wx;
+        memcpy(num + t, &n, sizeof(n));
+        memcpy(den + t, &d, sizeof(d));
+    }
+    for (; t < length; t++) {
+        if (!isnan(v[t])) {
+            num[t] += w * v[t];
+            den[t] += w;
+        }
+    }
+}
+
+/* Inverse-distance weighted estimate per timestamp */
+cimis_result_t cimis_idw_interpolate(const float *const *series, const float *distances_km, uint32_t k,
+                                     uint32_t length, float power, float *out) {
+    if (series == NULL || distances_km == NULL || (out == NULL && length > 0)) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    for (uint32_t i = 0; i < k; i++) {
+        if (series[i] == NULL && length > 0) {
+            return CIMIS_ERR_NULL_PTR;
+        }
+    }
+
+    float *den = mem_calloc(CIMIS_MEM_SPATIAL, length > 0 ? length : 1, sizeof(float));
+    if (den == NULL) {
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+    memset(out, 0, (size_t)length * sizeof(float));
+
+    for (uint32_t i = 0; i < k; i++) {
+        if (distances_km[i] > 0.0f) {
+            idw_accumulate(series[i], powf(distances_km[i], -power), length, out, den);
+        }
+    }
+    for (uint32_t t = 0; t < length; t++) {
+        out[t] = den[t] > 0.0f ? out[t] / den[t] : NAN;
+    }
+
+    /* Co-located stations override the weighted estimate where they have data */
+    for (uint32_t i = 0; i < k; i++) {
+        if (distances_km[i] > 0.0f) {
+            continue;
+        }
+        for (uint32_t t = 0; t < length; t++) {
+            if (!isnan(series[i][t])) {
+                out[t] = series[i][t];
+            }
+        }
+    }
+    mem_free(den);
+
+    return CIMIS_OK;
+}
+
+/*
+ * Batch date parsing
+ *
+ * "YYYY-MM-DD" is checked eight bytes at a time (SWAR): a byte is a digit
+ * when its high nibble is 3 and its low nibble plus 6 does not carry, so one
+ * pair of mask tests validates all six digits of "YYYY-MM-" at once.
+ */
+
+#define SWAR_ONES 0x0101010101010101ULL
+#define DATE_DIGIT_MASK 0x00FFFF00FFFFFFFFULL   /* Bytes 0-3, 5-6 of "YYYY-MM-" */
+#define DATE_DASHES 0x2D00002D00000000ULL        /* '-' at bytes 4 and 7 */
+
+static inline uint64_t load_le64(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+/* True when every byte selected by mask is an ASCII digit */
+static inline bool swar_all_digits(uint64_t v, uint64_t mask) {
+    uint64_t high = v & (0xF0 * SWAR_ONES) & mask;
+    uint64_t low = v & (0x0F * SWAR_ONES) & mask;
+    return high == ((0x30 * SWAR_ONES) & mask) && ((low + 0x06 * SWAR_ONES) & (0xF0 * SWAR_ONES) & mask) == 0;
+}
+
+static inline bool parse_date_fast(const char *s, uint32_t *days) {
+    uint64_t v = load_le64(s);
+    unsigned d8 = (unsigned char)s[8] - '0', d9 = (unsigned char)s[9] - '0';
+
+    if (!swar_all_digits(v, DATE_DIGIT_MASK) || (v & ~DATE_DIGIT_MASK) != DATE_DASHES || d8 > 9 || d9 > 9) {
+        return false;
+    }
+
+    uint64_t d = v & 0x0F * SWAR_ONES;
+    int year = (int)((d & 0xFF) * 1000 + ((d >> 8) & 0xFF) * 100 + ((d >> 16) & 0xFF) * 10 + ((d >> 24) & 0xFF));
+    int month = (int)(((d >> 40) & 0xFF) * 10 + ((d >> 48) & 0xFF));
+    int day = (int)(d8 * 10 + d9);
+
+    if (year < CIMIS_EPOCH_YEAR || year > 2100 || month < 1 || month > 12 || day < 1) {
+        return false;
+    }
+
+    uint32_t start = year_start_days[year - CIMIS_EPOCH_YEAR];
+    int leap = year_start_days[year - CIMIS_EPOCH_YEAR + 1] - start == 366;
+    if (day > days_in_month[month - 1] + (leap && month == 2)) {
+        return false;
+    }
+    *days = start + cumulative_days[leap][month - 1] + (uint32_t)(day - 1);
+    return true;
+}
+
+static inline bool parse_hour_fast(const char *s, size_t stride, int *hour) {
+    unsigned h0 = (unsigned char)s[0] - '0', h1 = (unsigned char)s[1] - '0';
+    const char *minutes = s + 2;
+
+    if (s[2] == ':') {
+        if (stride < 5) {
+            return false;
+        }
+        minutes = s + 3;
+    }
+    if (h0 > 9 || h1 > 9 || minutes[0] != '0' || minutes[1] != '0') {
+        return false;
+    }
+    *hour = (int)(h0 * 10 + h1);
+    return *hour <= 24;
+}
+
+/* Parse "YYYY-MM-DD" strings to days since epoch */
+size_t cimis_parse_dates_batch(const char *dates, size_t stride, size_t count,
+                               uint32_t *days_out, uint8_t *valid) {
+    if (dates == NULL || days_out == NULL || stride < 10) {
+        return 0;
+    }
+
+    size_t ok_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t days = 0;
+        bool ok = parse_date_fast(dates + i * stride, &days);
+        days_out[i] = ok ? days : 0;
+        if (valid != NULL) {
+            valid[i] = ok;
+        }
+        ok_count += ok;
+    }
+    return ok_count;
+}
+
+/* Parse date and hour string pairs to hours since epoch */
+size_t cimis_parse_datetimes_batch(const char *dates, size_t date_stride,
+                                   const char *hours, size_t hour_stride, size_t count,
+                                   uint32_t *hours_out, uint8_t *valid) {
+    if (dates == NULL || hours == NULL || hours_out == NULL || date_stride < 10 || hour_stride < 4) {
+        return 0;
+    }
+
+    size_t ok_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t days = 0;
+        int hour = 0;
+        bool ok = parse_date_fast(dates + i * date_stride, &days) &&
+                  parse_hour_fast(hours + i * hour_stride, hour_stride, &hour);
+        hours_out[i] = ok ? days * 24 + (uint32_t)hour : 0;
+        if (valid != NULL) {
+            valid[i] = ok;
+        }
+        ok_count += ok;
+    }
+    return ok_count;
+}
+
+cimis_result_t cimis_tail_index_open(const char *path, cimis_tail_index_t *index) {
+    if (path == NULL || index == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    memset(index, 0, sizeof(*index));
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return CIMIS_ERR_IO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return CIMIS_ERR_IO;
+    }
+    if (st.st_size < CIMIS_TAIL_HEADER_SIZE) {
+        close(fd);
+        return CIMIS_ERR_BAD_FORMAT;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return CIMIS_ERR_IO;
+    }
+    index->data = data;
+    index->size = (size_t)st.st_size;
+    index->mapped = true;
+#else
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return CIMIS_ERR_IO;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size < CIMIS_TAIL_HEADER_SIZE) {
+        fclose(fp);
+        return CIMIS_ERR_BAD_FORMAT;
+    }
+    index->data = mem_alloc(CIMIS_MEM_TAIL_INDEX, (size_t)size);
+    if (index->data == NULL) {
+        fclose(fp);
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+    if (fread(index->data, (size_t)size, 1, fp) != 1) {
+        fclose(fp);
+        mem_free(index->data);
+        index->data = NULL;
+        return CIMIS_ERR_IO;
+    }
+    fclose(fp);
+    index->size = (size_t)size;
+#endif
+
+    const uint8_t *h = index->data;
+    if (memcmp(h, CIMIS_TAIL_MAGIC, 4) != 0 || read_le32(h + 4) != CIMIS_TAIL_VERSION) {
+        cimis_tail_index_close(index);
+        return CIMIS_ERR_BAD_FORMAT;
+    }
+
+    /* Writers replace the file by rename, so the mapping is one whole
+     * version of it; still only trust slots it actually backs */
+    size_t backed = (index->size - CIMIS_TAIL_HEADER_SIZE) / CIMIS_TAIL_SLOT_SIZE;
+    uint32_t slots = read_le32(h + 8);
+    index->num_slots = slots < backed ? slots : (uint32_t)backed;
+
+    return CIMIS_OK;
+}
+
+void cimis_tail_index_close(cimis_tail_index_t *index) {
+    if (index == NULL || index->data == NULL) {
+        return;
+    }
+#ifndef _WIN32
+    if (index->mapped) {
+        munmap(index->data, index->size);
+    } else {
+        mem_free(index->data);
+    }
+#else
+    mem_free(index->data);
+#endif
+    memset(index, 0, sizeof(*index));
+}
+
+/* Encoded slot half of a station, or NULL when the station has none */
+static const uint8_t *tail_slot(const cimis_tail_index_t *index, uint16_t station_id, size_t offset) {
+    if (station_id == 0 || station_id >= index->num_slots) {
+        return NULL;
+    }
+    const uint8_t *p = (const uint8_t *)index->data + CIMIS_TAIL_HEADER_SIZE +
+                       (size_t)station_id * CIMIS_TAIL_SLOT_SIZE + offset;
+    return read_le16(p + 4) == station_id ? p : NULL;
+}
+
+cimis_result_t cimis_tail_index_daily(const cimis_tail_index_t *index, uint16_t station_id,
+                                      cimis_daily_record_t *record) {
+    if (index == NULL || index->data == NULL || record == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    const uint8_t *p = tail_slot(index, station_id, 0);
+    if (p == NULL) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+    return cimis_decode_daily_record(p, CIMIS_DAILY_RECORD_SIZE, record);
+}
+
+cimis_result_t cimis_tail_index_hourly(const cimis_tail_index_t *index, uint16_t station_id,
+                                       cimis_hourly_record_t *record) {
+    if (index == NULL || index->data == NULL || record == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    const uint8_t *p = tail_slot(index, station_id, CIMIS_DAILY_RECORD_SIZE);
+    if (p == NULL) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+    return cimis_decode_hourly_record(p, CIMIS_HOURLY_RECORD_SIZE, record);
+}
+
+/* Out-of-core grouped aggregation */
+
+#define AGG_INITIAL_CAPACITY 1024u
+#define AGG_MAX_FANIN 64u
+
+static uint64_t agg_hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+}
+
+static int compare_agg_key(const void *a, const void *b) {
+    uint64_t x = ((const cimis_agg_entry_t *)a)->key;
+    uint64_t y = ((const cimis_agg_entry_t *)b)->key;
+    return (x > y) - (x < y);
+}
+
+static void agg_combine(cimis_agg_entry_t *dst, const cimis_agg_entry_t *src) {
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+cimis_result_t cimis_agg_init(cimis_agg_t *agg, size_t memory_budget, const char *spill_dir) {
+    if (agg == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    memset(agg, 0, sizeof(*agg));
+
+    /* Growing doubles the table while the old one is still live, so the
+     * largest table is the power of two whose growth step fits the budget. */
+    size_t slots = memory_budget / sizeof(cimis_agg_entry_t) * 2 / 3;
+    if (slots < 64) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+    uint32_t cap = 64;
+    while ((size_t)cap * 2 <= slots && cap < (1u << 30)) {
+        cap *= 2;
+    }
+    agg->max_capacity = cap;
+    agg->capacity = cap < AGG_INITIAL_CAPACITY ? cap : AGG_INITIAL_CAPACITY;
+    agg->spill_dir = spill_dir;
+    agg->table = mem_calloc(CIMIS_MEM_AGGREGATE, agg->capacity, sizeof(cimis_agg_entry_t));
+    if (agg->table == NULL) {
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+    return CIMIS_OK;
+}
+
+static cimis_agg_entry_t *agg_slot(cimis_agg_entry_t *table, uint32_t capacity, uint64_t key) {
+    uint32_t mask = capacity - 1;
+    uint32_t i = (uint32_t)agg_hash(key) & mask;
+    while (table[i].count != 0 && table[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return &table[i];
+}
+
+static cimis_result_t agg_grow(cimis_agg_t *agg) {
+    uint32_t capacity = agg->capacity * 2;
+    cimis_agg_entry_t *table = mem_calloc(CIMIS_MEM_AGGREGATE, capacity, sizeof(cimis_agg_entry_t));
+    if (table == NULL) {
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+    for (uint32_t i = 0; i < agg->capacity; i++) {
+        if (agg->table[i].count != 0) {
+            *agg_slot(table, capacity, agg->table[i].key) = agg->table[i];
+        }
+    }
+    mem_free(agg->table);
+    agg->table = table;
+    agg->capacity = capacity;
+    return CIMIS_OK;
+}
+
+/* Move occupied slots to the front and sort them by key */
+static uint32_t agg_sort_table(cimis_agg_t *agg) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < agg->capacity; i++) {
+        if (agg->table[i].count != 0) {
+            agg->table[n++] = agg->table[i];
+        }
+    }
+    qsort(agg->table, n, sizeof(cimis_agg_entry_t), compare_agg_key);
+    return n;
+}
+
+/* Anonymous temporary file: created in dir and unlinked at once */
+static FILE *agg_spill_file(const char *dir) {
+#ifndef _WIN32
+    if (dir == NULL) {
+        dir = getenv("TMPDIR");
+    }
+    if (dir == NULL || dir[0] == '\0') {
+        dir = "/tmp";
+    }
+    char path[4096];
+    if (snprintf(path, sizeof(path), "%s/cimis-agg-XXXXXX", dir) >= (int)sizeof(path)) {
+        return NULL;
+    }
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return NULL;
+    }
+    unlink(path);
+    FILE *f = fdopen(fd, "w+b");
+    if (f == NULL) {
+        close(fd);
+    }
+    return f;
+#else
+    (void)dir;
+    return tmpfile();
+#endif
+}
+
+static cimis_result_t agg_add_run(cimis_agg_t *agg, FILE *run) {
+    if (agg->num_runs == agg->runs_capacity) {
+        uint32_t capacity = agg->runs_capacity ? agg->runs_capacity * 2 : 8;
+        FILE **runs = mem_realloc(CIMIS_MEM_AGGREGATE, agg->runs, capacity * sizeof(FILE *));
+        if (runs == NULL) {
+            return CIMIS_ERR_OUT_OF_MEMORY;
+        }
+        agg->runs = runs;
+        agg->runs_capacity = capacity;
+    }
+    agg->runs[agg->num_runs++] = run;
+    return CIMIS_OK;
+}
+
+typedef struct {
+    cimis_agg_entry_t entry;
+    uint32_t run;
+} agg_heap_item_t;
+
+static void agg_heap_down(agg_heap_item_t *heap, uint32_t n, uint32_t i) {
+    for (;;) {
+        uint32_t l = 2 * i + 1, r = l + 1, m = i;
+        if (l < n && heap[l].entry.key < heap[m].entry.key) m = l;
+        if (r < n && heap[r].entry.key < heap[m].entry.key) m = r;
+        if (m == i) {
+            return;
+        }
+        agg_heap_item_t t = heap[i];
+        heap[i] = heap[m];
+        heap[m] = t;
+        i = m;
+    }
+}
+
+static int agg_write_entry(const cimis_agg_entry_t *entry, void *ctx) {
+    return fwrite(entry, sizeof(*entry), 1, (FILE *)ctx) == 1 ? 0 : -1;
+}
+
+/* K-way merge of sorted runs, combining equal keys across runs. A nonzero
+ * return from emit stops the merge; *stopped reports it. */
+static cimis_result_t agg_merge(FILE **runs, uint32_t n, cimis_agg_emit_fn emit, void *ctx,
+                                uint64_t *emitted, int *stopped) {
+    agg_heap_item_t *heap = mem_alloc(CIMIS_MEM_AGGREGATE, (size_t)n * sizeof(agg_heap_item_t));
+    if (heap == NULL) {
+        return CIMIS_ERR_OUT_OF_MEMORY;
+    }
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (fseek(runs[i], 0, SEEK_SET) != 0) {
+            mem_free(heap);
+            return CIMIS_ERR_IO;
+        }
+        if (fread(&heap[size].entry, sizeof(cimis_agg_entry_t), 1, runs[i]) == 1) {
+            heap[size++].run = i;
+        }
+    }
+    for (uint32_t i = size / 2; i-- > 0;) {
+        agg_heap_down(heap, size, i);
+    }
+
+    cimis_result_t rc = CIMIS_OK;
+    cimis_agg_entry_t acc;
+    int have = 0;
+    *stopped = 0;
+    while (size > 0) {
+        if (have && heap[0].entry.key == acc.key) {
+            agg_combine(&acc, &heap[0].entry);
+        } else {
+            if (have) {
+                (*emitted)++;
+                if (emit(&acc, ctx) != 0) {
+                    *stopped = 1;
+                    have = 0;
+                    break;
+                }
+            }
+            acc = heap[0].entry;
+            have = 1;
+        }
+        FILE *run = runs[heap[0].run];
+        if (fread(&heap[0].entry, sizeof(cimis_agg_entry_t), 1, run) != 1) {
+            if (ferror(run)) {
+                rc = CIMIS_ERR_IO;
+                have = 0;
+                break;
+            }
+            heap[0] = heap[--size];
+        }
+        agg_heap_down(heap, size, 0);
+    }
+    if (have) {
+        (*emitted)++;
+        *stopped = emit(&acc, ctx) != 0;
+    }
+    mem_free(heap);
+    return rc;
+}
+
+/* Merge all current runs into one so open spill files stay bounded */
+static cimis_result_t agg_fold_runs(cimis_agg_t *agg) {
+    FILE *out = agg_spill_file(agg->spill_dir);
+    if (out == NULL) {
+        return CIMIS_ERR_IO;
+    }
+    uint64_t written = 0;
+    int stopped = 0;
+    cimis_result_t rc = agg_merge(agg->runs, agg->num_runs, agg_write_entry, out, &written, &stopped);
+    if (rc == CIMIS_OK && (stopped || fflush(out) != 0)) {
+        rc = CIMIS_ERR_IO;
+    }
+    if (rc != CIMIS_OK) {
+        fclose(out);
+        return rc;
+    }
+    for (uint32_t i = 0; i < agg->num_runs; i++) {
+        fclose(agg->runs[i]);
+    }
+    agg->runs[0] = out;
+    agg->num_runs = 1;
+    agg->spill_bytes += written * sizeof(cimis_agg_entry_t);
+    return CIMIS_OK;
+}
+
+/* Write the table out as one sorted run and empty it */
+static cimis_result_t agg_spill(cimis_agg_t *agg) {
+    uint32_t n = agg_sort_table(agg);
+    FILE *run = agg_spill_file(agg->spill_dir);
+    if (run == NULL) {
+        return CIMIS_ERR_IO;
+    }
+    if (fwrite(agg->table, sizeof(cimis_agg_entry_t), n, run) != n || fflush(run) != 0) {
+        fclose(run);
+        return CIMIS_ERR_IO;
+    }
+    cimis_result_t rc = agg_add_run(agg, run);
+    if (rc != CIMIS_OK) {
+        fclose(run);
+        return rc;
+    }
+    agg->spill_bytes += (uint64_t)n * sizeof(cimis_agg_entry_t);
+    memset(agg->table, 0, (size_t)agg->capacity * sizeof(cimis_agg_entry_t));
+    agg->size = 0;
+    return agg->num_runs >= AGG_MAX_FANIN ? agg_fold_runs(agg) : CIMIS_OK;
+}
+
+cimis_result_t cimis_agg_add(cimis_agg_t *agg, uint64_t key, float value) {
+    if (agg == NULL || agg->table == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    if (isnan(value)) {
+        return CIMIS_OK;
+    }
+    agg->rows_in++;
+
+    cimis_agg_entry_t *e = agg_slot(agg->table, agg->capacity, key);
+    if (e->count == 0) {
+        /* New group: make room first if the table is at its load limit */
+        if ((uint64_t)(agg->size + 1) * 10 > (uint64_t)agg->capacity * 7) {
+            cimis_result_t rc = agg->capacity < agg->max_capacity ? agg_grow(agg) : agg_spill(agg);
+            if (rc != CIMIS_OK) {
+                return rc;
+            }
+            e = agg_slot(agg->table, agg->capacity, key);
+        }
+        e->key = key;
+        e->min = value;
+        e->max = value;
+        agg->size++;
+    }
+    e->count++;
+    e->sum += value;
+    if (value < e->min) e->min = value;
+    if (value > e->max) e->max = value;
+    return CIMIS_OK;
+}
+
+uint64_t cimis_agg_key_station_month_hour(uint16_t station_id, uint32_t hours_since_epoch) {
+    uint16_t slot = cimis_day_slot(hours_since_epoch / 24);
+    uint32_t month = 1;
+    while (month < 12 && cumulative_days[1][month] <= slot) {
+        month++;
+    }
+    return ((uint64_t)station_id << 16) | (month << 8) | (hours_since_epoch % 24);
+}
+
+cimis_result_t cimis_agg_add_hourly(cimis_agg_t *agg, const cimis_hourly_record_t *records,
+                                    uint32_t count, cimis_field_t field) {
+    if (agg == NULL || (records == NULL && count > 0)) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t key = cimis_agg_key_station_month_hour(records[i].station_id, records[i].timestamp);
+        cimis_result_t rc = cimis_agg_add(agg, key, cimis_hourly_field_value(&records[i], field));
+        if (rc != CIMIS_OK) {
+            return rc;
+        }
+    }
+    return CIMIS_OK;
+}
+
+cimis_result_t cimis_agg_finish(cimis_agg_t *agg, cimis_agg_emit_fn emit, void *ctx) {
+    if (agg == NULL || agg->table == NULL || emit == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+
+    if (agg->num_runs == 0) {
+        uint32_t n = agg_sort_table(agg);
+        for (uint32_t i = 0; i < n; i++) {
+            agg->groups_out++;
+            if (emit(&agg->table[i], ctx) != 0) {
+                break;
+            }
+        }
+        mem_free(agg->table);
+        agg->table = NULL;
+        agg->size = 0;
+        return CIMIS_OK;
+    }
+
+    cimis_result_t rc = agg->size > 0 ? agg_spill(agg) : CIMIS_OK;
+    if (rc != CIMIS_OK) {
+        return rc;
+    }
+    /* The merge streams from disk; give the table's memory back first */
+    mem_free(agg->table);
+    agg->table = NULL;
+
+    int stopped = 0;
+    return agg_merge(agg->runs, agg->num_runs, emit, ctx, &agg->groups_out, &stopped);
+}
+
+void cimis_agg_free(cimis_agg_t *agg) {
+    if (agg == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < agg->num_runs; i++) {
+        fclose(agg->runs[i]);
+    }
+    mem_free(agg->runs);
+    mem_free(agg->table);
+    memset(agg, 0, sizeof(*agg));
+}
+
+/* Hourly column codecs */
+
+/* Wind direction is stored as degrees / 2, so the circle is 180 units */
+#define WIND_DIR_CIRCLE 180
+#define WIND_DIR_ESCAPE 0xF
+
+static size_t put_uvarint(uint8_t *p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static size_t uvarint_size(uint32_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static bool get_uvarint(const uint8_t **p, const uint8_t *end, uint32_t *v) {
+    uint32_t x = 0;
+    for (int shift = 0; shift < 35 && *p < end; shift += 7) {
+        uint8_t b = *(*p)++;
+        x |= (uint32_t)(b & 0x7F) << shift;
+        if (b < 0x80) {
+            *v = x;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t zigzag32(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag32(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static size_t codec_write_header(uint8_t *buffer, cimis_codec_t codec, uint32_t count) {
+    buffer[0] = (uint8_t)codec;
+    write_le32(buffer + 1, count);
+    return CIMIS_CODEC_HEADER_SIZE;
+}
+
+/* Check a block's header against the expected codec and the caller's array */
+static cimis_result_t codec_open(const uint8_t *buffer, size_t buffer_size, cimis_codec_t want,
+                                 uint32_t capacity, uint32_t *count) {
+    cimis_codec_t codec;
+    cimis_result_t rc = cimis_codec_block_info(buffer, buffer_size, &codec, count);
+    if (rc != CIMIS_OK) {
+        return rc;
+    }
+    if (codec != want) {
+        return CIMIS_ERR_BAD_FORMAT;
+    }
+    return *count > capacity ? CIMIS_ERR_BUFFER_TOO_SMALL : CIMIS_OK;
+}
+
+cimis_result_t cimis_codec_block_info(const uint8_t *buffer, size_t buffer_size,
+                                      cimis_codec_t *codec, uint32_t *count) {
+    if (buffer == NULL || codec == NULL || count == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    if (buffer_size < CIMIS_CODEC_HEADER_SIZE) {
+        return CIMIS_ERR_BAD_FORMAT;
+    }
+    *codec = (cimis_codec_t)buffer[0];
+    *count = read_le32(buffer + 1);
+    return CIMIS_OK;
+}
+
+size_t cimis_solar_encode_bound(uint32_t count) {
+    /* A one-hour night and day run costs 2 header bytes and a 3-byte delta */
+    return CIMIS_CODEC_HEADER_SIZE + 10 + (size_t)count * 4;
+}
+
+size_t cimis_solar_encode(const uint16_t *values, uint32_t count, uint8_t *buffer, size_t buffer_size) {
+    if ((values == NULL && count > 0) || buffer == NULL || buffer_size < cimis_solar_encode_bound(count)) {
+        return 0;
+    }
+    size_t n = codec_write_header(buffer, CIMIS_CODEC_SOLAR, count);
+    uint32_t i = 0;
+    while (i < count) {
+        uint32_t night = i;
+        while (i < count && values[i] == 0) {
+            i++;
+        }
+        uint32_t day = i;
+        while (i < count && values[i] != 0) {
+            i++;
+        }
+        n += put_uvarint(buffer + n, day - night);
+        n += put_uvarint(buffer + n, i - day);
+        /* Each day starts from zero; the first delta is the sunrise value */
+        int32_t prev = 0;
+        for (uint32_t j = day; j < i; j++) {
+            n += put_uvarint(buffer + n, zigzag32((int32_t)values[j] - prev));
+            prev = values[j];
+        }
+    }
+    return n;
+}
+
+cimis_result_t cimis_solar_decode(const uint8_t *buffer, size_t buffer_size,
+                                  uint16_t *values, uint32_t capacity, uint32_t *count) {
+    if (values == NULL && capacity > 0) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    cimis_result_t rc = codec_open(buffer, buffer_size, CIMIS_CODEC_SOLAR, capacity, count);
+    if (rc != CIMIS_OK) {
+        return rc;
+    }
+    const uint8_t *p = buffer + CIMIS_CODEC_HEADER_SIZE, *end = buffer + buffer_size;
+    uint32_t i = 0;
+    while (i < *count) {
+        uint32_t night, day;
+        if (!get_uvarint(&p, end, &night) || !get_uvarint(&p, end, &day) ||
+            night > *count - i || day > *count - i - night) {
+            return CIMIS_ERR_BAD_FORMAT;
+        }
+        memset(values + i, 0, (size_t)night * sizeof(uint16_t));
+        i += night;
+        int32_t prev = 0;
+        for (uint32_t stop = i + day; i < stop; i++) {
+            uint32_t z;
+            if (!get_uvarint(&p, end, &z)) {
+                return CIMIS_ERR_BAD_FORMAT;
+            }
+            prev += unzigzag32(z);
+            values[i] = (uint16_t)prev;
+        }
+    }
+    return CIMIS_OK;
+}
+
+size_t cimis_wind_dir_encode_bound(uint32_t count) {
+    /* An escaped value is three nibbles */
+    return CIMIS_CODEC_HEADER_SIZE + ((size_t)count * 3 + 1) / 2;
+}
+
+size_t cimis_wind_dir_encode(const uint8_t *values, uint32_t count, uint8_t *buffer, size_t buffer_size) {
+    if ((values == NULL && count > 0) || buffer == NULL || buffer_size < cimis_wind_dir_encode_bound(count)) {
+        return 0;
+    }
+    size_t n = codec_write_header(buffer, CIMIS_CODEC_WIND_DIR, count);
+    uint8_t *out = buffer + n;
+    size_t nibbles = 0;
+#define PUT_NIBBLE(x)                                                   \
+    do {                                                                \
+        if (nibbles & 1) out[nibbles >> 1] |= (uint8_t)((x) << 4);      \
+        else out[nibbles >> 1] = (uint8_t)(x);                          \
+        nibbles++;                                                      \
+    } while (0)
+
+    uint8_t prev = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t v = values[i];
+        if (v < WIND_DIR_CIRCLE && prev < WIND_DIR_CIRCLE) {
+            /* Shortest way round: [-90, 89] */
+            int d = ((int)v - prev + WIND_DIR_CIRCLE + WIND_DIR_CIRCLE / 2) % WIND_DIR_CIRCLE - WIND_DIR_CIRCLE / 2;
+            if (d >= -7 && d <= 7) {
+                PUT_NIBBLE(zigzag32(d));
+                prev = v;
+                continue;
+            }
+        }
+        PUT_NIBBLE(WIND_DIR_ESCAPE);
+        PUT_NIBBLE(v & 0xF);
+        PUT_NIBBLE(v >> 4);
+        prev = v;
+    }
+#undef PUT_NIBBLE
+    return n + (nibbles + 1) / 2;
+}
+
+cimis_result_t cimis_wind_dir_decode(const uint8_t *buffer, size_t buffer_size,
+                                     uint8_t *values, uint32_t capacity, uint32_t *count) {
+    if (values == NULL && capacity > 0) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    cimis_result_t rc = codec_open(buffer, buffer_size, CIMIS_CODEC_WIND_DIR, capacity, count);
+    if (rc != CIMIS_OK) {
+        return rc;
+    }
+    const uint8_t *in = buffer + CIMIS_CODEC_HEADER_SIZE;
+    size_t limit = (buffer_size - CIMIS_CODEC_HEADER_SIZE) * 2;
+    size_t nibbles = 0;
+#define GET_NIBBLE() ((in[nibbles >> 1] >> ((nibbles & 1) * 4)) & 0xF)
+
+    int prev = 0;
+    for (uint32_t i = 0; i < *count; i++) {
+        if (nibbles >= limit) {
+            return CIMIS_ERR_BAD_FORMAT;
+        }
+        unsigned x = GET_NIBBLE();
+        nibbles++;
+        if (x == WIND_DIR_ESCAPE) {
+            if (limit - nibbles < 2) {
+                return CIMIS_ERR_BAD_FORMAT;
+            }
+            prev = GET_NIBBLE();
+            nibbles++;
+            prev |= GET_NIBBLE() << 4;
+            nibbles++;
+        } else {
+            prev += unzigzag32(x);
+            if (prev < 0) {
+                prev += WIND_DIR_CIRCLE;
+            } else if (prev >= WIND_DIR_CIRCLE) {
+                prev -= WIND_DIR_CIRCLE;
+            }
+        }
+        values[i] = (uint8_t)prev;
+    }
+#undef GET_NIBBLE
+    return CIMIS_OK;
+}
+
+/* Sparse columns */
+
+#define SPARSE_HEADER_SIZE (CIMIS_CODEC_HEADER_SIZE + 8)
+
+size_t cimis_sparse_encode_bound(uint32_t count) {
+    /* Every value non-zero: a 1-byte gap and a 3-byte varint each */
+    return SPARSE_HEADER_SIZE + (size_t)count * 4;
+}
+
+size_t cimis_sparse_encode(const uint16_t *values, uint32_t count, uint8_t *buffer, size_t buffer_size) {
+    if ((values == NULL && count > 0) || buffer == NULL || buffer_size < cimis_sparse_encode_bound(count)) {
+        return 0;
+    }
+    codec_write_header(buffer, CIMIS_CODEC_SPARSE, count);
+
+    /* First pass sizes the position section so values can follow it */
+    uint32_t nonzero = 0;
+    size_t gap_bytes = 0;
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (values[i] != 0) {
+            gap_bytes += uvarint_size(i - next);
+            nonzero++;
+            next = i + 1;
+        }
+    }
+    uint8_t *gaps = buffer + SPARSE_HEADER_SIZE;
+    uint8_t *vals = gaps + gap_bytes;
+    size_t val_bytes = 0;
+    next = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (values[i] != 0) {
+            gaps += put_uvarint(gaps, i - next);
+            val_bytes += put_uvarint(vals + val_bytes, values[i]);
+            next = i + 1;
+        }
+    }
+    write_le32(buffer + CIMIS_CODEC_HEADER_SIZE, nonzero);
+    write_le32(buffer + CIMIS_CODEC_HEADER_SIZE + 4, (uint32_t)gap_bytes);
+    return SPARSE_HEADER_SIZE + gap_bytes + val_bytes;
+}
+
+/* Validate the sparse header and locate the position and value sections */
+static cimis_result_t sparse_open(const uint8_t *buffer, size_t buffer_size, uint32_t *count,
+                                  uint32_t *nonzero, const uint8_t **gaps, const uint8_t **vals) {
+    cimis_codec_t codec;
+    cimis_result_t rc = cimis_codec_block_info(buffer, buffer_size, &codec, count);
+    if (rc != CIMIS_OK) {
+        return rc;
+    }
+    if (codec != CIMIS_CODEC_SPARSE || buffer_size < SPARSE_HEADER_SIZE) {
+        return CIMIS_ERR_BAD_FORMAT;
+    }
+    *nonzero = read_le32(buffer + CIMIS_CODEC_HEADER_SIZE);
+    uint32_t gap_bytes = read_le32(buffer + CIMIS_CODEC_HEADER_SIZE + 4);
+    if (*nonzero > *count || gap_bytes > buffer_size - SPARSE_HEADER_SIZE) {
+        return CIMIS_ERR_BAD_FORMAT;
+    }
+    *gaps = buffer + SPARSE_HEADER_SIZE;
+    *vals = *gaps + gap_bytes;
+    return CIMIS_OK;
+}
+
+cimis_result_t cimis_sparse_decode(const uint8_t *buffer, size_t buffer_size,
+                                   uint16_t *values, uint32_t capacity, uint32_t *count) {
+    if (buffer == NULL || count == NULL || (values == NULL && capacity > 0)) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    uint32_t nonzero;
+    const uint8_t *gaps, *vals;
+    cimis_result_t rc = sparse_open(buffer, buffer_size, count, &nonzero, &gaps, &vals);
+    if (rc != CIMIS_OK) {
+        return rc;
+    }
+    if (*count > capacity) {
+        return CIMIS_ERR_BUFFER_TOO_SMALL;
+    }
+    memset(values, 0, (size_t)*count * sizeof(uint16_t));
+    const uint8_t *end = buffer + buffer_size;
+    uint32_t pos = 0;
+    for (uint32_t k = 0; k < nonzero; k++) {
+        uint32_t gap, v;
+        if (!get_uvarint(&gaps, vals, &gap) || !get_uvarint(&vals, end, &v) ||
+            gap >= *count - pos || v == 0 || v > UINT16_MAX) {
+            return CIMIS_ERR_BAD_FORMAT;
+        }
+        pos += gap;
+        values[pos++] = (uint16_t)v;
+    }
+    return CIMIS_OK;
+}
+
+cimis_result_t cimis_sparse_sum(const uint8_t *buffer, size_t buffer_size, uint32_t begin, uint32_t end,
+                                uint64_t *sum, uint32_t *nonzero) {
+    if (buffer == NULL || sum == NULL || nonzero == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    uint32_t count, total;
+    const uint8_t *gaps, *vals;
+    cimis_result_t rc = sparse_open(buffer, buffer_size, &count, &total, &gaps, &vals);
+    if (rc != CIMIS_OK) {
+        return rc;
+    }
+    const uint8_t *buf_end = buffer + buffer_size;
+    bool whole = begin == 0 && end >= count;
+    *sum = 0;
+    *nonzero = 0;
+
+    if (whole) {
+        /* Most rainfall values fit one varint byte */
+        uint64_t acc = 0;
+        for (uint32_t k = 0; k < total; k++) {
+            uint32_t v;
+            if (vals < buf_end && *vals < 0x80) {
+                acc += *vals++;
+            } else if (get_uvarint(&vals, buf_end, &v)) {
+                acc += v;
+            } else {
+                return CIMIS_ERR_BAD_FORMAT;
+            }
+        }
+        *sum = acc;
+        *nonzero = total;
+        return CIMIS_OK;
+    }
+
+    uint32_t pos = 0;
+    for (uint32_t k = 0; k < total; k++) {
+        uint32_t gap, v;
+        if (!get_uvarint(&gaps, vals, &gap) || gap >= count - pos) {
+            return CIMIS_ERR_BAD_FORMAT;
+        }
+        pos += gap;
+        if (pos >= end) {
+            break;
+        }
+        if (!get_uvarint(&vals, buf_end, &v)) {
+            return CIMIS_ERR_BAD_FORMAT;
+        }
+        if (pos >= begin) {
+            *sum += v;
+            (*nonzero)++;
+        }
+        pos++;
+    }
+    return CIMIS_OK;
+}
+
+/* Range index */
+
+static size_t range_record_size(const cimis_range_index_t *index) {
+    return index->is_hourly ? CIMIS_HOURLY_RECORD_SIZE : CIMIS_DAILY_RECORD_SIZE;
+}
+
+static const field_layout_t *range_layout(const cimis_range_index_t *index, cimis_field_t field) {
+    return index->is_hourly ? &hourly_field_layout[field] : &daily_field_layout[field];
+}
+
+/* Fixed-point value of a field in an encoded record */
+static int32_t field_fixed(const uint8_t *record, const field_layout_t *layout) {
+    const uint8_t *p = record + layout->offset;
+    switch (layout->kind) {
+    case FIELD_I16:
+        return (int16_t)read_le16(p);
+    case FIELD_U16:
+        return read_le16(p);
+    default:
+        return p[0];
+    }
+}
+
+/* Exact physical value of a fixed-point total; the float scales are not
+ * exact reciprocals of the decimal divisors. */
+static double fixed_to_double(int64_t v, const field_layout_t *layout) {
+    if (layout->scale < 1.0f) {
+        return (double)v / nearbyint(1.0 / layout->scale);
+    }
+    return (double)v * layout->scale;
+}
+
+static int64_t range_scan_sum(const cimis_range_index_t *index, const field_layout_t *layout,
+                              uint32_t from, uint32_t to) {
+    size_t size = range_record_size(index);
+    int64_t sum = 0;
+    for (uint32_t i = from; i < to; i++) {
+        sum += field_fixed(index->records + (size_t)i * size, layout);
+    }
+    return sum;
+}
+
+/* First record whose timestamp is >= ts */
+static uint32_t range_lower_bound(const cimis_range_index_t *index, uint32_t ts) {
+    size_t size = range_record_size(index);
+    uint32_t lo = 0, hi = index->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (read_le32(index->records + (size_t)mid * size) < ts) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void range_window(const cimis_range_index_t *index, uint32_t start, uint32_t end,
+                         uint32_t *lo, uint32_t *hi) {
+    *lo = range_lower_bound(index, start);
+    *hi = end > start ? range_lower_bound(index, end) : *lo;
+}
+
+cimis_result_t cimis_range_index_build(cimis_range_index_t *index, const uint8_t *buffer, size_t buffer_size,
+                                       bool is_hourly, uint32_t field_mask) {
+    if (index == NULL || buffer == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    memset(index, 0, sizeof(*index));
+    size_t size = is_hourly ? CIMIS_HOURLY_RECORD_SIZE : CIMIS_DAILY_RECORD_SIZE;
+    uint32_t num_fields = is_hourly ? CIMIS_HOURLY_FIELD_COUNT : CIMIS_DAILY_FIELD_COUNT;
+    if (buffer_size % size != 0 || buffer_size / size > UINT32_MAX) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+    if (field_mask == 0) {
+        field_mask = 1u << CIMIS_FIELD_ET;
+        if (is_hourly) {
+            field_mask |= 1u << CIMIS_FIELD_PRECIPITATION;
+        }
+    }
+    if (field_mask >> num_fields != 0) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+
+    index->records = buffer;
+    index->count = (uint32_t)(buffer_size / size);
+    index->is_hourly = is_hourly;
+    index->field_mask = field_mask;
+    index->num_blocks = index->count / CIMIS_RANGE_BLOCK;
+
+    for (uint32_t f = 0; f < num_fields; f++) {
+        if (!(field_mask & (1u << f))) {
+            continue;
+        }
+        int64_t *prefix = mem_alloc(CIMIS_MEM_RANGE_INDEX, ((size_t)index->num_blocks + 1) * sizeof(int64_t));
+        if (prefix == NULL) {
+            cimis_range_index_free(index);
+            return CIMIS_ERR_OUT_OF_MEMORY;
+        }
+        const field_layout_t *layout = range_layout(index, (cimis_field_t)f);
+        prefix[0] = 0;
+        for (uint32_t b = 0; b < index->num_blocks; b++) {
+            prefix[b + 1] = prefix[b] + range_scan_sum(index, layout, b * CIMIS_RANGE_BLOCK,
+                                                       (b + 1) * CIMIS_RANGE_BLOCK);
+        }
+        index->prefix[f] = prefix;
+    }
+    return CIMIS_OK;
+}
+
+void cimis_range_index_free(cimis_range_index_t *index) {
+    if (index == NULL) {
+        return;
+    }
+    for (uint32_t f = 0; f < CIMIS_HOURLY_FIELD_COUNT; f++) {
+        mem_free(index->prefix[f]);
+        mem_free(index->min_table[f]);
+        mem_free(index->max_table[f]);
+    }
+    memset(index, 0, sizeof(*index));
+}
+
+cimis_result_t cimis_range_sum(const cimis_range_index_t *index, cimis_field_t field,
+                               uint32_t start, uint32_t end, double *sum, uint32_t *count) {
+    if (index == NULL || sum == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    if ((unsigned)field >= CIMIS_HOURLY_FIELD_COUNT || index->prefix[field] == NULL) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+    const field_layout_t *layout = range_layout(index, field);
+    uint32_t lo, hi;
+    range_window(index, start, end, &lo, &hi);
+
+    /* Whole blocks come from the prefix totals, the ragged edges from a scan */
+    uint32_t first_block = (lo + CIMIS_RANGE_BLOCK - 1) / CIMIS_RANGE_BLOCK;
+    uint32_t last_block = hi / CIMIS_RANGE_BLOCK;
+    int64_t total;
+    if (first_block < last_block) {
+        const int64_t *prefix = index->prefix[field];
+        total = range_scan_sum(index, layout, lo, first_block * CIMIS_RANGE_BLOCK) +
+                prefix[last_block] - prefix[first_block] +
+                range_scan_sum(index, layout, last_block * CIMIS_RANGE_BLOCK, hi);
+    } else {
+        total = range_scan_sum(index, layout, lo, hi);
+    }
+
+    *sum = fixed_to_double(total, layout);
+    if (count != NULL) {
+        *count = hi - lo;
+    }
+    return CIMIS_OK;
+}
+
+static uint32_t floor_log2(uint32_t v) {
+    uint32_t k = 0;
+    while (v >>= 1) {
+        k++;
+    }
+    return k;
+}
+
+static void range_scan_extremes(const cimis_range_index_t *index, const field_layout_t *layout,
+                                uint32_t from, uint32_t to, int32_t *lo, int32_t *hi) {
+    size_t size = range_record_size(index);
+    for (uint32_t i = from; i < to; i++) {
+        int32_t v = field_fixed(index->records + (size_t)i * size, layout);
+        if (v < *lo) *lo = v;
+        if (v > *hi) *hi = v;
+    }
+}
+
+cimis_result_t cimis_range_index_add_extremes(cimis_range_index_t *index, uint32_t field_mask) {
+    if (index == NULL || index->records == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    uint32_t num_fields = index->is_hourly ? CIMIS_HOURLY_FIELD_COUNT : CIMIS_DAILY_FIELD_COUNT;
+    if (field_mask == 0) {
+        field_mask = 1u << CIMIS_FIELD_TEMPERATURE;
+    }
+    if (field_mask >> num_fields != 0) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+
+    uint32_t nb = index->num_blocks;
+    uint32_t levels = nb > 0 ? floor_log2(nb) + 1 : 0;
+    for (uint32_t f = 0; f < num_fields; f++) {
+        if (!(field_mask & (1u << f)) || index->min_table[f] != NULL) {
+            continue;
+        }
+        /* + 1 keeps malloc from returning NULL for a chunk under one block */
+        int32_t *mins = mem_alloc(CIMIS_MEM_RANGE_INDEX, (size_t)levels * nb * sizeof(int32_t) + 1);
+        int32_t *maxs = mem_alloc(CIMIS_MEM_RANGE_INDEX, (size_t)levels * nb * sizeof(int32_t) + 1);
+        if (mins == NULL || maxs == NULL) {
+            mem_free(mins);
+            mem_free(maxs);
+            return CIMIS_ERR_OUT_OF_MEMORY;
+        }
+        const field_layout_t *layout = range_layout(index, (cimis_field_t)f);
+        for (uint32_t b = 0; b < nb; b++) {
+            mins[b] = INT32_MAX;
+            maxs[b] = INT32_MIN;
+            range_scan_extremes(index, layout, b * CIMIS_RANGE_BLOCK, (b + 1) * CIMIS_RANGE_BLOCK,
+                                &mins[b], &maxs[b]);
+        }
+        /* Level k covers 2^k blocks as two overlapping halves of level k-1 */
+        for (uint32_t k = 1; k < levels; k++) {
+            const int32_t *pmin = mins + (size_t)(k - 1) * nb, *pmax = maxs + (size_t)(k - 1) * nb;
+            int32_t *cmin = mins + (size_t)k * nb, *cmax = maxs + (size_t)k * nb;
+            uint32_t half = 1u << (k - 1);
+            for (uint32_t b = 0; b + 2 * half <= nb; b++) {
+                cmin[b] = pmin[b] < pmin[b + half] ? pmin[b] : pmin[b + half];
+                cmax[b] = pmax[b] > pmax[b + half] ? pmax[b] : pmax[b + half];
+            }
+        }
+        index->min_table[f] = mins;
+        index->max_table[f] = maxs;
+        index->extreme_mask |= 1u << f;
+    }
+    index->num_levels = levels;
+    return CIMIS_OK;
+}
+
+cimis_result_t cimis_range_extremes(const cimis_range_index_t *index, cimis_field_t field,
+                                    uint32_t start, uint32_t end, float *min, float *max, uint32_t *count) {
+    if (index == NULL || min == NULL || max == NULL) {
+        return CIMIS_ERR_NULL_PTR;
+    }
+    if ((unsigned)field >= CIMIS_HOURLY_FIELD_COUNT || index->min_table[field] == NULL) {
+        return CIMIS_ERR_INVALID_SIZE;
+    }
+    const field_layout_t *layout = range_layout(index, field);
+    uint32_t lo, hi;
+    range_window(index, start, end, &lo, &hi);
+    if (count != NULL) {
+        *count = hi - lo;
+    }
+    if (lo == hi) {
+        *min = NAN;
+        *max = NAN;
+        return CIMIS_OK;
+    }
+
+    int32_t vmin = INT32_MAX, vmax = INT32_MIN;
+    uint32_t first_block = (lo + CIMIS_RANGE_BLOCK - 1) / CIMIS_RANGE_BLOCK;
+    uint32_t last_block = hi / CIMIS_RANGE_BLOCK;
+    if (first_block < last_block) {
+        uint32_t k = floor_log2(last_block - first_block);
+        size_t row = (size_t)k * index->num_blocks;
+        uint32_t other = last_block - (1u << k);
+        const int32_t *mins = index->min_table[field] + row, *maxs = index->max_table[field] + row;
+        vmin = mins[first_block] < mins[other] ? mins[first_block] : mins[other];
+        vmax = maxs[first_block] > maxs[other] ? maxs[first_block] : maxs[other];
+        range_scan_extremes(index, layout, lo, first_block * CIMIS_RANGE_BLOCK, &vmin, &vmax);
+        range_scan_extremes(index, layout, last_block * CIMIS_RANGE_BLOCK, hi, &vmin, &vmax);
+    } else {
+        range_scan_extremes(index, layout, lo, hi, &vmin, &vmax);
+    }
+
+    *min = (float)fixed_to_double(vmin, layout);
+    *max = (float)fixed_to_double(vmax, layout);
+    return CIMIS_OK;
+}
+
+/* HDR latency histogram */
+
+#define HDR_SUB_COUNT (1u << CIMIS_HDR_SUB_BITS)
+#define HDR_HALF_COUNT (HDR_SUB_COUNT / 2)
+#define HDR_MAX_VALUE ((UINT64_C(1) << CIMIS_HDR_MAX_BITS) - 1)
+
+static uint32_t hdr_index(uint64_t v) {
+    if (v < HDR_SUB_COUNT) {
+        return (uint32_t)v;
+    }
+    uint32_t bits = 64 - (uint32_t)__builtin_clzll(v);
+    uint32_t shift = bits - CIMIS_HDR_SUB_BITS;
+    return HDR_SUB_COUNT + (shift - 1) * HDR_HALF_COUNT + (uint32_t)(v >> shift) - HDR_HALF_COUNT;
+}
+
+/* Midpoint of the values that map to bucket i */
+static uint64_t hdr_value(uint32_t i) {
+    if (i < HDR_SUB_COUNT) {
+        return i;
+    }
+    uint32_t shift = (i - HDR_SUB_COUNT) / HDR_HALF_COUNT + 1;
+    uint64_t mantissa = (i - HDR_SUB_COUNT) % HDR_HALF_COUNT + HDR_HALF_COUNT;
+    return (mantissa << shift) + ((UINT64_C(1) << shift) >> 1);
+}
+
+void cimis_hdr_init(cimis_hdr_t *hist) {
+    if (hist == NULL) {
+        return;
+    }
+    memset(hist, 0, sizeof(*hist));
+    hist->min = UINT64_MAX;
+}
+
+void cimis_hdr_record_n(cimis_hdr_t *hist, uint64_t value, uint64_t n) {
+    if (hist == NULL || n == 0) {
+        return;
+    }
+    if (value > HDR_MAX_VALUE) {
+        value = HDR_MAX_VALUE;
+    }
+    hist->counts[hdr_index(value)] += n;
+    hist->total += n;
+    hist->sum += (double)value * (double)n;
+    if (value < hist->min) hist->min = value;
+    if (value > hist->max) hist->max = value;
+}
+
+void cimis_hdr_record(cimis_hdr_t *hist, uint64_t value) {
+    cimis_hdr_record_n(hist, value, 1);
+}
+
+void cimis_hdr_merge(cimis_hdr_t *dst, const cimis_hdr_t *src) {
+    if (dst == NULL || src == NULL || src->total == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < CIMIS_HDR_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+uint64_t cimis_hdr_quantile(const cimis_hdr_t *hist, double q) {
+    if (hist == NULL || hist->total == 0) {
+        return 0;
+    }
+    if (q <= 0) {
+        return hist->min;
+    }
+    if (q >= 1) {
+        return hist->max;
+    }
+    uint64_t rank = (uint64_t)ceil(q * (double)hist->total);
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < CIMIS_HDR_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            uint64_t v = hdr_value(i);
+            if (v < hist->min) v = hist->min;
+            if (v > hist->max) v = hist->max;
+            return v;
+        }
+    }
+    return hist->max;
+}
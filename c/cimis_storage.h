@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -114,7 +115,10 @@ typedef enum {
     CIMIS_ERR_INVALID_SIZE = -2,
     CIMIS_ERR_BUFFER_TOO_SMALL = -3,
     CIMIS_ERR_OUT_OF_MEMORY = -4,
-    CIMIS_ERR_INVALID_TIMESTAMP = -5
+    CIMIS_ERR_INVALID_TIMESTAMP = -5,
+    CIMIS_ERR_IO = -6,
+    CIMIS_ERR_BAD_FORMAT = -7,
+    CIMIS_ERR_BUSY = -8
 } cimis_result_t;
 
 /* Function Prototypes */
@@ -189,6 +193,17 @@ uint32_t cimis_date_to_days_since_epoch(int year, int month, int day);
 void cimis_days_since_epoch_to_date(uint32_t days, int *year, int *month, int *day);
 uint32_t cimis_datetime_to_hours_since_epoch(int year, int month, int day, int hour);
 
+/* Batch timestamp parsing for API strings laid out every stride bytes.
+ * Dates are "YYYY-MM-DD" (stride >= 10); hours are "HH00" or "HH:00", 0-24,
+ * where 2400 is midnight at the end of the day as the CIMIS API reports it.
+ * valid (optional) gets 1 or 0 per entry; invalid entries are written as 0.
+ * Both return the number of valid entries. */
+size_t cimis_parse_dates_batch(const char *dates, size_t stride, size_t count,
+                               uint32_t *days_out, uint8_t *valid);
+size_t cimis_parse_datetimes_batch(const char *dates, size_t date_stride,
+                                   const char *hours, size_t hour_stride, size_t count,
+                                   uint32_t *hours_out, uint8_t *valid);
+
 /* Record encoding/decoding */
 cimis_result_t cimis_encode_daily_record(const cimis_daily_record_t *record, uint8_t *buffer, size_t buffer_size);
 cimis_result_t cimis_decode_daily_record(const uint8_t *buffer, size_t buffer_size, cimis_daily_record_t *record);
@@ -214,6 +229,7 @@ typedef struct {
     size_t current_offset;
     uint32_t record_count;
     bool is_hourly;
+    int32_t stride;           /* Records advanced per step; negative walks backward */
 } cimis_record_iterator_t;
 
 cimis_result_t cimis_iterator_init(cimis_record_iterator_t *iter, const uint8_t *buffer, size_t buffer_size, bool is_hourly);
@@ -221,6 +237,32 @@ bool cimis_iterator_has_next(const cimis_record_iterator_t *iter);
 cimis_result_t cimis_iterator_next_daily(cimis_record_iterator_t *iter, cimis_daily_record_t *record);
 cimis_result_t cimis_iterator_next_hourly(cimis_record_iterator_t *iter, cimis_hourly_record_t *record);
 
+/* Batch iteration: decode up to max_count records per call into records, which
+ * is a cimis_daily_record_t or cimis_hourly_record_t array matching the
+ * iterator. Returns the number decoded, 0 once the buffer is exhausted. */
+uint32_t cimis_iterator_next_batch(cimis_record_iterator_t *iter, void *records, uint32_t max_count);
+
+/* Zero-copy variant: point *span at up to max_count encoded records inside the
+ * iterator's buffer and advance past them. Returns the record count. */
+uint32_t cimis_iterator_next_span(cimis_record_iterator_t *iter, uint32_t max_count, const uint8_t **span);
+
+/* Traversal modes; every next_* call honors them and decodes only the records
+ * it returns. A positive stride yields every stride-th record forward from the
+ * current position. A negative stride restarts at the last whole record and
+ * walks backward (-1 gives latest-first). Spans need stride 1 and return 0
+ * otherwise. */
+cimis_result_t cimis_iterator_set_stride(cimis_record_iterator_t *iter, int32_t stride);
+
+/* Systematic sample: evenly spaced forward stride yielding at most target
+ * records, anchored so the last record is always included */
+cimis_result_t cimis_iterator_set_sample(cimis_record_iterator_t *iter, uint32_t target);
+
+uint32_t cimis_iterator_remaining(const cimis_record_iterator_t *iter);
+
+/* Uniform random sample of up to k of the remaining records (reservoir
+ * Algorithm L), written in traversal order. Consumes the iterator. */
+uint32_t cimis_iterator_sample(cimis_record_iterator_t *iter, uint32_t k, uint64_t seed, void *records);
+
 /* Statistics calculation */
 typedef struct {
     float min_temp;
@@ -232,6 +274,469 @@ typedef struct {
 
 void cimis_calculate_daily_stats(const cimis_daily_record_t *records, uint32_t count, cimis_daily_stats_t *stats);
 
+/* Measurement fields for column extraction */
+typedef enum {
+    CIMIS_FIELD_TEMPERATURE = 0,
+    CIMIS_FIELD_ET,
+    CIMIS_FIELD_WIND_SPEED,
+    CIMIS_FIELD_HUMIDITY,
+    CIMIS_FIELD_SOLAR_RADIATION,
+    CIMIS_FIELD_WIND_DIRECTION,   /* Hourly only */
+    CIMIS_FIELD_PRECIPITATION,    /* Hourly only */
+    CIMIS_FIELD_VAPOR_PRESSURE    /* Hourly only */
+} cimis_field_t;
+
+#define CIMIS_DAILY_FIELD_COUNT 5
+#define CIMIS_HOURLY_FIELD_COUNT 8
+
+/* Field values in physical units (NAN for fields the record type lacks) */
+float cimis_daily_field_value(const cimis_daily_record_t *record, cimis_field_t field);
+float cimis_hourly_field_value(const cimis_hourly_record_t *record, cimis_field_t field);
+
+/* Columnar batch iteration. Every non-NULL array holds at least capacity
+ * entries; NULL columns are not decoded. Values are in physical units and
+ * hourly-only fields read as NAN from a daily iterator. */
+typedef struct {
+    uint32_t capacity;
+    uint32_t count;                              /* Set by each call, 0 at the end */
+    uint32_t *timestamps;
+    uint16_t *station_ids;
+    uint8_t *qc_flags;
+    float *values[CIMIS_HOURLY_FIELD_COUNT];     /* Indexed by cimis_field_t */
+} cimis_column_batch_t;
+
+cimis_result_t cimis_iterator_next_columns(cimis_record_iterator_t *iter, cimis_column_batch_t *batch);
+
+/* Pairwise station correlation */
+typedef struct {
+    const uint32_t *timestamps;   /* Ascending; duplicates keep the first value */
+    const float *values;          /* NAN marks a missing value */
+    uint32_t count;
+} cimis_series_t;
+
+cimis_result_t cimis_series_from_daily(const cimis_daily_record_t *records, uint32_t count,
+                                       cimis_field_t field, uint32_t *timestamps, float *values);
+
+/* Pearson correlation of every series pair over their overlapping timestamps.
+ * corr (and optional overlap counts) are num_series × num_series, row-major.
+ * Pairs with fewer than min_overlap shared samples or zero variance get NAN.
+ * num_threads <= 0 uses all online CPUs. */
+cimis_result_t cimis_correlation_matrix(const cimis_series_t *series, uint32_t num_series,
+                                        uint32_t min_overlap, int num_threads,
+                                        float *corr, uint32_t *overlap);
+
+/* Climatology
+ * Slots are leap-aware: day slot 59 is Feb 29 and Mar 1 is always slot 60,
+ * so the same calendar day lines up across leap and non-leap years.
+ * Hourly slots are day_slot * 24 + hour. */
+#define CIMIS_CLIM_DAY_SLOTS 366
+#define CIMIS_CLIM_HOUR_SLOTS (CIMIS_CLIM_DAY_SLOTS * 24)
+
+uint16_t cimis_day_slot(uint32_t days_since_epoch);
+uint16_t cimis_hour_slot(uint32_t hours_since_epoch);
+
+/* Per-station climatology view; arrays are indexed [field * num_slots + slot] */
+typedef struct {
+    uint16_t station_id;
+    bool is_hourly;
+    uint32_t num_slots;           /* CIMIS_CLIM_DAY_SLOTS or CIMIS_CLIM_HOUR_SLOTS */
+    uint32_t num_fields;          /* CIMIS_DAILY_FIELD_COUNT or CIMIS_HOURLY_FIELD_COUNT */
+    const float *mean;
+    const float *std;
+    const float *min;             /* May be NULL */
+    const float *max;             /* May be NULL */
+    const uint32_t *count;        /* Samples per slot; NULL skips the min_samples check */
+} cimis_climatology_t;
+
+/* Streaming anomaly scan */
+typedef struct {
+    uint32_t timestamp;
+    uint16_t station_id;
+    uint8_t  field;               /* cimis_field_t */
+    uint8_t  reserved;
+    float    value;
+    float    expected;            /* Climatological mean for the slot */
+    float    z_score;
+} cimis_anomaly_t;
+
+/* Scan state carried across chunks; memory use is constant in input size */
+typedef struct {
+    const cimis_climatology_t *clim;
+    float threshold;              /* Emit when |z| >= threshold */
+    uint32_t field_mask;          /* Bit (1 << cimis_field_t) per scanned field */
+    uint32_t min_samples;
+    uint8_t carry[CIMIS_HOURLY_RECORD_SIZE];  /* Record split across buffers */
+    uint32_t carry_len;
+    uint64_t records_scanned;
+    uint64_t records_skipped;     /* Other stations */
+    uint64_t anomalies_found;
+} cimis_anomaly_scan_t;
+
+cimis_result_t cimis_anomaly_scan_init(cimis_anomaly_scan_t *scan, const cimis_climatology_t *clim,
+                                       float threshold, uint32_t field_mask, uint32_t min_samples);
+
+/* Scan encoded records (daily or hourly to match clim). Buffers may split
+ * records anywhere. Stops early when out cannot hold another tile's worth of
+ * anomalies; *consumed reports how much of buffer was used so the caller can
+ * drain out and resume at buffer + *consumed. */
+cimis_result_t cimis_anomaly_scan_feed(cimis_anomaly_scan_t *scan, const uint8_t *buffer, size_t buffer_size,
+                                       cimis_anomaly_t *out, uint32_t max_out,
+                                       uint32_t *out_count, size_t *consumed);
+
+/* Climatology building
+ * Accumulators use Welford updates and merge with Chan et al.'s pairwise
+ * formula, so per-thread, per-year or previously stored partial results
+ * combine without re-reading the underlying records. */
+typedef struct {
+    uint32_t count;
+    float min;
+    float max;
+    double mean;
+    double m2;                    /* Sum of squared deviations from mean */
+} cimis_clim_accum_t;
+
+void cimis_clim_accum_init(cimis_clim_accum_t *acc, size_t n);
+void cimis_clim_accum_add(cimis_clim_accum_t *acc, float value);
+void cimis_clim_accum_merge(cimis_clim_accum_t *dst, const cimis_clim_accum_t *src);
+
+/* Accumulate one station's records into acc[field * num_slots + slot] */
+cimis_result_t cimis_climatology_accumulate(const cimis_record_batch_t *batch, bool is_hourly,
+                                            cimis_clim_accum_t *acc);
+
+/* Accumulate one batch per station in parallel; acc holds num_batches
+ * consecutive blocks of fields × slots accumulators. */
+cimis_result_t cimis_climatology_build(const cimis_record_batch_t *batches, uint32_t num_batches,
+                                       bool is_hourly, int num_threads, cimis_clim_accum_t *acc);
+
+/* Climatology table file (little-endian, mmap-able)
+ * Offset  Size        Field
+ * 0       4           Magic "CCLM"
+ * 4       u16         Version (1)
+ * 6       u16         Flags (bit 0: hourly)
+ * 8       u32         Fields
+ * 12      u32         Slots
+ * 16      u32         Stations
+ * 20-63   --          Reserved
+ * 64      16×N        Station entries sorted by ID:
+ *                     u16 station, u16 reserved, u32 block, u64 years mask
+ *                     (bit y - CIMIS_EPOCH_YEAR set when year y is included)
+ * ...     N blocks    f32 mean, f32 std, f32 min, f32 max, u32 count,
+ *                     each an array of fields × slots
+ */
+#define CIMIS_CLIM_MAGIC "CCLM"
+#define CIMIS_CLIM_VERSION 1
+#define CIMIS_CLIM_HEADER_SIZE 64
+#define CIMIS_CLIM_ENTRY_SIZE 16
+
+typedef struct {
+    void *data;
+    size_t size;
+    bool mapped;
+    bool is_hourly;
+    uint32_t num_fields;
+    uint32_t num_slots;
+    uint32_t num_stations;
+} cimis_climatology_table_t;
+
+cimis_result_t cimis_climatology_table_write(const char *path, bool is_hourly, uint32_t num_stations,
+                                             const uint16_t *station_ids, const uint64_t *years_masks,
+                                             const cimis_clim_accum_t *acc);
+cimis_result_t cimis_climatology_table_open(const char *path, cimis_climatology_table_t *table);
+void cimis_climatology_table_close(cimis_climatology_table_t *table);
+
+/* Zero-copy view of one station's baseline; CIMIS_ERR_INVALID_SIZE if absent */
+cimis_result_t cimis_climatology_table_station(const cimis_climatology_table_t *table, uint16_t station_id,
+                                               cimis_climatology_t *view, uint64_t *years_mask);
+
+/* Rebuild accumulators from a stored station so new years can be merged in */
+cimis_result_t cimis_climatology_table_load_accum(const cimis_climatology_table_t *table, uint16_t station_id,
+                                                  cimis_clim_accum_t *acc, uint64_t *years_mask);
+
+/* Spatial station index
+ * Stations are stored as unit vectors on a sphere so chord distance orders
+ * neighbors exactly like great-circle distance. */
+typedef struct {
+    uint16_t station_id;
+    float lat;                    /* Decimal degrees */
+    float lon;                    /* Decimal degrees */
+} cimis_station_coord_t;
+
+typedef struct {
+    uint16_t station_id;
+    uint32_t index;               /* Position in the array passed to cimis_kdtree_build */
+    float distance_km;            /* Great-circle distance */
+} cimis_neighbor_t;
+
+typedef struct {
+    float xyz[3];
+    uint16_t station_id;
+    uint32_t index;
+} cimis_kdnode_t;
+
+typedef struct {
+    cimis_kdnode_t *nodes;        /* Implicit tree: median of each range is its root */
+    uint32_t count;
+} cimis_kdtree_t;
+
+cimis_result_t cimis_kdtree_build(cimis_kdtree_t *tree, const cimis_station_coord_t *stations, uint32_t count);
+void cimis_kdtree_free(cimis_kdtree_t *tree);
+
+/* k nearest stations to (lat, lon), nearest first; returns how many were written */
+uint32_t cimis_knn(const cimis_kdtree_t *tree, float lat, float lon, uint32_t k, cimis_neighbor_t *out);
+
+/* Inverse-distance weighting over k aligned series of equal length.
+ * series[i][t] may be NAN; out[t] is NAN when no station has a value.
+ * A station at distance 0 contributes its value exactly. */
+cimis_result_t cimis_idw_interpolate(const float *const *series, const float *distances_km, uint32_t k,
+                                     uint32_t length, float power, float *out);
+
+/* Tail index: the latest daily and hourly record of every station, kept
+ * current by the Go chunk writers (internal/tailindex).
+ * Layout: 16-byte header ("CTAI", u32 version, u32 slots, u32 reserved)
+ * followed by one slot per station ID, each an encoded daily record and an
+ * encoded hourly record. A zero station ID marks an empty half. Writers
+ * replace the file by rename; reopen to see newer records. */
+#define CIMIS_TAIL_MAGIC "CTAI"
+#define CIMIS_TAIL_VERSION 1
+#define CIMIS_TAIL_HEADER_SIZE 16
+#define CIMIS_TAIL_SLOT_SIZE (CIMIS_DAILY_RECORD_SIZE + CIMIS_HOURLY_RECORD_SIZE)
+
+typedef struct {
+    void *data;
+    size_t size;
+    bool mapped;
+    uint32_t num_slots;
+} cimis_tail_index_t;
+
+cimis_result_t cimis_tail_index_open(const char *path, cimis_tail_index_t *index);
+void cimis_tail_index_close(cimis_tail_index_t *index);
+
+/* Latest record of a station; CIMIS_ERR_INVALID_SIZE if it has none */
+cimis_result_t cimis_tail_index_daily(const cimis_tail_index_t *index, uint16_t station_id,
+                                      cimis_daily_record_t *record);
+cimis_result_t cimis_tail_index_hourly(const cimis_tail_index_t *index, uint16_t station_id,
+                                       cimis_hourly_record_t *record);
+
+/* Out-of-core grouped aggregation
+ * Groups live in an in-memory hash table bounded by memory_budget bytes.
+ * When it fills, the groups are sorted by key and spilled to an unlinked
+ * temporary file in spill_dir (NULL: $TMPDIR or /tmp); finish merges the
+ * runs and emits every group once, in ascending key order. init rejects a
+ * budget too small for a 64-group table with CIMIS_ERR_INVALID_SIZE. */
+typedef struct {
+    uint64_t key;
+    uint64_t count;
+    double sum;
+    float min;
+    float max;
+} cimis_agg_entry_t;
+
+/* Return nonzero to stop the emission early */
+typedef int (*cimis_agg_emit_fn)(const cimis_agg_entry_t *entry, void *ctx);
+
+typedef struct {
+    cimis_agg_entry_t *table;     /* Open addressing; count == 0 marks a free slot */
+    uint32_t capacity;            /* Power of two */
+    uint32_t max_capacity;        /* Largest table memory_budget allows */
+    uint32_t size;
+    const char *spill_dir;
+    FILE **runs;
+    uint32_t num_runs;
+    uint32_t runs_capacity;
+    uint64_t rows_in;
+    uint64_t spill_bytes;         /* Bytes written to spill runs */
+    uint64_t groups_out;
+} cimis_agg_t;
+
+cimis_result_t cimis_agg_init(cimis_agg_t *agg, size_t memory_budget, const char *spill_dir);
+cimis_result_t cimis_agg_add(cimis_agg_t *agg, uint64_t key, float value);
+
+/* (station, month, hour-of-day) grouping key for hourly records */
+uint64_t cimis_agg_key_station_month_hour(uint16_t station_id, uint32_t hours_since_epoch);
+
+/* Add one field of a batch of hourly records grouped by station, month and hour */
+cimis_result_t cimis_agg_add_hourly(cimis_agg_t *agg, const cimis_hourly_record_t *records,
+                                    uint32_t count, cimis_field_t field);
+
+/* Emit all groups; consumes the aggregation, which then only accepts free */
+cimis_result_t cimis_agg_finish(cimis_agg_t *agg, cimis_agg_emit_fn emit, void *ctx);
+void cimis_agg_free(cimis_agg_t *agg);
+
+/* Hourly column codecs
+ * Block codecs for single hourly columns, tuned to how the fields behave.
+ * A block is a codec tag byte and the u32 value count, then the payload.
+ * Encoders return the block size, or 0 when buffer_size is below the
+ * codec's bound. Decoders write the count to *count and fail with
+ * CIMIS_ERR_BUFFER_TOO_SMALL if it exceeds capacity and with
+ * CIMIS_ERR_BAD_FORMAT on a truncated or corrupt block. */
+#define CIMIS_CODEC_HEADER_SIZE 5
+
+typedef enum {
+    CIMIS_CODEC_SOLAR = 1,
+    CIMIS_CODEC_WIND_DIR = 2,
+    CIMIS_CODEC_SPARSE = 3
+} cimis_codec_t;
+
+/* Value count of a block, or CIMIS_ERR_BAD_FORMAT if it is not one */
+cimis_result_t cimis_codec_block_info(const uint8_t *buffer, size_t buffer_size,
+                                      cimis_codec_t *codec, uint32_t *count);
+
+/* Solar radiation: alternating night and daylight runs. Night hours are
+ * stored only as run lengths; daylight values as zigzag varint deltas. */
+size_t cimis_solar_encode_bound(uint32_t count);
+size_t cimis_solar_encode(const uint16_t *values, uint32_t count, uint8_t *buffer, size_t buffer_size);
+cimis_result_t cimis_solar_decode(const uint8_t *buffer, size_t buffer_size,
+                                  uint16_t *values, uint32_t capacity, uint32_t *count);
+
+/* Wind direction (degrees / 2): deltas taken modulo the circle, so a turn
+ * through north is as small as any other. Deltas within ±7 take a nibble;
+ * larger turns and out-of-range values are escaped as the raw byte. */
+size_t cimis_wind_dir_encode_bound(uint32_t count);
+size_t cimis_wind_dir_encode(const uint8_t *values, uint32_t count, uint8_t *buffer, size_t buffer_size);
+cimis_result_t cimis_wind_dir_decode(const uint8_t *buffer, size_t buffer_size,
+                                     uint8_t *values, uint32_t capacity, uint32_t *count);
+
+/* Sparse columns (precipitation): only non-zero values are stored, as a
+ * u32 non-zero count and u32 position-section size, the positions as
+ * varint gaps, then the values as varints. Decoding scatters into a zeroed
+ * column. */
+size_t cimis_sparse_encode_bound(uint32_t count);
+size_t cimis_sparse_encode(const uint16_t *values, uint32_t count, uint8_t *buffer, size_t buffer_size);
+cimis_result_t cimis_sparse_decode(const uint8_t *buffer, size_t buffer_size,
+                                   uint16_t *values, uint32_t capacity, uint32_t *count);
+
+/* Sum and count of the non-zero values at positions [begin, end) without
+ * expanding the block; cost is proportional to the non-zero values. The
+ * whole block (begin 0, end >= count) skips the positions entirely. */
+cimis_result_t cimis_sparse_sum(const uint8_t *buffer, size_t buffer_size, uint32_t begin, uint32_t end,
+                                uint64_t *sum, uint32_t *nonzero);
+
+/* Range index over a buffer of encoded records sorted by timestamp.
+ * Every CIMIS_RANGE_BLOCK records it keeps the running fixed-point total of
+ * each indexed field as int64, so a window sum is two prefix lookups plus a
+ * scan of at most two partial blocks. The index points into the record
+ * buffer, which must outlive it. */
+#define CIMIS_RANGE_BLOCK 64
+
+typedef struct {
+    const uint8_t *records;
+    uint32_t count;
+    bool is_hourly;
+    uint32_t field_mask;          /* Bit (1 << cimis_field_t) per indexed field */
+    uint32_t num_blocks;
+    int64_t *prefix[CIMIS_HOURLY_FIELD_COUNT];  /* num_blocks + 1 totals; NULL if not indexed */
+    uint32_t extreme_mask;        /* Fields with a min/max sparse table */
+    uint32_t num_levels;
+    int32_t *min_table[CIMIS_HOURLY_FIELD_COUNT];  /* [level * num_blocks + block]: extreme of */
+    int32_t *max_table[CIMIS_HOURLY_FIELD_COUNT];  /* blocks [block, block + 2^level) */
+} cimis_range_index_t;
+
+/* field_mask 0 indexes ET, plus precipitation for hourly records */
+cimis_result_t cimis_range_index_build(cimis_range_index_t *index, const uint8_t *buffer, size_t buffer_size,
+                                       bool is_hourly, uint32_t field_mask);
+void cimis_range_index_free(cimis_range_index_t *index);
+
+/* Sum of field, in physical units, over records with start <= timestamp < end
+ * (days or hours since epoch). count (optional) receives the records in the
+ * window. CIMIS_ERR_INVALID_SIZE if field is not indexed. */
+cimis_result_t cimis_range_sum(const cimis_range_index_t *index, cimis_field_t field,
+                               uint32_t start, uint32_t end, double *sum, uint32_t *count);
+
+/* Add a sparse table of per-block minima and maxima for the fields in
+ * field_mask (0: temperature). It takes about 4% of the record buffer per
+ * field for a year of hourly records. */
+cimis_result_t cimis_range_index_add_extremes(cimis_range_index_t *index, uint32_t field_mask);
+
+/* Minimum and maximum of field over start <= timestamp < end from two table
+ * lookups and at most two partial blocks. An empty window gives NAN for
+ * both. CIMIS_ERR_INVALID_SIZE if field has no extremes table. */
+cimis_result_t cimis_range_extremes(const cimis_range_index_t *index, cimis_field_t field,
+                                    uint32_t start, uint32_t end, float *min, float *max, uint32_t *count);
+
+/* HDR latency histogram
+ * Log-linear buckets with fixed memory: values below 2^CIMIS_HDR_SUB_BITS
+ * are exact, larger ones land in one of 2^(SUB_BITS-1) linear sub-buckets
+ * per power of two, so quantiles are within 1/64 (1.6%) of the recorded
+ * value. Values are unit-less (nanoseconds by convention) and clamp at
+ * 2^CIMIS_HDR_MAX_BITS - 1. Not thread-safe: give each worker its own
+ * histogram and merge them. The Go side (internal/profile) uses the same
+ * layout. */
+#define CIMIS_HDR_SUB_BITS 7
+#define CIMIS_HDR_MAX_BITS 45
+#define CIMIS_HDR_BUCKETS ((1u << CIMIS_HDR_SUB_BITS) + \
+                           (CIMIS_HDR_MAX_BITS - CIMIS_HDR_SUB_BITS) * (1u << (CIMIS_HDR_SUB_BITS - 1)))
+
+typedef struct {
+    uint64_t counts[CIMIS_HDR_BUCKETS];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+} cimis_hdr_t;
+
+void cimis_hdr_init(cimis_hdr_t *hist);
+void cimis_hdr_record(cimis_hdr_t *hist, uint64_t value);
+void cimis_hdr_record_n(cimis_hdr_t *hist, uint64_t value, uint64_t n);
+void cimis_hdr_merge(cimis_hdr_t *dst, const cimis_hdr_t *src);
+
+/* Value at quantile q in [0, 1] (0 for an empty histogram) */
+uint64_t cimis_hdr_quantile(const cimis_hdr_t *hist, double q);
+
+/* Allocator hooks and memory accounting
+ * Every heap allocation the library makes (iterator samples, correlation
+ * scratch, climatology builds and tables, spatial indexes, tail index,
+ * aggregation tables and spill runs, range indexes) goes through these
+ * functions. Thread stacks, stdio buffers and mmap'd files are not heap
+ * allocations and are not counted. Passing all three functions as NULL
+ * restores the C library allocator; realloc_fn may be NULL on its own, in
+ * which case resizing allocates, copies and frees. The allocator can only
+ * be replaced while the library holds no live allocations (CIMIS_ERR_BUSY
+ * otherwise) and must not be replaced concurrently with other calls. */
+typedef void *(*cimis_malloc_fn)(size_t size, void *ctx);
+typedef void (*cimis_free_fn)(void *ptr, void *ctx);
+typedef void *(*cimis_realloc_fn)(void *ptr, size_t size, void *ctx);
+
+cimis_result_t cimis_set_allocator(cimis_malloc_fn malloc_fn, cimis_free_fn free_fn,
+                                   cimis_realloc_fn realloc_fn, void *ctx);
+
+/* Fail allocations that would take live bytes past limit (0 = no limit) */
+void cimis_set_memory_limit(uint64_t limit);
+
+/* Subsystems allocations are attributed to */
+typedef enum {
+    CIMIS_MEM_ITERATOR = 0,
+    CIMIS_MEM_CORRELATION,
+    CIMIS_MEM_CLIMATOLOGY,
+    CIMIS_MEM_SPATIAL,
+    CIMIS_MEM_TAIL_INDEX,
+    CIMIS_MEM_AGGREGATE,
+    CIMIS_MEM_RANGE_INDEX,
+    CIMIS_MEM_SUBSYSTEM_COUNT
+} cimis_mem_subsystem_t;
+
+/* Byte counts are requested sizes, excluding the allocator's own overhead
+ * and a 16-byte header the library keeps per allocation */
+typedef struct {
+    uint64_t live_bytes;
+    uint64_t peak_bytes;
+    uint64_t allocations;   /* successful malloc/calloc/realloc calls */
+    uint64_t frees;
+    uint64_t failures;      /* allocator returned NULL or limit reached */
+} cimis_mem_counters_t;
+
+typedef struct {
+    cimis_mem_counters_t total;
+    cimis_mem_counters_t subsystem[CIMIS_MEM_SUBSYSTEM_COUNT];
+} cimis_mem_stats_t;
+
+/* Snapshot the counters; safe to call from any thread */
+void cimis_mem_stats(cimis_mem_stats_t *stats);
+
+/* Reset every peak to the current live bytes */
+void cimis_mem_reset_peak(void);
+
+const char *cimis_mem_subsystem_name(cimis_mem_subsystem_t subsystem);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,170 @@
+package main
+
+import (
+	"flag"
+	"fmt"
+	"os"
+	"path/filepath"
+	"runtime"
+	"sync"
+	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/api"
+	"github.com/dl-alexandre/cimis-cli/internal/climatology"
+	"github.com/dl-alexandre/cimis-tsdb/metadata"
+	"github.com/dl-alexandre/cimis-tsdb/storage"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// climatologyFileName is the default daily climatology table under the data dir.
+const climatologyFileName = "climatology_daily.bin"
+
+func cmdClimatology(dataDir string, args []string) {
+	fatalIfErr(runClimatology(dataDir, args))
+}
+
+// runClimatology builds per-station, per-day-of-year baselines from stored
+// daily chunks. Only past years are included, and years already in the
+// table are skipped, so a new year costs one chunk read per station. A
+// folded year whose chunk has since changed record count (a partial year
+// filled in later, a repair) cannot be subtracted out again, so that
+// station is rebuilt from all of its years.
+func runClimatology(dataDir string, args []string) error {
+	fs := flag.NewFlagSet("climatology", flag.ContinueOnError)
+	stations := fs.String("stations", "all", "Stations: 'all', CSV list or range")
+	workers := fs.Int("workers", runtime.NumCPU(), "Stations processed in parallel")
+	rebuild := fs.Bool("rebuild", false, "Ignore the existing table and re-scan every year")
+	out := fs.String("out", "", "Output table (default <data-dir>/"+climatologyFileName+")")
+
+	if err := fs.Parse(args); err != nil {
+		return err
+	}
+	if *workers < 1 {
+		return fmt.Errorf("workers must be at least 1")
+	}
+	if *out == "" {
+		*out = filepath.Join(dataDir, climatologyFileName)
+	}
+
+	stationList, err := resolveStations(dataDir, *stations, 0)
+	if err != nil {
+		return err
+	}
+
+	buildStart := time.Now()
+	baselines := make(map[uint16]*climatology.Station)
+	if !*rebuild {
+		existing, err := climatology.Read(*out)
+		if err != nil && !os.IsNotExist(err) {
+			return fmt.Errorf("failed to read existing table (use -rebuild): %w", err)
+		}
+		for _, s := range existing {
+			baselines[s.ID] = s
+		}
+	}
+
+	store, err := metadata.NewStore(filepath.Join(dataDir, "metadata.sqlite3"))
+	if err != nil {
+		return fmt.Errorf("failed to open metadata store: %w", err)
+	}
+	defer store.Close()
+
+	lastYear := time.Now().Year() - 1
+	type stationJob struct {
+		baseline *climatology.Station
+		chunks   []types.ChunkInfo
+	}
+	var jobs []stationJob
+	var skipped, rebuilt int
+	for _, sid := range stationList {
+		chunks, err := getChunksForYearRange(store, uint16(sid), api.EpochYear, lastYear, types.DataTypeDaily)
+		if err != nil {
+			return fmt.Errorf("failed to get chunks for station %d: %w", sid, err)
+		}
+		baseline, ok := baselines[uint16(sid)]
+		if !ok {
+			baseline = climatology.NewStation(uint16(sid))
+		}
+		var pending []types.ChunkInfo
+		changed := false
+		for _, chunk := range chunks {
+			if !baseline.HasYear(chunk.Year) {
+				pending = append(pending, chunk)
+			} else if baseline.YearRows(chunk.Year) != chunk.RowCount {
+				changed = true
+			}
+		}
+		if changed {
+			baseline = climatology.NewStation(uint16(sid))
+			pending = chunks
+			rebuilt++
+		} else {
+			skipped += len(chunks) - len(pending)
+		}
+		if len(pending) > 0 || ok {
+			baselines[uint16(sid)] = baseline
+		}
+		if len(pending) > 0 {
+			jobs = append(jobs, stationJob{baseline: baseline, chunks: pending})
+		}
+	}
+
+	// Stations are independent, so each worker owns whole baselines.
+	var read, failed int
+	var mu sync.Mutex
+	var wg sync.WaitGroup
+	queue := make(chan stationJob)
+	for w := 0; w < *workers; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			reader := storage.NewChunkReader(dataDir)
+			for job := range queue {
+				for _, chunk := range job.chunks {
+					records, err := reader.ReadDailyChunk(chunk.StationID, chunk.Year)
+					mu.Lock()
+					if err != nil {
+						failed++
+					} else {
+						read++
+					}
+					mu.Unlock()
+					if err != nil {
+						continue
+					}
+					for _, r := range records {
+						for f, name := range climatology.DailyFields {
+							job.baseline.Add(r.Timestamp, f, dailyFields[name](r))
+						}
+					}
+					job.baseline.MarkYear(chunk.Year, chunk.RowCount)
+				}
+			}
+		}()
+	}
+	for _, job := range jobs {
+		queue <- job
+	}
+	close(queue)
+	wg.Wait()
+
+	if len(baselines) == 0 {
+		fmt.Printf("No complete years of daily data for %d station(s)\n", len(stationList))
+		return nil
+	}
+
+	all := make([]*climatology.Station, 0, len(baselines))
+	for _, s := range baselines {
+		all = append(all, s)
+	}
+	if err := climatology.Write(*out, all); err != nil {
+		return fmt.Errorf("failed to write climatology table: %w", err)
+	}
+
+	fmt.Printf("Climatology: %d station(s) through %d, %d new chunk(s) read, %d already included, %d station(s) rebuilt, %d failed\n",
+		len(all), lastYear, read, skipped, rebuilt, failed)
+	if info, err := os.Stat(*out); err == nil {
+		fmt.Printf("Wrote %s (%.1f KB) in %v\n", *out, float64(info.Size())/1024, time.Since(buildStart))
+	}
+	return nil
+}
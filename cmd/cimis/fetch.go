@@ -10,6 +10,8 @@ import (
 	"time"
 
 	"github.com/dl-alexandre/cimis-cli/internal/api"
+	"github.com/dl-alexandre/cimis-cli/internal/profile"
+	"github.com/dl-alexandre/cimis-cli/internal/trace"
 	"github.com/dl-alexandre/cimis-tsdb/metadata"
 	"github.com/dl-alexandre/cimis-tsdb/storage"
 	"github.com/dl-alexandre/cimis-tsdb/types"
@@ -94,6 +96,8 @@ func runFetchStreaming(dataDir, appKey string, args []string) error {
 	allocs := fs.Bool("allocs", false, "Measure memory allocations per station (use with concurrency=1)")
 	retries := fs.Int("retries", 3, "Max retries on failure")
 	outDir := fs.String("out", dataDir, "Output directory")
+	metricsAddr := fs.String("metrics-addr", "", "Serve Prometheus metrics on this address while fetching (e.g., localhost:9100)")
+	tracePath := fs.String("trace", "", "Write a Chrome trace of per-station spans to this file")
 
 	if err := fs.Parse(args); err != nil {
 		return err
@@ -155,6 +159,16 @@ func runFetchStreaming(dataDir, appKey string, args []string) error {
 
 	client := newOptimizedAPIClient(appKey)
 
+	if *metricsAddr != "" {
+		server, err := startMetricsServer(*metricsAddr)
+		if err != nil {
+			return err
+		}
+		defer server.Close()
+	}
+
+	rec := startTrace(*tracePath, "fetch-streaming")
+
 	type job struct {
 		stationID uint16
 	}
@@ -162,13 +176,24 @@ func runFetchStreaming(dataDir, appKey string, args []string) error {
 	jobs := make(chan job, len(stationList))
 	results := make(chan stationFetchResult, len(stationList))
 
+	runStart := time.Now()
+	workerShare := 1 / float64(*concurrency)
+	// Each worker fills its own latency histograms; they are merged once
+	// every result has been received.
+	workerLatencies := make([]fetchPhaseLatencies, *concurrency)
 	for w := 0; w < *concurrency; w++ {
+		latencies := newFetchPhaseLatencies()
+		workerLatencies[w] = latencies
+		track := rec.Track(fmt.Sprintf("worker %d", w))
 		go func() {
 			for j := range jobs {
+				workerPoolUtilization.Add(workerShare)
 				m := fetchStationStreaming(
-					client, store, writer, j.stationID,
-					startDate, endDate, *format, *dryRun, *retries,
+					client, store, writer, compressionLevel, j.stationID,
+					startDate, endDate, *format, *dryRun, *retries, track,
 				)
+				workerPoolUtilization.Add(-workerShare)
+				latencies.record(m)
 				results <- m
 			}
 		}()
@@ -194,6 +219,10 @@ func runFetchStreaming(dataDir, appKey string, args []string) error {
 		}
 	}
 
+	if elapsed := time.Since(runStart).Seconds(); elapsed > 0 {
+		recordsPerSecond.Set(float64(totalRecords) / elapsed)
+	}
+
 	fmt.Printf("\n=== Fetch Streaming Summary ===\n")
 	fmt.Printf("Stations processed: %d\n", len(stationList))
 	fmt.Printf("Successful: %d\n", successCount)
@@ -218,6 +247,15 @@ func runFetchStreaming(dataDir, appKey string, args []string) error {
 				fmt.Printf("Station %d: FAILED - %v\n", m.stationID, m.err)
 			}
 		}
+
+		latencies := newFetchPhaseLatencies()
+		for _, l := range workerLatencies {
+			latencies.merge(l)
+		}
+		fmt.Printf("\n=== Latency Percentiles (%d stations) ===\n", successCount)
+		for i, phase := range fetchPhases {
+			fmt.Printf("  %-8s %s\n", phase.name+":", latencies[i].Percentiles())
+		}
 	}
 
 	if failCount > 0 {
@@ -228,7 +266,7 @@ func runFetchStreaming(dataDir, appKey string, args []string) error {
 		fmt.Println("\nNote: Allocation tracking enabled (authoritative when concurrency=1)")
 	}
 
-	return nil
+	return finishTrace(rec, *tracePath)
 }
 
 func parseStationList(input string) ([]int, error) {
@@ -278,6 +316,7 @@ func sortStations(stations []int) {
 type stationFetchResult struct {
 	stationID    uint16
 	success      bool
+	skipped      bool // chunk already stored; nothing was fetched
 	recordCount  int
 	dns          time.Duration
 	tcp          time.Duration
@@ -291,23 +330,73 @@ type stationFetchResult struct {
 	err          error
 }
 
+// fetchPhases are the per-station timings summarized by -perf.
+var fetchPhases = []struct {
+	name string
+	of   func(stationFetchResult) time.Duration
+}{
+	{"DNS", func(m stationFetchResult) time.Duration { return m.dns }},
+	{"TCP", func(m stationFetchResult) time.Duration { return m.tcp }},
+	{"TLS", func(m stationFetchResult) time.Duration { return m.tls }},
+	{"TTFB", func(m stationFetchResult) time.Duration { return m.ttfb }},
+	{"Read", func(m stationFetchResult) time.Duration { return m.read }},
+	{"Decode", func(m stationFetchResult) time.Duration { return m.decode }},
+	{"Write", func(m stationFetchResult) time.Duration { return m.write }},
+	{"Total", func(m stationFetchResult) time.Duration { return m.totalTime }},
+}
+
+// fetchPhaseLatencies holds one histogram per entry of fetchPhases.
+type fetchPhaseLatencies []*profile.Histogram
+
+func newFetchPhaseLatencies() fetchPhaseLatencies {
+	l := make(fetchPhaseLatencies, len(fetchPhases))
+	for i := range l {
+		l[i] = profile.NewHistogram()
+	}
+	return l
+}
+
+// record adds the phase timings of a station that was actually fetched;
+// failures and skipped stations would only skew the percentiles.
+func (l fetchPhaseLatencies) record(m stationFetchResult) {
+	if !m.success || m.skipped {
+		return
+	}
+	for i, phase := range fetchPhases {
+		l[i].Record(phase.of(m))
+	}
+}
+
+func (l fetchPhaseLatencies) merge(o fetchPhaseLatencies) {
+	for i := range l {
+		l[i].Merge(o[i])
+	}
+}
+
 func fetchStationStreaming(
 	client *api.OptimizedClient,
 	store *metadata.Store,
 	writer *storage.ChunkWriter,
+	level int,
 	stationID uint16,
 	startDate, endDate time.Time,
 	format string,
 	dryRun bool,
 	maxRetries int,
+	track *trace.Track,
 ) stationFetchResult {
 	m := stationFetchResult{stationID: stationID}
 	totalStart := time.Now()
 
 	year := startDate.Year()
+	span := track.Start(fmt.Sprintf("station %d", stationID), "station", stationID, "year", year)
+	defer span.End()
+
 	exists, _ := store.ChunkExists(stationID, year, types.DataTypeDaily)
 	if exists {
+		span.Set("skipped", "chunk exists")
 		m.success = true
+		m.skipped = true
 		m.recordCount = 0
 		m.totalTime = time.Since(totalStart)
 		return m
@@ -320,14 +409,21 @@ func fetchStationStreaming(
 	for attempt := 0; attempt <= maxRetries; attempt++ {
 		if attempt > 0 {
 			backoff := time.Duration(1<<uint(attempt)) * time.Second
+			sleepStart := time.Now()
 			retrySleep(backoff + retryJitter(backoff))
+			track.Add("backoff", sleepStart, time.Since(sleepStart), "attempt", attempt)
 		}
 
+		fetchStart := time.Now()
+		activeConnections.Add(1)
 		records, fetchMetrics, err = client.FetchDailyDataStreaming(
 			int(stationID),
 			api.FormatCIMISDate(startDate),
 			api.FormatCIMISDate(endDate),
 		)
+		activeConnections.Add(-1)
+		recordFetch(fetchMetrics, err)
+		traceFetch(track, fetchStart, fetchMetrics, err)
 
 		if err == nil {
 			break
@@ -354,10 +450,14 @@ func fetchStationStreaming(
 		m.decode = fetchMetrics.JSONDecode
 	}
 	m.recordCount = len(records)
+	span.Set("records", len(records))
 
 	if !dryRun && len(records) > 0 {
 		writeStart := time.Now()
-		_, err := writer.WriteDailyChunk(stationID, year, records)
+		chunkInfo, err := writer.WriteDailyChunk(stationID, year, records)
+		if err == nil {
+			err = frameChunk(chunkInfo, level)
+		}
 		m.write = time.Since(writeStart)
 
 		if err != nil {
@@ -366,12 +466,30 @@ func fetchStationStreaming(
 			m.totalTime = time.Since(totalStart)
 			return m
 		}
+		if chunkInfo != nil {
+			recordChunkWrite(len(records), chunkInfo.FileSize, chunkInfo.CompressionRatio, m.write)
+			track.Add("write chunk", writeStart, m.write, "records", len(records), "bytes", chunkInfo.FileSize, "ratio", chunkInfo.CompressionRatio)
+		} else {
+			recordChunkWrite(len(records), 0, 0, m.write)
+			track.Add("write chunk", writeStart, m.write, "records", len(records))
+		}
+
+		// Sketch sidecars and the tail index are optional; queries backfill them on demand.
+		if chunkInfo != nil {
+			sidecarStart := time.Now()
+			_ = writeDailySketchSidecar(chunkInfo.FilePath, records)
+			_ = updateTailIndex(chunkInfo.FilePath, records, nil)
+			track.Add("sidecars", sidecarStart, time.Since(sidecarStart))
+		}
 
-		if err := saveChunkMetadata(store, &types.ChunkInfo{
+		commit := track.Start("metadata commit")
+		err = saveChunkMetadata(store, &types.ChunkInfo{
 			StationID: stationID,
 			Year:      year,
 			DataType:  types.DataTypeDaily,
-		}); err != nil {
+		})
+		commit.End()
+		if err != nil {
 			m.success = false
 			m.err = err
 			m.totalTime = time.Since(totalStart)
@@ -0,0 +1,80 @@
+package main
+
+import (
+	"fmt"
+	"strconv"
+
+	"github.com/dl-alexandre/cimis-cli/internal/perfcounter"
+)
+
+// perfFlag is -perf: a plain switch, or -perf=hw to add CPU hardware
+// counters per query phase.
+type perfFlag struct {
+	on bool
+	hw bool
+}
+
+func (p *perfFlag) String() string {
+	if p == nil || !p.on {
+		return "false"
+	}
+	if p.hw {
+		return "hw"
+	}
+	return "true"
+}
+
+func (p *perfFlag) Set(s string) error {
+	if s == "hw" {
+		p.on, p.hw = true, true
+		return nil
+	}
+	on, err := strconv.ParseBool(s)
+	if err != nil {
+		return fmt.Errorf("want true, false or hw")
+	}
+	p.on, p.hw = on, false
+	return nil
+}
+
+func (p *perfFlag) IsBoolFlag() bool { return true }
+
+// hwPhase is the hardware counter total for one query phase.
+type hwPhase struct {
+	name   string
+	counts perfcounter.Counts
+}
+
+// printHWCounters reports IPC and misses per scanned record for each phase.
+func printHWCounters(phases []hwPhase, records int) {
+	fmt.Println("\n=== Hardware Counters (query thread, user space) ===")
+	fmt.Printf("%-8s %14s %14s %6s %12s %12s %12s\n", "Phase", "Cycles", "Instructions", "IPC", "L1D/record", "LLC/record", "BrMiss/rec")
+	var total perfcounter.Counts
+	for _, p := range phases {
+		printHWPhase(p.name, p.counts, records)
+		total.Add(p.counts)
+	}
+	printHWPhase("total", total, records)
+}
+
+func printHWPhase(name string, c perfcounter.Counts, records int) {
+	count := func(e perfcounter.Event) string {
+		if v, ok := c.Get(e); ok {
+			return strconv.FormatUint(v, 10)
+		}
+		return "n/a"
+	}
+	perRecord := func(e perfcounter.Event) string {
+		if v, ok := c.PerRecord(e, records); ok {
+			return fmt.Sprintf("%.3f", v)
+		}
+		return "n/a"
+	}
+	ipc := "n/a"
+	if v := c.IPC(); v > 0 {
+		ipc = fmt.Sprintf("%.2f", v)
+	}
+	fmt.Printf("%-8s %14s %14s %6s %12s %12s %12s\n", name,
+		count(perfcounter.Cycles), count(perfcounter.Instructions), ipc,
+		perRecord(perfcounter.L1DMisses), perRecord(perfcounter.LLCMisses), perRecord(perfcounter.BranchMisses))
+}
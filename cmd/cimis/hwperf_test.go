@@ -0,0 +1,53 @@
+package main
+
+import (
+	"flag"
+	"io"
+	"strings"
+	"testing"
+)
+
+func TestPerfFlagParsing(t *testing.T) {
+	tests := []struct {
+		args   []string
+		on, hw bool
+		valid  bool
+	}{
+		{nil, false, false, true},
+		{[]string{"-perf"}, true, false, true},
+		{[]string{"-perf=hw"}, true, true, true},
+		{[]string{"-perf=false"}, false, false, true},
+		{[]string{"-perf=cycles"}, false, false, false},
+	}
+	for _, tt := range tests {
+		fs := flag.NewFlagSet("query", flag.ContinueOnError)
+		fs.SetOutput(io.Discard)
+		var perf perfFlag
+		fs.Var(&perf, "perf", "")
+		err := fs.Parse(tt.args)
+		if (err == nil) != tt.valid {
+			t.Fatalf("Parse(%v) error = %v", tt.args, err)
+		}
+		if tt.valid && (perf.on != tt.on || perf.hw != tt.hw) {
+			t.Fatalf("Parse(%v) = %+v", tt.args, perf)
+		}
+	}
+}
+
+func TestQueryHardwareCounters(t *testing.T) {
+	dataDir := setupTierDataDir(t, 2024)
+	output := captureStdout(t, func() {
+		if err := runQuery(dataDir, []string{"-station", "2", "-start", "2024-03-01", "-end", "2024-04-01", "-perf=hw"}); err != nil {
+			t.Fatalf("runQuery() error = %v", err)
+		}
+	})
+	if !strings.Contains(output, "Total records: 31") || !strings.Contains(output, "Performance Metrics") {
+		t.Fatalf("query output:\n%s", output)
+	}
+	// Either the counters are readable or the query says why not; it never
+	// fails because of them.
+	counted := strings.Contains(output, "Hardware Counters") && strings.Contains(output, "filter ")
+	if !counted && !strings.Contains(output, "Hardware counters unavailable: ") {
+		t.Fatalf("query -perf=hw output has neither counters nor a reason:\n%s", output)
+	}
+}
@@ -11,7 +11,7 @@ import (
 	"github.com/dl-alexandre/cimis-tsdb/metadata"
 )
 
-func runIngest(dataDir, appKey string, args []string) error {
+func runIngest(dataDir, appKey string, args []string) (err error) {
 	if appKey == "" {
 		return fmt.Errorf("CIMIS app key required")
 	}
@@ -21,6 +21,7 @@ func runIngest(dataDir, appKey string, args []string) error {
 	stationID := fs.Int("station", 0, "Station ID")
 	year := fs.Int("year", 0, "Year to ingest (default: current year)")
 	compressionLevel := fs.Int("compression", 1, "Compression level (1-16)")
+	tracePath := fs.String("trace", "", "Write a Chrome trace of the fetch and write spans to this file")
 
 	if err := fs.Parse(args); err != nil {
 		return err
@@ -51,6 +52,17 @@ func runIngest(dataDir, appKey string, args []string) error {
 		return fmt.Errorf("failed to create chunk writer: %w", err)
 	}
 
+	// The trace is written on failure too; that is when it is most useful.
+	rec := startTrace(*tracePath, "ingest")
+	track := rec.Track("ingest")
+	defer func() {
+		if traceErr := finishTrace(rec, *tracePath); err == nil {
+			err = traceErr
+		}
+	}()
+	span := track.Start(fmt.Sprintf("station %d", *stationID), "station", *stationID, "year", *year)
+	defer span.End()
+
 	// Check if chunk already exists
 	exists, _ := store.ChunkExists(uint16(*stationID), *year, "daily")
 	if exists {
@@ -64,7 +76,10 @@ func runIngest(dataDir, appKey string, args []string) error {
 	endDate := time.Date(*year, 12, 31, 0, 0, 0, 0, time.UTC)
 
 	fmt.Printf("Fetching daily data for station %d, year %d...\n", *stationID, *year)
+	fetchStart := time.Now()
 	records, fetchMetrics, err := client.FetchDailyDataStreaming(*stationID, api.FormatCIMISDate(startDate), api.FormatCIMISDate(endDate))
+	recordFetch(fetchMetrics, err)
+	traceFetch(track, fetchStart, fetchMetrics, err)
 	if err != nil {
 		return fmt.Errorf("failed to fetch data: %w", err)
 	}
@@ -81,16 +96,35 @@ func runIngest(dataDir, appKey string, args []string) error {
 	}
 
 	// Write chunk
+	writeStart := time.Now()
 	chunkInfo, err := writer.WriteDailyChunk(uint16(*stationID), *year, records)
+	if err == nil {
+		err = frameChunk(chunkInfo, *compressionLevel)
+	}
 	if err != nil {
 		return fmt.Errorf("failed to write chunk: %w", err)
 	}
+	writeTime := time.Since(writeStart)
+	recordChunkWrite(len(records), chunkInfo.FileSize, chunkInfo.CompressionRatio, writeTime)
+	track.Add("write chunk", writeStart, writeTime, "records", len(records), "bytes", chunkInfo.FileSize, "ratio", chunkInfo.CompressionRatio)
 
 	// Save metadata
-	if err := saveChunkMetadata(store, chunkInfo); err != nil {
+	commit := track.Start("metadata commit")
+	err = saveChunkMetadata(store, chunkInfo)
+	commit.End()
+	if err != nil {
 		return fmt.Errorf("failed to save chunk metadata: %w", err)
 	}
 
+	sidecars := track.Start("sidecars")
+	if err := writeDailySketchSidecar(chunkInfo.FilePath, records); err != nil {
+		fmt.Printf("Warning: failed to write sketch sidecar: %v\n", err)
+	}
+	if err := updateTailIndex(chunkInfo.FilePath, records, nil); err != nil {
+		fmt.Printf("Warning: failed to update tail index: %v\n", err)
+	}
+	sidecars.End()
+
 	// Print summary
 	fmt.Printf("Ingested %d daily records\n", len(records))
 	fmt.Printf("  Compressed: %d bytes (%.2fx ratio)\n", chunkInfo.FileSize, chunkInfo.CompressionRatio)
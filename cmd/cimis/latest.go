@@ -0,0 +1,190 @@
+package main
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/api"
+	"github.com/dl-alexandre/cimis-cli/internal/tailindex"
+	"github.com/dl-alexandre/cimis-tsdb/metadata"
+	"github.com/dl-alexandre/cimis-tsdb/storage"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// tailIndexPathForChunk locates the data directory's tail index from a chunk
+// path (<data-dir>/stations/<id>/<year>_<type>.zst).
+func tailIndexPathForChunk(chunkPath string) string {
+	return filepath.Join(filepath.Dir(chunkPath), "..", "..", tailindex.FileName)
+}
+
+// updateTailIndex records the newest records of a freshly written chunk.
+// The index is an accelerator only; -latest backfills stations it lacks.
+func updateTailIndex(chunkPath string, daily []types.DailyRecord, hourly []types.HourlyRecord) error {
+	if chunkPath == "" {
+		return nil
+	}
+	return tailindex.Update(tailIndexPathForChunk(chunkPath), daily, hourly)
+}
+
+type latestOptions struct {
+	stations  string
+	stationID int
+	hourly    bool
+	perf      bool
+}
+
+// runLatestQuery prints the most recent record of each station from the tail
+// index. Stations missing from the index (data written before it existed)
+// are answered from their newest chunk once and backfilled.
+func runLatestQuery(dataDir string, opts latestOptions) error {
+	queryStart := time.Now()
+
+	stationList, err := resolveStations(dataDir, opts.stations, opts.stationID)
+	if err != nil {
+		return err
+	}
+
+	indexPath := filepath.Join(dataDir, tailindex.FileName)
+	index, err := tailindex.Open(indexPath)
+	if err != nil && !os.IsNotExist(err) {
+		fmt.Printf("Warning: ignoring tail index: %v\n", err)
+	}
+	indexDuration := time.Since(queryStart)
+
+	kind := "daily"
+	if opts.hourly {
+		kind = "hourly"
+	}
+	fmt.Printf("Latest %s record for %d station(s):\n", kind, len(stationList))
+
+	var fromIndex, fromChunks, missing int
+	var store *metadata.Store
+	defer func() {
+		if store != nil {
+			store.Close()
+		}
+	}()
+
+	for _, sid := range stationList {
+		id := uint16(sid)
+		if opts.hourly {
+			if r, ok := latestHourlyFromIndex(index, id); ok {
+				printLatestHourly(r)
+				fromIndex++
+				continue
+			}
+		} else if r, ok := latestDailyFromIndex(index, id); ok {
+			printLatestDaily(r)
+			fromIndex++
+			continue
+		}
+
+		if store == nil {
+			if store, err = metadata.NewStore(filepath.Join(dataDir, "metadata.sqlite3")); err != nil {
+				return fmt.Errorf("failed to open metadata store: %w", err)
+			}
+		}
+		found, err := latestFromChunks(dataDir, store, id, opts.hourly, indexPath)
+		if err != nil {
+			fmt.Printf("Warning: station %d: %v\n", sid, err)
+		}
+		if !found {
+			fmt.Printf("  Station %3d  no data\n", sid)
+			missing++
+			continue
+		}
+		fromChunks++
+	}
+
+	fmt.Printf("\n%d from tail index, %d from chunks, %d without data\n", fromIndex, fromChunks, missing)
+	if opts.perf {
+		fmt.Println("\n=== Performance Metrics ===")
+		fmt.Printf("Tail index load time:      %v\n", indexDuration)
+		fmt.Printf("Total query duration:      %v\n", time.Since(queryStart))
+	}
+	return nil
+}
+
+func latestDailyFromIndex(index *tailindex.Index, id uint16) (types.DailyRecord, bool) {
+	if index == nil {
+		return types.DailyRecord{}, false
+	}
+	return index.Daily(id)
+}
+
+func latestHourlyFromIndex(index *tailindex.Index, id uint16) (types.HourlyRecord, bool) {
+	if index == nil {
+		return types.HourlyRecord{}, false
+	}
+	return index.Hourly(id)
+}
+
+// latestFromChunks reads a station's newest chunk, prints its latest record
+// and backfills the tail index.
+func latestFromChunks(dataDir string, store *metadata.Store, id uint16, hourly bool, indexPath string) (bool, error) {
+	dataType := types.DataTypeDaily
+	if hourly {
+		dataType = types.DataTypeHourly
+	}
+	chunks, err := getChunksForYearRange(store, id, api.Epoch.Year(), time.Now().Year(), dataType)
+	if err != nil {
+		return false, fmt.Errorf("failed to get chunks: %w", err)
+	}
+
+	reader := storage.NewChunkReader(dataDir)
+	// Walk back from the newest year; an empty or unreadable chunk defers to the one before it.
+	for i := len(chunks) - 1; i >= 0; i-- {
+		if hourly {
+			records, err := reader.ReadHourlyChunk(id, chunks[i].Year)
+			if err != nil || len(records) == 0 {
+				continue
+			}
+			latest := records[0]
+			for _, r := range records[1:] {
+				if r.Timestamp > latest.Timestamp {
+					latest = r
+				}
+			}
+			printLatestHourly(latest)
+			return true, tailindex.Update(indexPath, nil, []types.HourlyRecord{latest})
+		}
+
+		records, err := reader.ReadDailyChunk(id, chunks[i].Year)
+		if err != nil || len(records) == 0 {
+			continue
+		}
+		latest := records[0]
+		for _, r := range records[1:] {
+			if r.Timestamp > latest.Timestamp {
+				latest = r
+			}
+		}
+		printLatestDaily(latest)
+		return true, tailindex.Update(indexPath, []types.DailyRecord{latest}, nil)
+	}
+	return false, nil
+}
+
+func printLatestDaily(r types.DailyRecord) {
+	ts := api.Epoch.Add(time.Duration(r.Timestamp) * 24 * time.Hour)
+	fmt.Printf("  Station %3d  %s: Temp=%.1f°C ET=%.2fmm Wind=%.1fm/s Humidity=%d%%\n",
+		r.StationID,
+		ts.Format("2006-01-02"),
+		float64(r.Temperature)/10.0,
+		float64(r.ET)/100.0,
+		float64(r.WindSpeed)/10.0,
+		r.Humidity)
+}
+
+func printLatestHourly(r types.HourlyRecord) {
+	ts := api.Epoch.Add(time.Duration(r.Timestamp) * time.Hour)
+	fmt.Printf("  Station %3d  %s: Temp=%.1f°C ET=%.2fmm Wind=%.1fm/s Humidity=%d%%\n",
+		r.StationID,
+		ts.Format("2006-01-02 15:00"),
+		float64(r.Temperature)/10.0,
+		float64(r.ET)/1000.0,
+		float64(r.WindSpeed)/10.0,
+		r.Humidity)
+}
@@ -129,7 +129,19 @@ func run(args []string) int {
 		return commandExitCode(runStats(*dataDir))
 
 	case "verify":
-		return commandExitCode(runVerify(*dataDir))
+		return commandExitCode(runVerify(*dataDir, *appKey, args[2:]))
+
+	case "repack":
+		return commandExitCode(runRepack(*dataDir, args[2:]))
+
+	case "tier":
+		return commandExitCode(runTier(*dataDir, args[2:]))
+
+	case "climatology":
+		return commandExitCode(runClimatology(*dataDir, args[2:]))
+
+	case "stations":
+		return commandExitCode(runStations(*dataDir, *appKey, args[2:]))
 
 	case "profile":
 		return commandExitCode(runProfile(*dataDir, args[2:]))
@@ -1,6 +1,7 @@
 package main
 
 import (
+	"bytes"
 	"errors"
 	"fmt"
 	"io"
@@ -13,6 +14,7 @@ import (
 	"time"
 
 	"github.com/dl-alexandre/cimis-cli/internal/api"
+	"github.com/dl-alexandre/cimis-cli/internal/climatology"
 	profilepkg "github.com/dl-alexandre/cimis-cli/internal/profile"
 	"github.com/dl-alexandre/cimis-tsdb/metadata"
 	"github.com/dl-alexandre/cimis-tsdb/storage"
@@ -272,7 +274,7 @@ func TestCmdInitStatsAndVerifyHappyPaths(t *testing.T) {
 	}
 
 	verifyOutput := captureStdout(t, func() {
-		cmdVerify(dataDir)
+		cmdVerify(dataDir, "", nil)
 	})
 	if !strings.Contains(verifyOutput, "Verification complete: 0 OK, 0 failed") {
 		t.Fatalf("cmdVerify output = %q", verifyOutput)
@@ -314,7 +316,7 @@ func TestRunInitStatsVerifyErrors(t *testing.T) {
 		t.Fatal("expected runStats database stats error")
 	}
 
-	if err := runVerify(filepath.Join(base, "missing")); err == nil {
+	if err := runVerify(filepath.Join(base, "missing"), "", nil); err == nil {
 		t.Fatal("expected runVerify error for missing stations dir")
 	}
 }
@@ -547,6 +549,9 @@ func TestRunQueryValidationErrors(t *testing.T) {
 		{"bad end date", t.TempDir(), []string{"-station", "2", "-start", "2024-01-01", "-end", "bad"}},
 		{"metadata store open error", filepath.Join(blockedParent, "child"), []string{"-station", "2", "-start", "2024-01-01", "-end", "2024-01-31"}},
 		{"bad cache size", initializedDir, []string{"-station", "2", "-start", "2024-01-01", "-end", "2024-01-31", "-cache", "bad"}},
+		{"negative prefetch", initializedDir, []string{"-station", "2", "-start", "2024-01-01", "-end", "2024-01-31", "-prefetch", "-1"}},
+		{"bad prefetch cap", initializedDir, []string{"-station", "2", "-start", "2024-01-01", "-end", "2024-01-31", "-prefetch-mem", "bad"}},
+		{"bad compressed cache size", initializedDir, []string{"-station", "2", "-start", "2024-01-01", "-end", "2024-01-31", "-cache-compressed", "bad"}},
 	}
 
 	for _, tt := range tests {
@@ -624,11 +629,27 @@ func TestCmdQueryDailyRecordsWithPerfAndCache(t *testing.T) {
 			"-perf",
 		})
 	})
-	for _, want := range []string{"Querying 1 chunks", "Total records: 11", "(showing first 10)", "Performance Metrics", "Cache Statistics"} {
+	for _, want := range []string{"Querying 1 chunks", "Total records: 11", "(showing first 10)", "Performance Metrics", "Prefetch hits/stalls", "Chunk read latency:        p50=", "p999=", "(n=1)", "Cache Statistics"} {
 		if !strings.Contains(output, want) {
 			t.Fatalf("cmdQuery output missing %q:\n%s", want, output)
 		}
 	}
+
+	output = captureStdout(t, func() {
+		cmdQuery(dataDir, []string{
+			"-station", "2",
+			"-start", "2024-01-01",
+			"-end", "2024-02-01",
+			"-cache", "1MB",
+			"-cache-compressed", "4MB",
+			"-perf",
+		})
+	})
+	for _, want := range []string{"Total records: 11", "Hits: 0 decoded, 0 packed; misses: 1", "Packed tier:"} {
+		if !strings.Contains(output, want) {
+			t.Fatalf("cmdQuery -cache-compressed output missing %q:\n%s", want, output)
+		}
+	}
 }
 
 func TestCmdQueryHourlyRecords(t *testing.T) {
@@ -685,6 +706,196 @@ func TestCmdQueryHourlyRecords(t *testing.T) {
 	}
 }
 
+func TestSketchSidecarRoundTrip(t *testing.T) {
+	dir := t.TempDir()
+	chunkPath := filepath.Join(dir, "2024_daily.zst")
+
+	records := make([]types.DailyRecord, 0, 100)
+	for i := 0; i < 100; i++ {
+		records = append(records, types.DailyRecord{StationID: 2, Timestamp: uint32(i), Temperature: int16(i * 10), Humidity: 50})
+	}
+	if err := writeDailySketchSidecar(chunkPath, records); err != nil {
+		t.Fatalf("writeDailySketchSidecar() error = %v", err)
+	}
+	if err := writeDailySketchSidecar("", records); err != nil {
+		t.Fatalf("writeDailySketchSidecar(\"\") error = %v", err)
+	}
+
+	sidecar := chunkSidecarPath(dir, types.ChunkInfo{FilePath: chunkPath}, ".sketch")
+	s, err := readSketchSidecar(sidecar, "temperature")
+	if err != nil {
+		t.Fatalf("readSketchSidecar() error = %v", err)
+	}
+	if s.Count() != 100 || s.Percentile(50) != 49 || s.Max() != 99 {
+		t.Fatalf("temperature sketch n=%d p50=%v max=%v", s.Count(), s.Percentile(50), s.Max())
+	}
+	if _, err := readSketchSidecar(sidecar, "vapor_pressure"); err == nil {
+		t.Fatal("expected missing field error")
+	}
+	if err := os.WriteFile(sidecar, []byte("junk"), 0644); err != nil {
+		t.Fatalf("WriteFile() error = %v", err)
+	}
+	if _, err := readSketchSidecar(sidecar, "temperature"); err == nil {
+		t.Fatal("expected invalid sidecar error")
+	}
+
+	hourlyPath := filepath.Join(dir, "2024_hourly.zst")
+	if err := writeHourlySketchSidecar(hourlyPath, []types.HourlyRecord{{StationID: 2, Precipitation: 250}}); err != nil {
+		t.Fatalf("writeHourlySketchSidecar() error = %v", err)
+	}
+	hs, err := readSketchSidecar(strings.TrimSuffix(hourlyPath, ".zst")+".sketch", "precipitation")
+	if err != nil || hs.Max() != 2.5 {
+		t.Fatalf("hourly precipitation sketch = %v, %v", hs, err)
+	}
+
+	derived := chunkSidecarPath("/data", types.ChunkInfo{StationID: 7, Year: 2020, DataType: types.DataTypeHourly}, ".sketch")
+	if derived != filepath.Join("/data", "stations", "007", "2020_hourly.sketch") {
+		t.Fatalf("chunkSidecarPath() = %q", derived)
+	}
+}
+
+func TestRunPercentileQueryValidation(t *testing.T) {
+	dataDir := t.TempDir()
+	tests := []struct {
+		name string
+		args []string
+	}{
+		{"out of range", []string{"-percentile", "101", "-stations", "2"}},
+		{"unknown daily field", []string{"-percentile", "95", "-stations", "2", "-field", "precipitation"}},
+		{"unknown hourly field", []string{"-percentile", "95", "-stations", "2", "-hourly", "-field", "bogus"}},
+		{"no stations", []string{"-percentile", "95"}},
+		{"missing stations dir", []string{"-percentile", "95", "-stations", "all"}},
+		{"bad start", []string{"-percentile", "95", "-station", "2", "-start", "bad"}},
+		{"bad end", []string{"-percentile", "95", "-station", "2", "-end", "bad"}},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			if err := runQuery(dataDir, tt.args); err == nil {
+				t.Fatalf("runQuery(%v) expected error", tt.args)
+			}
+		})
+	}
+}
+
+func TestCmdQueryPercentileAcrossStations(t *testing.T) {
+	dataDir := t.TempDir()
+	captureStdout(t, func() {
+		cmdInit(dataDir)
+	})
+
+	writer, err := storage.NewChunkWriter(dataDir, 1)
+	if err != nil {
+		t.Fatalf("NewChunkWriter() error = %v", err)
+	}
+	store, err := metadata.NewStore(filepath.Join(dataDir, "metadata.sqlite3"))
+	if err != nil {
+		t.Fatalf("NewStore() error = %v", err)
+	}
+	for _, sid := range []uint16{2, 5} {
+		records := make([]types.DailyRecord, 0, 100)
+		for i := 0; i < 100; i++ {
+			records = append(records, types.DailyRecord{
+				Timestamp:   types.TimeToDaysSinceEpoch(time.Date(2024, 1, 1, 0, 0, 0, 0, time.UTC).AddDate(0, 0, i)),
+				StationID:   sid,
+				Temperature: int16(i*10 + int(sid)*1000),
+			})
+		}
+		chunkInfo, err := writer.WriteDailyChunk(sid, 2024, records)
+		if err != nil {
+			t.Fatalf("WriteDailyChunk() error = %v", err)
+		}
+		if err := store.SaveChunk(chunkInfo); err != nil {
+			t.Fatalf("SaveChunk() error = %v", err)
+		}
+		// Only station 2 gets a sidecar up front; station 5 is backfilled.
+		if sid == 2 {
+			if err := writeDailySketchSidecar(chunkInfo.FilePath, records); err != nil {
+				t.Fatalf("writeDailySketchSidecar() error = %v", err)
+			}
+		}
+	}
+	if err := store.Close(); err != nil {
+		t.Fatalf("Close store: %v", err)
+	}
+
+	output := captureStdout(t, func() {
+		cmdQuery(dataDir, []string{"-percentile", "100", "-stations", "all", "-start", "2024-01-01", "-end", "2024-12-31"})
+	})
+	for _, want := range []string{"Stations: 2, chunks: 2 (backfilled 1, failed 0)", "P100 temperature: 599.00", "over 200 values", "Min/Max: 200.00 / 599.00"} {
+		if !strings.Contains(output, want) {
+			t.Fatalf("percentile output missing %q:\n%s", want, output)
+		}
+	}
+	if _, err := os.Stat(filepath.Join(dataDir, "stations", "005", "2024_daily.sketch")); err != nil {
+		t.Fatalf("expected backfilled sidecar: %v", err)
+	}
+}
+
+func TestCmdQueryLatestFromTailIndex(t *testing.T) {
+	dataDir := t.TempDir()
+	captureStdout(t, func() {
+		cmdInit(dataDir)
+	})
+
+	writer, err := storage.NewChunkWriter(dataDir, 1)
+	if err != nil {
+		t.Fatalf("NewChunkWriter() error = %v", err)
+	}
+	store, err := metadata.NewStore(filepath.Join(dataDir, "metadata.sqlite3"))
+	if err != nil {
+		t.Fatalf("NewStore() error = %v", err)
+	}
+	for _, sid := range []uint16{2, 5} {
+		records := make([]types.DailyRecord, 0, 30)
+		for i := 0; i < 30; i++ {
+			records = append(records, types.DailyRecord{
+				Timestamp:   types.TimeToDaysSinceEpoch(time.Date(2024, 3, 1, 0, 0, 0, 0, time.UTC).AddDate(0, 0, i)),
+				StationID:   sid,
+				Temperature: int16(i*10 + int(sid)*10),
+			})
+		}
+		chunkInfo, err := writer.WriteDailyChunk(sid, 2024, records)
+		if err != nil {
+			t.Fatalf("WriteDailyChunk() error = %v", err)
+		}
+		if err := store.SaveChunk(chunkInfo); err != nil {
+			t.Fatalf("SaveChunk() error = %v", err)
+		}
+		// Only station 2 is indexed up front; station 5 is backfilled.
+		if sid == 2 {
+			if err := updateTailIndex(chunkInfo.FilePath, records, nil); err != nil {
+				t.Fatalf("updateTailIndex() error = %v", err)
+			}
+		}
+	}
+	if err := store.Close(); err != nil {
+		t.Fatalf("Close store: %v", err)
+	}
+
+	output := captureStdout(t, func() {
+		cmdQuery(dataDir, []string{"-latest", "-stations", "all"})
+	})
+	for _, want := range []string{"Latest daily record for 2 station(s)", "Station   2  2024-03-30: Temp=31.0°C", "Station   5  2024-03-30: Temp=34.0°C", "1 from tail index, 1 from chunks, 0 without data"} {
+		if !strings.Contains(output, want) {
+			t.Fatalf("latest output missing %q:\n%s", want, output)
+		}
+	}
+
+	output = captureStdout(t, func() {
+		cmdQuery(dataDir, []string{"-latest", "-stations", "2,5"})
+	})
+	if !strings.Contains(output, "2 from tail index, 0 from chunks") {
+		t.Fatalf("station 5 should have been backfilled:\n%s", output)
+	}
+
+	output = captureStdout(t, func() {
+		cmdQuery(dataDir, []string{"-latest", "-station", "2", "-hourly"})
+	})
+	if !strings.Contains(output, "Station   2  no data") {
+		t.Fatalf("expected no hourly data:\n%s", output)
+	}
+}
+
 func TestRunQueryMissingChunkWarnings(t *testing.T) {
 	for _, tt := range []struct {
 		name     string
@@ -900,7 +1111,7 @@ func TestCmdVerifyValidAndInvalidChunks(t *testing.T) {
 	}
 
 	output := captureStdout(t, func() {
-		cmdVerify(dataDir)
+		cmdVerify(dataDir, "", nil)
 	})
 	if !strings.Contains(output, "1 OK, 0 failed") {
 		t.Fatalf("cmdVerify output = %q", output)
@@ -918,7 +1129,7 @@ func TestRunVerifyInvalidChunk(t *testing.T) {
 	}
 
 	output := captureStdout(t, func() {
-		if err := runVerify(dataDir); err == nil {
+		if err := runVerify(dataDir, "", nil); err == nil {
 			t.Fatal("expected runVerify error for invalid chunk")
 		}
 	})
@@ -946,7 +1157,7 @@ func TestRunVerifyReadErrors(t *testing.T) {
 		}
 
 		output := captureStdout(t, func() {
-			if err := runVerify(dataDir); err != nil {
+			if err := runVerify(dataDir, "", nil); err != nil {
 				t.Fatalf("runVerify() error = %v", err)
 			}
 		})
@@ -973,7 +1184,7 @@ func TestRunVerifyReadErrors(t *testing.T) {
 		}
 
 		output := captureStdout(t, func() {
-			if err := runVerify(dataDir); err == nil {
+			if err := runVerify(dataDir, "", nil); err == nil {
 				t.Fatal("expected runVerify read error")
 			}
 		})
@@ -983,6 +1194,213 @@ func TestRunVerifyReadErrors(t *testing.T) {
 	})
 }
 
+func TestMissingSpansAndCoalesce(t *testing.T) {
+	present := map[uint32]struct{}{}
+	for _, ts := range []uint32{10, 11, 14, 15, 19} {
+		present[ts] = struct{}{}
+	}
+
+	spans := missingSpans(present, 10, 20)
+	want := []timestampSpan{{12, 13}, {16, 18}, {20, 20}}
+	if len(spans) != len(want) {
+		t.Fatalf("missingSpans() = %v, want %v", spans, want)
+	}
+	for i := range want {
+		if spans[i] != want[i] {
+			t.Fatalf("missingSpans()[%d] = %v, want %v", i, spans[i], want[i])
+		}
+	}
+
+	if got := missingSpans(present, 10, 11); len(got) != 0 {
+		t.Fatalf("missingSpans() over complete range = %v, want none", got)
+	}
+
+	merged := coalesceSpans(spans, 2)
+	if len(merged) != 1 || merged[0] != (timestampSpan{12, 20}) {
+		t.Fatalf("coalesceSpans(2) = %v, want [{12 20}]", merged)
+	}
+	if got := coalesceSpans(spans, 0); len(got) != 3 {
+		t.Fatalf("coalesceSpans(0) = %v, want 3 spans", got)
+	}
+	if got := coalesceSpans(nil, 24); got != nil {
+		t.Fatalf("coalesceSpans(nil) = %v, want nil", got)
+	}
+}
+
+func TestParseChunkFileNameAndBounds(t *testing.T) {
+	tests := []struct {
+		name     string
+		year     int
+		dataType types.DataType
+		ok       bool
+	}{
+		{"2024_daily.zst", 2024, types.DataTypeDaily, true},
+		{"2023_hourly.zst", 2023, types.DataTypeHourly, true},
+		{"2024_optimized.zst", 0, "", false},
+		{"daily.zst", 0, "", false},
+		{"abcd_daily.zst", 0, "", false},
+	}
+	for _, tt := range tests {
+		year, dataType, ok := parseChunkFileName(tt.name)
+		if year != tt.year || dataType != tt.dataType || ok != tt.ok {
+			t.Errorf("parseChunkFileName(%q) = %d, %q, %v", tt.name, year, dataType, ok)
+		}
+	}
+
+	now := time.Date(2024, 3, 10, 12, 0, 0, 0, time.UTC)
+	start, end, ok := chunkTimestampBounds(2024, types.DataTypeDaily, now)
+	if !ok || start != types.TimeToDaysSinceEpoch(time.Date(2024, 1, 1, 0, 0, 0, 0, time.UTC)) ||
+		end != types.TimeToDaysSinceEpoch(time.Date(2024, 3, 9, 0, 0, 0, 0, time.UTC)) {
+		t.Fatalf("daily bounds = %d-%d (%v)", start, end, ok)
+	}
+	start, end, ok = chunkTimestampBounds(2023, types.DataTypeHourly, now)
+	if !ok || end-start+1 != 365*24 {
+		t.Fatalf("hourly bounds = %d-%d (%v), want a full year of hours", start, end, ok)
+	}
+	if _, _, ok := chunkTimestampBounds(2025, types.DataTypeDaily, now); ok {
+		t.Fatal("expected future year to have no bounds")
+	}
+}
+
+func TestRunVerifyRepairRequiresAppKey(t *testing.T) {
+	t.Setenv("CIMIS_APP_KEY", "")
+	if err := runVerify(t.TempDir(), "", []string{"-repair"}); err == nil || !strings.Contains(err.Error(), "app key") {
+		t.Fatalf("runVerify(-repair) error = %v, want app key error", err)
+	}
+	if err := runVerify(t.TempDir(), "", []string{"-unknown"}); err == nil {
+		t.Fatal("expected flag parse error")
+	}
+}
+
+func TestRunVerifyRepairRefetchesOnlyMissingDays(t *testing.T) {
+	originalNow := repairNow
+	t.Cleanup(func() { repairNow = originalNow })
+	repairNow = func() time.Time { return time.Date(2024, 6, 1, 0, 0, 0, 0, time.UTC) }
+
+	var requested []string
+	server := httptest.NewServer(http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		startDate := r.URL.Query().Get("startDate")
+		endDate := r.URL.Query().Get("endDate")
+		requested = append(requested, startDate+".."+endDate)
+
+		from, _ := time.Parse("2006-01-02", startDate)
+		to, _ := time.Parse("2006-01-02", endDate)
+		var recs []string
+		for d := from; !d.After(to); d = d.AddDate(0, 0, 1) {
+			recs = append(recs, fmt.Sprintf(`{"Date":"%s","DayAirTmpAvg":{"Value":"20.0","Qc":" "},"DayAsceEto":{"Value":"3.0","Qc":" "},"DayWindSpdAvg":{"Value":"1.0","Qc":" "},"DayRelHumAvg":{"Value":"50","Qc":" "},"DaySolRadAvg":{"Value":"2.0","Qc":" "}}`, d.Format("2006-01-02")))
+		}
+		w.Header().Set("Content-Type", "application/json")
+		fmt.Fprintf(w, `{"Data":{"Providers":[{"Records":[%s]}]}}`, strings.Join(recs, ","))
+	}))
+	defer server.Close()
+	installMockCIMISClients(t, server.URL)
+
+	dataDir := t.TempDir()
+	captureStdout(t, func() {
+		cmdInit(dataDir)
+	})
+
+	// 2023 with Jan 10-12 and Jan 15 missing and a corrupt record dropped in.
+	var records []types.DailyRecord
+	for d := time.Date(2023, 1, 1, 0, 0, 0, 0, time.UTC); d.Year() == 2023; d = d.AddDate(0, 0, 1) {
+		if d.Month() == time.January && (d.Day() >= 10 && d.Day() <= 12 || d.Day() == 15) {
+			continue
+		}
+		records = append(records, types.DailyRecord{
+			Timestamp:   types.TimeToDaysSinceEpoch(d),
+			StationID:   2,
+			Temperature: types.ScaleTemperature(18.0),
+			Humidity:    55,
+		})
+	}
+	records = append(records, types.DailyRecord{Timestamp: 1, StationID: 2, Humidity: 250})
+
+	writer, err := storage.NewChunkWriter(dataDir, 1)
+	if err != nil {
+		t.Fatalf("NewChunkWriter() error = %v", err)
+	}
+	if _, err := writer.WriteDailyChunk(2, 2023, records); err != nil {
+		t.Fatalf("WriteDailyChunk() error = %v", err)
+	}
+
+	// The chunk decompresses, so plain -repair leaves its gaps alone.
+	output := captureStdout(t, func() {
+		if err := runVerify(dataDir, "test-key", []string{"-repair"}); err != nil {
+			t.Fatalf("runVerify(-repair) error = %v", err)
+		}
+	})
+	if len(requested) != 0 || !strings.Contains(output, "Repaired: 0 chunk(s)") {
+		t.Fatalf("-repair touched a healthy chunk: requested %v, output %q", requested, output)
+	}
+
+	output = captureStdout(t, func() {
+		if err := runVerify(dataDir, "test-key", []string{"-backfill"}); err != nil {
+			t.Fatalf("runVerify(-backfill) error = %v", err)
+		}
+	})
+	if !strings.Contains(output, "salvaged 361, dropped 1, re-fetched 4 record(s) across 2 span(s)") {
+		t.Fatalf("repair output = %q", output)
+	}
+	// Both gaps are a few days apart, so they share one request.
+	if len(requested) != 1 || requested[0] != "2023-01-10..2023-01-15" {
+		t.Fatalf("requested spans = %v, want only 2023-01-10..2023-01-15", requested)
+	}
+
+	repairedRecords, err := storage.NewChunkReader(dataDir).ReadDailyChunk(2, 2023)
+	if err != nil {
+		t.Fatalf("ReadDailyChunk() after repair error = %v", err)
+	}
+	if len(repairedRecords) != 365 {
+		t.Fatalf("repaired chunk has %d records, want 365", len(repairedRecords))
+	}
+	entries, err := os.ReadDir(dataDir)
+	if err != nil {
+		t.Fatalf("ReadDir() error = %v", err)
+	}
+	for _, entry := range entries {
+		if strings.HasPrefix(entry.Name(), ".repair-") {
+			t.Fatalf("repair scratch dir %s left behind", entry.Name())
+		}
+	}
+
+	// The repaired chunk is framed per block. Damage the second frame (days
+	// 64-127): plain -repair keeps the other frames and re-fetches only the
+	// dates that frame held.
+	paths, _ := filepath.Glob(filepath.Join(dataDir, "stations", "*", "*.zst"))
+	if len(paths) != 1 {
+		t.Fatalf("chunk files = %v, want one", paths)
+	}
+	data, err := os.ReadFile(paths[0])
+	if err != nil {
+		t.Fatal(err)
+	}
+	frameMagic := []byte{0x28, 0xb5, 0x2f, 0xfd}
+	second := bytes.Index(data[1:], frameMagic) + 1
+	third := bytes.Index(data[second+1:], frameMagic) + second + 1
+	if second <= 0 || third <= second {
+		t.Fatalf("repaired chunk is not framed per block")
+	}
+	data[(second+third)/2] ^= 0xff
+	if err := os.WriteFile(paths[0], data, 0644); err != nil {
+		t.Fatalf("WriteFile() error = %v", err)
+	}
+	requested = nil
+	output = captureStdout(t, func() {
+		if err := runVerify(dataDir, "test-key", []string{"-repair"}); err != nil {
+			t.Fatalf("runVerify(-repair) on damaged chunk error = %v", err)
+		}
+	})
+	if !strings.Contains(output, "salvaged 301, dropped 0, re-fetched 64 record(s) across 1 span(s)") {
+		t.Fatalf("damaged chunk repair output = %q", output)
+	}
+	if len(requested) != 1 || requested[0] != "2023-03-06..2023-05-08" {
+		t.Fatalf("requested spans = %v, want only the damaged frame's 2023-03-06..2023-05-08", requested)
+	}
+	if repairedRecords, err = storage.NewChunkReader(dataDir).ReadDailyChunk(2, 2023); err != nil || len(repairedRecords) != 365 {
+		t.Fatalf("ReadDailyChunk() after block repair = %d records, %v", len(repairedRecords), err)
+	}
+}
+
 func TestFetchStationStreamingWritesAndSkipsExistingChunk(t *testing.T) {
 	var requestCount int
 	server := httptest.NewServer(http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
@@ -1015,7 +1433,7 @@ func TestFetchStationStreamingWritesAndSkipsExistingChunk(t *testing.T) {
 	start := time.Date(2024, 1, 1, 0, 0, 0, 0, time.UTC)
 	end := time.Date(2024, 12, 31, 0, 0, 0, 0, time.UTC)
 
-	result := fetchStationStreaming(client, store, writer, 2, start, end, "v1", false, 0)
+	result := fetchStationStreaming(client, store, writer, 1, 2, start, end, "v1", false, 0, nil)
 	if !result.success {
 		t.Fatalf("fetchStationStreaming failed: %v", result.err)
 	}
@@ -1026,16 +1444,21 @@ func TestFetchStationStreamingWritesAndSkipsExistingChunk(t *testing.T) {
 		t.Fatalf("requestCount = %d, want 1", requestCount)
 	}
 
-	result = fetchStationStreaming(client, store, writer, 2, start, end, "v1", false, 0)
+	result = fetchStationStreaming(client, store, writer, 1, 2, start, end, "v1", false, 0, nil)
 	if !result.success {
 		t.Fatalf("existing chunk result failed: %v", result.err)
 	}
-	if result.recordCount != 0 {
-		t.Fatalf("existing chunk recordCount = %d, want 0", result.recordCount)
+	if result.recordCount != 0 || !result.skipped {
+		t.Fatalf("existing chunk result = %+v, want skipped with 0 records", result)
 	}
 	if requestCount != 1 {
 		t.Fatalf("existing chunk should not refetch; requestCount = %d", requestCount)
 	}
+	latencies := newFetchPhaseLatencies()
+	latencies.record(result)
+	if got := latencies[0].Count(); got != 0 {
+		t.Fatalf("skipped station recorded %d latency sample(s)", got)
+	}
 }
 
 func TestFetchStationStreamingFailure(t *testing.T) {
@@ -1061,7 +1484,7 @@ func TestFetchStationStreamingFailure(t *testing.T) {
 	start := time.Date(2024, 1, 1, 0, 0, 0, 0, time.UTC)
 	end := time.Date(2024, 12, 31, 0, 0, 0, 0, time.UTC)
 
-	result := fetchStationStreaming(client, store, writer, 2, start, end, "v1", true, 0)
+	result := fetchStationStreaming(client, store, writer, 1, 2, start, end, "v1", true, 0, nil)
 	if result.success {
 		t.Fatal("expected failed result")
 	}
@@ -1109,7 +1532,7 @@ func TestFetchStationStreamingRetriesThenSucceeds(t *testing.T) {
 	start := time.Date(2024, 1, 1, 0, 0, 0, 0, time.UTC)
 	end := time.Date(2024, 12, 31, 0, 0, 0, 0, time.UTC)
 
-	result := fetchStationStreaming(client, store, writer, 2, start, end, "v1", false, 1)
+	result := fetchStationStreaming(client, store, writer, 1, 2, start, end, "v1", false, 1, nil)
 	if !result.success {
 		t.Fatalf("fetchStationStreaming retry result failed: %v", result.err)
 	}
@@ -1144,7 +1567,7 @@ func TestFetchStationStreamingWriteAndSaveErrors(t *testing.T) {
 		client := api.NewOptimizedClient("test-key")
 		client.SetBaseURL(server.URL)
 
-		result := fetchStationStreaming(client, store, writer, 2, start, end, "v1", false, 0)
+		result := fetchStationStreaming(client, store, writer, 1, 2, start, end, "v1", false, 0, nil)
 		if result.success || result.err == nil {
 			t.Fatalf("expected write error result, got %+v", result)
 		}
@@ -1168,7 +1591,7 @@ func TestFetchStationStreamingWriteAndSaveErrors(t *testing.T) {
 		client := api.NewOptimizedClient("test-key")
 		client.SetBaseURL(server.URL)
 
-		result := fetchStationStreaming(client, store, writer, 2, start, end, "v1", false, 0)
+		result := fetchStationStreaming(client, store, writer, 1, 2, start, end, "v1", false, 0, nil)
 		if result.success || result.err == nil {
 			t.Fatalf("expected save metadata error result, got %+v", result)
 		}
@@ -1310,7 +1733,7 @@ func TestCmdFetchStreamingWithMockAPI(t *testing.T) {
 			"-allocs",
 		})
 	})
-	for _, want := range []string{"Fetch Streaming Summary", "Successful: 1", "Total records: 1", "Performance Metrics"} {
+	for _, want := range []string{"Fetch Streaming Summary", "Successful: 1", "Total records: 1", "Performance Metrics", "Latency Percentiles (1 stations)", "TTFB:    p50="} {
 		if !strings.Contains(output, want) {
 			t.Fatalf("cmdFetchStreaming output missing %q:\n%s", want, output)
 		}
@@ -1872,3 +2295,153 @@ func TestRunProfileMemoryIngestNoRecords(t *testing.T) {
 		t.Fatalf("runProfile ingest output = %q", output)
 	}
 }
+
+func TestCmdClimatologyIncremental(t *testing.T) {
+	dataDir := t.TempDir()
+	captureStdout(t, func() {
+		cmdInit(dataDir)
+	})
+
+	writer, err := storage.NewChunkWriter(dataDir, 1)
+	if err != nil {
+		t.Fatalf("NewChunkWriter() error = %v", err)
+	}
+	writeYear := func(year, days int) {
+		store, err := metadata.NewStore(filepath.Join(dataDir, "metadata.sqlite3"))
+		if err != nil {
+			t.Fatalf("NewStore() error = %v", err)
+		}
+		defer store.Close()
+
+		var records []types.DailyRecord
+		for d := time.Date(year, 1, 1, 0, 0, 0, 0, time.UTC); d.Year() == year && len(records) < days; d = d.AddDate(0, 0, 1) {
+			records = append(records, types.DailyRecord{
+				Timestamp:   types.TimeToDaysSinceEpoch(d),
+				StationID:   2,
+				Temperature: int16(100 + 10*(year-2022)),
+			})
+		}
+		chunkInfo, err := writer.WriteDailyChunk(2, year, records)
+		if err != nil {
+			t.Fatalf("WriteDailyChunk() error = %v", err)
+		}
+		if err := store.SaveChunk(chunkInfo); err != nil {
+			t.Fatalf("SaveChunk() error = %v", err)
+		}
+	}
+	writeYear(2022, 366)
+
+	output := captureStdout(t, func() {
+		cmdClimatology(dataDir, nil)
+	})
+	if !strings.Contains(output, "1 station(s)") || !strings.Contains(output, "1 new chunk(s) read, 0 already included") {
+		t.Fatalf("first build output unexpected:\n%s", output)
+	}
+
+	// 2023 is still partial (through Jul 19) when it is first folded in.
+	writeYear(2023, 200)
+	output = captureStdout(t, func() {
+		cmdClimatology(dataDir, []string{"-stations", "2"})
+	})
+	if !strings.Contains(output, "1 new chunk(s) read, 1 already included") {
+		t.Fatalf("incremental build should only read 2023:\n%s", output)
+	}
+
+	// Once the rest of 2023 arrives its record count changes, and the
+	// station is rebuilt so the late days reach the baseline.
+	writeYear(2023, 366)
+	output = captureStdout(t, func() {
+		cmdClimatology(dataDir, nil)
+	})
+	if !strings.Contains(output, "2 new chunk(s) read, 0 already included, 1 station(s) rebuilt") {
+		t.Fatalf("grown 2023 chunk should rebuild the station:\n%s", output)
+	}
+	output = captureStdout(t, func() {
+		cmdClimatology(dataDir, nil)
+	})
+	if !strings.Contains(output, "0 new chunk(s) read, 2 already included, 0 station(s) rebuilt") {
+		t.Fatalf("unchanged chunks should not be read again:\n%s", output)
+	}
+
+	stations, err := climatology.Read(filepath.Join(dataDir, climatologyFileName))
+	if err != nil {
+		t.Fatalf("climatology.Read() error = %v", err)
+	}
+	cell := stations[0].Cell(0, climatology.SlotForDate(3, 1))
+	if stations[0].ID != 2 || cell.Count != 2 || cell.Mean != 10.5 || cell.Min != 10 || cell.Max != 11 {
+		t.Fatalf("Mar 1 temperature baseline = %+v", cell)
+	}
+	if cell := stations[0].Cell(0, climatology.SlotForDate(12, 31)); cell.Count != 2 {
+		t.Fatalf("Dec 31 count = %d, want both years", cell.Count)
+	}
+	if err := runClimatology(dataDir, []string{"-workers", "0"}); err == nil {
+		t.Fatal("expected error for -workers 0")
+	}
+}
+
+func TestRunStationsAndSpatialQuery(t *testing.T) {
+	server := httptest.NewServer(http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		if r.URL.Path != "/StationWeb/GetAllStations" {
+			t.Errorf("unexpected path %s", r.URL.Path)
+		}
+		w.Header().Set("Content-Type", "application/json")
+		fmt.Fprint(w, `{"Stations":[`+
+			`{"StationNbr":"2","Name":"FivePoints","IsActive":"True","HmsLatitude":"36º20'10N / 36.336222","HmsLongitude":"-120º6'46W / -120.11291"},`+
+			`{"StationNbr":"5","Name":"Shafter","IsActive":"True","HmsLatitude":"35º31'57N / 35.532556","HmsLongitude":"-119º16'54W / -119.28175"},`+
+			`{"StationNbr":"7","Name":"NoCoords","IsActive":"False"}]}`)
+	}))
+	defer server.Close()
+	installMockCIMISClients(t, server.URL)
+
+	dataDir := t.TempDir()
+	captureStdout(t, func() {
+		cmdInit(dataDir)
+	})
+
+	if err := runSpatialQuery(dataDir, spatialOptions{lat: 36, lon: -120, k: 2, power: 2, field: "temperature", startDate: "2024-01-01", endDate: "2024-01-05"}); err == nil || !strings.Contains(err.Error(), "cimis stations") {
+		t.Fatalf("expected missing cache error, got %v", err)
+	}
+	if err := runStations(dataDir, "", []string{"-refresh"}); err == nil {
+		t.Fatal("expected app key error")
+	}
+
+	output := captureStdout(t, func() {
+		cmdStations(dataDir, "test-key", nil)
+	})
+	if !strings.Contains(output, "Cached 2 station coordinates") || !strings.Contains(output, "1 skipped") {
+		t.Fatalf("unexpected stations output:\n%s", output)
+	}
+	output = captureStdout(t, func() {
+		cmdStations(dataDir, "", nil)
+	})
+	if !strings.Contains(output, "2 cached") {
+		t.Fatalf("cached stations should not need a fetch:\n%s", output)
+	}
+
+	writer, err := storage.NewChunkWriter(dataDir, 1)
+	if err != nil {
+		t.Fatalf("NewChunkWriter() error = %v", err)
+	}
+	for _, sid := range []uint16{2, 5} {
+		var records []types.DailyRecord
+		for i := 0; i < 10; i++ {
+			records = append(records, types.DailyRecord{
+				Timestamp:   types.TimeToDaysSinceEpoch(time.Date(2024, 1, 1+i, 0, 0, 0, 0, time.UTC)),
+				StationID:   sid,
+				Temperature: int16(sid) * 50,
+			})
+		}
+		if _, err := writer.WriteDailyChunk(sid, 2024, records); err != nil {
+			t.Fatalf("WriteDailyChunk() error = %v", err)
+		}
+	}
+
+	output = captureStdout(t, func() {
+		cmdQuery(dataDir, []string{"-lat", "36.336222", "-lon", "-120.11291", "-k", "2", "-start", "2024-01-01", "-end", "2024-01-05"})
+	})
+	for _, want := range []string{"Nearest 2 station(s)", "Station 2 (FivePoints): 0.0 km", "Station 5 (Shafter)", "2024-01-01: 10.00", "Estimated 4 of 4 day(s)"} {
+		if !strings.Contains(output, want) {
+			t.Fatalf("spatial query output missing %q:\n%s", want, output)
+		}
+	}
+}
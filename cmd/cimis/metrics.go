@@ -2,13 +2,126 @@ package main
 
 import (
 	"encoding/json"
+	"errors"
 	"fmt"
+	"log"
+	"net"
+	"net/http"
 	"os"
 	"runtime"
 	"strings"
 	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/api"
+	"github.com/dl-alexandre/cimis-cli/internal/metrics"
+)
+
+// Prometheus series recorded by fetch, ingest and query. Names follow the
+// dashboard and alerting list in docs/streaming-client.md.
+var (
+	fetchRequestsTotal    = metrics.Default.Counter("cimis_fetch_requests_total", "Station fetch requests sent, including retries.")
+	fetchErrorsTotal      = metrics.Default.Counter("cimis_fetch_errors_total", "Station fetch requests that failed.")
+	jsonDecodeErrorsTotal = metrics.Default.Counter("cimis_json_decode_errors_total", "API responses that could not be decoded.")
+	bytesFetchedTotal     = metrics.Default.Counter("cimis_bytes_fetched_total", "Response bytes received from the CIMIS API.")
+	recordsIngestedTotal  = metrics.Default.Counter("cimis_records_ingested_total", "Records written to chunks.")
+	chunkBytesWritten     = metrics.Default.Counter("cimis_chunk_bytes_written_total", "Compressed chunk bytes written.")
+	chunkWriteDuration    = metrics.Default.Histogram("cimis_chunk_write_duration_seconds", "Time to encode, compress and write one chunk.", metrics.DefBuckets)
+	recordsPerSecond      = metrics.Default.Gauge("cimis_records_per_second", "Throughput of the last fetch or query run.")
+	compressRatio         = metrics.Default.Gauge("cimis_compress_ratio", "Compression ratio of the last chunk written.")
+	cacheHitRatio         = metrics.Default.Gauge("cache_hit_ratio", "Chunk cache hit ratio of the last query.")
+	activeConnections     = metrics.Default.Gauge("cimis_active_connections", "API requests in flight.")
+	workerPoolUtilization = metrics.Default.Gauge("cimis_worker_pool_utilization", "Fraction of fetch workers busy.")
+)
+
+// Per-phase duration series, resolved once so observations skip the
+// registry lookup and its lock.
+var (
+	fetchDNSDuration    = fetchDuration("dns")
+	fetchTCPDuration    = fetchDuration("tcp")
+	fetchTLSDuration    = fetchDuration("tls")
+	fetchTTFBDuration   = fetchDuration("ttfb")
+	fetchReadDuration   = fetchDuration("read")
+	fetchDecodeDuration = fetchDuration("decode")
+	fetchTotalDuration  = fetchDuration("total")
+
+	queryMetadataDuration = queryDuration("metadata")
+	queryReadDuration     = queryDuration("read")
+	queryFilterDuration   = queryDuration("filter")
+	queryTotalDuration    = queryDuration("total")
 )
 
+// fetchDuration is cimis_fetch_duration_seconds for one request phase.
+func fetchDuration(phase string) *metrics.Histogram {
+	return metrics.Default.Histogram("cimis_fetch_duration_seconds", "API fetch time by phase.", metrics.DefBuckets, "phase", phase)
+}
+
+// queryDuration is cimis_query_duration_seconds for one query phase.
+func queryDuration(phase string) *metrics.Histogram {
+	return metrics.Default.Histogram("cimis_query_duration_seconds", "Query time by phase.", metrics.DefBuckets, "phase", phase)
+}
+
+// recordFetch feeds one API request's outcome and timings into the registry.
+func recordFetch(m *api.FetchMetrics, err error) {
+	fetchRequestsTotal.Inc()
+	if err != nil {
+		fetchErrorsTotal.Inc()
+		var decodeErr *api.DecodeError
+		if errors.As(err, &decodeErr) {
+			jsonDecodeErrorsTotal.Inc()
+		}
+	}
+	if m == nil {
+		return
+	}
+	phases := [...]struct {
+		h *metrics.Histogram
+		d time.Duration
+	}{
+		{fetchDNSDuration, m.DNSLookup}, {fetchTCPDuration, m.TCPConnect}, {fetchTLSDuration, m.TLSHandshake},
+		{fetchTTFBDuration, m.TTFB}, {fetchReadDuration, m.BodyRead}, {fetchDecodeDuration, m.JSONDecode},
+	}
+	for _, p := range phases {
+		if p.d > 0 {
+			p.h.ObserveDuration(p.d)
+		}
+	}
+	if err == nil {
+		fetchTotalDuration.ObserveDuration(m.TotalDuration)
+		bytesFetchedTotal.Add(uint64(m.BytesTransferred))
+	}
+}
+
+// recordChunkWrite feeds one chunk write into the registry.
+func recordChunkWrite(records int, fileSize int64, ratio float64, d time.Duration) {
+	recordsIngestedTotal.Add(uint64(records))
+	if fileSize > 0 {
+		chunkBytesWritten.Add(uint64(fileSize))
+	}
+	if ratio > 0 {
+		compressRatio.Set(ratio)
+	}
+	chunkWriteDuration.ObserveDuration(d)
+}
+
+// startMetricsServer serves the registry at /metrics on addr until the
+// returned server is closed.
+func startMetricsServer(addr string) (*http.Server, error) {
+	ln, err := net.Listen("tcp", addr)
+	if err != nil {
+		return nil, fmt.Errorf("metrics listener: %w", err)
+	}
+	mux := http.NewServeMux()
+	mux.Handle("/metrics", metrics.Default.Handler())
+	server := &http.Server{Handler: mux}
+	go func() {
+		if err := server.Serve(ln); err != nil && err != http.ErrServerClosed {
+			log.Printf("metrics server error: %v", err)
+		}
+	}()
+	fmt.Printf("Serving metrics on http://%s/metrics\n", ln.Addr())
+	return server, nil
+}
+
 type AllocMetrics struct {
 	BeforeAlloc    uint64
 	BeforeHeap     uint64
@@ -3,10 +3,15 @@ package main
 import (
 	"encoding/json"
 	"errors"
+	"io"
+	"net/http"
 	"os"
 	"path/filepath"
+	"strings"
 	"testing"
 	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/api"
 )
 
 func TestAllocMetricsString(t *testing.T) {
@@ -196,3 +201,54 @@ func TestPrintJSONResults(t *testing.T) {
 		t.Errorf("TotalRecords = %d, want 10", summary.TotalRecords)
 	}
 }
+
+func TestRecordFetchAndServeMetrics(t *testing.T) {
+	decodeErrors := jsonDecodeErrorsTotal.Value()
+	fetchErrors := fetchErrorsTotal.Value()
+	bytesFetched := bytesFetchedTotal.Value()
+
+	recordFetch(&api.FetchMetrics{DNSLookup: time.Millisecond, TotalDuration: 20 * time.Millisecond, BytesTransferred: 512}, nil)
+	recordFetch(nil, &api.DecodeError{Err: errors.New("bad token")})
+	recordFetch(nil, errors.New("connection refused"))
+
+	if got := jsonDecodeErrorsTotal.Value() - decodeErrors; got != 1 {
+		t.Fatalf("decode errors recorded = %d, want 1", got)
+	}
+	if got := fetchErrorsTotal.Value() - fetchErrors; got != 2 {
+		t.Fatalf("fetch errors recorded = %d, want 2", got)
+	}
+	if got := bytesFetchedTotal.Value() - bytesFetched; got != 512 {
+		t.Fatalf("bytes fetched recorded = %d, want 512", got)
+	}
+
+	var server *http.Server
+	output := captureStdout(t, func() {
+		var err error
+		if server, err = startMetricsServer("127.0.0.1:0"); err != nil {
+			t.Fatalf("startMetricsServer() error = %v", err)
+		}
+	})
+	defer server.Close()
+	url := strings.TrimSpace(strings.TrimPrefix(output, "Serving metrics on "))
+	resp, err := http.Get(url)
+	if err != nil {
+		t.Fatalf("GET %s: %v", url, err)
+	}
+	defer resp.Body.Close()
+	body, _ := io.ReadAll(resp.Body)
+	for _, want := range []string{
+		`cimis_fetch_duration_seconds_bucket{phase="dns",le="0.005"}`,
+		"# TYPE cimis_records_per_second gauge",
+		"cimis_bytes_fetched_total ",
+		"cache_hit_ratio ",
+		`cimis_query_duration_seconds_count{phase="filter"}`,
+	} {
+		if !strings.Contains(string(body), want) {
+			t.Fatalf("/metrics missing %q:\n%s", want, body)
+		}
+	}
+
+	if _, err := startMetricsServer("bad address"); err == nil {
+		t.Fatal("expected listen error")
+	}
+}
@@ -0,0 +1,344 @@
+package main
+
+import (
+	"encoding/binary"
+	"fmt"
+	"os"
+	"path/filepath"
+	"runtime"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/api"
+	"github.com/dl-alexandre/cimis-cli/internal/sketch"
+	"github.com/dl-alexandre/cimis-tsdb/metadata"
+	"github.com/dl-alexandre/cimis-tsdb/storage"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// sketchSidecarMagic identifies per-chunk quantile sketch sidecars.
+const sketchSidecarMagic = "CSKS"
+
+// dailyFields maps query field names to physical-unit extractors for daily records.
+var dailyFields = map[string]func(types.DailyRecord) float64{
+	"temperature":     func(r types.DailyRecord) float64 { return float64(r.Temperature) / 10.0 },
+	"et":              func(r types.DailyRecord) float64 { return float64(r.ET) / 100.0 },
+	"wind_speed":      func(r types.DailyRecord) float64 { return float64(r.WindSpeed) / 10.0 },
+	"humidity":        func(r types.DailyRecord) float64 { return float64(r.Humidity) },
+	"solar_radiation": func(r types.DailyRecord) float64 { return float64(r.SolarRadiation) / 10.0 },
+}
+
+// hourlyFields maps query field names to physical-unit extractors for hourly records.
+var hourlyFields = map[string]func(types.HourlyRecord) float64{
+	"temperature":     func(r types.HourlyRecord) float64 { return float64(r.Temperature) / 10.0 },
+	"et":              func(r types.HourlyRecord) float64 { return float64(r.ET) / 1000.0 },
+	"wind_speed":      func(r types.HourlyRecord) float64 { return float64(r.WindSpeed) / 10.0 },
+	"wind_direction":  func(r types.HourlyRecord) float64 { return float64(r.WindDirection) * 2 },
+	"humidity":        func(r types.HourlyRecord) float64 { return float64(r.Humidity) },
+	"solar_radiation": func(r types.HourlyRecord) float64 { return float64(r.SolarRadiation) },
+	"precipitation":   func(r types.HourlyRecord) float64 { return float64(r.Precipitation) / 100.0 },
+	"vapor_pressure":  func(r types.HourlyRecord) float64 { return float64(r.VaporPressure) / 100.0 },
+}
+
+// chunkSidecarPath returns the path of a sidecar stored next to a chunk file.
+func chunkSidecarPath(dataDir string, chunk types.ChunkInfo, ext string) string {
+	chunkPath := chunk.FilePath
+	if chunkPath == "" {
+		chunkPath = filepath.Join(dataDir, "stations", fmt.Sprintf("%03d", chunk.StationID),
+			fmt.Sprintf("%d_%s.zst", chunk.Year, chunk.DataType))
+	}
+	return strings.TrimSuffix(chunkPath, ".zst") + ext
+}
+
+// buildDailySketches summarizes every daily field of a chunk.
+func buildDailySketches(records []types.DailyRecord) map[string]*sketch.KLL {
+	sketches := make(map[string]*sketch.KLL, len(dailyFields))
+	for name, extract := range dailyFields {
+		s := sketch.NewKLL(sketch.DefaultK)
+		for _, r := range records {
+			s.Update(extract(r))
+		}
+		sketches[name] = s
+	}
+	return sketches
+}
+
+// buildHourlySketches summarizes every hourly field of a chunk.
+func buildHourlySketches(records []types.HourlyRecord) map[string]*sketch.KLL {
+	sketches := make(map[string]*sketch.KLL, len(hourlyFields))
+	for name, extract := range hourlyFields {
+		s := sketch.NewKLL(sketch.DefaultK)
+		for _, r := range records {
+			s.Update(extract(r))
+		}
+		sketches[name] = s
+	}
+	return sketches
+}
+
+// writeSketchSidecar atomically writes per-field sketches next to a chunk.
+func writeSketchSidecar(path string, sketches map[string]*sketch.KLL) error {
+	names := make([]string, 0, len(sketches))
+	for name := range sketches {
+		names = append(names, name)
+	}
+	sort.Strings(names)
+
+	buf := []byte(sketchSidecarMagic)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(len(names)))
+	for _, name := range names {
+		encoded, err := sketches[name].MarshalBinary()
+		if err != nil {
+			return err
+		}
+		buf = append(buf, byte(len(name)))
+		buf = append(buf, name...)
+		buf = binary.LittleEndian.AppendUint32(buf, uint32(len(encoded)))
+		buf = append(buf, encoded...)
+	}
+
+	tmp := path + ".tmp"
+	if err := os.WriteFile(tmp, buf, 0644); err != nil {
+		return err
+	}
+	return os.Rename(tmp, path)
+}
+
+// readSketchSidecar loads the sketch for a single field from a sidecar.
+func readSketchSidecar(path, field string) (*sketch.KLL, error) {
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return nil, err
+	}
+	if len(data) < 8 || string(data[:4]) != sketchSidecarMagic {
+		return nil, fmt.Errorf("%s: %w", path, sketch.ErrInvalidSketch)
+	}
+	count := int(binary.LittleEndian.Uint32(data[4:]))
+	pos := 8
+	for i := 0; i < count; i++ {
+		if pos+1 > len(data) {
+			break
+		}
+		nameLen := int(data[pos])
+		pos++
+		if pos+nameLen+4 > len(data) {
+			break
+		}
+		name := string(data[pos : pos+nameLen])
+		pos += nameLen
+		size := int(binary.LittleEndian.Uint32(data[pos:]))
+		pos += 4
+		if pos+size > len(data) {
+			break
+		}
+		if name == field {
+			s := &sketch.KLL{}
+			if err := s.UnmarshalBinary(data[pos : pos+size]); err != nil {
+				return nil, fmt.Errorf("%s: %w", path, err)
+			}
+			return s, nil
+		}
+		pos += size
+	}
+	return nil, fmt.Errorf("%s: field %q not found: %w", path, field, sketch.ErrInvalidSketch)
+}
+
+// writeDailySketchSidecar builds and stores sketches for a freshly written daily chunk.
+func writeDailySketchSidecar(chunkPath string, records []types.DailyRecord) error {
+	if chunkPath == "" {
+		return nil
+	}
+	return writeSketchSidecar(strings.TrimSuffix(chunkPath, ".zst")+".sketch", buildDailySketches(records))
+}
+
+// writeHourlySketchSidecar builds and stores sketches for a freshly written hourly chunk.
+func writeHourlySketchSidecar(chunkPath string, records []types.HourlyRecord) error {
+	if chunkPath == "" {
+		return nil
+	}
+	return writeSketchSidecar(strings.TrimSuffix(chunkPath, ".zst")+".sketch", buildHourlySketches(records))
+}
+
+// listStoredStations returns station IDs that have a directory under stations/.
+func listStoredStations(dataDir string) ([]int, error) {
+	entries, err := os.ReadDir(filepath.Join(dataDir, "stations"))
+	if err != nil {
+		return nil, fmt.Errorf("failed to read stations directory: %w", err)
+	}
+	var stations []int
+	for _, entry := range entries {
+		if !entry.IsDir() {
+			continue
+		}
+		if sid, err := strconv.Atoi(entry.Name()); err == nil && sid > 0 {
+			stations = append(stations, sid)
+		}
+	}
+	sortStations(stations)
+	return stations, nil
+}
+
+// resolveStations expands a -stations value ("all", CSV or ranges).
+func resolveStations(dataDir, stationsArg string, stationID int) ([]int, error) {
+	switch {
+	case stationsArg == "all":
+		return listStoredStations(dataDir)
+	case stationsArg != "":
+		return parseStationList(stationsArg)
+	case stationID != 0:
+		return []int{stationID}, nil
+	}
+	return nil, fmt.Errorf("station ID required (-station or -stations)")
+}
+
+type percentileOptions struct {
+	percentile float64
+	field      string
+	stations   string
+	stationID  int
+	startDate  string
+	endDate    string
+	hourly     bool
+}
+
+// runPercentileQuery answers a percentile over many stations from per-chunk
+// sketch sidecars. Chunks without a sidecar are read once and backfilled.
+// Sketches cover whole chunks, so the year range of -start/-end is used.
+func runPercentileQuery(dataDir string, opts percentileOptions) error {
+	if opts.percentile <= 0 || opts.percentile > 100 {
+		return fmt.Errorf("percentile must be in (0, 100]")
+	}
+	if opts.hourly {
+		if _, ok := hourlyFields[opts.field]; !ok {
+			return fmt.Errorf("unknown hourly field: %s", opts.field)
+		}
+	} else if _, ok := dailyFields[opts.field]; !ok {
+		return fmt.Errorf("unknown daily field: %s", opts.field)
+	}
+
+	stationList, err := resolveStations(dataDir, opts.stations, opts.stationID)
+	if err != nil {
+		return err
+	}
+
+	startYear, endYear := api.EpochYear, time.Now().Year()
+	if opts.startDate != "" {
+		start, err := time.Parse("2006-01-02", opts.startDate)
+		if err != nil {
+			return fmt.Errorf("invalid start date: %w", err)
+		}
+		startYear = start.Year()
+	}
+	if opts.endDate != "" {
+		end, err := time.Parse("2006-01-02", opts.endDate)
+		if err != nil {
+			return fmt.Errorf("invalid end date: %w", err)
+		}
+		endYear = end.Year()
+	}
+
+	queryStart := time.Now()
+	store, err := metadata.NewStore(filepath.Join(dataDir, "metadata.sqlite3"))
+	if err != nil {
+		return fmt.Errorf("failed to open metadata store: %w", err)
+	}
+	defer store.Close()
+
+	dataType := types.DataTypeDaily
+	if opts.hourly {
+		dataType = types.DataTypeHourly
+	}
+
+	var chunks []types.ChunkInfo
+	for _, sid := range stationList {
+		stationChunks, err := getChunksForYearRange(store, uint16(sid), startYear, endYear, dataType)
+		if err != nil {
+			return fmt.Errorf("failed to get chunks for station %d: %w", sid, err)
+		}
+		chunks = append(chunks, stationChunks...)
+	}
+	if len(chunks) == 0 {
+		fmt.Printf("No data found for %d station(s) in %d-%d\n", len(stationList), startYear, endYear)
+		return nil
+	}
+
+	// Each worker merges into its own sketch; the partials are merged at the end.
+	workers := runtime.NumCPU()
+	if workers > len(chunks) {
+		workers = len(chunks)
+	}
+	jobs := make(chan types.ChunkInfo)
+	partials := make([]*sketch.KLL, workers)
+	var backfilled, failed int
+	var mu sync.Mutex
+	var wg sync.WaitGroup
+
+	for w := 0; w < workers; w++ {
+		partials[w] = sketch.NewKLL(sketch.DefaultK)
+		wg.Add(1)
+		go func(local *sketch.KLL) {
+			defer wg.Done()
+			reader := storage.NewChunkReader(dataDir)
+			for chunk := range jobs {
+				path := chunkSidecarPath(dataDir, chunk, ".sketch")
+				s, err := readSketchSidecar(path, opts.field)
+				if err != nil {
+					var sketches map[string]*sketch.KLL
+					if opts.hourly {
+						records, readErr := reader.ReadHourlyChunk(chunk.StationID, chunk.Year)
+						err = readErr
+						sketches = buildHourlySketches(records)
+					} else {
+						records, readErr := reader.ReadDailyChunk(chunk.StationID, chunk.Year)
+						err = readErr
+						sketches = buildDailySketches(records)
+					}
+					mu.Lock()
+					if err != nil {
+						failed++
+					} else {
+						backfilled++
+					}
+					mu.Unlock()
+					if err != nil {
+						continue
+					}
+					_ = writeSketchSidecar(path, sketches)
+					s = sketches[opts.field]
+				}
+				if err := local.Merge(s); err != nil {
+					mu.Lock()
+					failed++
+					mu.Unlock()
+				}
+			}
+		}(partials[w])
+	}
+	for _, chunk := range chunks {
+		jobs <- chunk
+	}
+	close(jobs)
+	wg.Wait()
+
+	merged := sketch.NewKLL(sketch.DefaultK)
+	for _, partial := range partials {
+		if err := merged.Merge(partial); err != nil {
+			return fmt.Errorf("failed to merge sketches: %w", err)
+		}
+	}
+
+	fmt.Printf("Stations: %d, chunks: %d (backfilled %d, failed %d), years %d-%d\n",
+		len(stationList), len(chunks), backfilled, failed, startYear, endYear)
+	if merged.Count() == 0 {
+		fmt.Println("No values available")
+		return nil
+	}
+	fmt.Printf("P%g %s: %.2f (approximate, KLL k=%d over %d values)\n",
+		opts.percentile, opts.field, merged.Percentile(opts.percentile), merged.K(), merged.Count())
+	fmt.Printf("Min/Max: %.2f / %.2f\n", merged.Min(), merged.Max())
+	fmt.Printf("Query duration: %v\n", time.Since(queryStart))
+	return nil
+}
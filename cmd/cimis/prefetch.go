@@ -0,0 +1,213 @@
+package main
+
+import (
+	"sync"
+	"time"
+
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// queryChunkReader is the subset of the chunk readers used by query.
+type queryChunkReader interface {
+	ReadDailyChunk(stationID uint16, year int) ([]types.DailyRecord, error)
+	ReadHourlyChunk(stationID uint16, year int) ([]types.HourlyRecord, error)
+}
+
+// prefetchedChunk is one decoded chunk handed out by a chunkPrefetcher.
+type prefetchedChunk struct {
+	chunk     types.ChunkInfo
+	daily     []types.DailyRecord
+	hourly    []types.HourlyRecord
+	err       error
+	readStart time.Time
+	readTime  time.Duration
+	bytes     int64
+}
+
+// prefetchStats reports how well reads were hidden behind processing.
+type prefetchStats struct {
+	hits      int           // chunks that were already decoded when asked for
+	stalls    int           // chunks the caller had to wait for
+	stallTime time.Duration // total time spent waiting
+	peakBytes int64         // largest amount of decoded data held at once
+}
+
+// chunkPrefetcher reads and decodes chunks in order on a background goroutine
+// while the caller processes earlier ones. Up to depth chunks are kept ready,
+// bounded by memCap bytes of decoded records; a single chunk larger than the
+// cap is still admitted so the scan always makes progress. The chunk last
+// returned by Next stays charged until the following call, so the caller's
+// working chunk counts against the cap too.
+//
+// With depth 0 chunks are read synchronously inside Next.
+type chunkPrefetcher struct {
+	reader queryChunkReader
+	chunks []types.ChunkInfo
+	hourly bool
+	depth  int
+	memCap int64
+
+	ready chan prefetchedChunk
+	done  chan struct{}
+	wg    sync.WaitGroup
+
+	mu       sync.Mutex
+	cond     *sync.Cond
+	inflight int64
+	stats    prefetchStats
+
+	next      int   // synchronous mode cursor
+	lastBytes int64 // charge of the chunk the caller currently holds
+}
+
+func newChunkPrefetcher(reader queryChunkReader, chunks []types.ChunkInfo, hourly bool, depth int, memCap int64) *chunkPrefetcher {
+	p := &chunkPrefetcher{
+		reader: reader,
+		chunks: chunks,
+		hourly: hourly,
+		depth:  depth,
+		memCap: memCap,
+		done:   make(chan struct{}),
+	}
+	p.cond = sync.NewCond(&p.mu)
+	if depth > 0 {
+		// The goroutine holds one decoded chunk while blocked on send, so a
+		// buffer of depth-1 keeps exactly depth chunks ahead of the caller.
+		p.ready = make(chan prefetchedChunk, depth-1)
+		p.wg.Add(1)
+		go p.run()
+	}
+	return p
+}
+
+func (p *chunkPrefetcher) read(chunk types.ChunkInfo) prefetchedChunk {
+	start := time.Now()
+	item := prefetchedChunk{chunk: chunk, readStart: start}
+	if p.hourly {
+		item.hourly, item.err = p.reader.ReadHourlyChunk(chunk.StationID, chunk.Year)
+		item.bytes = int64(len(item.hourly)) * 24
+	} else {
+		item.daily, item.err = p.reader.ReadDailyChunk(chunk.StationID, chunk.Year)
+		item.bytes = int64(len(item.daily)) * 16
+	}
+	item.readTime = time.Since(start)
+	return item
+}
+
+func (p *chunkPrefetcher) run() {
+	defer p.wg.Done()
+	defer close(p.ready)
+
+	for _, chunk := range p.chunks {
+		// Hold off while the decoded backlog is over budget.
+		p.mu.Lock()
+		for p.memCap > 0 && p.inflight >= p.memCap && !p.closed() {
+			p.cond.Wait()
+		}
+		p.mu.Unlock()
+		if p.closed() {
+			return
+		}
+
+		item := p.read(chunk)
+		p.charge(item.bytes)
+
+		select {
+		case p.ready <- item:
+		case <-p.done:
+			return
+		}
+	}
+}
+
+func (p *chunkPrefetcher) closed() bool {
+	select {
+	case <-p.done:
+		return true
+	default:
+		return false
+	}
+}
+
+func (p *chunkPrefetcher) charge(n int64) {
+	p.mu.Lock()
+	p.inflight += n
+	if p.inflight > p.stats.peakBytes {
+		p.stats.peakBytes = p.inflight
+	}
+	p.mu.Unlock()
+}
+
+func (p *chunkPrefetcher) release(n int64) {
+	if n == 0 {
+		return
+	}
+	p.mu.Lock()
+	p.inflight -= n
+	p.cond.Signal()
+	p.mu.Unlock()
+}
+
+// Next returns the next chunk in order, or false when all have been returned.
+func (p *chunkPrefetcher) Next() (prefetchedChunk, bool) {
+	p.release(p.lastBytes)
+	p.lastBytes = 0
+
+	if p.depth <= 0 {
+		if p.next >= len(p.chunks) {
+			return prefetchedChunk{}, false
+		}
+		item := p.read(p.chunks[p.next])
+		p.next++
+		p.mu.Lock()
+		p.stats.stalls++
+		p.stats.stallTime += item.readTime
+		p.mu.Unlock()
+		return item, true
+	}
+
+	var item prefetchedChunk
+	var ok bool
+	select {
+	case item, ok = <-p.ready:
+		if ok {
+			p.mu.Lock()
+			p.stats.hits++
+			p.mu.Unlock()
+		}
+	default:
+		waitStart := time.Now()
+		item, ok = <-p.ready
+		if ok {
+			p.mu.Lock()
+			p.stats.stalls++
+			p.stats.stallTime += time.Since(waitStart)
+			p.mu.Unlock()
+		}
+	}
+	if !ok {
+		return prefetchedChunk{}, false
+	}
+	p.lastBytes = item.bytes
+	return item, true
+}
+
+// Close stops the background reader; safe to call more than once.
+func (p *chunkPrefetcher) Close() {
+	p.mu.Lock()
+	select {
+	case <-p.done:
+	default:
+		close(p.done)
+	}
+	p.cond.Broadcast()
+	p.mu.Unlock()
+	p.wg.Wait()
+}
+
+// Stats returns a snapshot of the prefetch counters.
+func (p *chunkPrefetcher) Stats() prefetchStats {
+	p.mu.Lock()
+	defer p.mu.Unlock()
+	return p.stats
+}
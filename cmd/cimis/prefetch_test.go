@@ -0,0 +1,136 @@
+package main
+
+import (
+	"errors"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+type slowChunkReader struct {
+	delay  time.Duration
+	rows   int
+	reads  atomic.Int32
+	failAt int
+}
+
+func (r *slowChunkReader) ReadDailyChunk(stationID uint16, year int) ([]types.DailyRecord, error) {
+	r.reads.Add(1)
+	time.Sleep(r.delay)
+	if year == r.failAt {
+		return nil, errors.New("corrupt chunk")
+	}
+	records := make([]types.DailyRecord, r.rows)
+	for i := range records {
+		records[i] = types.DailyRecord{StationID: stationID, Timestamp: uint32(year)}
+	}
+	return records, nil
+}
+
+func (r *slowChunkReader) ReadHourlyChunk(stationID uint16, year int) ([]types.HourlyRecord, error) {
+	r.reads.Add(1)
+	time.Sleep(r.delay)
+	return []types.HourlyRecord{{StationID: stationID, Timestamp: uint32(year)}}, nil
+}
+
+func prefetchTestChunks(n int) []types.ChunkInfo {
+	chunks := make([]types.ChunkInfo, n)
+	for i := range chunks {
+		chunks[i] = types.ChunkInfo{StationID: 2, Year: 2000 + i}
+	}
+	return chunks
+}
+
+func TestChunkPrefetcherOrderAndErrors(t *testing.T) {
+	for _, depth := range []int{0, 1, 3} {
+		reader := &slowChunkReader{rows: 10, failAt: 2002}
+		p := newChunkPrefetcher(reader, prefetchTestChunks(5), false, depth, 1<<20)
+
+		var years []int
+		for {
+			item, ok := p.Next()
+			if !ok {
+				break
+			}
+			years = append(years, item.chunk.Year)
+			if item.chunk.Year == 2002 {
+				if item.err == nil {
+					t.Fatalf("depth %d: expected read error for 2002", depth)
+				}
+				continue
+			}
+			if len(item.daily) != 10 || item.daily[0].Timestamp != uint32(item.chunk.Year) {
+				t.Fatalf("depth %d: chunk %d decoded wrong records", depth, item.chunk.Year)
+			}
+		}
+		p.Close()
+
+		if len(years) != 5 {
+			t.Fatalf("depth %d: got %d chunks, want 5", depth, len(years))
+		}
+		for i, y := range years {
+			if y != 2000+i {
+				t.Fatalf("depth %d: chunks out of order: %v", depth, years)
+			}
+		}
+	}
+}
+
+func TestChunkPrefetcherHidesReadsBehindWork(t *testing.T) {
+	reader := &slowChunkReader{delay: 5 * time.Millisecond, rows: 1}
+	p := newChunkPrefetcher(reader, prefetchTestChunks(6), false, 2, 1<<20)
+	defer p.Close()
+
+	for {
+		if _, ok := p.Next(); !ok {
+			break
+		}
+		time.Sleep(15 * time.Millisecond) // slower consumer than reader
+	}
+	stats := p.Stats()
+	if stats.hits+stats.stalls != 6 {
+		t.Fatalf("hits+stalls = %d, want 6", stats.hits+stats.stalls)
+	}
+	// Only the first chunk should have to be waited for.
+	if stats.hits < 4 {
+		t.Fatalf("expected most chunks to be prefetched, got %+v", stats)
+	}
+}
+
+func TestChunkPrefetcherMemoryCap(t *testing.T) {
+	// Each chunk decodes to 1600 bytes; a 2000-byte cap allows one ahead at most.
+	reader := &slowChunkReader{rows: 100}
+	p := newChunkPrefetcher(reader, prefetchTestChunks(8), false, 4, 2000)
+	defer p.Close()
+
+	if _, ok := p.Next(); !ok {
+		t.Fatal("expected a chunk")
+	}
+	time.Sleep(20 * time.Millisecond)
+	if got := reader.reads.Load(); got > 2 {
+		t.Fatalf("reader ran %d chunks ahead despite the memory cap", got)
+	}
+	for {
+		if _, ok := p.Next(); !ok {
+			break
+		}
+	}
+	if peak := p.Stats().peakBytes; peak > 3200 {
+		t.Fatalf("peak decoded bytes = %d, want <= 3200", peak)
+	}
+}
+
+func TestChunkPrefetcherCloseEarly(t *testing.T) {
+	reader := &slowChunkReader{delay: time.Millisecond, rows: 1}
+	p := newChunkPrefetcher(reader, prefetchTestChunks(50), true, 2, 1<<20)
+	if item, ok := p.Next(); !ok || len(item.hourly) != 1 {
+		t.Fatalf("Next() = %+v, %v", item, ok)
+	}
+	p.Close()
+	p.Close()
+	if got := reader.reads.Load(); got > 5 {
+		t.Fatalf("reader kept going after Close: %d reads", got)
+	}
+}
@@ -56,6 +56,7 @@ func runProfile(dataDir string, args []string) error {
 		fmt.Printf("  Heap: curl http://%s/debug/pprof/heap\n", *server)
 		fmt.Printf("  Goroutines: curl http://%s/debug/pprof/goroutine\n", *server)
 		fmt.Printf("  Allocs: curl http://%s/debug/pprof/allocs\n", *server)
+		fmt.Printf("  Metrics: curl http://%s/metrics\n", *server)
 		fmt.Println("Press Ctrl+C to stop...")
 
 		// Wait for interrupt
@@ -4,9 +4,13 @@ import (
 	"flag"
 	"fmt"
 	"path/filepath"
+	"runtime"
 	"time"
 
 	"github.com/dl-alexandre/cimis-cli/internal/api"
+	"github.com/dl-alexandre/cimis-cli/internal/chunkcache"
+	"github.com/dl-alexandre/cimis-cli/internal/perfcounter"
+	"github.com/dl-alexandre/cimis-cli/internal/profile"
 	"github.com/dl-alexandre/cimis-tsdb/metadata"
 	"github.com/dl-alexandre/cimis-tsdb/storage"
 	"github.com/dl-alexandre/cimis-tsdb/types"
@@ -16,23 +20,126 @@ func cmdQuery(dataDir string, args []string) {
 	fatalIfErr(runQuery(dataDir, args))
 }
 
-func runQuery(dataDir string, args []string) error {
+func runQuery(dataDir string, args []string) (err error) {
 	// Parse flags
 	fs := flag.NewFlagSet("query", flag.ContinueOnError)
 	stationID := fs.Int("station", 0, "Station ID")
 	startDate := fs.String("start", "", "Start date (YYYY-MM-DD)")
 	endDate := fs.String("end", "", "End date (YYYY-MM-DD)")
 	hourly := fs.Bool("hourly", false, "Query hourly data (default: daily)")
-	perf := fs.Bool("perf", false, "Show performance metrics")
+	var perf perfFlag
+	fs.Var(&perf, "perf", "Show performance metrics (-perf=hw adds CPU hardware counters per phase)")
 	cache := fs.String("cache", "", "Enable caching with specified size (e.g., 100MB, 1GB)")
+	cacheCompressed := fs.String("cache-compressed", "", "Keep chunks evicted from -cache S2-compressed in memory, up to this size")
+	metricsAddr := fs.String("metrics-addr", "", "Serve Prometheus metrics on this address while the query runs")
+	percentile := fs.Float64("percentile", 0, "Answer a percentile (0-100] from chunk sketches")
+	stations := fs.String("stations", "", "Stations for -percentile and -latest: 'all', CSV list or range")
+	field := fs.String("field", "temperature", "Field for -percentile and -lat/-lon")
+	lat := fs.Float64("lat", 0, "Latitude for a local IDW estimate from nearby stations")
+	lon := fs.Float64("lon", 0, "Longitude for a local IDW estimate from nearby stations")
+	neighbors := fs.Int("k", 4, "Nearest stations used for -lat/-lon")
+	power := fs.Float64("power", 2, "IDW distance power for -lat/-lon")
+	latest := fs.Bool("latest", false, "Show the most recent record per station from the tail index")
+	prefetch := fs.Int("prefetch", 2, "Chunks decoded ahead on a background goroutine (0 disables)")
+	prefetchMem := fs.String("prefetch-mem", "64MB", "Memory cap for decoded chunks held by -prefetch")
+	tracePath := fs.String("trace", "", "Write a Chrome trace of per-chunk decode and filter spans to this file")
 
 	if err := fs.Parse(args); err != nil {
 		return err
 	}
 
+	if *latest {
+		return runLatestQuery(dataDir, latestOptions{
+			stations:  *stations,
+			stationID: *stationID,
+			hourly:    *hourly,
+			perf:      perf.on,
+		})
+	}
+
+	if *percentile != 0 {
+		return runPercentileQuery(dataDir, percentileOptions{
+			percentile: *percentile,
+			field:      *field,
+			stations:   *stations,
+			stationID:  *stationID,
+			startDate:  *startDate,
+			endDate:    *endDate,
+			hourly:     *hourly,
+		})
+	}
+
+	if *lat != 0 || *lon != 0 {
+		if *hourly {
+			return fmt.Errorf("-lat/-lon supports daily data only")
+		}
+		return runSpatialQuery(dataDir, spatialOptions{
+			lat:       *lat,
+			lon:       *lon,
+			k:         *neighbors,
+			power:     *power,
+			field:     *field,
+			startDate: *startDate,
+			endDate:   *endDate,
+		})
+	}
+
 	if *stationID == 0 {
 		return fmt.Errorf("station ID required")
 	}
+	if *prefetch < 0 {
+		return fmt.Errorf("prefetch depth must be >= 0")
+	}
+	prefetchCap := parseCacheSize(*prefetchMem)
+	if prefetchCap <= 0 {
+		return fmt.Errorf("invalid prefetch memory cap: %s", *prefetchMem)
+	}
+
+	if *metricsAddr != "" {
+		server, err := startMetricsServer(*metricsAddr)
+		if err != nil {
+			return err
+		}
+		defer server.Close()
+	}
+
+	// Hardware counters follow one OS thread, so pin this goroutine and
+	// read chunks on it rather than on the prefetch goroutine.
+	var hw *perfcounter.Group
+	var hwErr error
+	if perf.hw {
+		runtime.LockOSThread()
+		defer runtime.UnlockOSThread()
+		if hw, hwErr = perfcounter.Open(); hwErr == nil {
+			defer hw.Close()
+			*prefetch = 0
+		}
+	}
+	// A failed read leaves its sample invalid; intervals touching it are
+	// dropped rather than counted as zero.
+	hwSample := func() (perfcounter.Reading, bool) {
+		if hw == nil {
+			return perfcounter.Reading{}, false
+		}
+		r, err := hw.Read()
+		return r, err == nil
+	}
+	var hwRead, hwFilter perfcounter.Counts
+	var scanned int
+
+	rec := startTrace(*tracePath, "query")
+	track := rec.Track("query")
+	readTrack := track
+	if *prefetch > 0 {
+		readTrack = rec.Track("prefetch")
+	}
+	defer func() {
+		if traceErr := finishTrace(rec, *tracePath); err == nil {
+			err = traceErr
+		}
+	}()
+	querySpan := track.Start("query", "station", *stationID, "hourly", *hourly)
+	defer querySpan.End()
 
 	// Start total query timer
 	queryStart := time.Now()
@@ -56,22 +163,35 @@ func runQuery(dataDir string, args []string) error {
 	defer store.Close()
 
 	// Initialize chunk reader (with caching if requested)
-	var reader interface {
-		ReadDailyChunk(stationID uint16, year int) ([]types.DailyRecord, error)
-		ReadHourlyChunk(stationID uint16, year int) ([]types.HourlyRecord, error)
-	}
+	var reader queryChunkReader
 	var cachedReader *storage.CachedChunkReader
+	var packedCache *chunkcache.Cache
 
-	if *cache != "" {
-		cacheSize := parseCacheSize(*cache)
-		if cacheSize <= 0 {
-			return fmt.Errorf("invalid cache size: %s", *cache)
+	if *cache != "" || *cacheCompressed != "" {
+		var cacheSize, packedSize int64
+		if *cache != "" {
+			if cacheSize = parseCacheSize(*cache); cacheSize <= 0 {
+				return fmt.Errorf("invalid cache size: %s", *cache)
+			}
+		}
+		if *cacheCompressed != "" {
+			if packedSize = parseCacheSize(*cacheCompressed); packedSize <= 0 {
+				return fmt.Errorf("invalid compressed cache size: %s", *cacheCompressed)
+			}
+		}
+		if packedSize > 0 {
+			packedCache = chunkcache.New(storage.NewChunkReader(dataDir), cacheSize, packedSize)
+			reader = packedCache
+		} else {
+			cachedReader = storage.NewCachedChunkReader(dataDir, cacheSize)
+			reader = cachedReader
 		}
-		cachedReader = storage.NewCachedChunkReader(dataDir, cacheSize)
-		reader = cachedReader
 	} else {
 		reader = storage.NewChunkReader(dataDir)
 	}
+	// Hot-tier chunks are read from their raw copies without decompression.
+	tiered := &tieredChunkReader{dataDir: dataDir, base: reader}
+	reader = tiered
 
 	// Get chunks in range
 	startYear := start.Year()
@@ -85,6 +205,8 @@ func runQuery(dataDir string, args []string) error {
 	metadataStart := time.Now()
 	chunks, err := getChunksForYearRange(store, uint16(*stationID), startYear, endYear, dataType)
 	metadataDuration := time.Since(metadataStart)
+	queryMetadataDuration.ObserveDuration(metadataDuration)
+	track.Add("metadata", metadataStart, metadataDuration, "chunks", len(chunks))
 	if err != nil {
 		return fmt.Errorf("failed to get chunks: %w", err)
 	}
@@ -101,26 +223,46 @@ func runQuery(dataDir string, args []string) error {
 	var chunksRead int
 	var totalChunkReadTime time.Duration
 	var totalFilterTime time.Duration
+	readLatency := profile.NewHistogram()
+	filterLatency := profile.NewHistogram()
 
-	for _, chunk := range chunks {
-		if *hourly {
-			// Time chunk read
-			chunkReadStart := time.Now()
-			records, err := reader.ReadHourlyChunk(chunk.StationID, chunk.Year)
-			chunkReadDuration := time.Since(chunkReadStart)
-			totalChunkReadTime += chunkReadDuration
-			chunksRead++
-
-			if err != nil {
-				fmt.Printf("Warning: failed to read chunk %d: %v\n", chunk.Year, err)
-				continue
+	// Decode upcoming chunks in the background while this one is filtered.
+	prefetcher := newChunkPrefetcher(reader, chunks, *hourly, *prefetch, prefetchCap)
+	defer prefetcher.Close()
+
+	for {
+		waitStart := time.Now()
+		hwMark, hwMarkOK := hwSample()
+		item, ok := prefetcher.Next()
+		if !ok {
+			break
+		}
+		if hw != nil {
+			r, rOK := hwSample()
+			if hwMarkOK && rOK {
+				hwRead.Add(r.Since(hwMark))
 			}
+			hwMark, hwMarkOK = r, rOK
+		}
+		scanned += len(item.daily) + len(item.hourly)
+		track.Add("next chunk", waitStart, time.Since(waitStart), "year", item.chunk.Year)
+		readTrack.Add("decode block", item.readStart, item.readTime, "year", item.chunk.Year, "bytes", item.bytes)
+		totalChunkReadTime += item.readTime
+		queryReadDuration.ObserveDuration(item.readTime)
+		readLatency.Record(item.readTime)
+		chunksRead++
+		if item.err != nil {
+			fmt.Printf("Warning: failed to read chunk %d: %v\n", item.chunk.Year, item.err)
+			continue
+		}
+
+		if *hourly {
 			// Filter by timestamp range
 			filterStart := time.Now()
 			startTs := uint32(start.Sub(api.Epoch).Hours())
 			endTs := uint32(end.Sub(api.Epoch).Hours())
 
-			for _, r := range records {
+			for _, r := range item.hourly {
 				if r.Timestamp >= startTs && r.Timestamp < endTs {
 					totalRecords++
 					if totalRecords <= 10 {
@@ -134,25 +276,18 @@ func runQuery(dataDir string, args []string) error {
 					}
 				}
 			}
-			totalFilterTime += time.Since(filterStart)
+			filterTime := time.Since(filterStart)
+			totalFilterTime += filterTime
+			queryFilterDuration.ObserveDuration(filterTime)
+			filterLatency.Record(filterTime)
+			track.Add("filter", filterStart, filterTime, "year", item.chunk.Year)
 		} else {
-			// Time chunk read
-			chunkReadStart := time.Now()
-			records, err := reader.ReadDailyChunk(chunk.StationID, chunk.Year)
-			chunkReadDuration := time.Since(chunkReadStart)
-			totalChunkReadTime += chunkReadDuration
-			chunksRead++
-
-			if err != nil {
-				fmt.Printf("Warning: failed to read chunk %d: %v\n", chunk.Year, err)
-				continue
-			}
 			// Filter by timestamp range
 			filterStart := time.Now()
 			startTs := uint32(start.Sub(api.Epoch).Hours() / 24)
 			endTs := uint32(end.Sub(api.Epoch).Hours() / 24)
 
-			for _, r := range records {
+			for _, r := range item.daily {
 				if r.Timestamp >= startTs && r.Timestamp < endTs {
 					totalRecords++
 					if totalRecords <= 10 {
@@ -166,8 +301,29 @@ func runQuery(dataDir string, args []string) error {
 					}
 				}
 			}
-			totalFilterTime += time.Since(filterStart)
+			filterTime := time.Since(filterStart)
+			totalFilterTime += filterTime
+			queryFilterDuration.ObserveDuration(filterTime)
+			filterLatency.Record(filterTime)
+			track.Add("filter", filterStart, filterTime, "year", item.chunk.Year)
 		}
+		if hw != nil {
+			if r, rOK := hwSample(); hwMarkOK && rOK {
+				hwFilter.Add(r.Since(hwMark))
+			}
+		}
+	}
+
+	recordChunkAccess(dataDir, chunks)
+	querySpan.Set("records", totalRecords)
+
+	queryElapsed := time.Since(queryStart)
+	queryTotalDuration.ObserveDuration(queryElapsed)
+	if queryElapsed > 0 {
+		recordsPerSecond.Set(float64(totalRecords) / queryElapsed.Seconds())
+	}
+	if packedCache != nil {
+		cacheHitRatio.Set(packedCache.Stats().HitRate())
 	}
 
 	fmt.Printf("\nTotal records: %d\n", totalRecords)
@@ -176,7 +332,7 @@ func runQuery(dataDir string, args []string) error {
 	}
 
 	// Print performance metrics if requested
-	if *perf {
+	if perf.on {
 		totalDuration := time.Since(queryStart)
 		avgChunkReadTime := time.Duration(0)
 		if chunksRead > 0 {
@@ -196,9 +352,17 @@ func runQuery(dataDir string, args []string) error {
 		fmt.Printf("Metadata lookup time:      %v\n", metadataDuration)
 		fmt.Printf("Chunks read:               %d\n", chunksRead)
 		fmt.Printf("Average chunk read time:   %v\n", avgChunkReadTime)
+		fmt.Printf("Chunk read latency:        %s\n", readLatency.Percentiles())
+		fmt.Printf("Chunk filter latency:      %s\n", filterLatency.Percentiles())
+		fmt.Printf("Hot tier (raw) reads:      %d/%d\n", tiered.rawHits.Load(), chunksRead)
 		fmt.Printf("Total filter/process time: %v\n", totalFilterTime)
 		fmt.Printf("Average record time:       %v\n", avgRecordTime)
 		fmt.Printf("Records per second:        %.2f\n", recordsPerSec)
+		if *prefetch > 0 {
+			ps := prefetcher.Stats()
+			fmt.Printf("Prefetch hits/stalls:      %d/%d (stalled %v, peak %.1f MB decoded)\n",
+				ps.hits, ps.stalls, ps.stallTime, float64(ps.peakBytes)/(1024*1024))
+		}
 
 		// Print cache statistics if caching was enabled
 		if cachedReader != nil {
@@ -206,6 +370,16 @@ func runQuery(dataDir string, args []string) error {
 			fmt.Println("\n=== Cache Statistics ===")
 			fmt.Println(storage.FormatCacheStats(cacheStats))
 		}
+		if packedCache != nil {
+			fmt.Println("\n=== Cache Statistics ===")
+			fmt.Println(packedCache.Stats())
+		}
+
+		if hw != nil {
+			printHWCounters([]hwPhase{{"read", hwRead}, {"filter", hwFilter}}, scanned)
+		} else if hwErr != nil {
+			fmt.Printf("\nHardware counters unavailable: %v\n", hwErr)
+		}
 	}
 	return nil
 }
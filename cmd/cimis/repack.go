@@ -0,0 +1,484 @@
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"errors"
+	"flag"
+	"fmt"
+	"os"
+	"path/filepath"
+	"reflect"
+	"runtime"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/dl-alexandre/cimis-tsdb/metadata"
+	"github.com/dl-alexandre/cimis-tsdb/storage"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// repackJournalName records chunks already repacked so an interrupted run
+// resumes where it stopped. It is removed once a run finishes cleanly.
+const repackJournalName = ".repack-journal"
+
+// repackTarget is one chunk file to convert.
+type repackTarget struct {
+	path      string // absolute chunk path
+	rel       string // path relative to the data directory, used in the journal
+	stationID uint16
+	year      int
+	dataType  types.DataType // empty for *_optimized.zst column files
+}
+
+// repackResult is the outcome of converting a single chunk.
+type repackResult struct {
+	target    repackTarget
+	before    int64
+	after     int64
+	chunkInfo *types.ChunkInfo
+	err       error
+}
+
+// byteRateLimiter paces reads shared by several workers to a byte rate.
+// A zero rate disables pacing.
+type byteRateLimiter struct {
+	mu          sync.Mutex
+	bytesPerSec float64
+	next        time.Time
+	sleep       func(time.Duration)
+}
+
+func newByteRateLimiter(mbps float64) *byteRateLimiter {
+	return &byteRateLimiter{bytesPerSec: mbps * 1024 * 1024, sleep: time.Sleep}
+}
+
+// Wait blocks until n more bytes fit under the rate.
+func (l *byteRateLimiter) Wait(n int64) {
+	if l == nil || l.bytesPerSec <= 0 || n <= 0 {
+		return
+	}
+	l.mu.Lock()
+	now := time.Now()
+	if l.next.Before(now) {
+		l.next = now
+	}
+	start := l.next
+	l.next = l.next.Add(time.Duration(float64(n) / l.bytesPerSec * float64(time.Second)))
+	l.mu.Unlock()
+
+	if d := time.Until(start); d > 0 {
+		l.sleep(d)
+	}
+}
+
+// repackJournal is an append-only list of finished chunks and the
+// compression level they were repacked at.
+type repackJournal struct {
+	mu   sync.Mutex
+	path string
+	done map[string]int
+	file *os.File
+}
+
+func openRepackJournal(path string, restart bool) (*repackJournal, error) {
+	j := &repackJournal{path: path, done: make(map[string]int)}
+	if restart {
+		if err := os.Remove(path); err != nil && !os.IsNotExist(err) {
+			return nil, fmt.Errorf("reset repack journal: %w", err)
+		}
+	} else if data, err := os.ReadFile(path); err == nil {
+		scanner := bufio.NewScanner(bytes.NewReader(data))
+		for scanner.Scan() {
+			rel, level, ok := strings.Cut(scanner.Text(), "\t")
+			if !ok {
+				continue
+			}
+			if n, err := strconv.Atoi(level); err == nil {
+				j.done[rel] = n
+			}
+		}
+	} else if !os.IsNotExist(err) {
+		return nil, fmt.Errorf("read repack journal: %w", err)
+	}
+
+	f, err := os.OpenFile(path, os.O_CREATE|os.O_APPEND|os.O_WRONLY, 0644)
+	if err != nil {
+		return nil, fmt.Errorf("open repack journal: %w", err)
+	}
+	j.file = f
+	return j, nil
+}
+
+// Done reports whether rel was already repacked at level.
+func (j *repackJournal) Done(rel string, level int) bool {
+	j.mu.Lock()
+	defer j.mu.Unlock()
+	n, ok := j.done[rel]
+	return ok && n == level
+}
+
+// Record durably marks rel as repacked at level.
+func (j *repackJournal) Record(rel string, level int) error {
+	j.mu.Lock()
+	defer j.mu.Unlock()
+	if _, err := fmt.Fprintf(j.file, "%s\t%d\n", rel, level); err != nil {
+		return err
+	}
+	j.done[rel] = level
+	return j.file.Sync()
+}
+
+func (j *repackJournal) Close() error {
+	return j.file.Close()
+}
+
+func cmdRepack(dataDir string, args []string) {
+	fatalIfErr(runRepack(dataDir, args))
+}
+
+func runRepack(dataDir string, args []string) error {
+	fs := flag.NewFlagSet("repack", flag.ContinueOnError)
+	workers := fs.Int("workers", runtime.NumCPU(), "Number of chunks converted in parallel")
+	mbps := fs.Float64("mbps", 0, "Limit chunk reads to this many MB/s (0 = unlimited)")
+	compressionLevel := fs.Int("compression", 3, "Compression level for repacked chunks")
+	stationID := fs.Int("station", 0, "Only repack this station (0 = all)")
+	restart := fs.Bool("restart", false, "Ignore the resume journal and repack every chunk")
+
+	if err := fs.Parse(args); err != nil {
+		return err
+	}
+	if *workers < 1 {
+		return fmt.Errorf("-workers must be at least 1")
+	}
+	if *mbps < 0 {
+		return fmt.Errorf("-mbps must not be negative")
+	}
+
+	targets, err := findRepackTargets(dataDir, *stationID)
+	if err != nil {
+		return err
+	}
+
+	journal, err := openRepackJournal(filepath.Join(dataDir, repackJournalName), *restart)
+	if err != nil {
+		return err
+	}
+	defer journal.Close()
+
+	var pending []repackTarget
+	for _, t := range targets {
+		if !journal.Done(t.rel, *compressionLevel) {
+			pending = append(pending, t)
+		}
+	}
+	skipped := len(targets) - len(pending)
+	fmt.Printf("Repacking %d chunk(s) at compression level %d with %d worker(s)", len(pending), *compressionLevel, *workers)
+	if skipped > 0 {
+		fmt.Printf(" (%d already done)", skipped)
+	}
+	fmt.Println()
+
+	start := time.Now()
+	limiter := newByteRateLimiter(*mbps)
+	stop := make(chan struct{})
+	results := repackChunks(dataDir, pending, *compressionLevel, *workers, limiter, stop)
+	defer func() {
+		// Let in-flight conversions finish if we bail out early.
+		close(stop)
+		for range results {
+		}
+	}()
+
+	saver := &repackMetadataSaver{dataDir: dataDir}
+	defer saver.Close()
+
+	var repacked, failed int
+	var before, after int64
+	for res := range results {
+		if res.err != nil {
+			fmt.Printf("FAIL: %s - %v\n", res.target.path, res.err)
+			failed++
+			continue
+		}
+		if err := saver.Save(res.chunkInfo); err != nil {
+			fmt.Printf("FAIL: %s - save metadata: %v\n", res.target.path, err)
+			failed++
+			continue
+		}
+		if err := journal.Record(res.target.rel, *compressionLevel); err != nil {
+			return fmt.Errorf("write repack journal: %w", err)
+		}
+		repacked++
+		before += res.before
+		after += res.after
+		fmt.Printf("OK: %s (%d -> %d bytes)\n", res.target.path, res.before, res.after)
+	}
+	elapsed := time.Since(start)
+
+	fmt.Printf("\nRepack complete: %d repacked, %d skipped, %d failed\n", repacked, skipped, failed)
+	if repacked > 0 {
+		fmt.Printf("Size: %.2f MB -> %.2f MB (%.1f%% of original)\n",
+			float64(before)/(1024*1024), float64(after)/(1024*1024), float64(after)/float64(before)*100)
+		fmt.Printf("Throughput: %.2f MB/s over %v\n", float64(before)/(1024*1024)/elapsed.Seconds(), elapsed.Round(time.Millisecond))
+	}
+	if failed > 0 {
+		return fmt.Errorf("%d chunk(s) failed to repack", failed)
+	}
+
+	journal.Close()
+	if err := os.Remove(journal.path); err != nil && !os.IsNotExist(err) {
+		return fmt.Errorf("remove repack journal: %w", err)
+	}
+	return nil
+}
+
+// repackMetadataSaver refreshes chunk metadata after a swap, opening the
+// metadata store on first use.
+type repackMetadataSaver struct {
+	dataDir string
+	store   *metadata.Store
+}
+
+func (s *repackMetadataSaver) Save(info *types.ChunkInfo) error {
+	if info == nil {
+		return nil
+	}
+	if s.store == nil {
+		store, err := metadata.NewStore(filepath.Join(s.dataDir, "metadata.sqlite3"))
+		if err != nil {
+			return fmt.Errorf("failed to open metadata store: %w", err)
+		}
+		s.store = store
+	}
+	return saveChunkMetadata(s.store, info)
+}
+
+func (s *repackMetadataSaver) Close() {
+	if s.store != nil {
+		s.store.Close()
+	}
+}
+
+// findRepackTargets lists year chunks and *_optimized.zst files under the
+// data directory in station/year order.
+func findRepackTargets(dataDir string, onlyStation int) ([]repackTarget, error) {
+	stationsDir := filepath.Join(dataDir, "stations")
+	entries, err := os.ReadDir(stationsDir)
+	if err != nil {
+		return nil, fmt.Errorf("failed to read stations directory: %w", err)
+	}
+
+	var targets []repackTarget
+	for _, entry := range entries {
+		if !entry.IsDir() {
+			continue
+		}
+		sid, err := strconv.Atoi(entry.Name())
+		if err != nil || sid <= 0 || sid > 65535 || (onlyStation != 0 && sid != onlyStation) {
+			continue
+		}
+		stationDir := filepath.Join(stationsDir, entry.Name())
+		files, err := os.ReadDir(stationDir)
+		if err != nil {
+			continue
+		}
+		for _, f := range files {
+			if f.IsDir() || filepath.Ext(f.Name()) != ".zst" {
+				continue
+			}
+			t := repackTarget{
+				path:      filepath.Join(stationDir, f.Name()),
+				rel:       filepath.Join("stations", entry.Name(), f.Name()),
+				stationID: uint16(sid),
+			}
+			if year, dataType, ok := parseChunkFileName(f.Name()); ok {
+				t.year, t.dataType = year, dataType
+			} else if y, ok := strings.CutSuffix(f.Name(), "_optimized.zst"); ok {
+				if t.year, err = strconv.Atoi(y); err != nil {
+					continue
+				}
+			} else {
+				continue
+			}
+			targets = append(targets, t)
+		}
+	}
+	sort.Slice(targets, func(i, j int) bool { return targets[i].rel < targets[j].rel })
+	return targets, nil
+}
+
+// repackChunks converts targets on a pool of workers and streams results in
+// completion order. The channel is closed once every target is done or, after
+// stop is closed, once the conversions already started have finished.
+func repackChunks(dataDir string, targets []repackTarget, level, workers int, limiter *byteRateLimiter, stop <-chan struct{}) <-chan repackResult {
+	jobs := make(chan repackTarget)
+	results := make(chan repackResult, workers)
+
+	var wg sync.WaitGroup
+	for i := 0; i < workers; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for t := range jobs {
+				results <- repackChunk(dataDir, t, level, limiter)
+			}
+		}()
+	}
+	go func() {
+	feed:
+		for _, t := range targets {
+			select {
+			case jobs <- t:
+			case <-stop:
+				break feed
+			}
+		}
+		close(jobs)
+		wg.Wait()
+		close(results)
+	}()
+	return results
+}
+
+// repackChunk re-encodes one chunk with the current writer at level, checks
+// that the new file decodes to the same contents and renames it over the
+// original so readers never see a partial file.
+func repackChunk(dataDir string, t repackTarget, level int, limiter *byteRateLimiter) repackResult {
+	res := repackResult{target: t}
+	info, err := os.Stat(t.path)
+	if err != nil {
+		res.err = err
+		return res
+	}
+	res.before = info.Size()
+	limiter.Wait(res.before)
+
+	tmpDir, err := os.MkdirTemp(dataDir, ".repack-")
+	if err != nil {
+		res.err = fmt.Errorf("create repack dir: %w", err)
+		return res
+	}
+	defer os.RemoveAll(tmpDir)
+
+	var newPath string
+	if t.dataType == "" {
+		newPath, err = repackColumnFile(tmpDir, t, level)
+	} else {
+		newPath, res.chunkInfo, err = repackYearChunk(dataDir, tmpDir, t, level)
+	}
+	if err != nil {
+		res.err = err
+		return res
+	}
+
+	newInfo, err := os.Stat(newPath)
+	if err != nil {
+		res.err = err
+		return res
+	}
+	if err := os.Chmod(newPath, info.Mode().Perm()); err != nil {
+		res.err = err
+		return res
+	}
+	if err := os.Rename(newPath, t.path); err != nil {
+		res.err = fmt.Errorf("swap repacked chunk: %w", err)
+		return res
+	}
+	res.after = newInfo.Size()
+	if res.chunkInfo != nil {
+		res.chunkInfo.FilePath = t.path
+	}
+	return res
+}
+
+// repackColumnFile recompresses an *_optimized.zst column file.
+func repackColumnFile(tmpDir string, t repackTarget, level int) (string, error) {
+	compressed, err := os.ReadFile(t.path)
+	if err != nil {
+		return "", err
+	}
+	raw, err := decompressData(nil, compressed)
+	if err != nil {
+		return "", fmt.Errorf("decompress: %w", err)
+	}
+	repacked, err := compressLevel(raw, level)
+	if err != nil {
+		return "", fmt.Errorf("compress: %w", err)
+	}
+	check, err := decompressData(nil, repacked)
+	if err != nil || !bytes.Equal(check, raw) {
+		return "", errors.New("verification failed: repacked data does not match original")
+	}
+
+	newPath := filepath.Join(tmpDir, filepath.Base(t.path))
+	if err := writeFileSync(newPath, repacked); err != nil {
+		return "", err
+	}
+	return newPath, nil
+}
+
+// repackYearChunk decodes a year chunk and writes it again through the chunk
+// writer into tmpDir, which mirrors the data directory layout.
+func repackYearChunk(dataDir, tmpDir string, t repackTarget, level int) (string, *types.ChunkInfo, error) {
+	reader := storage.NewChunkReader(dataDir)
+	writer, err := newChunkWriter(tmpDir, level)
+	if err != nil {
+		return "", nil, fmt.Errorf("create repack writer: %w", err)
+	}
+	check := storage.NewChunkReader(tmpDir)
+
+	var chunkInfo *types.ChunkInfo
+	var same bool
+	if t.dataType == types.DataTypeHourly {
+		records, err := reader.ReadHourlyChunk(t.stationID, t.year)
+		if err != nil {
+			return "", nil, fmt.Errorf("read chunk: %w", err)
+		}
+		if chunkInfo, err = writer.WriteHourlyChunk(t.stationID, t.year, records); err != nil {
+			return "", nil, fmt.Errorf("write chunk: %w", err)
+		}
+		if err := frameChunk(chunkInfo, level); err != nil {
+			return "", nil, fmt.Errorf("frame chunk: %w", err)
+		}
+		got, err := check.ReadHourlyChunk(t.stationID, t.year)
+		same = err == nil && reflect.DeepEqual(got, records)
+	} else {
+		records, err := reader.ReadDailyChunk(t.stationID, t.year)
+		if err != nil {
+			return "", nil, fmt.Errorf("read chunk: %w", err)
+		}
+		if chunkInfo, err = writer.WriteDailyChunk(t.stationID, t.year, records); err != nil {
+			return "", nil, fmt.Errorf("write chunk: %w", err)
+		}
+		if err := frameChunk(chunkInfo, level); err != nil {
+			return "", nil, fmt.Errorf("frame chunk: %w", err)
+		}
+		got, err := check.ReadDailyChunk(t.stationID, t.year)
+		same = err == nil && reflect.DeepEqual(got, records)
+	}
+	if !same {
+		return "", nil, errors.New("verification failed: repacked records do not match original")
+	}
+	return filepath.Join(tmpDir, t.rel), chunkInfo, nil
+}
+
+// writeFileSync writes data and flushes it to disk before returning.
+func writeFileSync(path string, data []byte) error {
+	f, err := os.Create(path)
+	if err != nil {
+		return err
+	}
+	if _, err := f.Write(data); err != nil {
+		f.Close()
+		return err
+	}
+	if err := f.Sync(); err != nil {
+		f.Close()
+		return err
+	}
+	return f.Close()
+}
@@ -0,0 +1,178 @@
+package main
+
+import (
+	"bytes"
+	"os"
+	"path/filepath"
+	"reflect"
+	"strings"
+	"testing"
+	"time"
+
+	"github.com/dl-alexandre/cimis-tsdb/storage"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// setupRepackDataDir writes a daily chunk and an optimized column file for station 2.
+func setupRepackDataDir(t *testing.T) (string, []types.DailyRecord, []byte) {
+	t.Helper()
+	dataDir := t.TempDir()
+	captureStdout(t, func() {
+		cmdInit(dataDir)
+	})
+
+	var records []types.DailyRecord
+	for d := time.Date(2023, 1, 1, 0, 0, 0, 0, time.UTC); d.Month() == time.January; d = d.AddDate(0, 0, 1) {
+		records = append(records, types.DailyRecord{
+			Timestamp:   types.TimeToDaysSinceEpoch(d),
+			StationID:   2,
+			Temperature: types.ScaleTemperature(12.5),
+			Humidity:    60,
+		})
+	}
+	writer, err := storage.NewChunkWriter(dataDir, 1)
+	if err != nil {
+		t.Fatalf("NewChunkWriter() error = %v", err)
+	}
+	if _, err := writer.WriteDailyChunk(2, 2023, records); err != nil {
+		t.Fatalf("WriteDailyChunk() error = %v", err)
+	}
+
+	raw := bytes.Repeat([]byte("column payload "), 200)
+	compressed, err := storage.CompressLevel(raw, 1)
+	if err != nil {
+		t.Fatalf("CompressLevel() error = %v", err)
+	}
+	optimized := filepath.Join(dataDir, "stations", "002", "2024_optimized.zst")
+	if err := os.WriteFile(optimized, compressed, 0644); err != nil {
+		t.Fatalf("write optimized file: %v", err)
+	}
+	return dataDir, records, raw
+}
+
+func TestRunRepackConvertsAndVerifiesChunks(t *testing.T) {
+	dataDir, records, raw := setupRepackDataDir(t)
+
+	output := captureStdout(t, func() {
+		if err := runRepack(dataDir, []string{"-compression", "9", "-workers", "2"}); err != nil {
+			t.Fatalf("runRepack() error = %v", err)
+		}
+	})
+	for _, want := range []string{"Repack complete: 2 repacked, 0 skipped, 0 failed", "Size:", "Throughput:"} {
+		if !strings.Contains(output, want) {
+			t.Fatalf("repack output missing %q:\n%s", want, output)
+		}
+	}
+
+	got, err := storage.NewChunkReader(dataDir).ReadDailyChunk(2, 2023)
+	if err != nil || !reflect.DeepEqual(got, records) {
+		t.Fatalf("ReadDailyChunk() after repack = %d records, %v", len(got), err)
+	}
+	compressed, err := os.ReadFile(filepath.Join(dataDir, "stations", "002", "2024_optimized.zst"))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if data, err := storage.Decompress(nil, compressed); err != nil || !bytes.Equal(data, raw) {
+		t.Fatalf("optimized file changed contents after repack: %v", err)
+	}
+
+	if _, err := os.Stat(filepath.Join(dataDir, repackJournalName)); !os.IsNotExist(err) {
+		t.Fatalf("journal should be removed after a clean run, stat error = %v", err)
+	}
+	entries, err := os.ReadDir(dataDir)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, e := range entries {
+		if strings.HasPrefix(e.Name(), ".repack-") {
+			t.Fatalf("left scratch directory %s behind", e.Name())
+		}
+	}
+}
+
+func TestRunRepackResumesFromJournal(t *testing.T) {
+	dataDir, _, _ := setupRepackDataDir(t)
+
+	journal := filepath.Join(dataDir, repackJournalName)
+	done := filepath.Join("stations", "002", "2023_daily.zst") + "\t9\n"
+	if err := os.WriteFile(journal, []byte(done), 0644); err != nil {
+		t.Fatal(err)
+	}
+
+	output := captureStdout(t, func() {
+		if err := runRepack(dataDir, []string{"-compression", "9"}); err != nil {
+			t.Fatalf("runRepack() error = %v", err)
+		}
+	})
+	if !strings.Contains(output, "Repack complete: 1 repacked, 1 skipped, 0 failed") {
+		t.Fatalf("resume output = %q", output)
+	}
+
+	// A different level is a different conversion and starts over.
+	if err := os.WriteFile(journal, []byte(done), 0644); err != nil {
+		t.Fatal(err)
+	}
+	output = captureStdout(t, func() {
+		if err := runRepack(dataDir, []string{"-compression", "5"}); err != nil {
+			t.Fatalf("runRepack() error = %v", err)
+		}
+	})
+	if !strings.Contains(output, "2 repacked, 0 skipped") {
+		t.Fatalf("level change output = %q", output)
+	}
+}
+
+func TestRunRepackKeepsJournalOnFailure(t *testing.T) {
+	dataDir, _, _ := setupRepackDataDir(t)
+
+	bad := filepath.Join(dataDir, "stations", "002", "2024_optimized.zst")
+	if err := os.WriteFile(bad, []byte("not zstd"), 0644); err != nil {
+		t.Fatal(err)
+	}
+
+	captureStdout(t, func() {
+		if err := runRepack(dataDir, []string{"-workers", "1"}); err == nil {
+			t.Fatal("expected repack failure for corrupt file")
+		}
+	})
+	if data, err := os.ReadFile(bad); err != nil || string(data) != "not zstd" {
+		t.Fatalf("failed chunk must be left untouched, got %q, %v", data, err)
+	}
+	journal, err := os.ReadFile(filepath.Join(dataDir, repackJournalName))
+	if err != nil {
+		t.Fatalf("journal should survive a failed run: %v", err)
+	}
+	if !strings.Contains(string(journal), "2023_daily.zst\t3") {
+		t.Fatalf("journal = %q, want the repacked daily chunk", journal)
+	}
+}
+
+func TestRunRepackFlagValidation(t *testing.T) {
+	dataDir := t.TempDir()
+	for _, args := range [][]string{{"-workers", "0"}, {"-mbps", "-1"}, {"-bogus"}} {
+		if err := runRepack(dataDir, args); err == nil {
+			t.Fatalf("runRepack(%v) expected error", args)
+		}
+	}
+	if err := runRepack(dataDir, nil); err == nil {
+		t.Fatal("expected missing stations directory error")
+	}
+}
+
+func TestByteRateLimiterPaces(t *testing.T) {
+	l := newByteRateLimiter(1) // 1 MB/s
+	var slept time.Duration
+	l.sleep = func(d time.Duration) { slept += d }
+
+	for i := 0; i < 4; i++ {
+		l.Wait(512 * 1024)
+	}
+	// Four half-megabyte reads at 1 MB/s: the last starts ~1.5s in.
+	if slept < 2*time.Second || slept > 4*time.Second {
+		t.Fatalf("limiter slept %v in total, want about 3s", slept)
+	}
+
+	var unlimited *byteRateLimiter
+	unlimited.Wait(1 << 30)
+	newByteRateLimiter(0).Wait(1 << 30)
+}
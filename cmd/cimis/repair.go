@@ -0,0 +1,309 @@
+package main
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"strings"
+	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/api"
+	"github.com/dl-alexandre/cimis-tsdb/metadata"
+	"github.com/dl-alexandre/cimis-tsdb/storage"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// repairChunkReader is the subset of storage.ChunkReader used to salvage records.
+type repairChunkReader interface {
+	ReadDailyChunk(stationID uint16, year int) ([]types.DailyRecord, error)
+	ReadHourlyChunk(stationID uint16, year int) ([]types.HourlyRecord, error)
+}
+
+var (
+	newRepairChunkReader = func(dataDir string) repairChunkReader {
+		return storage.NewChunkReader(dataDir)
+	}
+	repairNow = time.Now
+)
+
+// timestampSpan is an inclusive range of missing timestamps (days or hours since epoch).
+type timestampSpan struct {
+	start uint32
+	end   uint32
+}
+
+// repairResult summarizes a single chunk repair.
+type repairResult struct {
+	salvaged int
+	dropped  int
+	fetched  int
+	spans    []timestampSpan
+	written  bool
+}
+
+// parseChunkFileName extracts year and data type from "<year>_<type>.zst" chunk names.
+func parseChunkFileName(name string) (int, types.DataType, bool) {
+	base := strings.TrimSuffix(name, ".zst")
+	parts := strings.SplitN(base, "_", 2)
+	if len(parts) != 2 {
+		return 0, "", false
+	}
+	year, err := strconv.Atoi(parts[0])
+	if err != nil {
+		return 0, "", false
+	}
+	switch types.DataType(parts[1]) {
+	case types.DataTypeDaily:
+		return year, types.DataTypeDaily, true
+	case types.DataTypeHourly:
+		return year, types.DataTypeHourly, true
+	}
+	return 0, "", false
+}
+
+// chunkTimestampBounds returns the inclusive timestamp range a chunk should cover.
+// The current year is clipped to yesterday so repairs don't chase data the API
+// hasn't published yet.
+func chunkTimestampBounds(year int, dataType types.DataType, now time.Time) (uint32, uint32, bool) {
+	start := time.Date(year, 1, 1, 0, 0, 0, 0, time.UTC)
+	end := time.Date(year, 12, 31, 23, 0, 0, 0, time.UTC)
+	yesterday := time.Date(now.Year(), now.Month(), now.Day(), 23, 0, 0, 0, time.UTC).AddDate(0, 0, -1)
+	if end.After(yesterday) {
+		end = yesterday
+	}
+	if end.Before(start) {
+		return 0, 0, false
+	}
+
+	if dataType == types.DataTypeHourly {
+		return types.TimeToHoursSinceEpoch(start), types.TimeToHoursSinceEpoch(end), true
+	}
+	return types.TimeToDaysSinceEpoch(start), types.TimeToDaysSinceEpoch(end), true
+}
+
+// missingSpans returns the runs of timestamps in [start, end] that are absent from present.
+func missingSpans(present map[uint32]struct{}, start, end uint32) []timestampSpan {
+	var spans []timestampSpan
+	inGap := false
+	var gapStart uint32
+
+	for ts := start; ; ts++ {
+		_, ok := present[ts]
+		if !ok && !inGap {
+			inGap = true
+			gapStart = ts
+		} else if ok && inGap {
+			spans = append(spans, timestampSpan{start: gapStart, end: ts - 1})
+			inGap = false
+		}
+		if ts == end {
+			break
+		}
+	}
+	if inGap {
+		spans = append(spans, timestampSpan{start: gapStart, end: end})
+	}
+	return spans
+}
+
+// Gaps of at most this many present timestamps are re-fetched together:
+// scattered hourly holes inside the same day, or daily holes a few days
+// apart, cost a single request.
+const (
+	hourlyRepairMaxGap = 24
+	dailyRepairMaxGap  = 7
+)
+
+// coalesceSpans merges spans separated by at most maxGap present timestamps.
+func coalesceSpans(spans []timestampSpan, maxGap uint32) []timestampSpan {
+	if len(spans) == 0 {
+		return nil
+	}
+	merged := []timestampSpan{spans[0]}
+	for _, span := range spans[1:] {
+		last := &merged[len(merged)-1]
+		if span.start-last.end-1 <= maxGap {
+			last.end = span.end
+			continue
+		}
+		merged = append(merged, span)
+	}
+	return merged
+}
+
+// validDailyRecord mirrors cimis_validate_daily_record plus chunk ownership checks.
+func validDailyRecord(r types.DailyRecord, stationID uint16, start, end uint32) bool {
+	return r.StationID == stationID &&
+		r.Timestamp >= start && r.Timestamp <= end &&
+		r.Temperature >= -500 && r.Temperature <= 600 &&
+		r.Humidity <= 100
+}
+
+// validHourlyRecord mirrors cimis_validate_hourly_record plus chunk ownership checks.
+func validHourlyRecord(r types.HourlyRecord, stationID uint16, start, end uint32) bool {
+	return r.StationID == stationID &&
+		r.Timestamp >= start && r.Timestamp <= end &&
+		r.Temperature >= -500 && r.Temperature <= 600 &&
+		r.Humidity <= 100
+}
+
+// repairChunk salvages the readable records of a chunk, re-fetches only the
+// missing timestamp spans and atomically replaces the chunk file. A chunk
+// that no longer decodes as a whole keeps the records of its intact frames
+// (see frameChunk); one written before framing loses them all.
+func repairChunk(dataDir, appKey, chunkPath string, stationID uint16, year int, dataType types.DataType, compressionLevel int) (repairResult, error) {
+	var res repairResult
+
+	start, end, ok := chunkTimestampBounds(year, dataType, repairNow())
+	if !ok {
+		return res, nil
+	}
+
+	reader := newRepairChunkReader(dataDir)
+	present := make(map[uint32]struct{})
+
+	var daily []types.DailyRecord
+	var hourly []types.HourlyRecord
+	var readErr error
+	if dataType == types.DataTypeHourly {
+		var records []types.HourlyRecord
+		if records, readErr = reader.ReadHourlyChunk(stationID, year); readErr != nil {
+			_, records, _ = salvageFramedChunk(chunkPath, dataType)
+		}
+		for _, r := range records {
+			if _, dup := present[r.Timestamp]; dup || !validHourlyRecord(r, stationID, start, end) {
+				res.dropped++
+				continue
+			}
+			present[r.Timestamp] = struct{}{}
+			hourly = append(hourly, r)
+		}
+		res.salvaged = len(hourly)
+	} else {
+		var records []types.DailyRecord
+		if records, readErr = reader.ReadDailyChunk(stationID, year); readErr != nil {
+			records, _, _ = salvageFramedChunk(chunkPath, dataType)
+		}
+		for _, r := range records {
+			if _, dup := present[r.Timestamp]; dup || !validDailyRecord(r, stationID, start, end) {
+				res.dropped++
+				continue
+			}
+			present[r.Timestamp] = struct{}{}
+			daily = append(daily, r)
+		}
+		res.salvaged = len(daily)
+	}
+
+	res.spans = missingSpans(present, start, end)
+	if len(res.spans) > 0 && appKey == "" {
+		return res, fmt.Errorf("CIMIS app key required to re-fetch %d missing span(s)", len(res.spans))
+	}
+
+	if dataType == types.DataTypeHourly {
+		client := newAPIClient(appKey)
+		for _, span := range coalesceSpans(res.spans, hourlyRepairMaxGap) {
+			from := api.Epoch.Add(time.Duration(span.start) * time.Hour)
+			to := api.Epoch.Add(time.Duration(span.end) * time.Hour)
+			apiRecords, err := client.FetchHourlyData(int(stationID), api.FormatCIMISDate(from), api.FormatCIMISDate(to))
+			if err != nil {
+				return res, fmt.Errorf("fetch hours %d-%d: %w", span.start, span.end, err)
+			}
+			for _, r := range api.ConvertHourlyToRecordsFast(apiRecords, stationID) {
+				if _, dup := present[r.Timestamp]; dup || r.Timestamp < span.start || r.Timestamp > span.end {
+					continue
+				}
+				present[r.Timestamp] = struct{}{}
+				hourly = append(hourly, r)
+				res.fetched++
+			}
+		}
+	} else {
+		client := newOptimizedAPIClient(appKey)
+		for _, span := range coalesceSpans(res.spans, dailyRepairMaxGap) {
+			from := api.Epoch.AddDate(0, 0, int(span.start))
+			to := api.Epoch.AddDate(0, 0, int(span.end))
+			records, _, err := client.FetchDailyDataStreaming(int(stationID), api.FormatCIMISDate(from), api.FormatCIMISDate(to))
+			if err != nil {
+				return res, fmt.Errorf("fetch days %d-%d: %w", span.start, span.end, err)
+			}
+			for _, r := range records {
+				if _, dup := present[r.Timestamp]; dup || r.Timestamp < span.start || r.Timestamp > span.end {
+					continue
+				}
+				present[r.Timestamp] = struct{}{}
+				daily = append(daily, r)
+				res.fetched++
+			}
+		}
+	}
+
+	// Leave intact chunks alone when upstream has nothing new for their gaps.
+	if readErr == nil && res.dropped == 0 && res.fetched == 0 {
+		return res, nil
+	}
+	if len(daily) == 0 && len(hourly) == 0 {
+		return res, nil
+	}
+
+	// Write the merged chunk into a scratch data dir on the same filesystem,
+	// then rename it over the original so readers never see a partial file.
+	tmpDir, err := os.MkdirTemp(dataDir, ".repair-")
+	if err != nil {
+		return res, fmt.Errorf("create repair dir: %w", err)
+	}
+	defer os.RemoveAll(tmpDir)
+
+	writer, err := newChunkWriter(tmpDir, compressionLevel)
+	if err != nil {
+		return res, fmt.Errorf("create repair writer: %w", err)
+	}
+
+	var chunkInfo *types.ChunkInfo
+	if dataType == types.DataTypeHourly {
+		sort.Slice(hourly, func(i, j int) bool { return hourly[i].Timestamp < hourly[j].Timestamp })
+		chunkInfo, err = writer.WriteHourlyChunk(stationID, year, hourly)
+	} else {
+		sort.Slice(daily, func(i, j int) bool { return daily[i].Timestamp < daily[j].Timestamp })
+		chunkInfo, err = writer.WriteDailyChunk(stationID, year, daily)
+	}
+	if err != nil {
+		return res, fmt.Errorf("write repaired chunk: %w", err)
+	}
+	if err := frameChunk(chunkInfo, compressionLevel); err != nil {
+		return res, fmt.Errorf("frame repaired chunk: %w", err)
+	}
+
+	rel, err := filepath.Rel(dataDir, chunkPath)
+	if err != nil {
+		return res, fmt.Errorf("resolve chunk path: %w", err)
+	}
+	if err := os.Rename(filepath.Join(tmpDir, rel), chunkPath); err != nil {
+		return res, fmt.Errorf("swap repaired chunk: %w", err)
+	}
+	res.written = true
+
+	if dataType == types.DataTypeHourly {
+		_ = writeHourlySketchSidecar(chunkPath, hourly)
+		_ = updateTailIndex(chunkPath, nil, hourly)
+	} else {
+		_ = writeDailySketchSidecar(chunkPath, daily)
+		_ = updateTailIndex(chunkPath, daily, nil)
+	}
+
+	if chunkInfo != nil {
+		chunkInfo.FilePath = chunkPath
+		store, err := metadata.NewStore(filepath.Join(dataDir, "metadata.sqlite3"))
+		if err != nil {
+			return res, fmt.Errorf("failed to open metadata store: %w", err)
+		}
+		defer store.Close()
+		if err := saveChunkMetadata(store, chunkInfo); err != nil {
+			return res, fmt.Errorf("failed to save chunk metadata: %w", err)
+		}
+	}
+
+	return res, nil
+}
@@ -0,0 +1,218 @@
+package main
+
+import (
+	"encoding/json"
+	"flag"
+	"fmt"
+	"math"
+	"os"
+	"path/filepath"
+	"strconv"
+	"strings"
+	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/api"
+	"github.com/dl-alexandre/cimis-cli/internal/spatial"
+	"github.com/dl-alexandre/cimis-tsdb/storage"
+)
+
+// stationCacheFileName holds station coordinates fetched from FetchAllStations.
+const stationCacheFileName = "stations.json"
+
+// cachedStation is one entry of the local station coordinate cache.
+type cachedStation struct {
+	ID     int     `json:"id"`
+	Name   string  `json:"name"`
+	Lat    float64 `json:"lat"`
+	Lon    float64 `json:"lon"`
+	Active bool    `json:"active"`
+}
+
+func cmdStations(dataDir, appKey string, args []string) {
+	fatalIfErr(runStations(dataDir, appKey, args))
+}
+
+// runStations refreshes the local station coordinate cache used by
+// spatial queries, so they never need a network round trip.
+func runStations(dataDir, appKey string, args []string) error {
+	fs := flag.NewFlagSet("stations", flag.ContinueOnError)
+	refresh := fs.Bool("refresh", false, "Re-fetch station coordinates even if cached")
+
+	if err := fs.Parse(args); err != nil {
+		return err
+	}
+
+	path := filepath.Join(dataDir, stationCacheFileName)
+	if !*refresh {
+		if stations, err := loadStationCache(dataDir); err == nil {
+			fmt.Printf("Station coordinates: %d cached in %s (use -refresh to update)\n", len(stations), path)
+			return nil
+		}
+	}
+
+	if appKey == "" {
+		return fmt.Errorf("CIMIS app key required (use -app-key flag or CIMIS_APP_KEY env var)")
+	}
+	apiStations, err := newAPIClient(appKey).FetchAllStations()
+	if err != nil {
+		return fmt.Errorf("failed to fetch stations: %w", err)
+	}
+
+	var stations []cachedStation
+	var skipped int
+	for _, s := range apiStations {
+		id, err := strconv.Atoi(strings.TrimSpace(s.StationNbr))
+		lat, lon, ok := s.Coordinates()
+		if err != nil || !ok {
+			skipped++
+			continue
+		}
+		stations = append(stations, cachedStation{
+			ID:     id,
+			Name:   s.Name,
+			Lat:    lat,
+			Lon:    lon,
+			Active: strings.EqualFold(s.IsActive, "true"),
+		})
+	}
+
+	data, err := json.MarshalIndent(stations, "", "  ")
+	if err != nil {
+		return fmt.Errorf("failed to encode station cache: %w", err)
+	}
+	tmp := path + ".tmp"
+	if err := os.WriteFile(tmp, data, 0644); err != nil {
+		return fmt.Errorf("failed to write station cache: %w", err)
+	}
+	if err := os.Rename(tmp, path); err != nil {
+		return fmt.Errorf("failed to write station cache: %w", err)
+	}
+
+	fmt.Printf("Cached %d station coordinates in %s (%d skipped without coordinates)\n", len(stations), path, skipped)
+	return nil
+}
+
+// loadStationCache reads the coordinates written by runStations.
+func loadStationCache(dataDir string) ([]cachedStation, error) {
+	data, err := os.ReadFile(filepath.Join(dataDir, stationCacheFileName))
+	if err != nil {
+		return nil, err
+	}
+	var stations []cachedStation
+	if err := json.Unmarshal(data, &stations); err != nil {
+		return nil, fmt.Errorf("invalid station cache: %w", err)
+	}
+	return stations, nil
+}
+
+type spatialOptions struct {
+	lat       float64
+	lon       float64
+	k         int
+	power     float64
+	field     string
+	startDate string
+	endDate   string
+}
+
+// runSpatialQuery estimates a daily field at a point by inverse-distance
+// weighting the k nearest stations that have stored data.
+func runSpatialQuery(dataDir string, opts spatialOptions) error {
+	extract, ok := dailyFields[opts.field]
+	if !ok {
+		return fmt.Errorf("unknown daily field: %s", opts.field)
+	}
+	if opts.lat < -90 || opts.lat > 90 || opts.lon < -180 || opts.lon > 180 {
+		return fmt.Errorf("invalid coordinates: %g, %g", opts.lat, opts.lon)
+	}
+	if opts.k < 1 {
+		return fmt.Errorf("k must be at least 1")
+	}
+	start, err := time.Parse("2006-01-02", opts.startDate)
+	if err != nil {
+		return fmt.Errorf("invalid start date: %w", err)
+	}
+	end, err := time.Parse("2006-01-02", opts.endDate)
+	if err != nil {
+		return fmt.Errorf("invalid end date: %w", err)
+	}
+	if !end.After(start) {
+		return fmt.Errorf("end date must be after start date")
+	}
+
+	queryStart := time.Now()
+	cache, err := loadStationCache(dataDir)
+	if err != nil {
+		if os.IsNotExist(err) {
+			return fmt.Errorf("station coordinates not cached; run 'cimis stations' first")
+		}
+		return err
+	}
+	stored, err := listStoredStations(dataDir)
+	if err != nil {
+		return err
+	}
+	hasData := make(map[int]bool, len(stored))
+	for _, sid := range stored {
+		hasData[sid] = true
+	}
+
+	names := make(map[int]string)
+	var points []spatial.Point
+	for _, s := range cache {
+		if hasData[s.ID] {
+			points = append(points, spatial.Point{ID: s.ID, Lat: s.Lat, Lon: s.Lon})
+			names[s.ID] = s.Name
+		}
+	}
+	if len(points) == 0 {
+		return fmt.Errorf("no stored stations have cached coordinates")
+	}
+
+	neighbors := spatial.NewKDTree(points).Nearest(opts.lat, opts.lon, opts.k)
+
+	// Align each neighbor's values on the requested day range.
+	startTs := uint32(start.Sub(api.Epoch).Hours() / 24)
+	endTs := uint32(end.Sub(api.Epoch).Hours() / 24)
+	days := int(endTs - startTs)
+	reader := storage.NewChunkReader(dataDir)
+	series := make([][]float64, len(neighbors))
+	distances := make([]float64, len(neighbors))
+	for i, n := range neighbors {
+		distances[i] = n.DistanceKm
+		values := make([]float64, days)
+		for d := range values {
+			values[d] = math.NaN()
+		}
+		for year := start.Year(); year <= end.Year(); year++ {
+			records, err := reader.ReadDailyChunk(uint16(n.ID), year)
+			if err != nil {
+				continue
+			}
+			for _, r := range records {
+				if r.Timestamp >= startTs && r.Timestamp < endTs {
+					values[r.Timestamp-startTs] = extract(r)
+				}
+			}
+		}
+		series[i] = values
+	}
+	estimates := spatial.IDW(series, distances, opts.power)
+
+	fmt.Printf("Nearest %d station(s) to %.4f, %.4f:\n", len(neighbors), opts.lat, opts.lon)
+	for _, n := range neighbors {
+		fmt.Printf("  Station %d (%s): %.1f km\n", n.ID, names[n.ID], n.DistanceKm)
+	}
+	fmt.Printf("\nIDW estimate of %s (power %g):\n", opts.field, opts.power)
+	var estimated int
+	for d, v := range estimates {
+		if math.IsNaN(v) {
+			continue
+		}
+		estimated++
+		ts := api.Epoch.AddDate(0, 0, int(startTs)+d)
+		fmt.Printf("  %s: %.2f\n", ts.Format("2006-01-02"), v)
+	}
+	fmt.Printf("\nEstimated %d of %d day(s) in %v\n", estimated, days, time.Since(queryStart))
+	return nil
+}
@@ -32,5 +32,8 @@ func runStats(dataDir string) error {
 	fmt.Printf("Total rows:         %d\n", stats.TotalRows)
 	fmt.Printf("Compressed size:    %.2f MB\n", float64(stats.TotalCompressedBytes)/(1024*1024))
 	fmt.Printf("Avg compression:    %.2fx\n", stats.AvgCompressionRatio)
+	if raw := rawCopyBytes(dataDir); raw > 0 {
+		fmt.Printf("Hot tier copies:    %.2f MB\n", float64(raw)/(1024*1024))
+	}
 	return nil
 }
@@ -0,0 +1,333 @@
+package main
+
+import (
+	"flag"
+	"fmt"
+	"os"
+	"path/filepath"
+	"sort"
+	"sync/atomic"
+	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/tier"
+	"github.com/dl-alexandre/cimis-tsdb/storage"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+var tierNow = time.Now
+
+// chunkFilePath is where the chunk writer stores a station-year chunk.
+func chunkFilePath(dataDir string, stationID uint16, year int, dataType types.DataType) string {
+	return filepath.Join(dataDir, "stations", fmt.Sprintf("%03d", stationID), fmt.Sprintf("%d_%s.zst", year, dataType))
+}
+
+// tieredChunkReader serves hot chunks from their raw copy without
+// decompressing them and leaves every other chunk to base.
+type tieredChunkReader struct {
+	dataDir string
+	base    queryChunkReader
+	rawHits atomic.Int64
+}
+
+func (r *tieredChunkReader) ReadDailyChunk(stationID uint16, year int) ([]types.DailyRecord, error) {
+	if records, err := tier.ReadRawDaily(chunkFilePath(r.dataDir, stationID, year, types.DataTypeDaily)); err == nil {
+		r.rawHits.Add(1)
+		return records, nil
+	}
+	return r.base.ReadDailyChunk(stationID, year)
+}
+
+func (r *tieredChunkReader) ReadHourlyChunk(stationID uint16, year int) ([]types.HourlyRecord, error) {
+	if records, err := tier.ReadRawHourly(chunkFilePath(r.dataDir, stationID, year, types.DataTypeHourly)); err == nil {
+		r.rawHits.Add(1)
+		return records, nil
+	}
+	return r.base.ReadHourlyChunk(stationID, year)
+}
+
+// recordChunkAccess notes which chunks a query read so the tier migrator can
+// promote frequently used years. It is best effort.
+func recordChunkAccess(dataDir string, chunks []types.ChunkInfo) {
+	keys := make([]string, 0, len(chunks))
+	for _, c := range chunks {
+		keys = append(keys, tier.ChunkKey(c.StationID, c.Year, c.DataType))
+	}
+	if err := tier.RecordAccess(filepath.Join(dataDir, tier.AccessLogName), keys, tierNow()); err != nil {
+		fmt.Printf("Warning: failed to record chunk access: %v\n", err)
+	}
+}
+
+type tierOptions struct {
+	policy  tier.Policy
+	workers int
+	mbps    float64
+	dryRun  bool
+}
+
+// tierPassStats summarizes one migration pass.
+type tierPassStats struct {
+	counts   map[tier.Tier]int
+	migrated int
+	failed   int
+	before   int64
+	after    int64
+}
+
+func cmdTier(dataDir string, args []string) {
+	fatalIfErr(runTier(dataDir, args))
+}
+
+func runTier(dataDir string, args []string) error {
+	def := tier.DefaultPolicy()
+	fs := flag.NewFlagSet("tier", flag.ContinueOnError)
+	hotYears := fs.Int("hot-years", def.HotYears, "Most recent years kept in the hot tier")
+	hotAccesses := fs.Int64("hot-accesses", def.HotAccesses, "Accesses within -idle that promote an older chunk to hot (0 disables)")
+	hotSet := fs.Int("hot-set", def.HotSet, "Most-queried chunks within -idle that are always hot (0 disables)")
+	coldAfter := fs.Int("cold-after", def.ColdAfterYears, "Age in years after which idle chunks move to the cold tier (0 disables)")
+	idle := fs.Duration("idle", def.Idle, "How long a query access counts towards promotion")
+	warmLevel := fs.Int("warm-level", def.WarmLevel, "Compression level for warm chunks and the .zst of hot chunks")
+	coldLevel := fs.Int("cold-level", def.ColdLevel, "Compression level for cold chunks")
+	workers := fs.Int("workers", 2, "Chunks recompressed in parallel")
+	mbps := fs.Float64("mbps", 0, "Limit chunk reads to this many MB/s (0 = unlimited)")
+	dryRun := fs.Bool("dry-run", false, "Show planned migrations without changing anything")
+	watch := fs.Duration("watch", 0, "Keep running and migrate again at this interval (0 = single pass)")
+
+	if err := fs.Parse(args); err != nil {
+		return err
+	}
+	opts := tierOptions{
+		policy: tier.Policy{
+			HotYears:       *hotYears,
+			HotAccesses:    *hotAccesses,
+			HotSet:         *hotSet,
+			ColdAfterYears: *coldAfter,
+			Idle:           *idle,
+			WarmLevel:      *warmLevel,
+			ColdLevel:      *coldLevel,
+		},
+		workers: *workers,
+		mbps:    *mbps,
+		dryRun:  *dryRun,
+	}
+	if err := opts.policy.Validate(); err != nil {
+		return err
+	}
+	if *workers < 1 {
+		return fmt.Errorf("-workers must be at least 1")
+	}
+	if *mbps < 0 {
+		return fmt.Errorf("-mbps must not be negative")
+	}
+	if *watch < 0 {
+		return fmt.Errorf("-watch must not be negative")
+	}
+
+	for {
+		stats, err := migrateTiers(dataDir, opts)
+		if err != nil && *watch == 0 {
+			return err
+		}
+		if err != nil {
+			fmt.Printf("Warning: tier pass failed: %v\n", err)
+		} else {
+			printTierPass(stats, opts.dryRun)
+		}
+		if *watch == 0 {
+			if stats.failed > 0 {
+				return fmt.Errorf("%d chunk(s) failed to migrate", stats.failed)
+			}
+			return nil
+		}
+		time.Sleep(*watch)
+	}
+}
+
+// tierMove is a chunk that has to change placement.
+type tierMove struct {
+	target repackTarget
+	from   tier.ManifestEntry
+	to     tier.ManifestEntry
+	key    string
+}
+
+// migrateTiers classifies every year chunk and moves the ones whose tier
+// changed: chunks are recompressed through the repack workers when their
+// level differs, then hot chunks get a raw copy and others lose theirs.
+// A manifest entry whose chunk was rewritten since (repack, fetch, repair)
+// is ignored, so that chunk is migrated again from scratch.
+func migrateTiers(dataDir string, opts tierOptions) (tierPassStats, error) {
+	stats := tierPassStats{counts: make(map[tier.Tier]int)}
+
+	targets, err := findRepackTargets(dataDir, 0)
+	if err != nil {
+		return stats, err
+	}
+	// Each pass folds the queries' access journal into the log.
+	loadAccess := tier.CompactAccessLog
+	if opts.dryRun {
+		loadAccess = tier.LoadAccessLog
+	}
+	access, err := loadAccess(filepath.Join(dataDir, tier.AccessLogName))
+	if err != nil {
+		return stats, err
+	}
+	manifestPath := filepath.Join(dataDir, tier.ManifestName)
+	manifest, err := tier.LoadManifest(manifestPath)
+	if err != nil {
+		return stats, err
+	}
+
+	now := tierNow()
+	// The most queried chunks stay hot even below -hot-accesses, so their
+	// raw copies carry the query working set across restarts.
+	hotSet := make(map[string]bool)
+	for _, key := range access.Hottest(now, opts.policy.Idle, opts.policy.HotSet) {
+		hotSet[key] = true
+	}
+	var moves []tierMove
+	for _, t := range targets {
+		if t.dataType == "" {
+			continue // column files are not read by queries
+		}
+		key := tier.ChunkKey(t.stationID, t.year, t.dataType)
+		want := opts.policy.Classify(t.year, access[key], now)
+		if hotSet[key] {
+			want = tier.Hot
+		}
+		stats.counts[want]++
+
+		to := tier.ManifestEntry{Tier: want, Level: opts.policy.Level(want)}
+		from, known := manifest[key]
+		if known && !from.Current(t.path) {
+			from, known = tier.ManifestEntry{}, false
+		}
+		hasRaw := tier.RawValid(t.path)
+		if known && from.Tier == to.Tier && from.Level == to.Level && hasRaw == (want == tier.Hot) {
+			continue
+		}
+		moves = append(moves, tierMove{target: t, from: from, to: to, key: key})
+	}
+
+	if opts.dryRun {
+		for _, m := range moves {
+			fmt.Printf("%s: %s -> %s (level %d)\n", m.target.rel, tierName(m.from), m.to.Tier, m.to.Level)
+		}
+		stats.migrated = len(moves)
+		return stats, nil
+	}
+
+	// Recompress in one worker pool per target level.
+	byLevel := make(map[int][]repackTarget)
+	for _, m := range moves {
+		if m.from.Level != m.to.Level || m.from.Tier == "" {
+			byLevel[m.to.Level] = append(byLevel[m.to.Level], m.target)
+		}
+	}
+	levels := make([]int, 0, len(byLevel))
+	for level := range byLevel {
+		levels = append(levels, level)
+	}
+	sort.Ints(levels)
+
+	limiter := newByteRateLimiter(opts.mbps)
+	saver := &repackMetadataSaver{dataDir: dataDir}
+	defer saver.Close()
+
+	failed := make(map[string]bool)
+	for _, level := range levels {
+		stop := make(chan struct{})
+		for res := range repackChunks(dataDir, byLevel[level], level, opts.workers, limiter, stop) {
+			if res.err == nil {
+				res.err = saver.Save(res.chunkInfo)
+			}
+			if res.err != nil {
+				fmt.Printf("FAIL: %s - %v\n", res.target.path, res.err)
+				failed[res.target.rel] = true
+				continue
+			}
+			stats.before += res.before
+			stats.after += res.after
+		}
+		close(stop)
+	}
+
+	reader := storage.NewChunkReader(dataDir)
+	for _, m := range moves {
+		if failed[m.target.rel] {
+			stats.failed++
+			continue
+		}
+		if err := applyRawCopy(reader, m.target, m.to.Tier == tier.Hot); err != nil {
+			fmt.Printf("FAIL: %s - raw copy: %v\n", m.target.path, err)
+			stats.failed++
+			continue
+		}
+		if err := m.to.Stamp(m.target.path); err != nil {
+			fmt.Printf("FAIL: %s - %v\n", m.target.path, err)
+			stats.failed++
+			continue
+		}
+		manifest[m.key] = m.to
+		stats.migrated++
+		fmt.Printf("%s: %s -> %s (level %d)\n", m.target.rel, tierName(m.from), m.to.Tier, m.to.Level)
+	}
+
+	if len(moves) > 0 {
+		if err := tier.SaveManifest(manifestPath, manifest); err != nil {
+			return stats, fmt.Errorf("save tier manifest: %w", err)
+		}
+	}
+	return stats, nil
+}
+
+// applyRawCopy writes (hot) or removes (warm, cold) a chunk's raw copy.
+func applyRawCopy(reader *storage.ChunkReader, t repackTarget, hot bool) error {
+	if !hot {
+		return tier.RemoveRaw(t.path)
+	}
+	if t.dataType == types.DataTypeHourly {
+		records, err := reader.ReadHourlyChunk(t.stationID, t.year)
+		if err != nil {
+			return err
+		}
+		return tier.WriteRawHourly(t.path, records)
+	}
+	records, err := reader.ReadDailyChunk(t.stationID, t.year)
+	if err != nil {
+		return err
+	}
+	return tier.WriteRawDaily(t.path, records)
+}
+
+func tierName(e tier.ManifestEntry) string {
+	if e.Tier == "" {
+		return "untiered"
+	}
+	return string(e.Tier)
+}
+
+func printTierPass(stats tierPassStats, dryRun bool) {
+	verb := "migrated"
+	if dryRun {
+		verb = "to migrate"
+	}
+	fmt.Printf("\nTiers: %d hot, %d warm, %d cold; %d %s, %d failed\n",
+		stats.counts[tier.Hot], stats.counts[tier.Warm], stats.counts[tier.Cold], stats.migrated, verb, stats.failed)
+	if stats.before > 0 {
+		fmt.Printf("Recompressed: %.2f MB -> %.2f MB\n", float64(stats.before)/(1024*1024), float64(stats.after)/(1024*1024))
+	}
+}
+
+// rawCopyBytes totals the hot tier raw copies under dataDir.
+func rawCopyBytes(dataDir string) int64 {
+	var total int64
+	_ = filepath.WalkDir(filepath.Join(dataDir, "stations"), func(path string, d os.DirEntry, err error) error {
+		if err == nil && !d.IsDir() && filepath.Ext(path) == ".raw" {
+			if info, err := d.Info(); err == nil {
+				total += info.Size()
+			}
+		}
+		return nil
+	})
+	return total
+}
@@ -0,0 +1,223 @@
+package main
+
+import (
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/tier"
+	"github.com/dl-alexandre/cimis-tsdb/metadata"
+	"github.com/dl-alexandre/cimis-tsdb/storage"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// setupTierDataDir writes daily chunks for station 2 in the given years and
+// registers them in the metadata store.
+func setupTierDataDir(t *testing.T, years ...int) string {
+	t.Helper()
+	dataDir := t.TempDir()
+	captureStdout(t, func() {
+		cmdInit(dataDir)
+	})
+
+	writer, err := storage.NewChunkWriter(dataDir, 3)
+	if err != nil {
+		t.Fatalf("NewChunkWriter() error = %v", err)
+	}
+	store, err := metadata.NewStore(filepath.Join(dataDir, "metadata.sqlite3"))
+	if err != nil {
+		t.Fatalf("NewStore() error = %v", err)
+	}
+	defer store.Close()
+
+	for _, year := range years {
+		var records []types.DailyRecord
+		for d := time.Date(year, 3, 1, 0, 0, 0, 0, time.UTC); d.Month() == time.March; d = d.AddDate(0, 0, 1) {
+			records = append(records, types.DailyRecord{
+				Timestamp:   types.TimeToDaysSinceEpoch(d),
+				StationID:   2,
+				Temperature: types.ScaleTemperature(15.5),
+				Humidity:    70,
+			})
+		}
+		info, err := writer.WriteDailyChunk(2, year, records)
+		if err != nil {
+			t.Fatalf("WriteDailyChunk(%d) error = %v", year, err)
+		}
+		if err := store.SaveChunk(info); err != nil {
+			t.Fatalf("SaveChunk() error = %v", err)
+		}
+	}
+	return dataDir
+}
+
+func TestRunTierMigratesByAgeAndAccess(t *testing.T) {
+	original := tierNow
+	t.Cleanup(func() { tierNow = original })
+	tierNow = func() time.Time { return time.Date(2024, 6, 1, 0, 0, 0, 0, time.UTC) }
+
+	dataDir := setupTierDataDir(t, 2000, 2005, 2016, 2024)
+	chunk := func(year int) string { return chunkFilePath(dataDir, 2, year, types.DataTypeDaily) }
+
+	// 2005 is old but queried often enough to stay hot.
+	hotKey := tier.ChunkKey(2, 2005, types.DataTypeDaily)
+	for i := 0; i < 12; i++ {
+		if err := tier.RecordAccess(filepath.Join(dataDir, tier.AccessLogName), []string{hotKey}, tierNow()); err != nil {
+			t.Fatal(err)
+		}
+	}
+
+	output := captureStdout(t, func() {
+		if err := runTier(dataDir, []string{"-dry-run"}); err != nil {
+			t.Fatalf("runTier(-dry-run) error = %v", err)
+		}
+	})
+	if !strings.Contains(output, "Tiers: 2 hot, 1 warm, 1 cold; 4 to migrate") {
+		t.Fatalf("dry run output = %q", output)
+	}
+	if tier.RawValid(chunk(2024)) {
+		t.Fatal("dry run must not write raw copies")
+	}
+
+	output = captureStdout(t, func() {
+		if err := runTier(dataDir, []string{"-workers", "2"}); err != nil {
+			t.Fatalf("runTier() error = %v", err)
+		}
+	})
+	for _, want := range []string{"2000_daily.zst: untiered -> cold (level 19)", "2024_daily.zst: untiered -> hot (level 3)", "4 migrated, 0 failed"} {
+		if !strings.Contains(output, want) {
+			t.Fatalf("tier output missing %q:\n%s", want, output)
+		}
+	}
+	for year, hot := range map[int]bool{2000: false, 2005: true, 2016: false, 2024: true} {
+		if tier.RawValid(chunk(year)) != hot {
+			t.Fatalf("year %d raw copy present = %v, want %v", year, !hot, hot)
+		}
+	}
+	manifest, err := tier.LoadManifest(filepath.Join(dataDir, tier.ManifestName))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if got := manifest[tier.ChunkKey(2, 2000, types.DataTypeDaily)]; got.Tier != tier.Cold || got.Level != 19 {
+		t.Fatalf("manifest entry for 2000 = %+v", got)
+	}
+
+	// A second pass has nothing to do.
+	output = captureStdout(t, func() {
+		if err := runTier(dataDir, nil); err != nil {
+			t.Fatalf("runTier() second pass error = %v", err)
+		}
+	})
+	if !strings.Contains(output, "0 migrated") {
+		t.Fatalf("second pass output = %q", output)
+	}
+
+	// Repack rewrites the cold chunk at its own level; the manifest entry no
+	// longer describes it, so the next pass puts it back at the cold level.
+	captureStdout(t, func() {
+		if err := runRepack(dataDir, []string{"-compression", "3", "-restart"}); err != nil {
+			t.Fatalf("runRepack() error = %v", err)
+		}
+	})
+	output = captureStdout(t, func() {
+		if err := runTier(dataDir, nil); err != nil {
+			t.Fatalf("runTier() after repack error = %v", err)
+		}
+	})
+	if !strings.Contains(output, "2000_daily.zst: untiered -> cold (level 19)") {
+		t.Fatalf("repacked chunk was not re-tiered:\n%s", output)
+	}
+
+	// Once the hot chunk goes idle it is demoted and loses its raw copy.
+	tierNow = func() time.Time { return time.Date(2025, 6, 1, 0, 0, 0, 0, time.UTC) }
+	captureStdout(t, func() {
+		if err := runTier(dataDir, nil); err != nil {
+			t.Fatalf("runTier() demotion pass error = %v", err)
+		}
+	})
+	if _, err := os.Stat(tier.RawPath(chunk(2005))); !os.IsNotExist(err) {
+		t.Fatalf("idle chunk kept its raw copy: %v", err)
+	}
+}
+
+func TestQueryReadsHotTierAndRecordsAccess(t *testing.T) {
+	dataDir := setupTierDataDir(t, 2024)
+	chunkPath := chunkFilePath(dataDir, 2, 2024, types.DataTypeDaily)
+	records, err := storage.NewChunkReader(dataDir).ReadDailyChunk(2, 2024)
+	if err != nil {
+		t.Fatal(err)
+	}
+	// Mark the raw copy so the test can tell it was the one served.
+	records[0].Temperature = types.ScaleTemperature(-40)
+	if err := tier.WriteRawDaily(chunkPath, records); err != nil {
+		t.Fatal(err)
+	}
+
+	output := captureStdout(t, func() {
+		if err := runQuery(dataDir, []string{"-station", "2", "-start", "2024-03-01", "-end", "2024-04-01", "-perf"}); err != nil {
+			t.Fatalf("runQuery() error = %v", err)
+		}
+	})
+	for _, want := range []string{"Temp=-40.0°C", "Hot tier (raw) reads:      1/1"} {
+		if !strings.Contains(output, want) {
+			t.Fatalf("query output missing %q:\n%s", want, output)
+		}
+	}
+
+	log, err := tier.LoadAccessLog(filepath.Join(dataDir, tier.AccessLogName))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if got := log[tier.ChunkKey(2, 2024, types.DataTypeDaily)].Count; got != 1 {
+		t.Fatalf("recorded accesses = %d, want 1", got)
+	}
+
+	// A stale copy is ignored in favour of the chunk itself.
+	later := time.Now().Add(time.Minute)
+	if err := os.Chtimes(chunkPath, later, later); err != nil {
+		t.Fatal(err)
+	}
+	output = captureStdout(t, func() {
+		if err := runQuery(dataDir, []string{"-station", "2", "-start", "2024-03-01", "-end", "2024-04-01", "-perf"}); err != nil {
+			t.Fatalf("runQuery() error = %v", err)
+		}
+	})
+	if strings.Contains(output, "Temp=-40.0°C") || !strings.Contains(output, "Hot tier (raw) reads:      0/1") {
+		t.Fatalf("stale raw copy was used:\n%s", output)
+	}
+}
+
+// TestTierHotSetWarmsLaterQueries: a chunk queried too rarely for
+// -hot-accesses is still among the most queried, so the tier pass keeps a
+// raw copy of it and the next query process reads it without decompressing.
+func TestTierHotSetWarmsLaterQueries(t *testing.T) {
+	original := tierNow
+	t.Cleanup(func() { tierNow = original })
+	tierNow = func() time.Time { return time.Date(2024, 6, 1, 0, 0, 0, 0, time.UTC) }
+
+	dataDir := setupTierDataDir(t, 2019, 2020)
+	query := func() string {
+		return captureStdout(t, func() {
+			if err := runQuery(dataDir, []string{"-station", "2", "-start", "2020-03-01", "-end", "2020-03-10", "-perf"}); err != nil {
+				t.Fatalf("runQuery() error = %v", err)
+			}
+		})
+	}
+	if output := query(); !strings.Contains(output, "Hot tier (raw) reads:      0/1") {
+		t.Fatalf("first query output:\n%s", output)
+	}
+
+	output := captureStdout(t, func() {
+		if err := runTier(dataDir, []string{"-hot-years", "0", "-hot-set", "1"}); err != nil {
+			t.Fatalf("runTier() error = %v", err)
+		}
+	})
+	if !strings.Contains(output, "2020_daily.zst: untiered -> hot") || !strings.Contains(output, "2019_daily.zst: untiered -> warm") {
+		t.Fatalf("tier output:\n%s", output)
+	}
+	if output := query(); !strings.Contains(output, "Hot tier (raw) reads:      1/1") {
+		t.Fatalf("later query did not read the warmed chunk:\n%s", output)
+	}
+}
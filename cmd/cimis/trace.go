@@ -0,0 +1,69 @@
+package main
+
+import (
+	"fmt"
+	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/api"
+	"github.com/dl-alexandre/cimis-cli/internal/trace"
+)
+
+// startTrace returns a recorder for -trace, or nil (which records nothing)
+// when no trace file was requested.
+func startTrace(path, command string) *trace.Recorder {
+	if path == "" {
+		return nil
+	}
+	return trace.New("cimis " + command)
+}
+
+// finishTrace writes the trace recorded for -trace.
+func finishTrace(rec *trace.Recorder, path string) error {
+	if rec == nil {
+		return nil
+	}
+	if err := rec.WriteFile(path); err != nil {
+		return err
+	}
+	fmt.Printf("Trace written to %s (open in ui.perfetto.dev or chrome://tracing)\n", path)
+	return nil
+}
+
+// traceFetch lays out the phases of an API fetch that began at start. The
+// client only reports durations, so connection setup is drawn from the
+// start of the request and decode after the response body was opened.
+func traceFetch(track *trace.Track, start time.Time, m *api.FetchMetrics, err error) {
+	if track == nil {
+		return
+	}
+	total := time.Since(start)
+	if m == nil {
+		track.Add("fetch", start, total, "error", fmt.Sprint(err))
+		return
+	}
+	args := []any{"records", m.RecordsFetched}
+	if err != nil {
+		args = append(args, "error", err.Error())
+	}
+	if err == nil && m.TotalDuration > 0 {
+		total = m.TotalDuration
+	}
+	track.Add("fetch", start, total, args...)
+
+	at := start
+	for _, phase := range []struct {
+		name string
+		d    time.Duration
+	}{{"dns", m.DNSLookup}, {"tcp", m.TCPConnect}, {"tls", m.TLSHandshake}} {
+		if phase.d > 0 && at.Add(phase.d).Sub(start) <= m.TTFB {
+			track.Add(phase.name, at, phase.d)
+			at = at.Add(phase.d)
+		}
+	}
+	if m.TTFB > 0 {
+		track.Add("ttfb", start, m.TTFB)
+	}
+	if m.JSONDecode > 0 {
+		track.Add("decode", start.Add(m.TTFB+m.BodyRead), m.JSONDecode)
+	}
+}
@@ -0,0 +1,112 @@
+package main
+
+import (
+	"encoding/json"
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+)
+
+type traceEvent struct {
+	Name string         `json:"name"`
+	Ph   string         `json:"ph"`
+	TID  int            `json:"tid"`
+	Args map[string]any `json:"args"`
+}
+
+// readTrace returns the spans of a trace file by name and its track names
+// by thread ID.
+func readTrace(t *testing.T, path string) (map[string][]traceEvent, map[int]string) {
+	t.Helper()
+	data, err := os.ReadFile(path)
+	if err != nil {
+		t.Fatalf("trace file: %v", err)
+	}
+	var trace struct {
+		TraceEvents []traceEvent `json:"traceEvents"`
+	}
+	if err := json.Unmarshal(data, &trace); err != nil {
+		t.Fatalf("trace is not valid JSON: %v", err)
+	}
+	spans := map[string][]traceEvent{}
+	tracks := map[int]string{}
+	for _, e := range trace.TraceEvents {
+		switch {
+		case e.Ph == "X":
+			spans[e.Name] = append(spans[e.Name], e)
+		case e.Name == "thread_name":
+			tracks[e.TID] = e.Args["name"].(string)
+		}
+	}
+	return spans, tracks
+}
+
+func TestQueryTraceSeparatesPrefetchTrack(t *testing.T) {
+	dataDir := setupTierDataDir(t, 2023, 2024)
+	path := filepath.Join(t.TempDir(), "query.json")
+
+	output := captureStdout(t, func() {
+		if err := runQuery(dataDir, []string{"-station", "2", "-start", "2023-01-01", "-end", "2025-01-01", "-trace", path}); err != nil {
+			t.Fatalf("runQuery() error = %v", err)
+		}
+	})
+	if !strings.Contains(output, "Trace written to "+path) {
+		t.Fatalf("query output = %q", output)
+	}
+
+	spans, tracks := readTrace(t, path)
+	if len(spans["query"]) != 1 || len(spans["metadata"]) != 1 || len(spans["decode block"]) != 2 || len(spans["filter"]) != 2 {
+		t.Fatalf("spans = %v", spans)
+	}
+	if tracks[spans["decode block"][0].TID] != "prefetch" || tracks[spans["filter"][0].TID] != "query" {
+		t.Fatalf("decode on %q, filter on %q", tracks[spans["decode block"][0].TID], tracks[spans["filter"][0].TID])
+	}
+	if got := spans["query"][0].Args["records"]; got != float64(62) {
+		t.Fatalf("query span records = %v", got)
+	}
+}
+
+func TestFetchStreamingAndIngestTrace(t *testing.T) {
+	server := newMockCIMISServer(t)
+	defer server.Close()
+	installMockCIMISClients(t, server.URL)
+
+	path := filepath.Join(t.TempDir(), "fetch.json")
+	captureStdout(t, func() {
+		if err := runFetchStreaming(t.TempDir(), "test-key", []string{
+			"-stations", "2", "-start", "2024-01-01", "-end", "2024-01-31",
+			"-concurrency", "2", "-retries", "0", "-trace", path,
+		}); err != nil {
+			t.Fatalf("runFetchStreaming() error = %v", err)
+		}
+	})
+	spans, tracks := readTrace(t, path)
+	for _, name := range []string{"station 2", "fetch", "ttfb", "decode", "write chunk", "metadata commit"} {
+		if len(spans[name]) != 1 {
+			t.Fatalf("fetch trace has %d %q spans: %v", len(spans[name]), name, spans)
+		}
+	}
+	if len(tracks) != 2 || !strings.HasPrefix(tracks[spans["write chunk"][0].TID], "worker ") {
+		t.Fatalf("tracks = %v", tracks)
+	}
+
+	path = filepath.Join(t.TempDir(), "ingest.json")
+	captureStdout(t, func() {
+		if err := runIngest(t.TempDir(), "test-key", []string{"-station", "2", "-year", "2024", "-trace", path}); err != nil {
+			t.Fatalf("runIngest() error = %v", err)
+		}
+	})
+	spans, _ = readTrace(t, path)
+	for _, name := range []string{"station 2", "fetch", "write chunk", "metadata commit", "sidecars"} {
+		if len(spans[name]) != 1 {
+			t.Fatalf("ingest trace has %d %q spans", len(spans[name]), name)
+		}
+	}
+
+	// A trace that cannot be written fails the command.
+	err := runIngest(t.TempDir(), "test-key", []string{"-station", "2", "-trace", filepath.Join(t.TempDir(), "missing", "x.json")})
+	if err == nil || !strings.Contains(err.Error(), "trace") {
+		t.Fatalf("runIngest() with bad trace path error = %v", err)
+	}
+}
@@ -1,6 +1,7 @@
 package main
 
 import (
+	"flag"
 	"fmt"
 	"os"
 	"path/filepath"
@@ -14,11 +15,30 @@ var (
 	verifyReadFile = os.ReadFile
 )
 
-func cmdVerify(dataDir string) {
-	fatalIfErr(runVerify(dataDir))
+func cmdVerify(dataDir, appKey string, args []string) {
+	fatalIfErr(runVerify(dataDir, appKey, args))
 }
 
-func runVerify(dataDir string) error {
+func runVerify(dataDir, appKey string, args []string) error {
+	fs := flag.NewFlagSet("verify", flag.ContinueOnError)
+	repair := fs.Bool("repair", false, "Salvage valid records and re-fetch only missing spans")
+	backfill := fs.Bool("backfill", false, "Also re-fetch missing spans of chunks that read cleanly (implies -repair)")
+	compressionLevel := fs.Int("compression", 3, "Compression level for repaired chunks")
+
+	if err := fs.Parse(args); err != nil {
+		return err
+	}
+	if *backfill {
+		*repair = true
+	}
+
+	if *repair && appKey == "" {
+		appKey = os.Getenv("CIMIS_APP_KEY")
+	}
+	if *repair && appKey == "" {
+		return fmt.Errorf("CIMIS app key required for -repair (use -app-key flag or CIMIS_APP_KEY env var)")
+	}
+
 	// Walk data directory
 	stationsDir := filepath.Join(dataDir, "stations")
 	entries, err := verifyReadDir(stationsDir)
@@ -26,7 +46,7 @@ func runVerify(dataDir string) error {
 		return fmt.Errorf("failed to read stations directory: %w", err)
 	}
 
-	var verified, failed int
+	var verified, failed, repaired int
 
 	for _, entry := range entries {
 		if !entry.IsDir() {
@@ -49,26 +69,46 @@ func runVerify(dataDir string) error {
 
 			// Try to read and decompress
 			filePath := filepath.Join(stationDir, chunk.Name())
+			ok := true
 			compressed, err := verifyReadFile(filePath)
 			if err != nil {
 				fmt.Printf("FAIL: %s - read error: %v\n", filePath, err)
-				failed++
-				continue
+				ok = false
+			} else if _, err = storage.Decompress(nil, compressed); err != nil {
+				fmt.Printf("FAIL: %s - decompress error: %v\n", filePath, err)
+				ok = false
+			} else {
+				fmt.Printf("OK: %s (station %d)\n", filePath, stationID)
 			}
 
-			_, err = storage.Decompress(nil, compressed)
-			if err != nil {
-				fmt.Printf("FAIL: %s - decompress error: %v\n", filePath, err)
-				failed++
-				continue
+			// Healthy chunks keep their ordinary gaps unless -backfill asks
+			// for them to be filled too.
+			if *repair && (!ok || *backfill) {
+				if year, dataType, isChunk := parseChunkFileName(chunk.Name()); isChunk {
+					res, err := repairChunk(dataDir, appKey, filePath, uint16(stationID), year, dataType, *compressionLevel)
+					if err != nil {
+						fmt.Printf("  repair failed: %v\n", err)
+					} else if res.written {
+						fmt.Printf("  repaired: salvaged %d, dropped %d, re-fetched %d record(s) across %d span(s)\n",
+							res.salvaged, res.dropped, res.fetched, len(res.spans))
+						repaired++
+						ok = true
+					}
+				}
 			}
 
-			fmt.Printf("OK: %s (station %d)\n", filePath, stationID)
-			verified++
+			if ok {
+				verified++
+			} else {
+				failed++
+			}
 		}
 	}
 
 	fmt.Printf("\nVerification complete: %d OK, %d failed\n", verified, failed)
+	if *repair {
+		fmt.Printf("Repaired: %d chunk(s)\n", repaired)
+	}
 	if failed > 0 {
 		return fmt.Errorf("%d chunk(s) failed verification", failed)
 	}
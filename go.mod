@@ -5,9 +5,9 @@ go 1.26.0
 require (
 	github.com/dl-alexandre/cimis-tsdb v1.0.0
 	github.com/dl-alexandre/cli-tools v0.0.1
+	github.com/klauspost/compress v1.19.0
 )
 
 require (
-	github.com/klauspost/compress v1.19.0 // indirect
 	github.com/mattn/go-sqlite3 v1.14.47 // indirect
 )
@@ -257,6 +257,56 @@ type Station struct {
 	SitingDesc     string   `json:"SitingDesc"`
 }
 
+// Coordinates returns the station location in decimal degrees.
+func (s Station) Coordinates() (lat, lon float64, ok bool) {
+	lat, latOK := ParseHMSCoordinate(s.HmsLatitude)
+	lon, lonOK := ParseHMSCoordinate(s.HmsLongitude)
+	return lat, lon, latOK && lonOK
+}
+
+// ParseHMSCoordinate parses CIMIS station coordinates such as
+// "36º20'10N / 36.336222", preferring the decimal part and falling back to
+// degrees, minutes and seconds with an N/S/E/W hemisphere.
+func ParseHMSCoordinate(value string) (float64, bool) {
+	if i := strings.LastIndex(value, "/"); i >= 0 {
+		if v, err := strconv.ParseFloat(strings.TrimSpace(value[i+1:]), 64); err == nil {
+			return v, true
+		}
+		value = value[:i]
+	}
+	value = strings.TrimSpace(value)
+	if value == "" {
+		return 0, false
+	}
+
+	negative := strings.HasPrefix(value, "-")
+	switch value[len(value)-1] {
+	case 'S', 's', 'W', 'w':
+		negative = true
+	}
+	parts := strings.FieldsFunc(value, func(r rune) bool {
+		return (r < '0' || r > '9') && r != '.'
+	})
+	if len(parts) == 0 || len(parts) > 3 {
+		return 0, false
+	}
+
+	var result float64
+	scale := 1.0
+	for _, part := range parts {
+		v, err := strconv.ParseFloat(part, 64)
+		if err != nil {
+			return 0, false
+		}
+		result += v / scale
+		scale *= 60
+	}
+	if negative {
+		result = -result
+	}
+	return result, true
+}
+
 // StationsResponse is the response shape for station metadata endpoints.
 type StationsResponse struct {
 	Stations []Station `json:"Stations"`
@@ -640,11 +690,8 @@ func ConvertHourlyToRecords(apiRecords []*HourlyDataRecord, stationID uint16) []
 			continue
 		}
 
-		// Parse hour (format is "HH:00")
-		hour := 0
-		if len(apiRec.Hour) >= 2 {
-			hour, _ = strconv.Atoi(apiRec.Hour[:2])
-		}
+		// Parse hour (format is "HH00", "2400" being the end of the day)
+		hour := parseHourPrefix(apiRec.Hour)
 
 		timestamp := date.Add(time.Duration(hour) * time.Hour)
 
@@ -682,6 +729,11 @@ func parseDateYYYYMMDD(s string) (year, month, day int, ok bool) {
 	if s[4] != '-' || s[7] != '-' {
 		return 0, 0, 0, false
 	}
+	// Bytes below '0' wrap around, so a single > 9 test rejects any non-digit.
+	if s[0]-'0' > 9 || s[1]-'0' > 9 || s[2]-'0' > 9 || s[3]-'0' > 9 ||
+		s[5]-'0' > 9 || s[6]-'0' > 9 || s[8]-'0' > 9 || s[9]-'0' > 9 {
+		return 0, 0, 0, false
+	}
 	year = (int(s[0]-'0')*1000 + int(s[1]-'0')*100 + int(s[2]-'0')*10 + int(s[3]-'0'))
 	month = (int(s[5]-'0')*10 + int(s[6]-'0'))
 	day = (int(s[8]-'0')*10 + int(s[9]-'0'))
@@ -692,11 +744,56 @@ func parseDateYYYYMMDD(s string) (year, month, day int, ok bool) {
 	return year, month, day, true
 }
 
+// lastTableYear is the last year covered by yearStartDays.
+const lastTableYear = 2100
+
+// yearStartDays[y-EpochYear] is the number of days from the epoch to January 1 of y.
+var yearStartDays = func() (table [lastTableYear - EpochYear + 1]uint32) {
+	for i := 1; i < len(table); i++ {
+		table[i] = table[i-1] + 365
+		if isLeapYear(EpochYear + i - 1) {
+			table[i]++
+		}
+	}
+	return table
+}()
+
+// cumulativeDays[leap][m-1] is the number of days before the first of month m.
+var cumulativeDays = [2][12]uint32{
+	{0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334},
+	{0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335},
+}
+
+func isLeapYear(year int) bool {
+	return year%4 == 0 && (year%100 != 0 || year%400 == 0)
+}
+
 // daysSinceEpoch computes days since 1985-01-01 from YYYY-MM-DD components.
-// Uses the same calculation as types.TimeToDaysSinceEpoch for consistency.
+// Matches types.TimeToDaysSinceEpoch, including time.Date's normalization of
+// day overflow, via lookup tables instead of constructing a time.Time.
 func daysSinceEpoch(year, month, day int) uint32 {
-	t := time.Date(year, time.Month(month), day, 0, 0, 0, 0, time.UTC)
-	return types.TimeToDaysSinceEpoch(t)
+	if year < EpochYear || year > lastTableYear || month < 1 || month > 12 {
+		t := time.Date(year, time.Month(month), day, 0, 0, 0, 0, time.UTC)
+		return types.TimeToDaysSinceEpoch(t)
+	}
+	leap := 0
+	if isLeapYear(year) {
+		leap = 1
+	}
+	return uint32(int(yearStartDays[year-EpochYear]+cumulativeDays[leap][month-1]) + day - 1)
+}
+
+// parseHourPrefix reads the hour from CIMIS "HH00" or "HH:00" strings.
+// Malformed input yields hour 0.
+func parseHourPrefix(s string) int {
+	if len(s) < 2 {
+		return 0
+	}
+	h0, h1 := s[0]-'0', s[1]-'0'
+	if h0 > 9 || h1 > 9 {
+		return 0
+	}
+	return int(h0)*10 + int(h1)
 }
 
 // ConvertDailyToRecordsFast converts daily records with manual date parsing.
@@ -748,29 +845,22 @@ func ConvertHourlyToRecordsFast(apiRecords []*HourlyDataRecord, stationID uint16
 	records := make([]types.HourlyRecord, 0, len(apiRecords))
 
 	for _, apiRec := range apiRecords {
-		// Parse date with fast path
+		// Parse date and hour with table lookups; no time.Time on the fast path
+		hour := parseHourPrefix(apiRec.Hour)
 		year, month, day, ok := parseDateYYYYMMDD(apiRec.Date)
-		var date time.Time
+		var ts uint32
 		if ok {
-			date = time.Date(year, time.Month(month), day, 0, 0, 0, 0, time.UTC)
+			ts = daysSinceEpoch(year, month, day)*24 + uint32(hour)
 		} else {
-			var err error
-			date, err = time.Parse("2006-01-02", apiRec.Date)
+			date, err := time.Parse("2006-01-02", apiRec.Date)
 			if err != nil {
 				continue
 			}
+			ts = types.TimeToHoursSinceEpoch(date.Add(time.Duration(hour) * time.Hour))
 		}
 
-		// Parse hour (format is "HH:00")
-		hour := 0
-		if len(apiRec.Hour) >= 2 {
-			hour, _ = strconv.Atoi(apiRec.Hour[:2])
-		}
-
-		timestamp := date.Add(time.Duration(hour) * time.Hour)
-
 		record := types.HourlyRecord{
-			Timestamp:      types.TimeToHoursSinceEpoch(timestamp),
+			Timestamp:      ts,
 			StationID:      stationID,
 			Temperature:    types.ScaleTemperature(ParseMeasurementValue(apiRec.HlyAirTmp)),
 			ET:             types.ScaleHourlyET(ParseMeasurementValue(apiRec.HlyAsceEto)),
@@ -92,6 +92,19 @@ type FetchMetrics struct {
 	BytesTransferred int64
 }
 
+// DecodeError reports a response body that could not be decoded.
+type DecodeError struct {
+	Err error
+}
+
+func (e *DecodeError) Error() string {
+	return "failed to decode: " + e.Err.Error()
+}
+
+func (e *DecodeError) Unwrap() error {
+	return e.Err
+}
+
 // String returns formatted metrics.
 func (m *FetchMetrics) String() string {
 	return fmt.Sprintf(
@@ -167,7 +180,7 @@ func (c *OptimizedClient) FetchDailyDataStreaming(stationID int, startDate, endD
 	decodeStart := time.Now()
 	records, err := c.streamDecodeDaily(bufReader, uint16(stationID))
 	if err != nil {
-		return nil, metrics, fmt.Errorf("failed to decode: %w", err)
+		return nil, metrics, &DecodeError{Err: err}
 	}
 	metrics.JSONDecode = time.Since(decodeStart)
 
@@ -218,6 +218,9 @@ func TestParseDateYYYYMMDD(t *testing.T) {
 		{"short", 0, 0, 0, false},
 		{"2024/01/15", 0, 0, 0, false}, // wrong separator
 		{"20240115xx", 0, 0, 0, false}, // wrong length ok but wrong format
+		{"2a24-01-15", 0, 0, 0, false}, // non-digit year
+		{"2024-0x-15", 0, 0, 0, false}, // non-digit month
+		{"2024-01- 5", 0, 0, 0, false}, // space in day
 		{"1984-01-01", 0, 0, 0, false}, // before epoch
 		{"2101-01-01", 0, 0, 0, false}, // after 2100
 		{"2024-13-01", 0, 0, 0, false}, // invalid month
@@ -267,6 +270,67 @@ func TestDaysSinceEpoch(t *testing.T) {
 	}
 }
 
+func TestDaysSinceEpochMatchesTimePackage(t *testing.T) {
+	for d := Epoch; d.Year() <= 2100; d = d.AddDate(0, 0, 1) {
+		want := types.TimeToDaysSinceEpoch(d)
+		if got := daysSinceEpoch(d.Year(), int(d.Month()), d.Day()); got != want {
+			t.Fatalf("daysSinceEpoch(%s) = %d, want %d", d.Format("2006-01-02"), got, want)
+		}
+	}
+
+	// Day overflow normalizes like time.Date.
+	if got, want := daysSinceEpoch(2023, 2, 31), types.TimeToDaysSinceEpoch(time.Date(2023, 3, 3, 0, 0, 0, 0, time.UTC)); got != want {
+		t.Errorf("daysSinceEpoch(2023, 2, 31) = %d, want %d", got, want)
+	}
+	if got, want := daysSinceEpoch(2101, 1, 1), types.TimeToDaysSinceEpoch(time.Date(2101, 1, 1, 0, 0, 0, 0, time.UTC)); got != want {
+		t.Errorf("daysSinceEpoch(2101, 1, 1) = %d, want %d", got, want)
+	}
+}
+
+func TestParseHourPrefix(t *testing.T) {
+	tests := map[string]int{
+		"0000":  0,
+		"0100":  1,
+		"1300":  13,
+		"2400":  24,
+		"13:00": 13,
+		"1":     0,
+		"":      0,
+		"1:00":  0,
+		"ab00":  0,
+	}
+	for input, want := range tests {
+		if got := parseHourPrefix(input); got != want {
+			t.Errorf("parseHourPrefix(%q) = %d, want %d", input, got, want)
+		}
+	}
+}
+
+func TestConvertHourlyToRecordsFastMatchesSlowPath(t *testing.T) {
+	apiRecords := []*HourlyDataRecord{
+		{Date: "2024-02-29", Hour: "0100"},
+		{Date: "2024-02-29", Hour: "2400"},
+		{Date: "2023-12-31", Hour: "2300"},
+		{Date: "2024-6-1", Hour: "0500"},
+		{Date: "bad-date", Hour: "0100"},
+	}
+
+	fast := ConvertHourlyToRecordsFast(apiRecords, 2)
+	slow := ConvertHourlyToRecords(apiRecords, 2)
+	if len(fast) != 3 || len(slow) != 3 {
+		t.Fatalf("got %d fast and %d slow records, want 3 each", len(fast), len(slow))
+	}
+	for i := range fast {
+		if fast[i].Timestamp != slow[i].Timestamp {
+			t.Errorf("record %d: fast timestamp %d, slow %d", i, fast[i].Timestamp, slow[i].Timestamp)
+		}
+	}
+	nextDay := types.TimeToHoursSinceEpoch(time.Date(2024, 3, 1, 0, 0, 0, 0, time.UTC))
+	if fast[1].Timestamp != nextDay {
+		t.Errorf("2400 should be midnight of the next day: got %d, want %d", fast[1].Timestamp, nextDay)
+	}
+}
+
 func TestConvertDailyToRecords(t *testing.T) {
 	apiRecords := []*DailyDataRecord{
 		{
@@ -1252,8 +1316,10 @@ func TestFetchDailyDataStreamingErrors(t *testing.T) {
 		client := NewOptimizedClient("test-key")
 		client.SetBaseURL(server.URL)
 
-		if _, _, err := client.FetchDailyDataStreaming(2, "2024-06-15", "2024-06-16"); err == nil {
-			t.Fatal("expected decode error")
+		_, _, err := client.FetchDailyDataStreaming(2, "2024-06-15", "2024-06-16")
+		var decodeErr *DecodeError
+		if !errors.As(err, &decodeErr) {
+			t.Fatalf("expected DecodeError, got %v", err)
 		}
 	})
 }
@@ -1434,3 +1500,34 @@ func TestSetHTTPClient(t *testing.T) {
 		t.Fatal("SetHTTPClient did not replace client")
 	}
 }
+
+func TestParseHMSCoordinate(t *testing.T) {
+	tests := []struct {
+		input string
+		want  float64
+		ok    bool
+	}{
+		{"36º20'10N / 36.336222", 36.336222, true},
+		{"-120º6'46W / -120.11291", -120.11291, true},
+		{"36º20'24N", 36.34, true},
+		{"120º6'36W", -120.11, true},
+		{"-119.5", -119.5, true},
+		{"", 0, false},
+		{"N/A", 0, false},
+	}
+
+	for _, tt := range tests {
+		got, ok := ParseHMSCoordinate(tt.input)
+		if ok != tt.ok || (ok && (got-tt.want > 1e-9 || tt.want-got > 1e-9)) {
+			t.Errorf("ParseHMSCoordinate(%q) = %v, %v; want %v, %v", tt.input, got, ok, tt.want, tt.ok)
+		}
+	}
+
+	lat, lon, ok := Station{HmsLatitude: "36º20'10N / 36.336222", HmsLongitude: "-120º6'46W / -120.11291"}.Coordinates()
+	if !ok || lat != 36.336222 || lon != -120.11291 {
+		t.Errorf("Coordinates() = %v, %v, %v", lat, lon, ok)
+	}
+	if _, _, ok := (Station{HmsLatitude: "36.3"}).Coordinates(); ok {
+		t.Error("Coordinates() should fail without a longitude")
+	}
+}
@@ -0,0 +1,291 @@
+// Package chunkcache is a two-tier cache of decoded chunks. The first tier
+// holds decoded records ready to use. Chunks evicted from it are not dropped
+// but re-encoded in the fixed record layout and packed with S2, an
+// LZ4-class block codec that decodes at several GB/s, into a second tier
+// with its own budget. Weather records compress well, so the packed tier
+// holds several times more station-years than the same memory of decoded
+// records, and a hit there avoids going back to zstd on disk.
+package chunkcache
+
+import (
+	"container/list"
+	"fmt"
+	"sync"
+
+	"github.com/dl-alexandre/cimis-cli/internal/recordio"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+	"github.com/klauspost/compress/s2"
+)
+
+// Reader is the chunk source behind the cache.
+type Reader interface {
+	ReadDailyChunk(stationID uint16, year int) ([]types.DailyRecord, error)
+	ReadHourlyChunk(stationID uint16, year int) ([]types.HourlyRecord, error)
+}
+
+type key struct {
+	stationID uint16
+	year      int
+	hourly    bool
+}
+
+type entry struct {
+	key    key
+	daily  []types.DailyRecord
+	hourly []types.HourlyRecord
+	packed []byte
+	size   int64 // bytes charged to the tier holding the entry
+	raw    int64 // decoded size of a packed entry
+	elem   *list.Element
+}
+
+// lru is one budgeted tier; the front of order is the most recent use.
+type lru struct {
+	budget int64
+	used   int64
+	order  *list.List
+	items  map[key]*entry
+}
+
+func newLRU(budget int64) lru {
+	return lru{budget: budget, order: list.New(), items: make(map[key]*entry)}
+}
+
+func (l *lru) add(e *entry) {
+	e.elem = l.order.PushFront(e)
+	l.items[e.key] = e
+	l.used += e.size
+}
+
+func (l *lru) remove(e *entry) {
+	l.order.Remove(e.elem)
+	delete(l.items, e.key)
+	l.used -= e.size
+}
+
+func (l *lru) oldest() *entry {
+	if back := l.order.Back(); back != nil {
+		return back.Value.(*entry)
+	}
+	return nil
+}
+
+// Stats counts cache activity per tier.
+type Stats struct {
+	DecodedHits  int64
+	PackedHits   int64
+	Misses       int64
+	Demotions    int64 // decoded chunks packed into the second tier
+	Evictions    int64 // chunks dropped from the packed tier
+	DecodedBytes int64 // current size of each tier
+	PackedBytes  int64
+	RawBytes     int64 // decoded size of the packed chunks
+	PackedChunks int
+}
+
+// HitRate is the fraction of reads served from either tier.
+func (s Stats) HitRate() float64 {
+	total := s.DecodedHits + s.PackedHits + s.Misses
+	if total == 0 {
+		return 0
+	}
+	return float64(s.DecodedHits+s.PackedHits) / float64(total)
+}
+
+func (s Stats) String() string {
+	ratio := 0.0
+	if s.PackedBytes > 0 {
+		ratio = float64(s.RawBytes) / float64(s.PackedBytes)
+	}
+	return fmt.Sprintf("Hits: %d decoded, %d packed; misses: %d (hit rate %.1f%%)\n"+
+		"Decoded tier: %.2f MB\n"+
+		"Packed tier:  %.2f MB holding %d chunk(s), %.1fx (%d demoted, %d evicted)",
+		s.DecodedHits, s.PackedHits, s.Misses, s.HitRate()*100,
+		float64(s.DecodedBytes)/(1024*1024),
+		float64(s.PackedBytes)/(1024*1024), s.PackedChunks, ratio, s.Demotions, s.Evictions)
+}
+
+// Cache serves chunks from memory before falling back to its Reader. It is
+// safe for concurrent use. Returned slices are shared with the cache and
+// must not be modified.
+type Cache struct {
+	base Reader
+
+	mu      sync.Mutex
+	decoded lru
+	packed  lru
+	stats   Stats
+}
+
+// New returns a cache over base with decodedBudget bytes of decoded records
+// and packedBudget bytes of S2 blocks. Either budget may be zero to disable
+// that tier.
+func New(base Reader, decodedBudget, packedBudget int64) *Cache {
+	return &Cache{
+		base:    base,
+		decoded: newLRU(decodedBudget),
+		packed:  newLRU(packedBudget),
+	}
+}
+
+// ReadDailyChunk returns a station's daily chunk for year.
+func (c *Cache) ReadDailyChunk(stationID uint16, year int) ([]types.DailyRecord, error) {
+	k := key{stationID: stationID, year: year}
+	if e := c.lookup(k); e != nil {
+		return e.daily, nil
+	}
+	records, err := c.base.ReadDailyChunk(stationID, year)
+	if err != nil {
+		return nil, err
+	}
+	c.store(&entry{key: k, daily: records, size: int64(len(records)) * recordio.DailySize})
+	return records, nil
+}
+
+// ReadHourlyChunk returns a station's hourly chunk for year.
+func (c *Cache) ReadHourlyChunk(stationID uint16, year int) ([]types.HourlyRecord, error) {
+	k := key{stationID: stationID, year: year, hourly: true}
+	if e := c.lookup(k); e != nil {
+		return e.hourly, nil
+	}
+	records, err := c.base.ReadHourlyChunk(stationID, year)
+	if err != nil {
+		return nil, err
+	}
+	c.store(&entry{key: k, hourly: records, size: int64(len(records)) * recordio.HourlySize})
+	return records, nil
+}
+
+// Stats returns a snapshot of the counters.
+func (c *Cache) Stats() Stats {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	s := c.stats
+	s.DecodedBytes = c.decoded.used
+	s.PackedBytes = c.packed.used
+	s.PackedChunks = len(c.packed.items)
+	return s
+}
+
+// lookup finds k in either tier, promoting a packed hit back to decoded.
+// It returns nil on a miss.
+func (c *Cache) lookup(k key) *entry {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	if e, ok := c.decoded.items[k]; ok {
+		c.decoded.order.MoveToFront(e.elem)
+		c.stats.DecodedHits++
+		return e
+	}
+	if p, ok := c.packed.items[k]; ok {
+		c.packed.remove(p)
+		c.stats.RawBytes -= p.raw
+		e, err := unpack(p)
+		if err != nil {
+			// A corrupt block is only a miss; the chunk is read again.
+			c.stats.Misses++
+			return nil
+		}
+		c.stats.PackedHits++
+		c.insertDecoded(e)
+		return e
+	}
+	c.stats.Misses++
+	return nil
+}
+
+func (c *Cache) store(e *entry) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if _, ok := c.decoded.items[e.key]; ok {
+		return // a concurrent miss already filled it
+	}
+	if p, ok := c.packed.items[e.key]; ok {
+		c.packed.remove(p)
+		c.stats.RawBytes -= p.raw
+	}
+	c.insertDecoded(e)
+}
+
+// insertDecoded adds e to the decoded tier and demotes least recently used
+// chunks until the tier fits its budget again.
+func (c *Cache) insertDecoded(e *entry) {
+	if e.size > c.decoded.budget {
+		c.demote(e)
+		return
+	}
+	c.decoded.add(e)
+	for c.decoded.used > c.decoded.budget {
+		old := c.decoded.oldest()
+		c.decoded.remove(old)
+		c.demote(old)
+	}
+}
+
+// demote packs e into the second tier, evicting from its cold end.
+func (c *Cache) demote(e *entry) {
+	if c.packed.budget <= 0 {
+		return
+	}
+	p := pack(e)
+	if p.size > c.packed.budget {
+		return
+	}
+	c.stats.Demotions++
+	c.packed.add(p)
+	c.stats.RawBytes += p.raw
+	for c.packed.used > c.packed.budget {
+		old := c.packed.oldest()
+		c.packed.remove(old)
+		c.stats.RawBytes -= old.raw
+		c.stats.Evictions++
+	}
+}
+
+// pack encodes records in the C record layout and S2-compresses them.
+func pack(e *entry) *entry {
+	var raw []byte
+	p := &entry{key: e.key}
+	if e.key.hourly {
+		raw = make([]byte, len(e.hourly)*recordio.HourlySize)
+		for i, r := range e.hourly {
+			recordio.PutHourly(raw[i*recordio.HourlySize:], r)
+		}
+	} else {
+		raw = make([]byte, len(e.daily)*recordio.DailySize)
+		for i, r := range e.daily {
+			recordio.PutDaily(raw[i*recordio.DailySize:], r)
+		}
+	}
+	p.packed = s2.Encode(nil, raw)
+	p.size = int64(len(p.packed))
+	p.raw = int64(len(raw))
+	return p
+}
+
+func unpack(p *entry) (*entry, error) {
+	raw, err := s2.Decode(nil, p.packed)
+	if err != nil {
+		return nil, err
+	}
+	e := &entry{key: p.key, size: int64(len(raw))}
+	if p.key.hourly {
+		if len(raw)%recordio.HourlySize != 0 {
+			return nil, fmt.Errorf("chunkcache: bad packed size %d", len(raw))
+		}
+		e.hourly = make([]types.HourlyRecord, len(raw)/recordio.HourlySize)
+		for i := range e.hourly {
+			e.hourly[i] = recordio.Hourly(raw[i*recordio.HourlySize:])
+		}
+	} else {
+		if len(raw)%recordio.DailySize != 0 {
+			return nil, fmt.Errorf("chunkcache: bad packed size %d", len(raw))
+		}
+		e.daily = make([]types.DailyRecord, len(raw)/recordio.DailySize)
+		for i := range e.daily {
+			e.daily[i] = recordio.Daily(raw[i*recordio.DailySize:])
+		}
+	}
+	return e, nil
+}
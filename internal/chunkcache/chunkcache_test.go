@@ -0,0 +1,120 @@
+package chunkcache
+
+import (
+	"reflect"
+	"sync"
+	"sync/atomic"
+	"testing"
+
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+type countingReader struct {
+	rows  int
+	reads atomic.Int32
+}
+
+func (r *countingReader) ReadDailyChunk(stationID uint16, year int) ([]types.DailyRecord, error) {
+	r.reads.Add(1)
+	records := make([]types.DailyRecord, r.rows)
+	for i := range records {
+		records[i] = types.DailyRecord{Timestamp: uint32(year*1000 + i), StationID: stationID, Temperature: int16(i % 50), Humidity: 60}
+	}
+	return records, nil
+}
+
+func (r *countingReader) ReadHourlyChunk(stationID uint16, year int) ([]types.HourlyRecord, error) {
+	r.reads.Add(1)
+	records := make([]types.HourlyRecord, r.rows)
+	for i := range records {
+		records[i] = types.HourlyRecord{Timestamp: uint32(year*1000 + i), StationID: stationID, SolarRadiation: uint16(i), WindDirection: 90}
+	}
+	return records, nil
+}
+
+func TestDecodedHitsAndDemotionToPackedTier(t *testing.T) {
+	base := &countingReader{rows: 100} // 1600 decoded bytes per daily chunk
+	c := New(base, 2000, 1<<20)
+
+	first, _ := c.ReadDailyChunk(2, 2020)
+	if again, _ := c.ReadDailyChunk(2, 2020); &again[0] != &first[0] {
+		t.Fatal("decoded hit should return the cached slice")
+	}
+
+	// A second chunk pushes the first out of the decoded tier into the packed one.
+	if _, err := c.ReadDailyChunk(2, 2021); err != nil {
+		t.Fatal(err)
+	}
+	s := c.Stats()
+	if s.DecodedHits != 1 || s.Misses != 2 || s.Demotions != 1 || s.PackedChunks != 1 {
+		t.Fatalf("stats after demotion = %+v", s)
+	}
+
+	got, err := c.ReadDailyChunk(2, 2020)
+	if err != nil {
+		t.Fatal(err)
+	}
+	want, _ := base.ReadDailyChunk(2, 2020)
+	if !reflect.DeepEqual(got, want) {
+		t.Fatal("packed hit returned different records")
+	}
+	if base.reads.Load() != 3 { // two misses plus the reference read above
+		t.Fatalf("base reads = %d, packed hit went to the base reader", base.reads.Load())
+	}
+	if s := c.Stats(); s.PackedHits != 1 || s.DecodedBytes > 2000 || s.PackedChunks != 1 {
+		t.Fatalf("stats after packed hit = %+v", s)
+	}
+}
+
+func TestPackedTierEvictsAndHourlyRoundTrip(t *testing.T) {
+	base := &countingReader{rows: 200}
+	c := New(base, 0, 1<<20) // packed-only
+
+	for year := 2000; year < 2004; year++ {
+		if _, err := c.ReadHourlyChunk(5, year); err != nil {
+			t.Fatal(err)
+		}
+	}
+	got, _ := c.ReadHourlyChunk(5, 2001)
+	want, _ := base.ReadHourlyChunk(5, 2001)
+	if !reflect.DeepEqual(got, want) {
+		t.Fatal("hourly records changed through the packed tier")
+	}
+	s := c.Stats()
+	if s.PackedHits != 1 || s.DecodedBytes != 0 || s.RawBytes != 4*200*24 {
+		t.Fatalf("stats = %+v", s)
+	}
+
+	// A tiny packed budget keeps only the newest chunk.
+	small := New(base, 0, s.PackedBytes/4+1)
+	for year := 2000; year < 2004; year++ {
+		small.ReadHourlyChunk(5, year)
+	}
+	if s := small.Stats(); s.PackedChunks != 1 || s.Evictions != 3 {
+		t.Fatalf("small cache stats = %+v", s)
+	}
+}
+
+func TestConcurrentReads(t *testing.T) {
+	base := &countingReader{rows: 50}
+	c := New(base, 4000, 8000)
+	var wg sync.WaitGroup
+	for g := 0; g < 8; g++ {
+		wg.Add(1)
+		go func(g int) {
+			defer wg.Done()
+			for i := 0; i < 200; i++ {
+				year := 2000 + (i*7+g)%12
+				records, err := c.ReadDailyChunk(uint16(g%3+1), year)
+				if err != nil || len(records) != 50 || records[0].Timestamp != uint32(year*1000) {
+					t.Errorf("bad read for %d: %v", year, err)
+					return
+				}
+			}
+		}(g)
+	}
+	wg.Wait()
+	if s := c.Stats(); s.DecodedBytes > 4000 || s.PackedBytes > 8000 {
+		t.Fatalf("budgets exceeded: %+v", s)
+	}
+}
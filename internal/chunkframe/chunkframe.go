@@ -0,0 +1,152 @@
+// Package chunkframe lays a chunk's compressed payload out as one
+// independent zstd frame per block of records, followed by an index in a
+// zstd skippable frame. Any zstd decoder still reads the file as the
+// original payload (concatenated frames decode back to back and skippable
+// frames are ignored), but a damaged file can be salvaged block by block:
+// each frame carries its own CRC32 in the index, so only the records of the
+// frames that fail it are lost.
+package chunkframe
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"hash/crc32"
+
+	"github.com/klauspost/compress/zstd"
+)
+
+// The index is the last frame of the file:
+//
+//	0  u32     skippable frame magic (0x184D2A5E)
+//	4  u32     content size
+//	8  ...     per frame: u32 compressed size, u32 record count, u32 CRC32
+//	           of the compressed frame
+//	   u32     payload header size (bytes before the first record)
+//	   u32     record size
+//	   u32     frame count
+//	   u32     CRC32 of everything above from offset 8
+//	   "CFRM"  magic
+//
+// Frame 0 holds the payload header together with the first block.
+const (
+	skippableMagic  = 0x184D2A5E
+	indexMagic      = "CFRM"
+	indexEntrySize  = 12
+	indexTrailer    = 20
+	skippableHeader = 8
+)
+
+// ErrNotFramed is returned by Salvage for files Encode did not write.
+var ErrNotFramed = errors.New("chunk has no frame index")
+
+// Block is the decoded records of one intact frame.
+type Block struct {
+	First   int    // index of the block's first record in the chunk
+	Records []byte // whole records, back to back
+}
+
+// Encode compresses payload, a headerSize-byte header followed by records
+// of recordSize bytes, as one frame per blockRecords records plus the index.
+func Encode(payload []byte, headerSize, recordSize, blockRecords, level int) ([]byte, error) {
+	if headerSize < 0 || recordSize <= 0 || blockRecords <= 0 || len(payload) < headerSize || (len(payload)-headerSize)%recordSize != 0 {
+		return nil, fmt.Errorf("chunkframe: payload of %d bytes is not a %d-byte header and %d-byte records", len(payload), headerSize, recordSize)
+	}
+	enc, err := zstd.NewWriter(nil, zstd.WithEncoderLevel(zstd.EncoderLevelFromZstd(level)), zstd.WithEncoderCRC(true))
+	if err != nil {
+		return nil, err
+	}
+	defer enc.Close()
+
+	var out, index []byte
+	records := (len(payload) - headerSize) / recordSize
+	begin := 0
+	for first := 0; first == 0 || first < records; first += blockRecords {
+		n := min(blockRecords, records-first)
+		end := headerSize + (first+n)*recordSize
+		start := len(out)
+		out = enc.EncodeAll(payload[begin:end], out)
+		index = binary.LittleEndian.AppendUint32(index, uint32(len(out)-start))
+		index = binary.LittleEndian.AppendUint32(index, uint32(n))
+		index = binary.LittleEndian.AppendUint32(index, crc32.ChecksumIEEE(out[start:]))
+		begin = end
+	}
+	frames := len(index) / indexEntrySize
+	index = binary.LittleEndian.AppendUint32(index, uint32(headerSize))
+	index = binary.LittleEndian.AppendUint32(index, uint32(recordSize))
+	index = binary.LittleEndian.AppendUint32(index, uint32(frames))
+	index = binary.LittleEndian.AppendUint32(index, crc32.ChecksumIEEE(index))
+	index = append(index, indexMagic...)
+
+	out = binary.LittleEndian.AppendUint32(out, skippableMagic)
+	out = binary.LittleEndian.AppendUint32(out, uint32(len(index)))
+	return append(out, index...), nil
+}
+
+type frameEntry struct {
+	size, records, crc uint32
+}
+
+// readIndex parses and checks the index at the end of data.
+func readIndex(data []byte) (entries []frameEntry, headerSize, recordSize int, err error) {
+	if len(data) < skippableHeader+indexTrailer || string(data[len(data)-4:]) != indexMagic {
+		return nil, 0, 0, ErrNotFramed
+	}
+	trailer := data[len(data)-indexTrailer:]
+	frames := int(binary.LittleEndian.Uint32(trailer[8:]))
+	size := frames*indexEntrySize + indexTrailer
+	if frames <= 0 || size+skippableHeader > len(data) {
+		return nil, 0, 0, ErrNotFramed
+	}
+	index := data[len(data)-size:]
+	frame := data[len(data)-size-skippableHeader:]
+	if binary.LittleEndian.Uint32(frame) != skippableMagic || int(binary.LittleEndian.Uint32(frame[4:])) != size ||
+		crc32.ChecksumIEEE(index[:size-8]) != binary.LittleEndian.Uint32(trailer[12:]) {
+		return nil, 0, 0, ErrNotFramed
+	}
+	entries = make([]frameEntry, frames)
+	for i := range entries {
+		e := index[i*indexEntrySize:]
+		entries[i] = frameEntry{binary.LittleEndian.Uint32(e), binary.LittleEndian.Uint32(e[4:]), binary.LittleEndian.Uint32(e[8:])}
+	}
+	return entries, int(binary.LittleEndian.Uint32(trailer)), int(binary.LittleEndian.Uint32(trailer[4:])), nil
+}
+
+// Salvage returns the records of every frame whose CRC32 matches and that
+// decodes to the expected size, and the record size the chunk was written
+// with. Frames past a damaged one are still found through the index; only a
+// damaged index loses the whole chunk.
+func Salvage(data []byte) ([]Block, int, error) {
+	entries, headerSize, recordSize, err := readIndex(data)
+	if err != nil {
+		return nil, 0, err
+	}
+	dec, err := zstd.NewReader(nil, zstd.WithDecoderConcurrency(1))
+	if err != nil {
+		return nil, 0, err
+	}
+	defer dec.Close()
+
+	var blocks []Block
+	offset, records := 0, 0
+	for i, e := range entries {
+		frame := data[min(offset, len(data)):min(offset+int(e.size), len(data))]
+		offset += int(e.size)
+		first := records
+		records += int(e.records)
+
+		want := int(e.records) * recordSize
+		if i == 0 {
+			want += headerSize
+		}
+		if len(frame) != int(e.size) || crc32.ChecksumIEEE(frame) != e.crc {
+			continue
+		}
+		decoded, err := dec.DecodeAll(frame, nil)
+		if err != nil || len(decoded) != want {
+			continue
+		}
+		blocks = append(blocks, Block{First: first, Records: decoded[want-int(e.records)*recordSize:]})
+	}
+	return blocks, recordSize, nil
+}
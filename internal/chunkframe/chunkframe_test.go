@@ -0,0 +1,74 @@
+package chunkframe
+
+import (
+	"bytes"
+	"encoding/binary"
+	"testing"
+
+	"github.com/klauspost/compress/zstd"
+)
+
+func testPayload(records int) []byte {
+	payload := []byte("HDR!")
+	for i := 0; i < records; i++ {
+		rec := make([]byte, 16)
+		binary.LittleEndian.PutUint32(rec, uint32(1000+i))
+		payload = append(payload, rec...)
+	}
+	return payload
+}
+
+func TestEncodeDecodesAsPlainZstd(t *testing.T) {
+	payload := testPayload(10)
+	framed, err := Encode(payload, 4, 16, 4, 3)
+	if err != nil {
+		t.Fatalf("Encode() error = %v", err)
+	}
+	dec, err := zstd.NewReader(nil)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer dec.Close()
+	got, err := dec.DecodeAll(framed, nil)
+	if err != nil || !bytes.Equal(got, payload) {
+		t.Fatalf("DecodeAll() = %d bytes, %v; want the original payload", len(got), err)
+	}
+
+	if _, err := Encode(payload[:len(payload)-1], 4, 16, 4, 3); err == nil {
+		t.Fatal("expected a payload with a partial record to be rejected")
+	}
+}
+
+func TestSalvageSkipsOnlyDamagedFrames(t *testing.T) {
+	payload := testPayload(10)
+	framed, err := Encode(payload, 4, 16, 4, 3)
+	if err != nil {
+		t.Fatal(err)
+	}
+	blocks, size, err := Salvage(framed)
+	if err != nil || size != 16 || len(blocks) != 3 {
+		t.Fatalf("Salvage() of an intact chunk = %d blocks, size %d, %v", len(blocks), size, err)
+	}
+
+	// Damage the second frame: records 4-7 are lost, the rest survive.
+	entries, _, _, _ := readIndex(framed)
+	framed[entries[0].size+entries[1].size/2] ^= 0xff
+	blocks, _, err = Salvage(framed)
+	if err != nil || len(blocks) != 2 {
+		t.Fatalf("Salvage() = %d blocks, %v; want 2", len(blocks), err)
+	}
+	if blocks[0].First != 0 || !bytes.Equal(blocks[0].Records, payload[4:4+4*16]) {
+		t.Fatalf("first block = %+v", blocks[0])
+	}
+	if blocks[1].First != 8 || !bytes.Equal(blocks[1].Records, payload[4+8*16:]) {
+		t.Fatalf("last block = %+v", blocks[1])
+	}
+
+	if _, _, err := Salvage(payload); err != ErrNotFramed {
+		t.Fatalf("Salvage() of an unframed chunk error = %v, want ErrNotFramed", err)
+	}
+	framed[len(framed)-6] ^= 0xff
+	if _, _, err := Salvage(framed); err != ErrNotFramed {
+		t.Fatalf("Salvage() with a damaged index error = %v, want ErrNotFramed", err)
+	}
+}
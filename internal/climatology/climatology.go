@@ -0,0 +1,372 @@
+// Package climatology builds and stores per-station day-of-year baselines.
+//
+// Tables use the same layout as cimis_climatology_table_write in
+// c/cimis_storage.c, so the C anomaly scan can mmap files written here.
+package climatology
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"math"
+	"os"
+	"sort"
+)
+
+const (
+	// DaySlots covers every calendar day including Feb 29 (slot 59).
+	DaySlots = 366
+	// FirstYear is the year tracked by bit 0 of a station's year mask.
+	FirstYear = 1985
+
+	magic      = "CCLM"
+	version    = 1
+	headerSize = 64
+	entrySize  = 16
+	arrays     = 5 // mean, std, min, max, count
+)
+
+// DailyFields lists fields in cimis_field_t order.
+var DailyFields = []string{"temperature", "et", "wind_speed", "humidity", "solar_radiation"}
+
+// ErrInvalidTable is returned when a table file is malformed.
+var ErrInvalidTable = errors.New("invalid climatology table")
+
+// cumulativeDays is the leap-year day offset of each month.
+var cumulativeDays = [12]int{0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335}
+
+// DaySlot maps days since the 1985 epoch to a leap-aware day-of-year slot,
+// so Mar 1 is slot 60 in every year and Feb 29 gets its own slot.
+func DaySlot(days uint32) int {
+	// Civil-from-days on a March-based year; 5479 days from 1970 to 1985.
+	z := uint64(days) + 5479 + 719468
+	doe := z % 146097
+	yoe := (doe - doe/1460 + doe/36524 - doe/146096) / 365
+	doy := doe - (365*yoe + yoe/4 - yoe/100) // 0 = Mar 1, 365 = Feb 29
+	if doy >= 306 {
+		return int(doy - 306)
+	}
+	return int(doy + 60)
+}
+
+// SlotForDate returns the slot of a calendar month and day.
+func SlotForDate(month, day int) int {
+	return cumulativeDays[month-1] + day - 1
+}
+
+// Accum is a Welford accumulator; Merge uses Chan et al.'s pairwise update.
+type Accum struct {
+	Count uint32
+	Min   float32
+	Max   float32
+	Mean  float64
+	M2    float64
+}
+
+// Add folds one value in. NaN values are ignored.
+func (a *Accum) Add(v float64) {
+	if math.IsNaN(v) {
+		return
+	}
+	if a.Count == 0 || float32(v) < a.Min {
+		a.Min = float32(v)
+	}
+	if a.Count == 0 || float32(v) > a.Max {
+		a.Max = float32(v)
+	}
+	a.Count++
+	delta := v - a.Mean
+	a.Mean += delta / float64(a.Count)
+	a.M2 += delta * (v - a.Mean)
+}
+
+// Merge folds b into a.
+func (a *Accum) Merge(b Accum) {
+	if b.Count == 0 {
+		return
+	}
+	if a.Count == 0 {
+		*a = b
+		return
+	}
+	na, nb := float64(a.Count), float64(b.Count)
+	n := na + nb
+	delta := b.Mean - a.Mean
+	a.Mean += delta * nb / n
+	a.M2 += b.M2 + delta*delta*na*nb/n
+	a.Count += b.Count
+	if b.Min < a.Min {
+		a.Min = b.Min
+	}
+	if b.Max > a.Max {
+		a.Max = b.Max
+	}
+}
+
+// Std returns the population standard deviation.
+func (a Accum) Std() float64 {
+	if a.Count == 0 {
+		return 0
+	}
+	return math.Sqrt(a.M2 / float64(a.Count))
+}
+
+// Station holds one station's accumulators, indexed [field*DaySlots+slot].
+// Rows is the record count of each folded year's chunk (by year mask bit),
+// so a chunk that has grown since it was folded can be detected.
+type Station struct {
+	ID    uint16
+	Years uint64
+	Rows  [64]uint32
+	Cells []Accum
+}
+
+// NewStation creates an empty station baseline.
+func NewStation(id uint16) *Station {
+	return &Station{ID: id, Cells: make([]Accum, len(DailyFields)*DaySlots)}
+}
+
+// Add records a value for field at the given day.
+func (s *Station) Add(days uint32, field int, v float64) {
+	s.Cells[field*DaySlots+DaySlot(days)].Add(v)
+}
+
+// Cell returns the accumulator for a field and slot.
+func (s *Station) Cell(field, slot int) Accum {
+	return s.Cells[field*DaySlots+slot]
+}
+
+// Merge folds another baseline of the same station into s.
+func (s *Station) Merge(other *Station) {
+	for i := range s.Cells {
+		s.Cells[i].Merge(other.Cells[i])
+	}
+	s.Years |= other.Years
+}
+
+// HasYear reports whether year is already part of the baseline.
+func (s *Station) HasYear(year int) bool {
+	bit := year - FirstYear
+	return bit >= 0 && bit < 64 && s.Years&(1<<uint(bit)) != 0
+}
+
+// YearRows returns the record count year was folded with; 0 if the year is
+// not folded or the table predates per-year counts.
+func (s *Station) YearRows(year int) int {
+	if !s.HasYear(year) {
+		return 0
+	}
+	return int(s.Rows[year-FirstYear])
+}
+
+// MarkYear records that year has been folded in from a chunk of rows records.
+func (s *Station) MarkYear(year, rows int) {
+	if bit := year - FirstYear; bit >= 0 && bit < 64 {
+		s.Years |= 1 << uint(bit)
+		s.Rows[bit] = uint32(rows)
+	}
+}
+
+// Write stores stations as a daily table, replacing path atomically.
+func Write(path string, stations []*Station) error {
+	sorted := append([]*Station(nil), stations...)
+	sort.Slice(sorted, func(i, j int) bool { return sorted[i].ID < sorted[j].ID })
+
+	cells := len(DailyFields) * DaySlots
+	buf := make([]byte, headerSize, headerSize+len(sorted)*(entrySize+arrays*4*cells))
+	copy(buf, magic)
+	binary.LittleEndian.PutUint16(buf[4:], version)
+	binary.LittleEndian.PutUint16(buf[6:], 0)
+	binary.LittleEndian.PutUint32(buf[8:], uint32(len(DailyFields)))
+	binary.LittleEndian.PutUint32(buf[12:], DaySlots)
+	binary.LittleEndian.PutUint32(buf[16:], uint32(len(sorted)))
+
+	for i, s := range sorted {
+		buf = binary.LittleEndian.AppendUint16(buf, s.ID)
+		buf = binary.LittleEndian.AppendUint16(buf, 0)
+		buf = binary.LittleEndian.AppendUint32(buf, uint32(i))
+		buf = binary.LittleEndian.AppendUint64(buf, s.Years)
+	}
+
+	for _, s := range sorted {
+		if len(s.Cells) != cells {
+			return fmt.Errorf("station %d has %d cells, want %d", s.ID, len(s.Cells), cells)
+		}
+		for _, a := range s.Cells {
+			buf = binary.LittleEndian.AppendUint32(buf, math.Float32bits(float32(a.Mean)))
+		}
+		for _, a := range s.Cells {
+			buf = binary.LittleEndian.AppendUint32(buf, math.Float32bits(float32(a.Std())))
+		}
+		for _, a := range s.Cells {
+			buf = binary.LittleEndian.AppendUint32(buf, math.Float32bits(a.Min))
+		}
+		for _, a := range s.Cells {
+			buf = binary.LittleEndian.AppendUint32(buf, math.Float32bits(a.Max))
+		}
+		for _, a := range s.Cells {
+			buf = binary.LittleEndian.AppendUint32(buf, a.Count)
+		}
+	}
+
+	if err := writeFile(path, buf); err != nil {
+		return err
+	}
+	return writeState(StatePath(path), sorted)
+}
+
+func writeFile(path string, buf []byte) error {
+	tmp := path + ".tmp"
+	if err := os.WriteFile(tmp, buf, 0644); err != nil {
+		return err
+	}
+	if err := os.Rename(tmp, path); err != nil {
+		_ = os.Remove(tmp)
+		return err
+	}
+	return nil
+}
+
+// The table keeps mean and std as float32 for the C reader. A state file
+// next to it keeps what incremental builds need at full precision:
+//
+//	0  "CCLS"  magic
+//	4  u16     version
+//	6  u16     reserved
+//	8  u32     cells per station
+//	12 u32     station count
+//
+// then per station: u16 ID, u16 reserved, u32 reserved, u64 year mask,
+// 64 u32 per-year record counts and, per cell, f64 mean and f64 M2.
+const (
+	stateMagic      = "CCLS"
+	stateVersion    = 1
+	stateHeaderSize = 16
+	stateEntrySize  = 16 + 64*4
+)
+
+// StatePath returns the state file path of a table.
+func StatePath(tablePath string) string {
+	return tablePath + ".state"
+}
+
+func writeState(path string, stations []*Station) error {
+	cells := len(DailyFields) * DaySlots
+	buf := make([]byte, stateHeaderSize, stateHeaderSize+len(stations)*(stateEntrySize+cells*16))
+	copy(buf, stateMagic)
+	binary.LittleEndian.PutUint16(buf[4:], stateVersion)
+	binary.LittleEndian.PutUint32(buf[8:], uint32(cells))
+	binary.LittleEndian.PutUint32(buf[12:], uint32(len(stations)))
+	for _, s := range stations {
+		buf = binary.LittleEndian.AppendUint16(buf, s.ID)
+		buf = binary.LittleEndian.AppendUint16(buf, 0)
+		buf = binary.LittleEndian.AppendUint32(buf, 0)
+		buf = binary.LittleEndian.AppendUint64(buf, s.Years)
+		for _, rows := range s.Rows {
+			buf = binary.LittleEndian.AppendUint32(buf, rows)
+		}
+		for _, a := range s.Cells {
+			buf = binary.LittleEndian.AppendUint64(buf, math.Float64bits(a.Mean))
+			buf = binary.LittleEndian.AppendUint64(buf, math.Float64bits(a.M2))
+		}
+	}
+	return writeFile(path, buf)
+}
+
+// readState overlays full-precision accumulators and per-year record counts
+// on stations read from the table. A missing or malformed state file, or a
+// station whose year mask no longer matches the table, keeps the float32
+// values from the table and unknown record counts.
+func readState(path string, stations []*Station) {
+	data, err := os.ReadFile(path)
+	cells := len(DailyFields) * DaySlots
+	if err != nil || len(data) < stateHeaderSize || string(data[:4]) != stateMagic ||
+		binary.LittleEndian.Uint16(data[4:]) != stateVersion ||
+		binary.LittleEndian.Uint32(data[8:]) != uint32(cells) {
+		return
+	}
+	n := int(binary.LittleEndian.Uint32(data[12:]))
+	entry := stateEntrySize + cells*16
+	if len(data) != stateHeaderSize+n*entry {
+		return
+	}
+	byID := make(map[uint16]*Station, len(stations))
+	for _, s := range stations {
+		byID[s.ID] = s
+	}
+	for i := 0; i < n; i++ {
+		e := data[stateHeaderSize+i*entry:]
+		s, ok := byID[binary.LittleEndian.Uint16(e)]
+		if !ok || binary.LittleEndian.Uint64(e[8:]) != s.Years {
+			continue
+		}
+		for y := range s.Rows {
+			s.Rows[y] = binary.LittleEndian.Uint32(e[16+4*y:])
+		}
+		for c := range s.Cells {
+			if s.Cells[c].Count == 0 {
+				continue
+			}
+			s.Cells[c].Mean = math.Float64frombits(binary.LittleEndian.Uint64(e[stateEntrySize+16*c:]))
+			s.Cells[c].M2 = math.Float64frombits(binary.LittleEndian.Uint64(e[stateEntrySize+16*c+8:]))
+		}
+	}
+}
+
+// Read loads a daily table. Accumulators come from its state file when it
+// matches; otherwise stored std and count are turned back into accumulators
+// (M2 = std² · count) so new years can still be merged in.
+func Read(path string) ([]*Station, error) {
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return nil, err
+	}
+	if len(data) < headerSize || string(data[:4]) != magic ||
+		binary.LittleEndian.Uint16(data[4:]) != version ||
+		binary.LittleEndian.Uint16(data[6:])&1 != 0 ||
+		binary.LittleEndian.Uint32(data[8:]) != uint32(len(DailyFields)) ||
+		binary.LittleEndian.Uint32(data[12:]) != DaySlots {
+		return nil, ErrInvalidTable
+	}
+
+	cells := len(DailyFields) * DaySlots
+	blockSize := arrays * 4 * cells
+	n := int(binary.LittleEndian.Uint32(data[16:]))
+	if len(data) != headerSize+n*(entrySize+blockSize) {
+		return nil, ErrInvalidTable
+	}
+
+	blocks := data[headerSize+n*entrySize:]
+	stations := make([]*Station, 0, n)
+	for i := 0; i < n; i++ {
+		entry := data[headerSize+i*entrySize:]
+		block := int(binary.LittleEndian.Uint32(entry[4:]))
+		if block >= n {
+			return nil, ErrInvalidTable
+		}
+		s := NewStation(binary.LittleEndian.Uint16(entry))
+		s.Years = binary.LittleEndian.Uint64(entry[8:])
+
+		b := blocks[block*blockSize:]
+		f32 := func(array, c int) float32 {
+			return math.Float32frombits(binary.LittleEndian.Uint32(b[(array*cells+c)*4:]))
+		}
+		for c := range s.Cells {
+			count := binary.LittleEndian.Uint32(b[(4*cells+c)*4:])
+			if count == 0 {
+				continue
+			}
+			std := float64(f32(1, c))
+			s.Cells[c] = Accum{
+				Count: count,
+				Mean:  float64(f32(0, c)),
+				M2:    std * std * float64(count),
+				Min:   f32(2, c),
+				Max:   f32(3, c),
+			}
+		}
+		stations = append(stations, s)
+	}
+	readState(StatePath(path), stations)
+	return stations, nil
+}
@@ -0,0 +1,141 @@
+package climatology
+
+import (
+	"math"
+	"os"
+	"path/filepath"
+	"testing"
+	"time"
+)
+
+func daysSince1985(y int, m time.Month, d int) uint32 {
+	return uint32(time.Date(y, m, d, 0, 0, 0, 0, time.UTC).Sub(time.Date(FirstYear, 1, 1, 0, 0, 0, 0, time.UTC)).Hours() / 24)
+}
+
+func TestDaySlotLeapAware(t *testing.T) {
+	for _, tt := range []struct {
+		year  int
+		month time.Month
+		day   int
+		want  int
+	}{
+		{1985, time.January, 1, 0},
+		{1985, time.February, 28, 58},
+		{1985, time.March, 1, 60},
+		{1988, time.February, 29, 59},
+		{1988, time.March, 1, 60},
+		{2000, time.December, 31, 365},
+		{2023, time.December, 31, 365},
+	} {
+		if got := DaySlot(daysSince1985(tt.year, tt.month, tt.day)); got != tt.want {
+			t.Errorf("DaySlot(%d-%02d-%02d) = %d, want %d", tt.year, tt.month, tt.day, got, tt.want)
+		}
+		if got := SlotForDate(int(tt.month), tt.day); got != tt.want {
+			t.Errorf("SlotForDate(%d, %d) = %d, want %d", tt.month, tt.day, got, tt.want)
+		}
+	}
+
+	// Every day over 40 years agrees with the calendar.
+	for d := uint32(0); d < 40*366; d++ {
+		date := time.Date(FirstYear, 1, 1, 0, 0, 0, 0, time.UTC).AddDate(0, 0, int(d))
+		if got, want := DaySlot(d), SlotForDate(int(date.Month()), date.Day()); got != want {
+			t.Fatalf("DaySlot(%d) [%s] = %d, want %d", d, date.Format("2006-01-02"), got, want)
+		}
+	}
+}
+
+func TestAccumMergeMatchesSinglePass(t *testing.T) {
+	var single, left, right Accum
+	for i := 0; i < 1000; i++ {
+		v := math.Sin(float64(i)) * 12
+		single.Add(v)
+		if i%3 == 0 {
+			left.Add(v)
+		} else {
+			right.Add(v)
+		}
+	}
+	left.Merge(right)
+
+	if left.Count != single.Count || left.Min != single.Min || left.Max != single.Max {
+		t.Fatalf("merged count/min/max = %d/%v/%v, want %d/%v/%v",
+			left.Count, left.Min, left.Max, single.Count, single.Min, single.Max)
+	}
+	if math.Abs(left.Mean-single.Mean) > 1e-9 || math.Abs(left.Std()-single.Std()) > 1e-9 {
+		t.Fatalf("merged mean/std = %v/%v, want %v/%v", left.Mean, left.Std(), single.Mean, single.Std())
+	}
+
+	var empty Accum
+	empty.Add(math.NaN())
+	if empty.Count != 0 || empty.Std() != 0 {
+		t.Fatalf("NaN should be ignored, got count %d", empty.Count)
+	}
+}
+
+func TestWriteReadIncremental(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "climatology_daily.bin")
+
+	build := func(s *Station, year int) {
+		for d := daysSince1985(year, 1, 1); d < daysSince1985(year+1, 1, 1); d++ {
+			s.Add(d, 0, float64(year-2000)+float64(DaySlot(d))/10)
+		}
+		s.MarkYear(year, 365)
+	}
+
+	a := NewStation(7)
+	build(a, 2020)
+	b := NewStation(2)
+	build(b, 2021)
+	if err := Write(path, []*Station{a, b}); err != nil {
+		t.Fatalf("Write() error = %v", err)
+	}
+
+	stations, err := Read(path)
+	if err != nil {
+		t.Fatalf("Read() error = %v", err)
+	}
+	if len(stations) != 2 || stations[0].ID != 2 || stations[1].ID != 7 {
+		t.Fatalf("Read() stations not sorted by ID: %+v", stations)
+	}
+	loaded := stations[1]
+	if !loaded.HasYear(2020) || loaded.HasYear(2021) {
+		t.Fatalf("year mask = %b, want only 2020", loaded.Years)
+	}
+	if loaded.YearRows(2020) != 365 || loaded.YearRows(2021) != 0 {
+		t.Fatalf("year rows = %d/%d, want 365/0", loaded.YearRows(2020), loaded.YearRows(2021))
+	}
+	if got, want := loaded.Cell(0, 100), a.Cell(0, 100); got.Mean != want.Mean || got.M2 != want.M2 {
+		t.Fatalf("accumulator lost precision through the state file: %+v, want %+v", got, want)
+	}
+	if c := loaded.Cell(0, 59); c.Count != 1 {
+		t.Fatalf("Feb 29 slot count = %d, want 1 (2020 is a leap year)", c.Count)
+	}
+
+	// Fold a second year into the stored baseline and compare with a fresh build.
+	build(loaded, 2021)
+	fresh := NewStation(7)
+	build(fresh, 2020)
+	build(fresh, 2021)
+	for _, slot := range []int{0, 59, 60, 365} {
+		got, want := loaded.Cell(0, slot), fresh.Cell(0, slot)
+		if got.Count != want.Count || math.Abs(got.Mean-want.Mean) > 1e-5 || math.Abs(got.Std()-want.Std()) > 1e-5 {
+			t.Errorf("slot %d incremental = %+v, fresh = %+v", slot, got, want)
+		}
+	}
+
+	// Without the state file the float32 table values still load.
+	if err := os.Remove(StatePath(path)); err != nil {
+		t.Fatal(err)
+	}
+	if stations, err = Read(path); err != nil || stations[1].YearRows(2020) != 0 || !stations[1].HasYear(2020) {
+		t.Fatalf("Read() without state = %v, rows %d", err, stations[1].YearRows(2020))
+	}
+
+	data, _ := os.ReadFile(path)
+	if err := os.WriteFile(path, data[:len(data)-4], 0644); err != nil {
+		t.Fatal(err)
+	}
+	if _, err := Read(path); err != ErrInvalidTable {
+		t.Fatalf("Read(truncated) error = %v, want ErrInvalidTable", err)
+	}
+}
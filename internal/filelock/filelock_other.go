@@ -0,0 +1,16 @@
+//go:build !unix
+
+// Package filelock serializes writers of shared data directory files across
+// processes with an advisory flock on a companion lock file.
+package filelock
+
+import "sync"
+
+var mu sync.Mutex
+
+// Lock falls back to a process-wide mutex where flock is unavailable, so
+// writers are only serialized within a process.
+func Lock(path string) (func(), error) {
+	mu.Lock()
+	return mu.Unlock, nil
+}
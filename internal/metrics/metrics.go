@@ -0,0 +1,318 @@
+// Package metrics is a small in-process metrics registry exported in the
+// Prometheus text format. Counters and histograms spread their updates over
+// cache-line padded atomic shards, so parallel fetch workers and query
+// goroutines never contend on a single word or take a lock to record.
+package metrics
+
+import (
+	"fmt"
+	"io"
+	"math"
+	"math/rand"
+	"net/http"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// shards is the number of atomic cells behind each counter and histogram.
+const shards = 16
+
+// DefBuckets are latency buckets in seconds, matching the Prometheus client
+// defaults.
+var DefBuckets = []float64{.005, .01, .025, .05, .1, .25, .5, 1, 2.5, 5, 10}
+
+type cell struct {
+	v atomic.Uint64
+	_ [56]byte // keep neighbouring shards on separate cache lines
+}
+
+// shard picks a cell for one update. The top-level math/rand functions are
+// lock-free and per-thread since Go 1.20.
+func shard() int {
+	return int(rand.Uint32() & (shards - 1))
+}
+
+// addFloat adds v to a float64 stored as bits in u.
+func addFloat(u *atomic.Uint64, v float64) {
+	for {
+		old := u.Load()
+		if u.CompareAndSwap(old, math.Float64bits(math.Float64frombits(old)+v)) {
+			return
+		}
+	}
+}
+
+// Counter is a monotonically increasing count.
+type Counter struct {
+	cells [shards]cell
+}
+
+// Add increases the counter by n.
+func (c *Counter) Add(n uint64) {
+	c.cells[shard()].v.Add(n)
+}
+
+// Inc increases the counter by one.
+func (c *Counter) Inc() {
+	c.Add(1)
+}
+
+// Value returns the current total.
+func (c *Counter) Value() uint64 {
+	var total uint64
+	for i := range c.cells {
+		total += c.cells[i].v.Load()
+	}
+	return total
+}
+
+// Gauge is a value that can go up and down.
+type Gauge struct {
+	bits atomic.Uint64
+}
+
+// Set replaces the gauge value.
+func (g *Gauge) Set(v float64) {
+	g.bits.Store(math.Float64bits(v))
+}
+
+// Add adds delta (which may be negative) to the gauge.
+func (g *Gauge) Add(delta float64) {
+	addFloat(&g.bits, delta)
+}
+
+// Value returns the current value.
+func (g *Gauge) Value() float64 {
+	return math.Float64frombits(g.bits.Load())
+}
+
+type histShard struct {
+	counts []atomic.Uint64 // one per bucket plus +Inf
+	sum    atomic.Uint64   // float64 bits
+	_      [32]byte
+}
+
+// Histogram counts observations into cumulative buckets.
+type Histogram struct {
+	upper  []float64
+	shards [shards]histShard
+}
+
+func newHistogram(buckets []float64) *Histogram {
+	upper := append([]float64(nil), buckets...)
+	sort.Float64s(upper)
+	h := &Histogram{upper: upper}
+	for i := range h.shards {
+		h.shards[i].counts = make([]atomic.Uint64, len(upper)+1)
+	}
+	return h
+}
+
+// Observe records one value.
+func (h *Histogram) Observe(v float64) {
+	s := &h.shards[shard()]
+	s.counts[sort.SearchFloat64s(h.upper, v)].Add(1)
+	addFloat(&s.sum, v)
+}
+
+// ObserveDuration records d in seconds.
+func (h *Histogram) ObserveDuration(d time.Duration) {
+	h.Observe(d.Seconds())
+}
+
+// HistogramSnapshot is a point-in-time copy of a histogram.
+type HistogramSnapshot struct {
+	Upper      []float64 // bucket upper bounds, ascending
+	Cumulative []uint64  // observations <= Upper[i]
+	Count      uint64
+	Sum        float64
+}
+
+// Snapshot merges the shards.
+func (h *Histogram) Snapshot() HistogramSnapshot {
+	counts := make([]uint64, len(h.upper)+1)
+	var sum float64
+	for i := range h.shards {
+		s := &h.shards[i]
+		for b := range s.counts {
+			counts[b] += s.counts[b].Load()
+		}
+		sum += math.Float64frombits(s.sum.Load())
+	}
+	snap := HistogramSnapshot{Upper: h.upper, Cumulative: make([]uint64, len(h.upper)), Sum: sum}
+	var running uint64
+	for b, n := range counts {
+		running += n
+		if b < len(h.upper) {
+			snap.Cumulative[b] = running
+		}
+	}
+	snap.Count = running
+	return snap
+}
+
+type kind string
+
+const (
+	counterKind   kind = "counter"
+	gaugeKind     kind = "gauge"
+	histogramKind kind = "histogram"
+)
+
+type series struct {
+	labels string // rendered label pairs without braces, e.g. phase="dns"
+	metric any
+}
+
+type family struct {
+	name    string
+	help    string
+	kind    kind
+	buckets []float64 // histogram families only
+	series  map[string]*series
+}
+
+// Registry holds named metric families. Looking a metric up by the same
+// name and labels returns the same instance, so callers may either keep
+// the pointer or fetch it again on each use.
+type Registry struct {
+	mu       sync.Mutex
+	families map[string]*family
+}
+
+// NewRegistry returns an empty registry.
+func NewRegistry() *Registry {
+	return &Registry{families: make(map[string]*family)}
+}
+
+// Default is the registry the CLI records into and serves.
+var Default = NewRegistry()
+
+// Counter returns the counter with the given name and label pairs.
+func (r *Registry) Counter(name, help string, labels ...string) *Counter {
+	return r.get(name, help, counterKind, nil, labels, func(*family) any { return &Counter{} }).(*Counter)
+}
+
+// Gauge returns the gauge with the given name and label pairs.
+func (r *Registry) Gauge(name, help string, labels ...string) *Gauge {
+	return r.get(name, help, gaugeKind, nil, labels, func(*family) any { return &Gauge{} }).(*Gauge)
+}
+
+// Histogram returns the histogram with the given name and label pairs. All
+// series of a name share the buckets of its first registration.
+func (r *Registry) Histogram(name, help string, buckets []float64, labels ...string) *Histogram {
+	return r.get(name, help, histogramKind, buckets, labels, func(f *family) any { return newHistogram(f.buckets) }).(*Histogram)
+}
+
+func (r *Registry) get(name, help string, k kind, buckets []float64, labels []string, create func(*family) any) any {
+	key := renderLabels(labels)
+
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	f, ok := r.families[name]
+	if !ok {
+		f = &family{name: name, help: help, kind: k, buckets: buckets, series: make(map[string]*series)}
+		r.families[name] = f
+	} else if f.kind != k {
+		panic(fmt.Sprintf("metrics: %s registered as %s, requested as %s", name, f.kind, k))
+	}
+	s, ok := f.series[key]
+	if !ok {
+		s = &series{labels: key, metric: create(f)}
+		f.series[key] = s
+	}
+	return s.metric
+}
+
+func renderLabels(labels []string) string {
+	if len(labels)%2 != 0 {
+		panic("metrics: labels must be name/value pairs")
+	}
+	parts := make([]string, 0, len(labels)/2)
+	for i := 0; i < len(labels); i += 2 {
+		parts = append(parts, labels[i]+"="+strconv.Quote(labels[i+1]))
+	}
+	return strings.Join(parts, ",")
+}
+
+// WriteText writes every family in the Prometheus text exposition format,
+// sorted by name and labels.
+func (r *Registry) WriteText(w io.Writer) error {
+	type listing struct {
+		*family
+		list []*series
+	}
+	r.mu.Lock()
+	families := make([]listing, 0, len(r.families))
+	for _, f := range r.families {
+		l := listing{family: f, list: make([]*series, 0, len(f.series))}
+		for _, s := range f.series {
+			l.list = append(l.list, s)
+		}
+		families = append(families, l)
+	}
+	r.mu.Unlock()
+	sort.Slice(families, func(i, j int) bool { return families[i].name < families[j].name })
+
+	var b strings.Builder
+	for _, f := range families {
+		sort.Slice(f.list, func(i, j int) bool { return f.list[i].labels < f.list[j].labels })
+		fmt.Fprintf(&b, "# HELP %s %s\n# TYPE %s %s\n", f.name, f.help, f.name, f.kind)
+		for _, s := range f.list {
+			switch m := s.metric.(type) {
+			case *Counter:
+				fmt.Fprintf(&b, "%s%s %d\n", f.name, braces(s.labels), m.Value())
+			case *Gauge:
+				fmt.Fprintf(&b, "%s%s %s\n", f.name, braces(s.labels), formatFloat(m.Value()))
+			case *Histogram:
+				writeHistogram(&b, f.name, s.labels, m.Snapshot())
+			}
+		}
+	}
+	_, err := io.WriteString(w, b.String())
+	return err
+}
+
+func writeHistogram(b *strings.Builder, name, labels string, snap HistogramSnapshot) {
+	prefix := labels
+	if prefix != "" {
+		prefix += ","
+	}
+	for i, upper := range snap.Upper {
+		fmt.Fprintf(b, "%s_bucket{%sle=%q} %d\n", name, prefix, formatFloat(upper), snap.Cumulative[i])
+	}
+	fmt.Fprintf(b, "%s_bucket{%sle=\"+Inf\"} %d\n", name, prefix, snap.Count)
+	fmt.Fprintf(b, "%s_sum%s %s\n", name, braces(labels), formatFloat(snap.Sum))
+	fmt.Fprintf(b, "%s_count%s %d\n", name, braces(labels), snap.Count)
+}
+
+func braces(labels string) string {
+	if labels == "" {
+		return ""
+	}
+	return "{" + labels + "}"
+}
+
+func formatFloat(v float64) string {
+	switch {
+	case math.IsInf(v, 1):
+		return "+Inf"
+	case math.IsInf(v, -1):
+		return "-Inf"
+	case math.IsNaN(v):
+		return "NaN"
+	}
+	return strconv.FormatFloat(v, 'g', -1, 64)
+}
+
+// Handler serves the registry at a Prometheus scrape endpoint.
+func (r *Registry) Handler() http.Handler {
+	return http.HandlerFunc(func(w http.ResponseWriter, _ *http.Request) {
+		w.Header().Set("Content-Type", "text/plain; version=0.0.4; charset=utf-8")
+		_ = r.WriteText(w)
+	})
+}
@@ -0,0 +1,120 @@
+package metrics
+
+import (
+	"math"
+	"net/http/httptest"
+	"strings"
+	"sync"
+	"testing"
+	"time"
+)
+
+func TestCounterConcurrentAdds(t *testing.T) {
+	var c Counter
+	var wg sync.WaitGroup
+	for g := 0; g < 8; g++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for i := 0; i < 1000; i++ {
+				c.Inc()
+			}
+		}()
+	}
+	wg.Wait()
+	if got := c.Value(); got != 8000 {
+		t.Fatalf("Value() = %d, want 8000", got)
+	}
+}
+
+func TestHistogramBuckets(t *testing.T) {
+	h := newHistogram([]float64{1, 0.1, 10})
+	for _, v := range []float64{0.05, 0.1, 0.5, 2, 100} {
+		h.Observe(v)
+	}
+	h.ObserveDuration(500 * time.Millisecond)
+
+	snap := h.Snapshot()
+	if want := []float64{0.1, 1, 10}; !equalFloats(snap.Upper, want) {
+		t.Fatalf("Upper = %v, want %v", snap.Upper, want)
+	}
+	if want := []uint64{2, 4, 5}; !equalUints(snap.Cumulative, want) {
+		t.Fatalf("Cumulative = %v, want %v", snap.Cumulative, want)
+	}
+	if snap.Count != 6 || math.Abs(snap.Sum-103.15) > 1e-9 {
+		t.Fatalf("Count = %d, Sum = %v", snap.Count, snap.Sum)
+	}
+}
+
+func TestRegistryWriteText(t *testing.T) {
+	r := NewRegistry()
+	r.Counter("b_total", "B events.").Add(3)
+	r.Gauge("a_ratio", "A ratio.").Set(0.25)
+	r.Histogram("c_seconds", "C time.", []float64{1}, "phase", "read").Observe(0.5)
+	r.Histogram("c_seconds", "C time.", nil, "phase", "dns").Observe(2)
+
+	if r.Counter("b_total", "B events.") != r.Counter("b_total", "ignored") {
+		t.Fatal("same name and labels must return the same counter")
+	}
+
+	rec := httptest.NewRecorder()
+	r.Handler().ServeHTTP(rec, httptest.NewRequest("GET", "/metrics", nil))
+	if ct := rec.Header().Get("Content-Type"); !strings.HasPrefix(ct, "text/plain; version=0.0.4") {
+		t.Fatalf("Content-Type = %q", ct)
+	}
+	want := `# HELP a_ratio A ratio.
+# TYPE a_ratio gauge
+a_ratio 0.25
+# HELP b_total B events.
+# TYPE b_total counter
+b_total 3
+# HELP c_seconds C time.
+# TYPE c_seconds histogram
+c_seconds_bucket{phase="dns",le="1"} 0
+c_seconds_bucket{phase="dns",le="+Inf"} 1
+c_seconds_sum{phase="dns"} 2
+c_seconds_count{phase="dns"} 1
+c_seconds_bucket{phase="read",le="1"} 1
+c_seconds_bucket{phase="read",le="+Inf"} 1
+c_seconds_sum{phase="read"} 0.5
+c_seconds_count{phase="read"} 1
+`
+	if got := rec.Body.String(); got != want {
+		t.Fatalf("WriteText() =\n%s\nwant\n%s", got, want)
+	}
+}
+
+func TestRegistryKindMismatchPanics(t *testing.T) {
+	r := NewRegistry()
+	r.Counter("x", "X.")
+	defer func() {
+		if recover() == nil {
+			t.Fatal("expected panic for a gauge named like a counter")
+		}
+	}()
+	r.Gauge("x", "X.")
+}
+
+func equalFloats(a, b []float64) bool {
+	if len(a) != len(b) {
+		return false
+	}
+	for i := range a {
+		if a[i] != b[i] {
+			return false
+		}
+	}
+	return true
+}
+
+func equalUints(a, b []uint64) bool {
+	if len(a) != len(b) {
+		return false
+	}
+	for i := range a {
+		if a[i] != b[i] {
+			return false
+		}
+	}
+	return true
+}
@@ -0,0 +1,124 @@
+// Package perfcounter reads CPU hardware performance counters (cycles,
+// instructions, cache and branch misses) for the calling thread through
+// Linux perf_event_open. Wall time alone cannot tell a memory-bound phase
+// from a compute-bound one; instructions per cycle and misses per record
+// can.
+//
+// Counters follow one OS thread, so callers must runtime.LockOSThread for
+// as long as a Group is open and keep the measured work on that goroutine.
+// On other systems, and where perf_event_paranoid, seccomp or a missing
+// PMU blocks access, Open returns an error and callers carry on without
+// counters.
+package perfcounter
+
+import (
+	"errors"
+	"fmt"
+)
+
+// Event is one hardware counter.
+type Event int
+
+const (
+	Cycles Event = iota
+	Instructions
+	L1DMisses // L1 data cache read misses
+	LLCMisses // last-level cache misses
+	BranchMisses
+	numEvents
+)
+
+// Events lists every counter in report order.
+var Events = []Event{Cycles, Instructions, L1DMisses, LLCMisses, BranchMisses}
+
+func (e Event) String() string {
+	switch e {
+	case Cycles:
+		return "cycles"
+	case Instructions:
+		return "instructions"
+	case L1DMisses:
+		return "L1D misses"
+	case LLCMisses:
+		return "LLC misses"
+	case BranchMisses:
+		return "branch misses"
+	}
+	return fmt.Sprintf("event(%d)", int(e))
+}
+
+// ErrUnsupported is returned by Open where perf_event_open does not exist.
+var ErrUnsupported = errors.New("hardware counters are only supported on Linux")
+
+// Reading is a raw snapshot of a Group: unscaled counter values plus how
+// long the group has been enabled and how long it actually held the PMU.
+type Reading struct {
+	Values  [numEvents]uint64
+	Counted [numEvents]bool
+	Enabled uint64 // nanoseconds
+	Running uint64 // nanoseconds
+}
+
+// Since returns the counts between an earlier reading and r. Raw values are
+// subtracted first and only the difference is scaled by the time the
+// kernel multiplexed the group out, so a delta can never go negative.
+// Events missing from either reading, and intervals in which the group
+// never ran, are left invalid.
+func (r Reading) Since(earlier Reading) Counts {
+	var c Counts
+	if r.Enabled < earlier.Enabled || r.Running <= earlier.Running {
+		return c
+	}
+	enabled, running := r.Enabled-earlier.Enabled, r.Running-earlier.Running
+	for i := range r.Values {
+		if !r.Counted[i] || !earlier.Counted[i] || r.Values[i] < earlier.Values[i] {
+			continue
+		}
+		v := r.Values[i] - earlier.Values[i]
+		if running < enabled {
+			v = uint64(float64(v) * float64(enabled) / float64(running))
+		}
+		c.Values[i] = v
+		c.Valid[i] = true
+	}
+	return c
+}
+
+// Counts are counter totals over an interval. Events the CPU or hypervisor
+// does not expose are marked invalid rather than reported as zero.
+type Counts struct {
+	Values [numEvents]uint64
+	Valid  [numEvents]bool
+}
+
+// Get returns the value of e and whether it was counted.
+func (c Counts) Get(e Event) (uint64, bool) {
+	return c.Values[e], c.Valid[e]
+}
+
+// Add accumulates d into c.
+func (c *Counts) Add(d Counts) {
+	for i := range c.Values {
+		c.Values[i] += d.Values[i]
+		c.Valid[i] = c.Valid[i] || d.Valid[i]
+	}
+}
+
+// IPC returns instructions per cycle, or 0 if either was not counted.
+func (c Counts) IPC() float64 {
+	cycles, ok1 := c.Get(Cycles)
+	instructions, ok2 := c.Get(Instructions)
+	if !ok1 || !ok2 || cycles == 0 {
+		return 0
+	}
+	return float64(instructions) / float64(cycles)
+}
+
+// PerRecord returns e divided by n, and false if e was not counted.
+func (c Counts) PerRecord(e Event, n int) (float64, bool) {
+	v, ok := c.Get(e)
+	if !ok || n <= 0 {
+		return 0, false
+	}
+	return float64(v) / float64(n), true
+}
@@ -0,0 +1,160 @@
+//go:build linux
+
+package perfcounter
+
+import (
+	"encoding/binary"
+	"fmt"
+	"os"
+	"strings"
+	"syscall"
+	"unsafe"
+)
+
+// Constants from linux/perf_event.h.
+const (
+	perfTypeHardware = 0
+	perfTypeHWCache  = 3
+
+	perfCountHWCPUCycles    = 0
+	perfCountHWInstructions = 1
+	perfCountHWCacheMisses  = 3
+	perfCountHWBranchMisses = 5
+
+	// L1D | OP_READ << 8 | RESULT_MISS << 16
+	perfCountHWCacheL1DReadMiss = 0 | 0<<8 | 1<<16
+
+	perfFormatTotalTimeEnabled = 1 << 0
+	perfFormatTotalTimeRunning = 1 << 1
+	perfFormatGroup            = 1 << 3
+
+	attrExcludeKernel = 1 << 5
+	attrExcludeHV     = 1 << 6
+
+	perfFlagFDCloexec = 1 << 3
+)
+
+// eventAttr is struct perf_event_attr up to config1 (PERF_ATTR_SIZE_VER0).
+type eventAttr struct {
+	Type         uint32
+	Size         uint32
+	Config       uint64
+	SamplePeriod uint64
+	SampleType   uint64
+	ReadFormat   uint64
+	Bits         uint64
+	WakeupEvents uint32
+	BPType       uint32
+	Config1      uint64
+}
+
+var eventConfig = [numEvents]struct {
+	typ    uint32
+	config uint64
+}{
+	Cycles:       {perfTypeHardware, perfCountHWCPUCycles},
+	Instructions: {perfTypeHardware, perfCountHWInstructions},
+	L1DMisses:    {perfTypeHWCache, perfCountHWCacheL1DReadMiss},
+	LLCMisses:    {perfTypeHardware, perfCountHWCacheMisses},
+	BranchMisses: {perfTypeHardware, perfCountHWBranchMisses},
+}
+
+// Group is a set of counters scheduled together on the calling thread.
+// User-space only, which is what perf_event_paranoid=2 (the usual default)
+// allows without privileges.
+type Group struct {
+	fds    []int
+	events []Event // event counted by each fd, in group read order
+	buf    []byte
+}
+
+func perfEventOpen(attr *eventAttr, groupFD int) (int, error) {
+	fd, _, errno := syscall.Syscall6(syscall.SYS_PERF_EVENT_OPEN,
+		uintptr(unsafe.Pointer(attr)), 0, uintptr(^uint(0)), uintptr(groupFD), perfFlagFDCloexec, 0)
+	if errno != 0 {
+		return -1, errno
+	}
+	return int(fd), nil
+}
+
+// Open starts counting on the calling thread. Events the hardware lacks
+// are skipped; Open fails only if not even the cycle counter is available.
+func Open() (*Group, error) {
+	g := &Group{}
+	for _, e := range Events {
+		attr := eventAttr{
+			Type:       eventConfig[e].typ,
+			Size:       uint32(unsafe.Sizeof(eventAttr{})),
+			Config:     eventConfig[e].config,
+			ReadFormat: perfFormatGroup | perfFormatTotalTimeEnabled | perfFormatTotalTimeRunning,
+			Bits:       attrExcludeKernel | attrExcludeHV,
+		}
+		leader := -1
+		if len(g.fds) > 0 {
+			leader = g.fds[0]
+		}
+		fd, err := perfEventOpen(&attr, leader)
+		if err != nil {
+			if e == Cycles {
+				return nil, openError(err)
+			}
+			continue
+		}
+		g.fds = append(g.fds, fd)
+		g.events = append(g.events, e)
+	}
+	g.buf = make([]byte, 8*(3+len(g.fds)))
+	return g, nil
+}
+
+func openError(err error) error {
+	switch err {
+	case syscall.EACCES, syscall.EPERM:
+		level := "unknown"
+		if b, rerr := os.ReadFile("/proc/sys/kernel/perf_event_paranoid"); rerr == nil {
+			level = strings.TrimSpace(string(b))
+		}
+		return fmt.Errorf("perf_event_open denied (kernel.perf_event_paranoid=%s; needs 2 or lower, or CAP_PERFMON): %w", level, err)
+	case syscall.ENOENT, syscall.ENODEV, syscall.EOPNOTSUPP:
+		return fmt.Errorf("no hardware performance counters on this CPU or VM: %w", err)
+	case syscall.ENOSYS:
+		return fmt.Errorf("perf_event_open is not available in this kernel or sandbox: %w", err)
+	}
+	return fmt.Errorf("perf_event_open: %w", err)
+}
+
+// Read returns the raw counter values since Open. Use Reading.Since to
+// turn two readings into counts for the interval between them.
+func (g *Group) Read() (Reading, error) {
+	var r Reading
+	n, err := syscall.Read(g.fds[0], g.buf)
+	if err != nil {
+		return r, fmt.Errorf("read counters: %w", err)
+	}
+	if n < len(g.buf) {
+		return r, fmt.Errorf("read counters: short read of %d bytes", n)
+	}
+	word := func(i int) uint64 { return binary.LittleEndian.Uint64(g.buf[8*i:]) }
+	nr := word(0)
+	if int(nr) != len(g.events) {
+		return r, fmt.Errorf("read counters: got %d values for %d events", nr, len(g.events))
+	}
+	r.Enabled, r.Running = word(1), word(2)
+	for i, e := range g.events {
+		r.Values[e] = word(3 + i)
+		r.Counted[e] = true
+	}
+	return r, nil
+}
+
+// Close releases the counters.
+func (g *Group) Close() error {
+	var first error
+	for _, fd := range g.fds {
+		if err := syscall.Close(fd); err != nil && first == nil {
+			first = err
+		}
+	}
+	g.fds = nil
+	return first
+}
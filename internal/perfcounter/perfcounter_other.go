@@ -0,0 +1,21 @@
+//go:build !linux
+
+package perfcounter
+
+// Group is a set of hardware counters; it cannot be opened on this system.
+type Group struct{}
+
+// Open always fails outside Linux.
+func Open() (*Group, error) {
+	return nil, ErrUnsupported
+}
+
+// Read returns no counts.
+func (g *Group) Read() (Reading, error) {
+	return Reading{}, ErrUnsupported
+}
+
+// Close does nothing.
+func (g *Group) Close() error {
+	return nil
+}
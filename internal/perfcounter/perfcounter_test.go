@@ -0,0 +1,93 @@
+package perfcounter
+
+import (
+	"runtime"
+	"testing"
+)
+
+func TestCountsArithmetic(t *testing.T) {
+	var before, after Reading
+	before.Values[Cycles], after.Values[Cycles] = 100, 1100
+	before.Values[Instructions], after.Values[Instructions] = 50, 2050
+	after.Values[L1DMisses] = 40
+	for _, e := range []Event{Cycles, Instructions, L1DMisses} {
+		before.Counted[e], after.Counted[e] = true, true
+	}
+	before.Enabled, before.Running = 1000, 1000
+	after.Enabled, after.Running = 2000, 2000
+
+	d := after.Since(before)
+	if ipc := d.IPC(); ipc != 2 {
+		t.Fatalf("IPC() = %v, want 2", ipc)
+	}
+	if v, ok := d.PerRecord(L1DMisses, 8); !ok || v != 5 {
+		t.Fatalf("PerRecord(L1DMisses) = %v, %v", v, ok)
+	}
+	if _, ok := d.PerRecord(LLCMisses, 8); ok {
+		t.Fatal("an uncounted event must not report a per-record value")
+	}
+
+	// Multiplexed for half the interval: the raw delta is doubled, however
+	// differently the two cumulative readings were scaled.
+	mux := after
+	mux.Values[Cycles] = 600
+	mux.Enabled, mux.Running = 2000, 1500
+	if v, ok := mux.Since(before).Get(Cycles); !ok || v != 1000 {
+		t.Fatalf("multiplexed cycles = %v, %v, want 1000", v, ok)
+	}
+	// A counter that went backwards, or an interval the group never ran in,
+	// yields no count instead of a wrapped one.
+	back := after
+	back.Values[Cycles] = 10
+	if _, ok := back.Since(before).Get(Cycles); ok {
+		t.Fatal("a decreasing counter must not report a delta")
+	}
+	idle := before
+	idle.Enabled += 500
+	if _, ok := idle.Since(before).Get(Instructions); ok {
+		t.Fatal("an interval with no running time must not report counts")
+	}
+
+	var total Counts
+	total.Add(d)
+	total.Add(d)
+	if v, ok := total.Get(Instructions); !ok || v != 4000 {
+		t.Fatalf("accumulated instructions = %v, %v", v, ok)
+	}
+	if (Counts{}).IPC() != 0 {
+		t.Fatal("IPC without counters must be 0")
+	}
+	if BranchMisses.String() != "branch misses" || Event(99).String() != "event(99)" {
+		t.Fatal("unexpected event names")
+	}
+}
+
+func TestOpenCountsUserInstructions(t *testing.T) {
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+
+	g, err := Open()
+	if err != nil {
+		// Sandboxes, containers and most VMs hide the PMU; the error is
+		// what callers print instead of counts.
+		t.Skipf("hardware counters unavailable: %v", err)
+	}
+	defer g.Close()
+
+	before, err := g.Read()
+	if err != nil {
+		t.Fatalf("Read() error = %v", err)
+	}
+	sum := 0
+	for i := 0; i < 1_000_000; i++ {
+		sum += i ^ (i >> 3)
+	}
+	after, err := g.Read()
+	if err != nil {
+		t.Fatalf("Read() error = %v", err)
+	}
+	d := after.Since(before)
+	if v, ok := d.Get(Instructions); ok && v < 1_000_000 {
+		t.Fatalf("counted %d instructions for a million-iteration loop (sum %d)", v, sum)
+	}
+}
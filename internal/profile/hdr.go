@@ -0,0 +1,160 @@
+package profile
+
+import (
+	"fmt"
+	"math"
+	"math/bits"
+	"sync/atomic"
+	"time"
+)
+
+// Histogram bucket layout, shared with cimis_hdr_t in c/cimis_storage.h.
+// Values below 2^hdrSubBits nanoseconds are exact; above that each power of
+// two is split into 2^(hdrSubBits-1) linear buckets, so a quantile is within
+// 1/64 of the recorded latency. Durations clamp at 2^hdrMaxBits ns (~9.8h).
+const (
+	hdrSubBits  = 7
+	hdrMaxBits  = 45
+	hdrSubCount = 1 << hdrSubBits
+	hdrHalf     = hdrSubCount / 2
+	hdrBuckets  = hdrSubCount + (hdrMaxBits-hdrSubBits)*hdrHalf
+	hdrMaxValue = 1<<hdrMaxBits - 1
+)
+
+// Histogram is an HDR-style latency histogram with fixed memory (about 20
+// KB) regardless of how many values it records. Record is lock-free and safe
+// for concurrent use; workers may also keep their own histograms and Merge
+// them at the end.
+type Histogram struct {
+	counts [hdrBuckets]atomic.Uint64
+	total  atomic.Uint64
+	sum    atomic.Int64
+	min    atomic.Int64
+	max    atomic.Int64
+}
+
+// NewHistogram returns an empty histogram.
+func NewHistogram() *Histogram {
+	h := &Histogram{}
+	h.min.Store(math.MaxInt64)
+	return h
+}
+
+func hdrIndex(v uint64) int {
+	if v < hdrSubCount {
+		return int(v)
+	}
+	shift := bits.Len64(v) - hdrSubBits
+	return hdrSubCount + (shift-1)*hdrHalf + int(v>>shift) - hdrHalf
+}
+
+// hdrValue is the midpoint of the values that map to bucket i.
+func hdrValue(i int) uint64 {
+	if i < hdrSubCount {
+		return uint64(i)
+	}
+	shift := (i-hdrSubCount)/hdrHalf + 1
+	mantissa := uint64((i-hdrSubCount)%hdrHalf + hdrHalf)
+	return mantissa<<shift + (1<<shift)>>1
+}
+
+// Record adds one observation. Negative durations count as zero.
+func (h *Histogram) Record(d time.Duration) {
+	v := int64(d)
+	if v < 0 {
+		v = 0
+	} else if v > hdrMaxValue {
+		v = hdrMaxValue
+	}
+	h.counts[hdrIndex(uint64(v))].Add(1)
+	h.total.Add(1)
+	h.sum.Add(v)
+	h.widen(v, v)
+}
+
+// widen extends the recorded range to include lo and hi.
+func (h *Histogram) widen(lo, hi int64) {
+	for old := h.min.Load(); lo < old && !h.min.CompareAndSwap(old, lo); old = h.min.Load() {
+	}
+	for old := h.max.Load(); hi > old && !h.max.CompareAndSwap(old, hi); old = h.max.Load() {
+	}
+}
+
+// Merge adds the observations of o into h.
+func (h *Histogram) Merge(o *Histogram) {
+	if o == nil || o.Count() == 0 {
+		return
+	}
+	for i := range o.counts {
+		if n := o.counts[i].Load(); n > 0 {
+			h.counts[i].Add(n)
+		}
+	}
+	h.total.Add(o.total.Load())
+	h.sum.Add(o.sum.Load())
+	h.widen(o.min.Load(), o.max.Load())
+}
+
+// Count returns the number of observations.
+func (h *Histogram) Count() uint64 {
+	return h.total.Load()
+}
+
+// Mean returns the exact average of the observations.
+func (h *Histogram) Mean() time.Duration {
+	n := h.Count()
+	if n == 0 {
+		return 0
+	}
+	return time.Duration(h.sum.Load() / int64(n))
+}
+
+// Max returns the largest observation.
+func (h *Histogram) Max() time.Duration {
+	if h.Count() == 0 {
+		return 0
+	}
+	return time.Duration(h.max.Load())
+}
+
+// Quantile returns the latency at q in [0, 1], e.g. 0.99 for p99.
+func (h *Histogram) Quantile(q float64) time.Duration {
+	n := h.Count()
+	if n == 0 {
+		return 0
+	}
+	lo, hi := h.min.Load(), h.max.Load()
+	if q <= 0 {
+		return time.Duration(lo)
+	}
+	if q >= 1 {
+		return time.Duration(hi)
+	}
+	rank := uint64(math.Ceil(q * float64(n)))
+	var seen uint64
+	for i := range h.counts {
+		seen += h.counts[i].Load()
+		if seen >= rank {
+			v := int64(hdrValue(i))
+			if v < lo {
+				v = lo
+			}
+			if v > hi {
+				v = hi
+			}
+			return time.Duration(v)
+		}
+	}
+	return time.Duration(hi)
+}
+
+// Percentiles formats p50, p90, p99, p999 and max on one line.
+func (h *Histogram) Percentiles() string {
+	round := func(d time.Duration) time.Duration { return d.Round(time.Microsecond) }
+	if h.Max() < time.Millisecond {
+		round = func(d time.Duration) time.Duration { return d }
+	}
+	return fmt.Sprintf("p50=%v p90=%v p99=%v p999=%v max=%v (n=%d)",
+		round(h.Quantile(0.5)), round(h.Quantile(0.9)), round(h.Quantile(0.99)),
+		round(h.Quantile(0.999)), round(h.Max()), h.Count())
+}
@@ -0,0 +1,113 @@
+package profile
+
+import (
+	"math"
+	"math/rand"
+	"sort"
+	"strings"
+	"sync"
+	"testing"
+	"time"
+)
+
+func TestHistogramBucketLayout(t *testing.T) {
+	prev := -1
+	for _, v := range []uint64{0, 1, 127, 128, 129, 255, 256, 1000, 1 << 20, 1<<20 + 12345, hdrMaxValue} {
+		i := hdrIndex(v)
+		if i < prev || i >= hdrBuckets {
+			t.Fatalf("hdrIndex(%d) = %d (previous %d, buckets %d)", v, i, prev, hdrBuckets)
+		}
+		prev = i
+		if got := hdrValue(i); math.Abs(float64(got)-float64(v)) > float64(v)/64 {
+			t.Fatalf("hdrValue(hdrIndex(%d)) = %d, outside 1/64", v, got)
+		}
+	}
+	for v := uint64(0); v < hdrSubCount; v++ {
+		if hdrValue(hdrIndex(v)) != v {
+			t.Fatalf("small value %d is not exact", v)
+		}
+	}
+}
+
+func TestHistogramQuantilesMatchExact(t *testing.T) {
+	rng := rand.New(rand.NewSource(7))
+	h := NewHistogram()
+	samples := make([]time.Duration, 50000)
+	for i := range samples {
+		// Log-normal around 2ms with a long tail.
+		samples[i] = time.Duration(math.Exp(rng.NormFloat64()*1.2) * float64(2*time.Millisecond))
+		h.Record(samples[i])
+	}
+	sort.Slice(samples, func(i, j int) bool { return samples[i] < samples[j] })
+
+	for _, q := range []float64{0.5, 0.9, 0.99, 0.999} {
+		exact := samples[int(math.Ceil(q*float64(len(samples))))-1]
+		got := h.Quantile(q)
+		if diff := math.Abs(float64(got - exact)); diff > float64(exact)/64 {
+			t.Errorf("Quantile(%v) = %v, exact %v", q, got, exact)
+		}
+	}
+	if h.Max() != samples[len(samples)-1] || h.Quantile(0) != samples[0] {
+		t.Errorf("range = [%v, %v], want [%v, %v]", h.Quantile(0), h.Max(), samples[0], samples[len(samples)-1])
+	}
+	var sum time.Duration
+	for _, s := range samples {
+		sum += s
+	}
+	if want := sum / time.Duration(len(samples)); h.Mean() != want {
+		t.Errorf("Mean() = %v, want %v", h.Mean(), want)
+	}
+}
+
+func TestHistogramMergeAcrossWorkers(t *testing.T) {
+	shared := NewHistogram()
+	perWorker := make([]*Histogram, 4)
+	var wg sync.WaitGroup
+	for w := range perWorker {
+		perWorker[w] = NewHistogram()
+		wg.Add(1)
+		go func(own *Histogram, w int) {
+			defer wg.Done()
+			for i := 1; i <= 1000; i++ {
+				d := time.Duration(w*1000+i) * time.Microsecond
+				own.Record(d)
+				shared.Record(d)
+			}
+		}(perWorker[w], w)
+	}
+	wg.Wait()
+
+	merged := NewHistogram()
+	for _, h := range perWorker {
+		merged.Merge(h)
+	}
+	merged.Merge(nil)
+	merged.Merge(NewHistogram())
+
+	if merged.Count() != 4000 || shared.Count() != 4000 {
+		t.Fatalf("counts = %d merged, %d shared; want 4000", merged.Count(), shared.Count())
+	}
+	for _, q := range []float64{0, 0.5, 0.9, 0.99, 0.999, 1} {
+		if merged.Quantile(q) != shared.Quantile(q) {
+			t.Errorf("Quantile(%v): merged %v, shared %v", q, merged.Quantile(q), shared.Quantile(q))
+		}
+	}
+	if merged.Quantile(0) != time.Microsecond || merged.Max() != 4*time.Millisecond {
+		t.Errorf("merged range = [%v, %v]", merged.Quantile(0), merged.Max())
+	}
+}
+
+func TestHistogramEmptyAndClamped(t *testing.T) {
+	h := NewHistogram()
+	if h.Count() != 0 || h.Mean() != 0 || h.Max() != 0 || h.Quantile(0.99) != 0 {
+		t.Fatal("empty histogram must report zeros")
+	}
+	h.Record(-time.Second)
+	h.Record(100 * time.Hour)
+	if h.Quantile(0) != 0 || h.Max() != time.Duration(hdrMaxValue) {
+		t.Fatalf("range = [%v, %v]", h.Quantile(0), h.Max())
+	}
+	if s := h.Percentiles(); !strings.Contains(s, "p999=") || !strings.Contains(s, "(n=2)") {
+		t.Fatalf("Percentiles() = %q", s)
+	}
+}
@@ -6,13 +6,14 @@ import (
 	"io"
 	"log"
 	"net/http"
-	_ "net/http/pprof"
+	httppprof "net/http/pprof"
 	"os"
 	"runtime"
 	"runtime/pprof"
 	"sync"
 	"time"
 
+	"github.com/dl-alexandre/cimis-cli/internal/metrics"
 	"github.com/dl-alexandre/cimis-tsdb/storage"
 )
 
@@ -128,11 +129,17 @@ func (p *Profiler) ProfileMutex(filename string) error {
 	return pprof.Lookup("mutex").WriteTo(f, 0)
 }
 
-// StartPProfServer starts an HTTP server for pprof endpoints.
+// StartPProfServer starts an HTTP server for pprof endpoints and the
+// Prometheus metrics of this process at /metrics.
 func StartPProfServer(addr string) *http.Server {
 	mux := http.NewServeMux()
+	mux.HandleFunc("/debug/pprof/", httppprof.Index)
+	mux.HandleFunc("/debug/pprof/cmdline", httppprof.Cmdline)
+	mux.HandleFunc("/debug/pprof/profile", httppprof.Profile)
+	mux.HandleFunc("/debug/pprof/symbol", httppprof.Symbol)
+	mux.HandleFunc("/debug/pprof/trace", httppprof.Trace)
+	mux.Handle("/metrics", metrics.Default.Handler())
 
-	// pprof endpoints are registered via _ "net/http/pprof" import
 	server := &http.Server{
 		Addr:    addr,
 		Handler: mux,
@@ -211,76 +218,63 @@ func PrintRuntimeStats(w io.Writer) {
 	fmt.Fprintf(w, "Objects: %d\n", stats.HeapObjects)
 }
 
-// PerformanceMonitor tracks database performance metrics.
+// PerformanceMonitor tracks database performance metrics. Latencies go into
+// fixed-size histograms, so a long-running monitor reports percentiles
+// without keeping every sample.
 type PerformanceMonitor struct {
-	mu           sync.RWMutex
-	queryTimes   []time.Duration
-	ingestTimes  []time.Duration
-	compressions []storage.CompressionStats
-	startTime    time.Time
+	mu               sync.RWMutex
+	queryTimes       *Histogram
+	ingestTimes      *Histogram
+	compressions     int
+	compressionRatio float64 // sum of recorded ratios
+	startTime        time.Time
 }
 
 // NewPerformanceMonitor creates a new performance monitor.
 func NewPerformanceMonitor() *PerformanceMonitor {
 	return &PerformanceMonitor{
-		queryTimes:   make([]time.Duration, 0),
-		ingestTimes:  make([]time.Duration, 0),
-		compressions: make([]storage.CompressionStats, 0),
-		startTime:    time.Now(),
+		queryTimes:  NewHistogram(),
+		ingestTimes: NewHistogram(),
+		startTime:   time.Now(),
 	}
 }
 
 // RecordQueryTime records a query execution time.
 func (pm *PerformanceMonitor) RecordQueryTime(d time.Duration) {
-	pm.mu.Lock()
-	defer pm.mu.Unlock()
-	pm.queryTimes = append(pm.queryTimes, d)
+	pm.queryTimes.Record(d)
 }
 
 // RecordIngestTime records an ingest operation time.
 func (pm *PerformanceMonitor) RecordIngestTime(d time.Duration) {
-	pm.mu.Lock()
-	defer pm.mu.Unlock()
-	pm.ingestTimes = append(pm.ingestTimes, d)
+	pm.ingestTimes.Record(d)
 }
 
 // RecordCompression records compression statistics.
 func (pm *PerformanceMonitor) RecordCompression(stats storage.CompressionStats) {
 	pm.mu.Lock()
 	defer pm.mu.Unlock()
-	pm.compressions = append(pm.compressions, stats)
+	pm.compressions++
+	pm.compressionRatio += stats.Ratio
 }
 
-// GetAverageQueryTime returns the average query time.
-func (pm *PerformanceMonitor) GetAverageQueryTime() time.Duration {
-	pm.mu.RLock()
-	defer pm.mu.RUnlock()
+// QueryLatencies returns the query time histogram.
+func (pm *PerformanceMonitor) QueryLatencies() *Histogram {
+	return pm.queryTimes
+}
 
-	if len(pm.queryTimes) == 0 {
-		return 0
-	}
+// IngestLatencies returns the ingest time histogram.
+func (pm *PerformanceMonitor) IngestLatencies() *Histogram {
+	return pm.ingestTimes
+}
 
-	var total time.Duration
-	for _, t := range pm.queryTimes {
-		total += t
-	}
-	return total / time.Duration(len(pm.queryTimes))
+// GetAverageQueryTime returns the average query time.
+func (pm *PerformanceMonitor) GetAverageQueryTime() time.Duration {
+	return pm.queryTimes.Mean()
 }
 
 // GetAverageIngestTime returns the average ingest time.
 func (pm *PerformanceMonitor) GetAverageIngestTime() time.Duration {
-	pm.mu.RLock()
-	defer pm.mu.RUnlock()
-
-	if len(pm.ingestTimes) == 0 {
-		return 0
-	}
-
-	var total time.Duration
-	for _, t := range pm.ingestTimes {
-		total += t
-	}
-	return total / time.Duration(len(pm.ingestTimes))
+	return pm.ingestTimes.Mean()
 }
 
 // GetAverageCompressionRatio returns the average compression ratio.
@@ -288,28 +282,29 @@ func (pm *PerformanceMonitor) GetAverageCompressionRatio() float64 {
 	pm.mu.RLock()
 	defer pm.mu.RUnlock()
 
-	if len(pm.compressions) == 0 {
+	if pm.compressions == 0 {
 		return 0
 	}
-
-	var total float64
-	for _, c := range pm.compressions {
-		total += c.Ratio
-	}
-	return total / float64(len(pm.compressions))
+	return pm.compressionRatio / float64(pm.compressions)
 }
 
 // PrintReport prints a performance report.
 func (pm *PerformanceMonitor) PrintReport(w io.Writer) {
-	pm.mu.RLock()
-	defer pm.mu.RUnlock()
-
 	fmt.Fprintf(w, "\n=== Performance Report ===\n")
 	fmt.Fprintf(w, "Uptime: %v\n", time.Since(pm.startTime))
 	fmt.Fprintf(w, "\n--- Operations ---\n")
-	fmt.Fprintf(w, "Queries: %d (avg: %v)\n", len(pm.queryTimes), pm.GetAverageQueryTime())
-	fmt.Fprintf(w, "Ingests: %d (avg: %v)\n", len(pm.ingestTimes), pm.GetAverageIngestTime())
-	fmt.Fprintf(w, "Compressions: %d (avg ratio: %.2fx)\n", len(pm.compressions), pm.GetAverageCompressionRatio())
+	fmt.Fprintf(w, "Queries: %d (avg: %v)\n", pm.queryTimes.Count(), pm.GetAverageQueryTime())
+	if pm.queryTimes.Count() > 0 {
+		fmt.Fprintf(w, "  %s\n", pm.queryTimes.Percentiles())
+	}
+	fmt.Fprintf(w, "Ingests: %d (avg: %v)\n", pm.ingestTimes.Count(), pm.GetAverageIngestTime())
+	if pm.ingestTimes.Count() > 0 {
+		fmt.Fprintf(w, "  %s\n", pm.ingestTimes.Percentiles())
+	}
+	pm.mu.RLock()
+	compressions := pm.compressions
+	pm.mu.RUnlock()
+	fmt.Fprintf(w, "Compressions: %d (avg ratio: %.2fx)\n", compressions, pm.GetAverageCompressionRatio())
 }
 
 // EnableMutexProfiling enables mutex profiling with the specified fraction.
@@ -274,7 +274,7 @@ func TestPerformanceMonitorCompressionAndReport(t *testing.T) {
 	var buf bytes.Buffer
 	pm.PrintReport(&buf)
 	output := buf.String()
-	for _, want := range []string{"Performance Report", "Queries: 1", "Ingests: 1", "Compressions: 2"} {
+	for _, want := range []string{"Performance Report", "Queries: 1", "Ingests: 1", "Compressions: 2", "p99=10ms", "p999=20ms"} {
 		if !strings.Contains(output, want) {
 			t.Fatalf("PrintReport output missing %q:\n%s", want, output)
 		}
@@ -0,0 +1,82 @@
+// Package recordio encodes daily and hourly records in the fixed
+// little-endian layout of cimis_daily_record_t and cimis_hourly_record_t
+// (c/cimis_storage.h), so files written with it can be mapped and iterated
+// by the C library directly.
+package recordio
+
+import (
+	"encoding/binary"
+
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// Encoded record sizes.
+const (
+	DailySize  = 16
+	HourlySize = 24
+)
+
+// PutDaily encodes r into b[:DailySize] and returns that slice.
+func PutDaily(b []byte, r types.DailyRecord) []byte {
+	binary.LittleEndian.PutUint32(b[0:], r.Timestamp)
+	binary.LittleEndian.PutUint16(b[4:], r.StationID)
+	binary.LittleEndian.PutUint16(b[6:], uint16(r.Temperature))
+	binary.LittleEndian.PutUint16(b[8:], uint16(r.ET))
+	binary.LittleEndian.PutUint16(b[10:], r.WindSpeed)
+	b[12] = r.Humidity
+	b[13] = r.SolarRadiation
+	b[14] = r.QCFlags
+	b[15] = r.Reserved
+	return b
+}
+
+// Daily decodes a record encoded by PutDaily.
+func Daily(b []byte) types.DailyRecord {
+	return types.DailyRecord{
+		Timestamp:      binary.LittleEndian.Uint32(b[0:]),
+		StationID:      binary.LittleEndian.Uint16(b[4:]),
+		Temperature:    int16(binary.LittleEndian.Uint16(b[6:])),
+		ET:             int16(binary.LittleEndian.Uint16(b[8:])),
+		WindSpeed:      binary.LittleEndian.Uint16(b[10:]),
+		Humidity:       b[12],
+		SolarRadiation: b[13],
+		QCFlags:        b[14],
+		Reserved:       b[15],
+	}
+}
+
+// PutHourly encodes r into b[:HourlySize] and returns that slice.
+func PutHourly(b []byte, r types.HourlyRecord) []byte {
+	binary.LittleEndian.PutUint32(b[0:], r.Timestamp)
+	binary.LittleEndian.PutUint16(b[4:], r.StationID)
+	binary.LittleEndian.PutUint16(b[6:], uint16(r.Temperature))
+	binary.LittleEndian.PutUint16(b[8:], uint16(r.ET))
+	binary.LittleEndian.PutUint16(b[10:], r.WindSpeed)
+	b[12] = r.WindDirection
+	b[13] = r.Humidity
+	binary.LittleEndian.PutUint16(b[14:], r.SolarRadiation)
+	binary.LittleEndian.PutUint16(b[16:], r.Precipitation)
+	binary.LittleEndian.PutUint16(b[18:], r.VaporPressure)
+	b[20] = r.QCFlags
+	b[21] = r.Reserved
+	b[22], b[23] = 0, 0
+	return b
+}
+
+// Hourly decodes a record encoded by PutHourly.
+func Hourly(b []byte) types.HourlyRecord {
+	return types.HourlyRecord{
+		Timestamp:      binary.LittleEndian.Uint32(b[0:]),
+		StationID:      binary.LittleEndian.Uint16(b[4:]),
+		Temperature:    int16(binary.LittleEndian.Uint16(b[6:])),
+		ET:             int16(binary.LittleEndian.Uint16(b[8:])),
+		WindSpeed:      binary.LittleEndian.Uint16(b[10:]),
+		WindDirection:  b[12],
+		Humidity:       b[13],
+		SolarRadiation: binary.LittleEndian.Uint16(b[14:]),
+		Precipitation:  binary.LittleEndian.Uint16(b[16:]),
+		VaporPressure:  binary.LittleEndian.Uint16(b[18:]),
+		QCFlags:        b[20],
+		Reserved:       b[21],
+	}
+}
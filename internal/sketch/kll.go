@@ -0,0 +1,306 @@
+// Package sketch provides mergeable quantile sketches for CIMIS measurements.
+package sketch
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"math"
+	"sort"
+)
+
+// DefaultK gives roughly 1.7% normalized rank error with a few KB per sketch.
+const DefaultK = 200
+
+const (
+	kllMagic    = "KLL1"
+	minCapacity = 8
+	capDecay    = 2.0 / 3.0
+)
+
+// ErrInvalidSketch is returned when decoding malformed sketch bytes.
+var ErrInvalidSketch = errors.New("invalid sketch encoding")
+
+// KLL is a mergeable quantile sketch (Karnin, Lang, Liberty 2016).
+//
+// Items are kept in a stack of compactors; level h items carry weight 2^h.
+// When a level overflows it is sorted and every other item is promoted,
+// so memory stays O(k) regardless of how many values were added. Sketches
+// built on different goroutines or processes merge by concatenating levels
+// and compacting again; the rank error bound holds for the merged result.
+// A KLL is not safe for concurrent use; merge per-worker sketches instead.
+type KLL struct {
+	k      int
+	n      uint64
+	min    float64
+	max    float64
+	levels [][]float64
+	seed   uint64
+}
+
+// NewKLL creates an empty sketch. k <= 0 selects DefaultK.
+func NewKLL(k int) *KLL {
+	if k <= 0 {
+		k = DefaultK
+	}
+	return &KLL{
+		k:      k,
+		min:    math.Inf(1),
+		max:    math.Inf(-1),
+		levels: [][]float64{make([]float64, 0, k)},
+		seed:   0x9E3779B97F4A7C15,
+	}
+}
+
+// K returns the accuracy parameter.
+func (s *KLL) K() int { return s.k }
+
+// Count returns the number of values summarized.
+func (s *KLL) Count() uint64 { return s.n }
+
+// Min returns the smallest value seen (NaN when empty).
+func (s *KLL) Min() float64 {
+	if s.n == 0 {
+		return math.NaN()
+	}
+	return s.min
+}
+
+// Max returns the largest value seen (NaN when empty).
+func (s *KLL) Max() float64 {
+	if s.n == 0 {
+		return math.NaN()
+	}
+	return s.max
+}
+
+// Update adds a value. NaN values are ignored.
+func (s *KLL) Update(v float64) {
+	if math.IsNaN(v) {
+		return
+	}
+	if v < s.min {
+		s.min = v
+	}
+	if v > s.max {
+		s.max = v
+	}
+	s.n++
+	s.levels[0] = append(s.levels[0], v)
+	if len(s.levels[0]) >= s.capacity(0) {
+		s.compress()
+	}
+}
+
+// Merge folds other into s. Both sketches must share the same k.
+func (s *KLL) Merge(other *KLL) error {
+	if other == nil || other.n == 0 {
+		return nil
+	}
+	if other.k != s.k {
+		return fmt.Errorf("cannot merge sketches with k=%d and k=%d", s.k, other.k)
+	}
+	for len(s.levels) < len(other.levels) {
+		s.levels = append(s.levels, nil)
+	}
+	for h, items := range other.levels {
+		s.levels[h] = append(s.levels[h], items...)
+	}
+	s.n += other.n
+	if other.min < s.min {
+		s.min = other.min
+	}
+	if other.max > s.max {
+		s.max = other.max
+	}
+	s.seed = mixSeeds(s.seed, other.seed)
+	s.compress()
+	return nil
+}
+
+// Quantile returns the approximate value at rank q in [0, 1].
+func (s *KLL) Quantile(q float64) float64 {
+	if s.n == 0 || math.IsNaN(q) {
+		return math.NaN()
+	}
+	if q <= 0 {
+		return s.min
+	}
+	if q >= 1 {
+		return s.max
+	}
+
+	type weighted struct {
+		v float64
+		w uint64
+	}
+	items := make([]weighted, 0, s.size())
+	var total uint64
+	for h, level := range s.levels {
+		w := uint64(1) << uint(h)
+		for _, v := range level {
+			items = append(items, weighted{v, w})
+			total += w
+		}
+	}
+	sort.Slice(items, func(i, j int) bool { return items[i].v < items[j].v })
+
+	target := q * float64(total)
+	var cum uint64
+	for _, it := range items {
+		cum += it.w
+		if float64(cum) >= target {
+			return it.v
+		}
+	}
+	return s.max
+}
+
+// Percentile is Quantile with p in [0, 100].
+func (s *KLL) Percentile(p float64) float64 {
+	return s.Quantile(p / 100)
+}
+
+// capacity returns the compactor size for level h; higher levels get more room.
+func (s *KLL) capacity(h int) int {
+	depth := len(s.levels) - h - 1
+	c := int(math.Ceil(float64(s.k) * math.Pow(capDecay, float64(depth))))
+	if c < minCapacity {
+		c = minCapacity
+	}
+	return c
+}
+
+func (s *KLL) size() int {
+	n := 0
+	for _, level := range s.levels {
+		n += len(level)
+	}
+	return n
+}
+
+func (s *KLL) maxSize() int {
+	n := 0
+	for h := range s.levels {
+		n += s.capacity(h)
+	}
+	return n
+}
+
+// compress compacts overflowing levels until the sketch fits its budget.
+func (s *KLL) compress() {
+	for h := 0; h < len(s.levels); h++ {
+		if len(s.levels[h]) < s.capacity(h) {
+			continue
+		}
+		if h+1 == len(s.levels) {
+			s.levels = append(s.levels, nil)
+		}
+
+		level := s.levels[h]
+		sort.Float64s(level)
+
+		// Odd-sized levels keep one item behind so total weight is preserved.
+		keep := len(level) % 2
+		offset := int(s.nextBit())
+		promoted := s.levels[h+1]
+		for i := keep + offset; i < len(level); i += 2 {
+			promoted = append(promoted, level[i])
+		}
+		s.levels[h+1] = promoted
+		s.levels[h] = level[:keep]
+
+		if s.size() < s.maxSize() {
+			return
+		}
+	}
+}
+
+// mixSeeds combines two coin states with splitmix64. XOR would zero the state
+// whenever both sides share a seed, the default, and xorshift never leaves 0.
+func mixSeeds(a, b uint64) uint64 {
+	z := a + b*0x9E3779B97F4A7C15
+	z = (z ^ z>>30) * 0xBF58476D1CE4E5B9
+	z = (z ^ z>>27) * 0x94D049BB133111EB
+	z ^= z >> 31
+	if z == 0 {
+		return 0x9E3779B97F4A7C15
+	}
+	return z
+}
+
+// nextBit is a xorshift coin flip; deterministic so runs are reproducible.
+func (s *KLL) nextBit() uint64 {
+	s.seed ^= s.seed << 13
+	s.seed ^= s.seed >> 7
+	s.seed ^= s.seed << 17
+	return s.seed & 1
+}
+
+// MarshalBinary encodes the sketch for sidecar files and cross-process merges.
+func (s *KLL) MarshalBinary() ([]byte, error) {
+	size := 4 + 4 + 8 + 8 + 8 + 8 + 4
+	for _, level := range s.levels {
+		size += 4 + 8*len(level)
+	}
+	buf := make([]byte, 0, size)
+	buf = append(buf, kllMagic...)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(s.k))
+	buf = binary.LittleEndian.AppendUint64(buf, s.n)
+	buf = binary.LittleEndian.AppendUint64(buf, math.Float64bits(s.min))
+	buf = binary.LittleEndian.AppendUint64(buf, math.Float64bits(s.max))
+	buf = binary.LittleEndian.AppendUint64(buf, s.seed)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(len(s.levels)))
+	for _, level := range s.levels {
+		buf = binary.LittleEndian.AppendUint32(buf, uint32(len(level)))
+		for _, v := range level {
+			buf = binary.LittleEndian.AppendUint64(buf, math.Float64bits(v))
+		}
+	}
+	return buf, nil
+}
+
+// UnmarshalBinary decodes a sketch produced by MarshalBinary.
+func (s *KLL) UnmarshalBinary(data []byte) error {
+	const header = 4 + 4 + 8 + 8 + 8 + 8 + 4
+	if len(data) < header || string(data[:4]) != kllMagic {
+		return ErrInvalidSketch
+	}
+	k := int(binary.LittleEndian.Uint32(data[4:]))
+	n := binary.LittleEndian.Uint64(data[8:])
+	minV := math.Float64frombits(binary.LittleEndian.Uint64(data[16:]))
+	maxV := math.Float64frombits(binary.LittleEndian.Uint64(data[24:]))
+	seed := binary.LittleEndian.Uint64(data[32:])
+	numLevels := int(binary.LittleEndian.Uint32(data[40:]))
+	if k <= 0 || numLevels <= 0 || numLevels > 64 {
+		return ErrInvalidSketch
+	}
+	if seed == 0 {
+		seed = mixSeeds(0, 0) // written by an older merge that zeroed it
+	}
+
+	pos := header
+	levels := make([][]float64, numLevels)
+	for h := range levels {
+		if pos+4 > len(data) {
+			return ErrInvalidSketch
+		}
+		count := int(binary.LittleEndian.Uint32(data[pos:]))
+		pos += 4
+		if count < 0 || pos+8*count > len(data) {
+			return ErrInvalidSketch
+		}
+		level := make([]float64, count)
+		for i := range level {
+			level[i] = math.Float64frombits(binary.LittleEndian.Uint64(data[pos:]))
+			pos += 8
+		}
+		levels[h] = level
+	}
+	if pos != len(data) {
+		return ErrInvalidSketch
+	}
+
+	s.k, s.n, s.min, s.max, s.seed, s.levels = k, n, minV, maxV, seed, levels
+	return nil
+}
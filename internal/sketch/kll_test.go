@@ -0,0 +1,165 @@
+package sketch
+
+import (
+	"math"
+	"math/rand"
+	"sort"
+	"testing"
+)
+
+func exactQuantile(sorted []float64, q float64) float64 {
+	idx := int(math.Ceil(q*float64(len(sorted)))) - 1
+	if idx < 0 {
+		idx = 0
+	}
+	return sorted[idx]
+}
+
+func rankError(sorted []float64, v, q float64) float64 {
+	rank := sort.SearchFloat64s(sorted, v)
+	return math.Abs(float64(rank)/float64(len(sorted)) - q)
+}
+
+func TestKLLQuantileAccuracy(t *testing.T) {
+	rng := rand.New(rand.NewSource(1))
+	s := NewKLL(0)
+	values := make([]float64, 200000)
+	for i := range values {
+		values[i] = rng.NormFloat64()*8 + 18
+		s.Update(values[i])
+	}
+	sort.Float64s(values)
+
+	if s.Count() != uint64(len(values)) {
+		t.Fatalf("Count() = %d, want %d", s.Count(), len(values))
+	}
+	if s.Min() != values[0] || s.Max() != values[len(values)-1] {
+		t.Fatalf("Min/Max = %v/%v, want %v/%v", s.Min(), s.Max(), values[0], values[len(values)-1])
+	}
+	for _, q := range []float64{0.01, 0.25, 0.5, 0.9, 0.95, 0.99} {
+		got := s.Quantile(q)
+		if err := rankError(values, got, q); err > 0.02 {
+			t.Errorf("Quantile(%v) = %v (exact %v), rank error %.4f", q, got, exactQuantile(values, q), err)
+		}
+	}
+
+	encoded, _ := s.MarshalBinary()
+	if len(encoded) > 16*1024 {
+		t.Errorf("sketch encodes to %d bytes, want bounded size", len(encoded))
+	}
+}
+
+func TestKLLMergeMatchesSingleSketch(t *testing.T) {
+	rng := rand.New(rand.NewSource(2))
+	merged := NewKLL(DefaultK)
+	var all []float64
+	for w := 0; w < 8; w++ {
+		part := NewKLL(DefaultK)
+		for i := 0; i < 25000; i++ {
+			v := rng.ExpFloat64() * float64(w+1)
+			part.Update(v)
+			all = append(all, v)
+		}
+		if err := merged.Merge(part); err != nil {
+			t.Fatalf("Merge() error = %v", err)
+		}
+	}
+	sort.Float64s(all)
+
+	if merged.Count() != uint64(len(all)) {
+		t.Fatalf("merged Count() = %d, want %d", merged.Count(), len(all))
+	}
+	for _, p := range []float64{50, 95, 99} {
+		got := merged.Percentile(p)
+		if err := rankError(all, got, p/100); err > 0.02 {
+			t.Errorf("Percentile(%v) = %v (exact %v), rank error %.4f", p, got, exactQuantile(all, p/100), err)
+		}
+	}
+
+	if err := merged.Merge(NewKLL(50)); err != nil {
+		t.Fatalf("merging an empty sketch should be a no-op, got %v", err)
+	}
+	other := NewKLL(50)
+	other.Update(1)
+	if err := merged.Merge(other); err == nil {
+		t.Fatal("expected k mismatch error")
+	}
+}
+
+func TestKLLMergeSameSeedKeepsCompactionRandom(t *testing.T) {
+	rng := rand.New(rand.NewSource(3))
+	a, b := NewKLL(DefaultK), NewKLL(DefaultK)
+	var all []float64
+	for i := 0; i < 50000; i++ {
+		v := rng.Float64()
+		a.Update(v)
+		all = append(all, v)
+		v = rng.Float64() * 2
+		b.Update(v)
+		all = append(all, v)
+	}
+	if err := a.Merge(b); err != nil {
+		t.Fatalf("Merge() error = %v", err)
+	}
+	if a.seed == 0 {
+		t.Fatal("merging two default-seeded sketches zeroed the coin state")
+	}
+	// Keep compacting after the merge; a stuck coin biases every level.
+	for i := 0; i < 100000; i++ {
+		v := rng.Float64() * 3
+		a.Update(v)
+		all = append(all, v)
+	}
+	sort.Float64s(all)
+	for _, q := range []float64{0.1, 0.5, 0.9, 0.99} {
+		if err := rankError(all, a.Quantile(q), q); err > 0.02 {
+			t.Errorf("Quantile(%v) rank error %.4f after a same-seed merge", q, err)
+		}
+	}
+}
+
+func TestKLLMarshalRoundTrip(t *testing.T) {
+	s := NewKLL(64)
+	for i := 0; i < 5000; i++ {
+		s.Update(float64(i % 997))
+	}
+	data, err := s.MarshalBinary()
+	if err != nil {
+		t.Fatalf("MarshalBinary() error = %v", err)
+	}
+
+	var decoded KLL
+	if err := decoded.UnmarshalBinary(data); err != nil {
+		t.Fatalf("UnmarshalBinary() error = %v", err)
+	}
+	if decoded.K() != 64 || decoded.Count() != s.Count() {
+		t.Fatalf("decoded k=%d n=%d, want k=64 n=%d", decoded.K(), decoded.Count(), s.Count())
+	}
+	for _, q := range []float64{0, 0.3, 0.75, 1} {
+		if decoded.Quantile(q) != s.Quantile(q) {
+			t.Errorf("decoded Quantile(%v) = %v, want %v", q, decoded.Quantile(q), s.Quantile(q))
+		}
+	}
+
+	for _, bad := range [][]byte{nil, []byte("XXXX"), data[:len(data)-3], append(append([]byte{}, data...), 0)} {
+		var k KLL
+		if err := k.UnmarshalBinary(bad); err != ErrInvalidSketch {
+			t.Errorf("UnmarshalBinary(%d bytes) error = %v, want ErrInvalidSketch", len(bad), err)
+		}
+	}
+}
+
+func TestKLLEmptyAndNaN(t *testing.T) {
+	s := NewKLL(0)
+	s.Update(math.NaN())
+	if s.Count() != 0 {
+		t.Fatalf("NaN should be ignored, Count() = %d", s.Count())
+	}
+	if !math.IsNaN(s.Quantile(0.5)) || !math.IsNaN(s.Min()) || !math.IsNaN(s.Max()) {
+		t.Fatal("empty sketch should report NaN")
+	}
+	s.Update(3)
+	if s.Quantile(0.5) != 3 || s.Quantile(-1) != 3 || s.Quantile(2) != 3 {
+		t.Fatalf("single-value sketch quantiles wrong: %v", s.Quantile(0.5))
+	}
+}
@@ -0,0 +1,171 @@
+// Package spatial provides a station k-d tree and inverse-distance interpolation.
+package spatial
+
+import (
+	"math"
+	"sort"
+)
+
+// EarthRadiusKm is the mean Earth radius used for great-circle distances.
+const EarthRadiusKm = 6371.0088
+
+// Point is a station location in decimal degrees.
+type Point struct {
+	ID  int
+	Lat float64
+	Lon float64
+}
+
+// Neighbor is a station returned by Nearest.
+type Neighbor struct {
+	ID         int
+	DistanceKm float64
+}
+
+type node struct {
+	xyz [3]float64
+	id  int
+}
+
+// KDTree indexes stations as unit vectors, so chord distance ranks neighbors
+// exactly like great-circle distance. Nodes form an implicit tree: the median
+// of each index range is that subtree's root.
+type KDTree struct {
+	nodes []node
+}
+
+func toXYZ(lat, lon float64) [3]float64 {
+	phi, lambda := lat*math.Pi/180, lon*math.Pi/180
+	return [3]float64{math.Cos(phi) * math.Cos(lambda), math.Cos(phi) * math.Sin(lambda), math.Sin(phi)}
+}
+
+func chordSq(a, b [3]float64) float64 {
+	dx, dy, dz := a[0]-b[0], a[1]-b[1], a[2]-b[2]
+	return dx*dx + dy*dy + dz*dz
+}
+
+// NewKDTree builds a tree over points.
+func NewKDTree(points []Point) *KDTree {
+	t := &KDTree{nodes: make([]node, len(points))}
+	for i, p := range points {
+		t.nodes[i] = node{xyz: toXYZ(p.Lat, p.Lon), id: p.ID}
+	}
+	t.build(0, len(t.nodes), 0)
+	return t
+}
+
+func (t *KDTree) build(lo, hi, depth int) {
+	if hi-lo <= 1 {
+		return
+	}
+	axis := depth % 3
+	part := t.nodes[lo:hi]
+	sort.Slice(part, func(i, j int) bool { return part[i].xyz[axis] < part[j].xyz[axis] })
+	mid := lo + (hi-lo)/2
+	t.build(lo, mid, depth+1)
+	t.build(mid+1, hi, depth+1)
+}
+
+// Len returns the number of indexed stations.
+func (t *KDTree) Len() int { return len(t.nodes) }
+
+type candidate struct {
+	id     int
+	distSq float64
+}
+
+// Nearest returns up to k stations closest to (lat, lon), nearest first.
+func (t *KDTree) Nearest(lat, lon float64, k int) []Neighbor {
+	if k <= 0 || len(t.nodes) == 0 {
+		return nil
+	}
+	if k > len(t.nodes) {
+		k = len(t.nodes)
+	}
+	q := toXYZ(lat, lon)
+	best := make([]candidate, 0, k)
+
+	offer := func(n *node) {
+		d := chordSq(q, n.xyz)
+		if len(best) == k && d >= best[k-1].distSq {
+			return
+		}
+		i := sort.Search(len(best), func(i int) bool { return best[i].distSq > d })
+		if len(best) < k {
+			best = append(best, candidate{})
+		}
+		copy(best[i+1:], best[i:len(best)-1])
+		best[i] = candidate{id: n.id, distSq: d}
+	}
+
+	var search func(lo, hi, depth int)
+	search = func(lo, hi, depth int) {
+		if lo >= hi {
+			return
+		}
+		mid := lo + (hi-lo)/2
+		n := &t.nodes[mid]
+		offer(n)
+
+		diff := q[depth%3] - n.xyz[depth%3]
+		nearLo, nearHi, farLo, farHi := lo, mid, mid+1, hi
+		if diff >= 0 {
+			nearLo, nearHi, farLo, farHi = mid+1, hi, lo, mid
+		}
+		search(nearLo, nearHi, depth+1)
+		if len(best) < k || diff*diff < best[len(best)-1].distSq {
+			search(farLo, farHi, depth+1)
+		}
+	}
+	search(0, len(t.nodes), 0)
+
+	out := make([]Neighbor, len(best))
+	for i, c := range best {
+		chord := math.Min(math.Sqrt(c.distSq), 2)
+		out[i] = Neighbor{ID: c.id, DistanceKm: 2 * EarthRadiusKm * math.Asin(chord/2)}
+	}
+	return out
+}
+
+// IDW blends aligned series with inverse-distance weights (distance^-power).
+// NaN samples are skipped; a timestamp with no values yields NaN. A station
+// at distance zero supplies its own value wherever it has one.
+func IDW(series [][]float64, distancesKm []float64, power float64) []float64 {
+	if len(series) == 0 {
+		return nil
+	}
+	length := len(series[0])
+	num := make([]float64, length)
+	den := make([]float64, length)
+	for i, values := range series {
+		if distancesKm[i] <= 0 {
+			continue
+		}
+		w := math.Pow(distancesKm[i], -power)
+		for t, v := range values {
+			if !math.IsNaN(v) {
+				num[t] += w * v
+				den[t] += w
+			}
+		}
+	}
+
+	out := make([]float64, length)
+	for t := range out {
+		out[t] = math.NaN()
+		if den[t] > 0 {
+			out[t] = num[t] / den[t]
+		}
+	}
+	for i, values := range series {
+		if distancesKm[i] > 0 {
+			continue
+		}
+		for t, v := range values {
+			if !math.IsNaN(v) {
+				out[t] = v
+			}
+		}
+	}
+	return out
+}
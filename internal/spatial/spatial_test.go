@@ -0,0 +1,78 @@
+package spatial
+
+import (
+	"math"
+	"math/rand"
+	"sort"
+	"testing"
+)
+
+func haversineKm(lat1, lon1, lat2, lon2 float64) float64 {
+	p1, p2 := lat1*math.Pi/180, lat2*math.Pi/180
+	dp, dl := p2-p1, (lon2-lon1)*math.Pi/180
+	a := math.Sin(dp/2)*math.Sin(dp/2) + math.Cos(p1)*math.Cos(p2)*math.Sin(dl/2)*math.Sin(dl/2)
+	return 2 * EarthRadiusKm * math.Asin(math.Sqrt(a))
+}
+
+func TestNearestMatchesBruteForce(t *testing.T) {
+	rng := rand.New(rand.NewSource(4))
+	points := make([]Point, 250)
+	for i := range points {
+		points[i] = Point{ID: i + 1, Lat: 32.5 + rng.Float64()*9.5, Lon: -124.3 + rng.Float64()*10}
+	}
+	tree := NewKDTree(points)
+	if tree.Len() != len(points) {
+		t.Fatalf("Len() = %d, want %d", tree.Len(), len(points))
+	}
+
+	for q := 0; q < 200; q++ {
+		lat, lon := 32+rng.Float64()*10, -125+rng.Float64()*11
+		type scored struct {
+			id int
+			d  float64
+		}
+		all := make([]scored, len(points))
+		for i, p := range points {
+			all[i] = scored{p.ID, haversineKm(lat, lon, p.Lat, p.Lon)}
+		}
+		sort.Slice(all, func(i, j int) bool { return all[i].d < all[j].d })
+
+		got := tree.Nearest(lat, lon, 4)
+		if len(got) != 4 {
+			t.Fatalf("Nearest() returned %d neighbors, want 4", len(got))
+		}
+		for i, n := range got {
+			if n.ID != all[i].id || math.Abs(n.DistanceKm-all[i].d) > 1e-6 {
+				t.Fatalf("query (%.3f, %.3f) neighbor %d = %+v, want id %d at %.6f km", lat, lon, i, n, all[i].id, all[i].d)
+			}
+		}
+	}
+
+	if got := NewKDTree(points[:2]).Nearest(36, -120, 5); len(got) != 2 {
+		t.Fatalf("k larger than tree should return all stations, got %d", len(got))
+	}
+	if got := NewKDTree(nil).Nearest(36, -120, 3); got != nil {
+		t.Fatalf("empty tree should return nil, got %v", got)
+	}
+}
+
+func TestIDW(t *testing.T) {
+	nan := math.NaN()
+	series := [][]float64{{1, 2, nan, nan}, {3, nan, 6, nan}}
+
+	got := IDW(series, []float64{1, 2}, 2)
+	want := []float64{(1*1 + 0.25*3) / 1.25, 2, 6}
+	for i, w := range want {
+		if math.Abs(got[i]-w) > 1e-12 {
+			t.Errorf("IDW()[%d] = %v, want %v", i, got[i], w)
+		}
+	}
+	if !math.IsNaN(got[3]) {
+		t.Errorf("IDW()[3] = %v, want NaN when no station has data", got[3])
+	}
+
+	got = IDW(series, []float64{0, 2}, 2)
+	if got[0] != 1 || got[1] != 2 || got[2] != 6 {
+		t.Errorf("co-located station should win where present, got %v", got)
+	}
+}
@@ -0,0 +1,215 @@
+// Package tailindex keeps the latest daily and hourly record of every station
+// in a small fixed-layout file so "current conditions" lookups skip the
+// metadata store and chunk decoding entirely.
+//
+// The layout matches cimis_tail_index_open in c/cimis_storage.c: a 16-byte
+// header followed by one slot per station ID, each holding an encoded daily
+// record and an encoded hourly record in the chunk wire format. Writers hold
+// an flock on FileName+".lock" and replace the file by rename, so a reader
+// that mmaps or reads the index sees a whole version of it, never a torn
+// slot; it picks up newer records by reopening.
+package tailindex
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"os"
+	"sync"
+
+	"github.com/dl-alexandre/cimis-cli/internal/filelock"
+	"github.com/dl-alexandre/cimis-cli/internal/recordio"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// FileName is the tail index file inside a data directory.
+const FileName = "tail_index.bin"
+
+const (
+	magic      = "CTAI"
+	version    = 1
+	headerSize = 16
+	dailySize  = recordio.DailySize
+	hourlySize = recordio.HourlySize
+	slotSize   = dailySize + hourlySize
+	slotGrowth = 64 // slots are added in blocks to avoid regrowing per station
+)
+
+// ErrInvalidIndex is returned when an index file is malformed.
+var ErrInvalidIndex = errors.New("invalid tail index")
+
+// updateMu serializes writers within a process (fetch-streaming writes chunks
+// from several goroutines); filelock serializes them across processes.
+var updateMu sync.Mutex
+
+// Index is a read-only snapshot of a tail index file.
+type Index struct {
+	data  []byte
+	slots int
+}
+
+// Open reads the index at path. A missing file is reported as an
+// os.ErrNotExist error so callers can fall back to scanning chunks.
+func Open(path string) (*Index, error) {
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return nil, err
+	}
+	slots, err := parseHeader(data)
+	if err != nil {
+		return nil, err
+	}
+	if backed := (len(data) - headerSize) / slotSize; slots > backed {
+		slots = backed
+	}
+	return &Index{data: data, slots: slots}, nil
+}
+
+// Daily returns the latest daily record stored for a station.
+func (ix *Index) Daily(stationID uint16) (types.DailyRecord, bool) {
+	b := ix.slot(stationID, 0, dailySize)
+	if b == nil {
+		return types.DailyRecord{}, false
+	}
+	return recordio.Daily(b), true
+}
+
+// Hourly returns the latest hourly record stored for a station.
+func (ix *Index) Hourly(stationID uint16) (types.HourlyRecord, bool) {
+	b := ix.slot(stationID, dailySize, hourlySize)
+	if b == nil {
+		return types.HourlyRecord{}, false
+	}
+	return recordio.Hourly(b), true
+}
+
+// Stations lists station IDs with a daily or hourly record, ascending.
+func (ix *Index) Stations() []uint16 {
+	var ids []uint16
+	for id := 1; id < ix.slots; id++ {
+		if ix.slot(uint16(id), 0, dailySize) != nil || ix.slot(uint16(id), dailySize, hourlySize) != nil {
+			ids = append(ids, uint16(id))
+		}
+	}
+	return ids
+}
+
+func (ix *Index) slot(stationID uint16, offset, size int) []byte {
+	if stationID == 0 || int(stationID) >= ix.slots {
+		return nil
+	}
+	start := headerSize + int(stationID)*slotSize + offset
+	b := ix.data[start : start+size]
+	if binary.LittleEndian.Uint16(b[4:]) != stationID {
+		return nil
+	}
+	return b
+}
+
+// Update records the newest daily and hourly record of each station in the
+// given batches, creating or growing the file as needed. Slots only move
+// forward in time, so rewriting an old chunk never hides newer data.
+func Update(path string, daily []types.DailyRecord, hourly []types.HourlyRecord) error {
+	latestDaily := make(map[uint16]types.DailyRecord)
+	for _, r := range daily {
+		if cur, ok := latestDaily[r.StationID]; r.StationID != 0 && (!ok || r.Timestamp >= cur.Timestamp) {
+			latestDaily[r.StationID] = r
+		}
+	}
+	latestHourly := make(map[uint16]types.HourlyRecord)
+	for _, r := range hourly {
+		if cur, ok := latestHourly[r.StationID]; r.StationID != 0 && (!ok || r.Timestamp >= cur.Timestamp) {
+			latestHourly[r.StationID] = r
+		}
+	}
+	if len(latestDaily) == 0 && len(latestHourly) == 0 {
+		return nil
+	}
+
+	maxID := 0
+	for id := range latestDaily {
+		maxID = max(maxID, int(id))
+	}
+	for id := range latestHourly {
+		maxID = max(maxID, int(id))
+	}
+
+	updateMu.Lock()
+	defer updateMu.Unlock()
+	unlock, err := filelock.Lock(path + ".lock")
+	if err != nil {
+		return fmt.Errorf("lock tail index: %w", err)
+	}
+	defer unlock()
+
+	data, err := os.ReadFile(path)
+	if err != nil && !os.IsNotExist(err) {
+		return fmt.Errorf("read tail index: %w", err)
+	}
+	if data, err = ensureSlots(data, maxID+1); err != nil {
+		return err
+	}
+
+	for id, r := range latestDaily {
+		b := data[headerSize+int(id)*slotSize:][:dailySize]
+		if binary.LittleEndian.Uint16(b[4:]) == id && binary.LittleEndian.Uint32(b[0:]) > r.Timestamp {
+			continue
+		}
+		recordio.PutDaily(b, r)
+	}
+	for id, r := range latestHourly {
+		b := data[headerSize+int(id)*slotSize+dailySize:][:hourlySize]
+		if binary.LittleEndian.Uint16(b[4:]) == id && binary.LittleEndian.Uint32(b[0:]) > r.Timestamp {
+			continue
+		}
+		recordio.PutHourly(b, r)
+	}
+
+	tmp := path + ".tmp"
+	if err := os.WriteFile(tmp, data, 0644); err != nil {
+		return fmt.Errorf("write tail index: %w", err)
+	}
+	if err := os.Rename(tmp, path); err != nil {
+		os.Remove(tmp)
+		return fmt.Errorf("replace tail index: %w", err)
+	}
+	return nil
+}
+
+// ensureSlots returns the index contents with room for at least want slots,
+// creating the header for an empty file. The index only ever grows: slots
+// past want that another writer added are kept.
+func ensureSlots(data []byte, want int) ([]byte, error) {
+	slots := 0
+	if len(data) > 0 {
+		var err error
+		if slots, err = parseHeader(data); err != nil {
+			return nil, err
+		}
+	}
+	backed := 0
+	if len(data) > headerSize {
+		backed = (len(data) - headerSize) / slotSize
+	}
+	slots = min(slots, backed)
+	if len(data) > 0 && slots >= want {
+		return data[:headerSize+slots*slotSize], nil
+	}
+
+	grown := max(slots, (want+slotGrowth-1)/slotGrowth*slotGrowth)
+	out := make([]byte, headerSize+grown*slotSize)
+	copy(out, data[:min(len(data), headerSize+slots*slotSize)])
+	copy(out, magic)
+	binary.LittleEndian.PutUint32(out[4:], version)
+	binary.LittleEndian.PutUint32(out[8:], uint32(grown))
+	binary.LittleEndian.PutUint32(out[12:], 0)
+	return out, nil
+}
+
+func parseHeader(data []byte) (int, error) {
+	if len(data) < headerSize || string(data[:4]) != magic ||
+		binary.LittleEndian.Uint32(data[4:]) != version {
+		return 0, ErrInvalidIndex
+	}
+	return int(binary.LittleEndian.Uint32(data[8:])), nil
+}
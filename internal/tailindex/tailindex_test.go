@@ -0,0 +1,168 @@
+package tailindex
+
+import (
+	"fmt"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"reflect"
+	"strconv"
+	"testing"
+
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+func TestUpdateAndOpen(t *testing.T) {
+	path := filepath.Join(t.TempDir(), FileName)
+
+	daily := []types.DailyRecord{
+		{Timestamp: 100, StationID: 2, Temperature: -35, ET: 410, WindSpeed: 22, Humidity: 61, SolarRadiation: 180, QCFlags: 1},
+		{Timestamp: 101, StationID: 2, Temperature: 215, ET: 420, WindSpeed: 23, Humidity: 60, SolarRadiation: 181},
+		{Timestamp: 90, StationID: 5, Temperature: 180},
+	}
+	hourly := []types.HourlyRecord{
+		{Timestamp: 2424, StationID: 2, Temperature: 190, ET: 1200, WindDirection: 90, Humidity: 40, SolarRadiation: 650, Precipitation: 3, VaporPressure: 120},
+	}
+	if err := Update(path, daily, hourly); err != nil {
+		t.Fatalf("Update() error = %v", err)
+	}
+
+	ix, err := Open(path)
+	if err != nil {
+		t.Fatalf("Open() error = %v", err)
+	}
+	if got, ok := ix.Daily(2); !ok || !reflect.DeepEqual(got, daily[1]) {
+		t.Fatalf("Daily(2) = %+v, %v; want %+v", got, ok, daily[1])
+	}
+	if got, ok := ix.Hourly(2); !ok || !reflect.DeepEqual(got, hourly[0]) {
+		t.Fatalf("Hourly(2) = %+v, %v; want %+v", got, ok, hourly[0])
+	}
+	if _, ok := ix.Hourly(5); ok {
+		t.Fatal("station 5 has no hourly record")
+	}
+	if _, ok := ix.Daily(3); ok {
+		t.Fatal("station 3 has no records")
+	}
+	if got := ix.Stations(); !reflect.DeepEqual(got, []uint16{2, 5}) {
+		t.Fatalf("Stations() = %v, want [2 5]", got)
+	}
+}
+
+func TestUpdateKeepsNewestAndGrows(t *testing.T) {
+	path := filepath.Join(t.TempDir(), FileName)
+
+	if err := Update(path, []types.DailyRecord{{Timestamp: 500, StationID: 7, Temperature: 100}}, nil); err != nil {
+		t.Fatalf("Update() error = %v", err)
+	}
+	// A repaired older chunk must not replace the newer tail.
+	if err := Update(path, []types.DailyRecord{{Timestamp: 400, StationID: 7, Temperature: 1}}, nil); err != nil {
+		t.Fatalf("Update() error = %v", err)
+	}
+	// Station 250 forces the file to grow past the first block of slots.
+	if err := Update(path, []types.DailyRecord{{Timestamp: 501, StationID: 250, Temperature: 55}}, nil); err != nil {
+		t.Fatalf("Update() error = %v", err)
+	}
+
+	ix, err := Open(path)
+	if err != nil {
+		t.Fatalf("Open() error = %v", err)
+	}
+	if got, _ := ix.Daily(7); got.Timestamp != 500 || got.Temperature != 100 {
+		t.Fatalf("Daily(7) = %+v, want timestamp 500", got)
+	}
+	if got, ok := ix.Daily(250); !ok || got.Temperature != 55 {
+		t.Fatalf("Daily(250) = %+v, %v", got, ok)
+	}
+	info, err := os.Stat(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if want := int64(headerSize + 256*slotSize); info.Size() != want {
+		t.Fatalf("index size = %d, want %d", info.Size(), want)
+	}
+}
+
+func TestOpenRejectsInvalidFiles(t *testing.T) {
+	dir := t.TempDir()
+	if _, err := Open(filepath.Join(dir, "missing.bin")); !os.IsNotExist(err) {
+		t.Fatalf("Open(missing) error = %v, want not-exist", err)
+	}
+
+	bad := filepath.Join(dir, "bad.bin")
+	if err := os.WriteFile(bad, []byte("XXXX0000000000000000"), 0644); err != nil {
+		t.Fatal(err)
+	}
+	if _, err := Open(bad); err != ErrInvalidIndex {
+		t.Fatalf("Open(bad) error = %v, want ErrInvalidIndex", err)
+	}
+	if err := Update(bad, []types.DailyRecord{{Timestamp: 1, StationID: 2}}, nil); err != ErrInvalidIndex {
+		t.Fatalf("Update(bad) error = %v, want ErrInvalidIndex", err)
+	}
+}
+
+// TestUpdateFromConcurrentProcesses runs writers in separate processes, as
+// concurrent fetch and repair commands would, while this process keeps
+// reading the index: every station must survive and no read may see a torn
+// or invalid file.
+func TestUpdateFromConcurrentProcesses(t *testing.T) {
+	path := filepath.Join(t.TempDir(), FileName)
+	if err := Update(path, []types.DailyRecord{{Timestamp: 1, StationID: 1}}, nil); err != nil {
+		t.Fatal(err)
+	}
+
+	const writers = 4
+	var cmds []*exec.Cmd
+	for w := 0; w < writers; w++ {
+		cmd := exec.Command(os.Args[0], "-test.run=TestTailIndexWriterHelperProcess")
+		cmd.Env = append(os.Environ(), "TAIL_INDEX_HELPER_PATH="+path, "TAIL_INDEX_HELPER_WRITER="+strconv.Itoa(w))
+		if err := cmd.Start(); err != nil {
+			t.Fatal(err)
+		}
+		cmds = append(cmds, cmd)
+	}
+	done := make(chan error, writers)
+	for _, cmd := range cmds {
+		go func(cmd *exec.Cmd) { done <- cmd.Wait() }(cmd)
+	}
+	for finished := 0; finished < writers; {
+		select {
+		case err := <-done:
+			if err != nil {
+				t.Fatalf("writer process: %v", err)
+			}
+			finished++
+		default:
+			if _, err := Open(path); err != nil {
+				t.Fatalf("Open() during updates error = %v", err)
+			}
+		}
+	}
+
+	ix, err := Open(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for w := 0; w < writers; w++ {
+		for i := 0; i < 50; i++ {
+			id := uint16(2 + w*50 + i)
+			if got, ok := ix.Daily(id); !ok || got.Temperature != int16(id) {
+				t.Fatalf("Daily(%d) = %+v, %v; lost a concurrent update", id, got, ok)
+			}
+		}
+	}
+}
+
+func TestTailIndexWriterHelperProcess(t *testing.T) {
+	path := os.Getenv("TAIL_INDEX_HELPER_PATH")
+	if path == "" {
+		return
+	}
+	w, _ := strconv.Atoi(os.Getenv("TAIL_INDEX_HELPER_WRITER"))
+	for i := 0; i < 50; i++ {
+		id := uint16(2 + w*50 + i)
+		if err := Update(path, []types.DailyRecord{{Timestamp: 10, StationID: id, Temperature: int16(id)}}, nil); err != nil {
+			fmt.Fprintln(os.Stderr, err)
+			os.Exit(1)
+		}
+	}
+}
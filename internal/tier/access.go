@@ -0,0 +1,294 @@
+package tier
+
+import (
+	"bytes"
+	"encoding/json"
+	"fmt"
+	"os"
+	"path/filepath"
+	"sort"
+	"sync"
+	"time"
+
+	"github.com/dl-alexandre/cimis-cli/internal/filelock"
+)
+
+// AccessLogName is the access log inside a data directory. Queries append
+// to a journal beside it (AccessLogName+".journal"), which CompactAccessLog
+// folds in; both are guarded by an flock on AccessLogName+".lock".
+const AccessLogName = "chunk_access.json"
+
+// ManifestName records the tier each chunk was last migrated to.
+const ManifestName = "tiers.json"
+
+// AccessRetention is how much per-day access history the log keeps, and so
+// the longest idle window a policy can count accesses in.
+const AccessRetention = 366 * 24 * time.Hour
+
+const dayLayout = "2006-01-02"
+
+// AccessStats counts the queries that read a chunk. Count is the lifetime
+// total; Days keeps per-day counts so each policy can count within its own
+// idle window.
+type AccessStats struct {
+	Count int64      `json:"count"`
+	Last  time.Time  `json:"last"`
+	Days  []DayCount `json:"days,omitempty"`
+}
+
+// DayCount is the number of accesses on one UTC day.
+type DayCount struct {
+	Day   string `json:"day"`
+	Count int64  `json:"count"`
+}
+
+// Within returns the accesses in the window before now, to day granularity.
+// Stats recorded before per-day counts existed fall back to Count while Last
+// is inside the window.
+func (s AccessStats) Within(now time.Time, window time.Duration) int64 {
+	if s.Last.IsZero() || now.Sub(s.Last) > window {
+		return 0
+	}
+	if len(s.Days) == 0 {
+		return s.Count
+	}
+	since := now.Add(-window).UTC().Format(dayLayout)
+	var n int64
+	for _, d := range s.Days {
+		if d.Day >= since {
+			n += d.Count
+		}
+	}
+	return n
+}
+
+// AccessLog maps ChunkKey to access counts.
+type AccessLog map[string]AccessStats
+
+// ManifestEntry is the placement a chunk was last migrated to, with the
+// size and modification time (Unix nanoseconds) of the .zst it left behind.
+// Repack, fetch and repair rewrite chunks without touching the manifest, so
+// an entry whose chunk no longer matches says nothing about the chunk.
+type ManifestEntry struct {
+	Tier    Tier  `json:"tier"`
+	Level   int   `json:"level"`
+	Size    int64 `json:"size,omitempty"`
+	ModTime int64 `json:"mtime,omitempty"`
+}
+
+// Current reports whether the chunk at chunkPath is still the one the entry
+// was recorded for.
+func (e ManifestEntry) Current(chunkPath string) bool {
+	info, err := os.Stat(chunkPath)
+	return err == nil && e.Size == info.Size() && e.ModTime == info.ModTime().UnixNano()
+}
+
+// Stamp records the current size and modification time of chunkPath.
+func (e *ManifestEntry) Stamp(chunkPath string) error {
+	info, err := os.Stat(chunkPath)
+	if err != nil {
+		return err
+	}
+	e.Size, e.ModTime = info.Size(), info.ModTime().UnixNano()
+	return nil
+}
+
+// Manifest maps ChunkKey to the chunk's current placement.
+type Manifest map[string]ManifestEntry
+
+// fileMu serializes manifest writes within a process.
+var fileMu sync.Mutex
+
+// accessEntry is one RecordAccess call in the journal, one JSON line each.
+type accessEntry struct {
+	Time time.Time `json:"t"`
+	Keys []string  `json:"keys"`
+}
+
+func journalPath(path string) string { return path + ".journal" }
+
+// LoadAccessLog reads the access log at path with the journal applied; a
+// missing log is empty.
+func LoadAccessLog(path string) (AccessLog, error) {
+	unlock, err := filelock.Lock(path + ".lock")
+	if err != nil {
+		return nil, err
+	}
+	defer unlock()
+	return loadAccessLog(path)
+}
+
+// RecordAccess adds one access at now to each key. It appends a single line
+// to the journal under the lock, so concurrent queries in separate processes
+// never lose each other's accesses and the cost does not grow with the log.
+func RecordAccess(path string, keys []string, now time.Time) error {
+	if len(keys) == 0 {
+		return nil
+	}
+	line, err := json.Marshal(accessEntry{Time: now, Keys: keys})
+	if err != nil {
+		return err
+	}
+	unlock, err := filelock.Lock(path + ".lock")
+	if err != nil {
+		return err
+	}
+	defer unlock()
+
+	f, err := os.OpenFile(journalPath(path), os.O_WRONLY|os.O_APPEND|os.O_CREATE, 0644)
+	if err != nil {
+		return err
+	}
+	if _, err := f.Write(append(line, '\n')); err != nil {
+		f.Close()
+		return err
+	}
+	return f.Close()
+}
+
+// CompactAccessLog folds the journal into the access log at path, trimming
+// days past AccessRetention, and returns the result. The tier command runs
+// it once per pass.
+func CompactAccessLog(path string) (AccessLog, error) {
+	unlock, err := filelock.Lock(path + ".lock")
+	if err != nil {
+		return nil, err
+	}
+	defer unlock()
+
+	log, err := loadAccessLog(path)
+	if err != nil {
+		return nil, err
+	}
+	if err := saveJSON(path, log); err != nil {
+		return nil, err
+	}
+	if err := os.Remove(journalPath(path)); err != nil && !os.IsNotExist(err) {
+		return nil, err
+	}
+	return log, nil
+}
+
+// loadAccessLog reads the log and replays the journal; the caller holds the
+// lock. A line cut short by a crash is skipped.
+func loadAccessLog(path string) (AccessLog, error) {
+	log := AccessLog{}
+	if err := loadJSON(path, &log); err != nil {
+		return nil, err
+	}
+	data, err := os.ReadFile(journalPath(path))
+	if os.IsNotExist(err) {
+		return log, nil
+	}
+	if err != nil {
+		return nil, err
+	}
+	for _, line := range bytes.Split(data, []byte("\n")) {
+		var e accessEntry
+		if len(line) > 0 && json.Unmarshal(line, &e) == nil {
+			log.add(e.Keys, e.Time)
+		}
+	}
+	return log, nil
+}
+
+// add counts one access at now for each key.
+func (log AccessLog) add(keys []string, now time.Time) {
+	day := now.UTC().Format(dayLayout)
+	cutoff := now.Add(-AccessRetention).UTC().Format(dayLayout)
+	for _, key := range keys {
+		s := log[key]
+		s.Count++
+		if now.After(s.Last) {
+			s.Last = now
+		}
+		if n := len(s.Days); n > 0 && s.Days[n-1].Day == day {
+			s.Days[n-1].Count++
+		} else {
+			s.Days = append(s.Days, DayCount{Day: day, Count: 1})
+		}
+		// Old days fall out of the log; no policy can count them.
+		kept := s.Days[:0]
+		for _, d := range s.Days {
+			if d.Day >= cutoff {
+				kept = append(kept, d)
+			}
+		}
+		s.Days = kept
+		log[key] = s
+	}
+}
+
+// Hottest returns up to n keys accessed within idle of now, most accessed
+// within idle first and most recent first among equals: the working set worth loading
+// into a cache after a restart.
+func (log AccessLog) Hottest(now time.Time, idle time.Duration, n int) []string {
+	keys := make([]string, 0, len(log))
+	for key, s := range log {
+		if now.Sub(s.Last) <= idle {
+			keys = append(keys, key)
+		}
+	}
+	sort.Slice(keys, func(i, j int) bool {
+		a, b := log[keys[i]], log[keys[j]]
+		if ca, cb := a.Within(now, idle), b.Within(now, idle); ca != cb {
+			return ca > cb
+		}
+		if !a.Last.Equal(b.Last) {
+			return a.Last.After(b.Last)
+		}
+		return keys[i] < keys[j]
+	})
+	if n >= 0 && len(keys) > n {
+		keys = keys[:n]
+	}
+	return keys
+}
+
+// LoadManifest reads the tier manifest at path; a missing manifest is empty.
+func LoadManifest(path string) (Manifest, error) {
+	m := Manifest{}
+	return m, loadJSON(path, &m)
+}
+
+// SaveManifest replaces the manifest at path atomically.
+func SaveManifest(path string, m Manifest) error {
+	fileMu.Lock()
+	defer fileMu.Unlock()
+	return saveJSON(path, m)
+}
+
+func loadJSON(path string, v any) error {
+	data, err := os.ReadFile(path)
+	if os.IsNotExist(err) {
+		return nil
+	}
+	if err != nil {
+		return err
+	}
+	if err := json.Unmarshal(data, v); err != nil {
+		return fmt.Errorf("parse %s: %w", filepath.Base(path), err)
+	}
+	return nil
+}
+
+// saveJSON writes v next to path and renames it into place.
+func saveJSON(path string, v any) error {
+	data, err := json.Marshal(v)
+	if err != nil {
+		return err
+	}
+	tmp, err := os.CreateTemp(filepath.Dir(path), filepath.Base(path)+".tmp-")
+	if err != nil {
+		return err
+	}
+	defer os.Remove(tmp.Name())
+	if _, err := tmp.Write(data); err != nil {
+		tmp.Close()
+		return err
+	}
+	if err := tmp.Close(); err != nil {
+		return err
+	}
+	return os.Rename(tmp.Name(), path)
+}
@@ -0,0 +1,180 @@
+package tier
+
+import (
+	"encoding/binary"
+	"errors"
+	"os"
+	"strings"
+
+	"github.com/dl-alexandre/cimis-cli/internal/recordio"
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// Raw copies hold a hot chunk's records uncompressed in the C record layout
+// after a 32-byte header:
+//
+//	0  "CRAW"  magic
+//	4  u32     version
+//	8  u32     record size (16 daily, 24 hourly)
+//	12 u32     record count
+//	16 u64     size of the .zst chunk the copy was made from
+//	24 i64     modification time of that chunk (Unix nanoseconds)
+//
+// The records start 32 bytes in, so a mapped copy can be handed to
+// cimis_iterator_init as is. A copy whose chunk has since been rewritten is
+// stale and ignored.
+const (
+	rawMagic      = "CRAW"
+	rawVersion    = 1
+	rawHeaderSize = 32
+)
+
+// ErrStaleRaw is returned when a raw copy no longer matches its chunk.
+var ErrStaleRaw = errors.New("raw chunk copy is stale")
+
+// ErrInvalidRaw is returned for malformed raw copies.
+var ErrInvalidRaw = errors.New("invalid raw chunk copy")
+
+// RawPath returns the raw copy path for a .zst chunk path.
+func RawPath(chunkPath string) string {
+	return strings.TrimSuffix(chunkPath, ".zst") + ".raw"
+}
+
+// WriteRawDaily writes the raw copy of the daily chunk at chunkPath.
+func WriteRawDaily(chunkPath string, records []types.DailyRecord) error {
+	buf, err := rawHeader(chunkPath, recordio.DailySize, len(records))
+	if err != nil {
+		return err
+	}
+	for _, r := range records {
+		buf = append(buf, recordio.PutDaily(make([]byte, recordio.DailySize), r)...)
+	}
+	return writeRaw(chunkPath, buf)
+}
+
+// WriteRawHourly writes the raw copy of the hourly chunk at chunkPath.
+func WriteRawHourly(chunkPath string, records []types.HourlyRecord) error {
+	buf, err := rawHeader(chunkPath, recordio.HourlySize, len(records))
+	if err != nil {
+		return err
+	}
+	for _, r := range records {
+		buf = append(buf, recordio.PutHourly(make([]byte, recordio.HourlySize), r)...)
+	}
+	return writeRaw(chunkPath, buf)
+}
+
+// ReadRawDaily reads the raw copy of the daily chunk at chunkPath.
+func ReadRawDaily(chunkPath string) ([]types.DailyRecord, error) {
+	body, n, err := readRaw(chunkPath, recordio.DailySize)
+	if err != nil {
+		return nil, err
+	}
+	records := make([]types.DailyRecord, n)
+	for i := range records {
+		records[i] = recordio.Daily(body[i*recordio.DailySize:])
+	}
+	return records, nil
+}
+
+// ReadRawHourly reads the raw copy of the hourly chunk at chunkPath.
+func ReadRawHourly(chunkPath string) ([]types.HourlyRecord, error) {
+	body, n, err := readRaw(chunkPath, recordio.HourlySize)
+	if err != nil {
+		return nil, err
+	}
+	records := make([]types.HourlyRecord, n)
+	for i := range records {
+		records[i] = recordio.Hourly(body[i*recordio.HourlySize:])
+	}
+	return records, nil
+}
+
+// RemoveRaw deletes the raw copy of chunkPath if there is one.
+func RemoveRaw(chunkPath string) error {
+	if err := os.Remove(RawPath(chunkPath)); err != nil && !os.IsNotExist(err) {
+		return err
+	}
+	return nil
+}
+
+// RawValid reports whether chunkPath has an up-to-date raw copy.
+func RawValid(chunkPath string) bool {
+	f, err := os.Open(RawPath(chunkPath))
+	if err != nil {
+		return false
+	}
+	defer f.Close()
+	header := make([]byte, rawHeaderSize)
+	if _, err := f.ReadAt(header, 0); err != nil {
+		return false
+	}
+	return checkRawHeader(chunkPath, header) == nil
+}
+
+func rawHeader(chunkPath string, recordSize, count int) ([]byte, error) {
+	info, err := os.Stat(chunkPath)
+	if err != nil {
+		return nil, err
+	}
+	buf := make([]byte, rawHeaderSize, rawHeaderSize+recordSize*count)
+	copy(buf, rawMagic)
+	binary.LittleEndian.PutUint32(buf[4:], rawVersion)
+	binary.LittleEndian.PutUint32(buf[8:], uint32(recordSize))
+	binary.LittleEndian.PutUint32(buf[12:], uint32(count))
+	binary.LittleEndian.PutUint64(buf[16:], uint64(info.Size()))
+	binary.LittleEndian.PutUint64(buf[24:], uint64(info.ModTime().UnixNano()))
+	return buf, nil
+}
+
+// writeRaw writes the copy beside the chunk and renames it into place so
+// readers never see a partial file.
+func writeRaw(chunkPath string, buf []byte) error {
+	path := RawPath(chunkPath)
+	tmp := path + ".tmp"
+	if err := os.WriteFile(tmp, buf, 0644); err != nil {
+		return err
+	}
+	if err := os.Rename(tmp, path); err != nil {
+		os.Remove(tmp)
+		return err
+	}
+	return nil
+}
+
+func readRaw(chunkPath string, recordSize int) ([]byte, int, error) {
+	data, err := os.ReadFile(RawPath(chunkPath))
+	if err != nil {
+		return nil, 0, err
+	}
+	if len(data) < rawHeaderSize {
+		return nil, 0, ErrInvalidRaw
+	}
+	if err := checkRawHeader(chunkPath, data[:rawHeaderSize]); err != nil {
+		return nil, 0, err
+	}
+	if int(binary.LittleEndian.Uint32(data[8:])) != recordSize {
+		return nil, 0, ErrInvalidRaw
+	}
+	n := int(binary.LittleEndian.Uint32(data[12:]))
+	body := data[rawHeaderSize:]
+	if len(body) != n*recordSize {
+		return nil, 0, ErrInvalidRaw
+	}
+	return body, n, nil
+}
+
+func checkRawHeader(chunkPath string, header []byte) error {
+	if string(header[:4]) != rawMagic || binary.LittleEndian.Uint32(header[4:]) != rawVersion {
+		return ErrInvalidRaw
+	}
+	info, err := os.Stat(chunkPath)
+	if err != nil {
+		return err
+	}
+	if binary.LittleEndian.Uint64(header[16:]) != uint64(info.Size()) ||
+		int64(binary.LittleEndian.Uint64(header[24:])) != info.ModTime().UnixNano() {
+		return ErrStaleRaw
+	}
+	return nil
+}
@@ -0,0 +1,126 @@
+// Package tier places year chunks in storage tiers by age and how often they
+// are queried. Hot chunks keep an uncompressed copy next to the compressed
+// chunk so queries skip decompression; the compressed chunk itself stays at
+// the warm level, since queries no longer read it. Cold chunks are
+// recompressed at a high level to keep the archive small.
+package tier
+
+import (
+	"fmt"
+	"strconv"
+	"strings"
+	"time"
+
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+// Tier is the storage class of a chunk.
+type Tier string
+
+const (
+	Hot  Tier = "hot"
+	Warm Tier = "warm"
+	Cold Tier = "cold"
+)
+
+// DefaultIdle is how long an access keeps counting towards promotion.
+const DefaultIdle = 90 * 24 * time.Hour
+
+// Policy decides which tier a chunk belongs in.
+type Policy struct {
+	HotYears       int           // most recent years that are always hot
+	HotAccesses    int64         // accesses that keep an older chunk hot
+	HotSet         int           // most accessed chunks within Idle that are always hot
+	ColdAfterYears int           // chunks at least this old may go cold
+	Idle           time.Duration // accesses older than this no longer count
+	WarmLevel      int           // compression level of warm and hot chunks
+	ColdLevel      int
+}
+
+// DefaultPolicy keeps the current and previous year and the 32 most queried
+// chunks hot, and sends chunks older than ten years that nobody queried in
+// 90 days to the cold tier.
+func DefaultPolicy() Policy {
+	return Policy{
+		HotYears:       2,
+		HotAccesses:    10,
+		HotSet:         32,
+		ColdAfterYears: 10,
+		Idle:           DefaultIdle,
+		WarmLevel:      3,
+		ColdLevel:      19,
+	}
+}
+
+// Validate reports policies that cannot be applied.
+func (p Policy) Validate() error {
+	if p.HotYears < 0 || p.ColdAfterYears < 0 || p.HotAccesses < 0 || p.HotSet < 0 || p.Idle < 0 {
+		return fmt.Errorf("tier policy values must not be negative")
+	}
+	if p.Idle > AccessRetention {
+		return fmt.Errorf("idle window %v exceeds the %v of access history kept", p.Idle, AccessRetention)
+	}
+	if p.ColdAfterYears > 0 && p.ColdAfterYears < p.HotYears {
+		return fmt.Errorf("cold tier age (%d years) overlaps the hot tier (%d years)", p.ColdAfterYears, p.HotYears)
+	}
+	return nil
+}
+
+// Classify returns the tier for a chunk of the given year. Recent years are
+// hot; older ones are promoted by recent, frequent access and demoted to cold
+// once they are both old and idle. Membership of the hot set is decided by
+// the caller over the whole access log (AccessLog.Hottest).
+func (p Policy) Classify(year int, stats AccessStats, now time.Time) Tier {
+	age := now.Year() - year
+	if age < p.HotYears {
+		return Hot
+	}
+	recent := !stats.Last.IsZero() && now.Sub(stats.Last) <= p.Idle
+	if recent && p.HotAccesses > 0 && stats.Within(now, p.Idle) >= p.HotAccesses {
+		return Hot
+	}
+	if p.ColdAfterYears > 0 && age >= p.ColdAfterYears && !recent {
+		return Cold
+	}
+	return Warm
+}
+
+// Level returns the compression level chunks in t are stored at. Hot chunks
+// are served from their raw copy, so their .zst stays at the warm level and
+// promotion or demotion between the two never recompresses.
+func (p Policy) Level(t Tier) int {
+	if t == Cold {
+		return p.ColdLevel
+	}
+	return p.WarmLevel
+}
+
+// ChunkKey identifies a chunk in the access log and tier manifest.
+func ChunkKey(stationID uint16, year int, dataType types.DataType) string {
+	return fmt.Sprintf("%03d/%d_%s", stationID, year, dataType)
+}
+
+// ParseChunkKey splits a key made by ChunkKey.
+func ParseChunkKey(key string) (uint16, int, types.DataType, bool) {
+	station, rest, ok := strings.Cut(key, "/")
+	if !ok {
+		return 0, 0, "", false
+	}
+	year, dataType, ok := strings.Cut(rest, "_")
+	if !ok {
+		return 0, 0, "", false
+	}
+	sid, err := strconv.ParseUint(station, 10, 16)
+	if err != nil {
+		return 0, 0, "", false
+	}
+	y, err := strconv.Atoi(year)
+	if err != nil {
+		return 0, 0, "", false
+	}
+	switch types.DataType(dataType) {
+	case types.DataTypeDaily, types.DataTypeHourly:
+		return uint16(sid), y, types.DataType(dataType), true
+	}
+	return 0, 0, "", false
+}
@@ -0,0 +1,229 @@
+package tier
+
+import (
+	"fmt"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"reflect"
+	"testing"
+	"time"
+
+	"github.com/dl-alexandre/cimis-tsdb/types"
+)
+
+func TestClassify(t *testing.T) {
+	p := DefaultPolicy()
+	now := time.Date(2024, 6, 1, 0, 0, 0, 0, time.UTC)
+	recent := AccessStats{Count: 50, Last: now.Add(-24 * time.Hour)}
+	stale := AccessStats{Count: 50, Last: now.Add(-2 * p.Idle)}
+
+	tests := []struct {
+		year  int
+		stats AccessStats
+		want  Tier
+	}{
+		{2024, AccessStats{}, Hot},
+		{2023, AccessStats{}, Hot},
+		{2022, AccessStats{}, Warm},
+		{2000, recent, Hot},
+		{2000, AccessStats{Count: 1, Last: recent.Last}, Warm},
+		{2000, stale, Cold},
+		{2000, AccessStats{}, Cold},
+		{2015, AccessStats{}, Warm},
+	}
+	for _, tt := range tests {
+		if got := p.Classify(tt.year, tt.stats, now); got != tt.want {
+			t.Errorf("Classify(%d, %+v) = %s, want %s", tt.year, tt.stats, got, tt.want)
+		}
+	}
+	if p.Level(Hot) != p.WarmLevel || p.Level(Warm) != p.WarmLevel || p.Level(Cold) != p.ColdLevel {
+		t.Fatal("Level() does not follow the policy")
+	}
+	if err := (Policy{HotYears: 5, ColdAfterYears: 3}).Validate(); err == nil {
+		t.Fatal("expected overlapping tiers to be rejected")
+	}
+}
+
+func TestRecordAccess(t *testing.T) {
+	path := filepath.Join(t.TempDir(), AccessLogName)
+	now := time.Date(2024, 6, 1, 0, 0, 0, 0, time.UTC)
+	key := ChunkKey(2, 2023, types.DataTypeDaily)
+
+	for i := 0; i < 3; i++ {
+		if err := RecordAccess(path, []string{key}, now); err != nil {
+			t.Fatalf("RecordAccess() error = %v", err)
+		}
+	}
+	log, err := LoadAccessLog(path)
+	if err != nil {
+		t.Fatalf("LoadAccessLog() error = %v", err)
+	}
+	if got := log[key]; got.Count != 3 || !got.Last.Equal(now) {
+		t.Fatalf("access stats = %+v, want 3 at %v", got, now)
+	}
+
+	// Each policy counts within its own idle window, not the default one.
+	later := now.Add(60 * 24 * time.Hour)
+	if err := RecordAccess(path, []string{key}, later); err != nil {
+		t.Fatal(err)
+	}
+	log, _ = LoadAccessLog(path)
+	s := log[key]
+	if s.Count != 4 || s.Within(later, 30*24*time.Hour) != 1 || s.Within(later, DefaultIdle) != 4 {
+		t.Fatalf("access stats = %+v, want 1 within 30 days and 4 within %v", s, DefaultIdle)
+	}
+	short := DefaultPolicy()
+	short.HotAccesses, short.Idle = 4, 30*24*time.Hour
+	if got := short.Classify(2000, s, later); got != Warm {
+		t.Fatalf("Classify() with a 30 day window = %s, want warm", got)
+	}
+	long := DefaultPolicy()
+	long.HotAccesses = 4
+	if got := long.Classify(2000, s, later); got != Hot {
+		t.Fatalf("Classify() with the default window = %s, want hot", got)
+	}
+
+	// Days beyond the retention drop out of the log.
+	if err := RecordAccess(path, []string{key}, later.Add(2*AccessRetention)); err != nil {
+		t.Fatal(err)
+	}
+	if log, _ = LoadAccessLog(path); len(log[key].Days) != 1 || log[key].Count != 5 {
+		t.Fatalf("access stats after retention = %+v", log[key])
+	}
+	if _, err := os.Stat(journalPath(path)); err != nil {
+		t.Fatalf("accesses were not journaled: %v", err)
+	}
+
+	// Compaction folds the journal into the log without changing it.
+	compacted, err := CompactAccessLog(path)
+	if err != nil || !reflect.DeepEqual(compacted, log) {
+		t.Fatalf("CompactAccessLog() = %+v, %v; want %+v", compacted, err, log)
+	}
+	if _, err := os.Stat(journalPath(path)); !os.IsNotExist(err) {
+		t.Fatalf("journal left after compaction: %v", err)
+	}
+	if log, _ = LoadAccessLog(path); log[key].Count != 5 {
+		t.Fatalf("access stats after compaction = %+v", log[key])
+	}
+	if err := (Policy{Idle: 2 * AccessRetention}).Validate(); err == nil {
+		t.Fatal("expected an idle window beyond the retention to be rejected")
+	}
+}
+
+// TestRecordAccessFromConcurrentProcesses records accesses from several
+// query processes at once while compacting: none may be lost.
+func TestRecordAccessFromConcurrentProcesses(t *testing.T) {
+	path := filepath.Join(t.TempDir(), AccessLogName)
+	const procs, each = 4, 25
+
+	var cmds []*exec.Cmd
+	for p := 0; p < procs; p++ {
+		cmd := exec.Command(os.Args[0], "-test.run=TestAccessRecorderHelperProcess")
+		cmd.Env = append(os.Environ(), "ACCESS_HELPER_PATH="+path)
+		if err := cmd.Start(); err != nil {
+			t.Fatal(err)
+		}
+		cmds = append(cmds, cmd)
+	}
+	for i := 0; i < 10; i++ {
+		if _, err := CompactAccessLog(path); err != nil {
+			t.Fatalf("CompactAccessLog() error = %v", err)
+		}
+	}
+	for _, cmd := range cmds {
+		if err := cmd.Wait(); err != nil {
+			t.Fatalf("recorder process: %v", err)
+		}
+	}
+
+	log, err := CompactAccessLog(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if got := log[ChunkKey(2, 2023, types.DataTypeDaily)].Count; got != procs*each {
+		t.Fatalf("recorded accesses = %d, want %d", got, procs*each)
+	}
+}
+
+func TestAccessRecorderHelperProcess(t *testing.T) {
+	path := os.Getenv("ACCESS_HELPER_PATH")
+	if path == "" {
+		return
+	}
+	for i := 0; i < 25; i++ {
+		if err := RecordAccess(path, []string{ChunkKey(2, 2023, types.DataTypeDaily)}, time.Now()); err != nil {
+			fmt.Fprintln(os.Stderr, err)
+			os.Exit(1)
+		}
+	}
+}
+
+func TestRawCopyRoundTripAndStaleness(t *testing.T) {
+	chunk := filepath.Join(t.TempDir(), "2023_daily.zst")
+	if err := os.WriteFile(chunk, []byte("compressed"), 0644); err != nil {
+		t.Fatal(err)
+	}
+	if RawValid(chunk) {
+		t.Fatal("no raw copy written yet")
+	}
+
+	daily := []types.DailyRecord{
+		{Timestamp: 13880, StationID: 2, Temperature: -12, ET: 310, WindSpeed: 21, Humidity: 64, SolarRadiation: 150, QCFlags: 1},
+		{Timestamp: 13881, StationID: 2, Temperature: 205},
+	}
+	if err := WriteRawDaily(chunk, daily); err != nil {
+		t.Fatalf("WriteRawDaily() error = %v", err)
+	}
+	got, err := ReadRawDaily(chunk)
+	if err != nil || !reflect.DeepEqual(got, daily) {
+		t.Fatalf("ReadRawDaily() = %+v, %v", got, err)
+	}
+	if _, err := ReadRawHourly(chunk); err != ErrInvalidRaw {
+		t.Fatalf("ReadRawHourly() on a daily copy error = %v, want ErrInvalidRaw", err)
+	}
+	if info, _ := os.Stat(RawPath(chunk)); info.Size() != rawHeaderSize+2*16 {
+		t.Fatalf("raw copy size = %d", info.Size())
+	}
+
+	// Rewriting the chunk invalidates the copy.
+	if err := os.WriteFile(chunk, []byte("recompressed chunk"), 0644); err != nil {
+		t.Fatal(err)
+	}
+	if _, err := ReadRawDaily(chunk); err != ErrStaleRaw {
+		t.Fatalf("ReadRawDaily() after rewrite error = %v, want ErrStaleRaw", err)
+	}
+	if err := RemoveRaw(chunk); err != nil {
+		t.Fatal(err)
+	}
+	if err := RemoveRaw(chunk); err != nil {
+		t.Fatalf("RemoveRaw() of a missing copy error = %v", err)
+	}
+}
+
+func TestHottestAndParseChunkKey(t *testing.T) {
+	now := time.Date(2024, 6, 1, 0, 0, 0, 0, time.UTC)
+	log := AccessLog{
+		ChunkKey(2, 2023, types.DataTypeDaily):  {Count: 5, Last: now.Add(-time.Hour)},
+		ChunkKey(2, 2024, types.DataTypeHourly): {Count: 9, Last: now.Add(-time.Hour)},
+		ChunkKey(5, 2024, types.DataTypeDaily):  {Count: 5, Last: now.Add(-time.Minute)},
+		ChunkKey(7, 1990, types.DataTypeDaily):  {Count: 99, Last: now.Add(-2 * DefaultIdle)},
+	}
+	want := []string{"002/2024_hourly", "005/2024_daily", "002/2023_daily"}
+	if got := log.Hottest(now, DefaultIdle, 10); !reflect.DeepEqual(got, want) {
+		t.Fatalf("Hottest() = %v, want %v", got, want)
+	}
+	if got := log.Hottest(now, DefaultIdle, 1); len(got) != 1 || got[0] != want[0] {
+		t.Fatalf("Hottest(n=1) = %v", got)
+	}
+
+	sid, year, dataType, ok := ParseChunkKey("002/2024_hourly")
+	if !ok || sid != 2 || year != 2024 || dataType != types.DataTypeHourly {
+		t.Fatalf("ParseChunkKey() = %d, %d, %s, %v", sid, year, dataType, ok)
+	}
+	for _, bad := range []string{"", "002", "002/2024", "x/2024_daily", "002/y_daily", "002/2024_weekly"} {
+		if _, _, _, ok := ParseChunkKey(bad); ok {
+			t.Fatalf("ParseChunkKey(%q) accepted", bad)
+		}
+	}
+}
@@ -0,0 +1,191 @@
+// Package trace records timing spans and writes them in the Chrome
+// trace-event JSON format, which chrome://tracing and ui.perfetto.dev load
+// directly. Every worker records onto its own track (a trace "thread"), so
+// overlapping fetches, chunk writes and block decodes line up on a single
+// timeline and pipeline stalls show up as gaps that summed timings hide.
+//
+// A nil *Recorder or *Track ignores every call, so callers can trace
+// unconditionally and only create a Recorder when a trace was requested.
+package trace
+
+import (
+	"encoding/json"
+	"fmt"
+	"io"
+	"os"
+	"sort"
+	"sync"
+	"time"
+)
+
+// event is one entry of the traceEvents array. Timestamps and durations are
+// in microseconds since the recorder started.
+type event struct {
+	Name string         `json:"name"`
+	Cat  string         `json:"cat,omitempty"`
+	Ph   string         `json:"ph"`
+	TS   float64        `json:"ts"`
+	Dur  float64        `json:"dur"`
+	PID  int            `json:"pid"`
+	TID  int            `json:"tid"`
+	Args map[string]any `json:"args,omitempty"`
+}
+
+// Recorder collects spans from any number of goroutines.
+type Recorder struct {
+	process string
+	start   time.Time
+
+	mu     sync.Mutex
+	events []event
+	tracks int
+}
+
+// New returns a recorder whose process is labelled name in the viewer.
+func New(name string) *Recorder {
+	r := &Recorder{process: name, start: time.Now()}
+	r.events = append(r.events, event{Name: "process_name", Ph: "M", PID: 1, Args: map[string]any{"name": name}})
+	return r
+}
+
+// Track registers a new named timeline, e.g. one per worker goroutine.
+func (r *Recorder) Track(name string) *Track {
+	if r == nil {
+		return nil
+	}
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	r.tracks++
+	t := &Track{r: r, tid: r.tracks}
+	r.events = append(r.events,
+		event{Name: "thread_name", Ph: "M", PID: 1, TID: t.tid, Args: map[string]any{"name": name}},
+		event{Name: "thread_sort_index", Ph: "M", PID: 1, TID: t.tid, Args: map[string]any{"sort_index": t.tid}})
+	return t
+}
+
+func (r *Recorder) micros(t time.Time) float64 {
+	return float64(t.Sub(r.start).Nanoseconds()) / 1e3
+}
+
+func (r *Recorder) add(e event) {
+	r.mu.Lock()
+	r.events = append(r.events, e)
+	r.mu.Unlock()
+}
+
+// Write encodes the trace as a JSON object with a traceEvents array.
+func (r *Recorder) Write(w io.Writer) error {
+	r.mu.Lock()
+	events := append([]event(nil), r.events...)
+	r.mu.Unlock()
+	// Metadata first, then spans by start time and outermost first, which
+	// is the order viewers nest complete events in.
+	sort.SliceStable(events, func(i, j int) bool {
+		a, b := events[i], events[j]
+		if (a.Ph == "M") != (b.Ph == "M") {
+			return a.Ph == "M"
+		}
+		if a.TS != b.TS {
+			return a.TS < b.TS
+		}
+		return a.Dur > b.Dur
+	})
+	return json.NewEncoder(w).Encode(struct {
+		TraceEvents     []event `json:"traceEvents"`
+		DisplayTimeUnit string  `json:"displayTimeUnit"`
+	}{events, "ms"})
+}
+
+// WriteFile writes the trace to path.
+func (r *Recorder) WriteFile(path string) error {
+	if r == nil {
+		return nil
+	}
+	f, err := os.Create(path)
+	if err != nil {
+		return fmt.Errorf("failed to create trace file: %w", err)
+	}
+	if err := r.Write(f); err != nil {
+		f.Close()
+		return fmt.Errorf("failed to write trace: %w", err)
+	}
+	return f.Close()
+}
+
+// Track is one timeline of a trace. Spans on a track nest by time, so a
+// span started inside another and ended before it is drawn beneath it.
+type Track struct {
+	r   *Recorder
+	tid int
+}
+
+// Span is an open interval on a track.
+type Span struct {
+	t     *Track
+	name  string
+	start time.Time
+	args  map[string]any
+}
+
+// Start opens a span. args are key/value pairs shown in the viewer's
+// details pane.
+func (t *Track) Start(name string, args ...any) *Span {
+	if t == nil {
+		return nil
+	}
+	return &Span{t: t, name: name, start: time.Now(), args: pairs(args)}
+}
+
+// Add records a span that was timed elsewhere.
+func (t *Track) Add(name string, start time.Time, d time.Duration, args ...any) {
+	if t == nil {
+		return
+	}
+	t.span(name, start, d, pairs(args))
+}
+
+func (t *Track) span(name string, start time.Time, d time.Duration, args map[string]any) {
+	t.r.add(event{
+		Name: name,
+		Cat:  t.r.process,
+		Ph:   "X",
+		TS:   t.r.micros(start),
+		Dur:  float64(d.Nanoseconds()) / 1e3,
+		PID:  1,
+		TID:  t.tid,
+		Args: args,
+	})
+}
+
+// End closes the span.
+func (s *Span) End() {
+	if s == nil {
+		return
+	}
+	s.t.span(s.name, s.start, time.Since(s.start), s.args)
+}
+
+// Set attaches or replaces an argument before the span ends.
+func (s *Span) Set(key string, value any) {
+	if s == nil {
+		return
+	}
+	if s.args == nil {
+		s.args = make(map[string]any)
+	}
+	s.args[key] = value
+}
+
+func pairs(kv []any) map[string]any {
+	if len(kv) == 0 {
+		return nil
+	}
+	if len(kv)%2 != 0 {
+		panic("trace: args must be key/value pairs")
+	}
+	m := make(map[string]any, len(kv)/2)
+	for i := 0; i < len(kv); i += 2 {
+		m[fmt.Sprint(kv[i])] = kv[i+1]
+	}
+	return m
+}
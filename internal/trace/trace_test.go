@@ -0,0 +1,115 @@
+package trace
+
+import (
+	"encoding/json"
+	"fmt"
+	"os"
+	"path/filepath"
+	"sync"
+	"testing"
+	"time"
+)
+
+type decoded struct {
+	TraceEvents []struct {
+		Name string         `json:"name"`
+		Cat  string         `json:"cat"`
+		Ph   string         `json:"ph"`
+		TS   float64        `json:"ts"`
+		Dur  float64        `json:"dur"`
+		PID  int            `json:"pid"`
+		TID  int            `json:"tid"`
+		Args map[string]any `json:"args"`
+	} `json:"traceEvents"`
+	DisplayTimeUnit string `json:"displayTimeUnit"`
+}
+
+func TestRecorderWritesNestedSpansPerTrack(t *testing.T) {
+	rec := New("cimis test")
+	var wg sync.WaitGroup
+	for w := 0; w < 3; w++ {
+		track := rec.Track(fmt.Sprintf("worker %d", w))
+		wg.Add(1)
+		go func(w int) {
+			defer wg.Done()
+			station := track.Start("station", "station", w)
+			inner := track.Start("write chunk")
+			time.Sleep(time.Millisecond)
+			inner.Set("bytes", 42)
+			inner.End()
+			track.Add("decode", time.Now().Add(-time.Microsecond), time.Microsecond)
+			station.End()
+		}(w)
+	}
+	wg.Wait()
+
+	path := filepath.Join(t.TempDir(), "trace.json")
+	if err := rec.WriteFile(path); err != nil {
+		t.Fatalf("WriteFile() error = %v", err)
+	}
+	data, err := os.ReadFile(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	var got decoded
+	if err := json.Unmarshal(data, &got); err != nil {
+		t.Fatalf("trace is not valid JSON: %v\n%s", err, data)
+	}
+	if got.DisplayTimeUnit != "ms" {
+		t.Fatalf("displayTimeUnit = %q", got.DisplayTimeUnit)
+	}
+
+	threads := map[int]string{}
+	spans := map[int]map[string][2]float64{}
+	seenSpan := false
+	for _, e := range got.TraceEvents {
+		switch e.Ph {
+		case "M":
+			if seenSpan {
+				t.Fatal("metadata events must precede spans")
+			}
+			if e.Name == "thread_name" {
+				threads[e.TID] = e.Args["name"].(string)
+			}
+		case "X":
+			seenSpan = true
+			if e.Cat != "cimis test" || e.PID != 1 {
+				t.Fatalf("span %+v", e)
+			}
+			if spans[e.TID] == nil {
+				spans[e.TID] = map[string][2]float64{}
+			}
+			spans[e.TID][e.Name] = [2]float64{e.TS, e.TS + e.Dur}
+			if e.Name == "write chunk" && e.Args["bytes"] != float64(42) {
+				t.Fatalf("write chunk args = %v", e.Args)
+			}
+		}
+	}
+	if len(threads) != 3 || len(spans) != 3 {
+		t.Fatalf("threads = %v, span tracks = %d", threads, len(spans))
+	}
+	for tid, s := range spans {
+		outer, inner := s["station"], s["write chunk"]
+		if inner[0] < outer[0] || inner[1] > outer[1] || inner[1]-inner[0] < 1000 {
+			t.Fatalf("track %d: write chunk %v not nested in station %v", tid, inner, outer)
+		}
+	}
+}
+
+func TestNilRecorderIsNoOp(t *testing.T) {
+	var rec *Recorder
+	track := rec.Track("main")
+	span := track.Start("query", "station", 2)
+	span.Set("records", 1)
+	span.End()
+	track.Add("decode", time.Now(), time.Millisecond)
+	if err := rec.WriteFile(filepath.Join(t.TempDir(), "unused.json")); err != nil {
+		t.Fatalf("nil WriteFile() error = %v", err)
+	}
+}
+
+func TestWriteFileError(t *testing.T) {
+	if err := New("x").WriteFile(filepath.Join(t.TempDir(), "missing", "trace.json")); err == nil {
+		t.Fatal("expected create error")
+	}
+}